@@ -0,0 +1,93 @@
+// array_ops.s's job (add 1 to every element of my_array) with NEON, the
+// AArch64 counterpart of ../array_ops/array_ops_rvv.s, for any LENGTH
+//
+// NEON registers are a fixed 128 bits, four words each, and there is no
+// vsetvli to shorten the last pass. So the work is split by hand:
+//
+// - by_sixteen: ld1 loads four registers (16 words) in one instruction,
+//   four adds, one st1 stores them and moves x0 on 64 bytes
+// - by_four: the rest four at a time, at most three passes
+// - tail_loop: the last 0-3 one at a time, like array_ops_unrolled.s
+//
+// 8 instructions per 16 elements = 0.5 per element, the same as RVV with
+// m4 at QEMU's VLEN of 128. The first add waits a cycle for the ld1 and
+// the b.ne back costs 2, so 11 cycles per 16 with rvsim's timing. make
+// count measures it.
+//
+// Before the first NEON instruction, CPACR_EL1.FPEN has to let EL1 use
+// the FP/SIMD registers; it is 0 (trap them all) after reset, like
+// mstatus.VS for RVV.
+
+// Register Roles
+// x0 - pointer to the next element
+// x1 - LENGTH, the number of elements
+// x2 - end of the array (my_array + 4 * LENGTH)
+// x3 - end of the part done sixteen at a time
+// x4 - end of the part done four at a time
+// v0-v3 - the elements in flight
+// v16 - four 1s
+
+// How many elements: make compile-neon LENGTH=1000 overrides this
+.ifndef LENGTH
+.equ LENGTH, 3
+.endif
+
+.section .data
+.balign 16
+my_array:
+    .zero 4 * LENGTH    // LENGTH words of 0
+
+.section .text
+.global _start
+
+_start:
+    mov x0, #(3 << 20)  // CPACR_EL1.FPEN = 0b11: turn FP/SIMD on
+    msr cpacr_el1, x0
+    isb
+    adr x0, my_array
+    mov x1, #LENGTH
+    add x2, x0, x1, lsl #2      // x2 = end of the array
+    and x5, x1, #~15            // LENGTH rounded down to a multiple of 16
+    add x3, x0, x5, lsl #2      // x3 = end of the groups of sixteen
+    and x5, x1, #~3
+    add x4, x0, x5, lsl #2      // x4 = end of the groups of four
+    movi v16.4s, #1
+    cmp x0, x3
+    b.eq fours          // fewer than 16 elements
+
+by_sixteen:
+    ld1 {v0.4s-v3.4s}, [x0]     // v0-v3 = the next 16 elements
+    add v0.4s, v0.4s, v16.4s    // + 1, four at a time
+    add v1.4s, v1.4s, v16.4s
+    add v2.4s, v2.4s, v16.4s
+    add v3.4s, v3.4s, v16.4s
+    st1 {v0.4s-v3.4s}, [x0], #64    // store them back, x0 += 64 bytes
+    cmp x0, x3
+    b.ne by_sixteen
+
+fours:
+    cmp x0, x4
+    b.eq tail           // LENGTH % 16 was under 4
+
+by_four:
+    ld1 {v0.4s}, [x0]
+    add v0.4s, v0.4s, v16.4s
+    st1 {v0.4s}, [x0], #16
+    cmp x0, x4
+    b.ne by_four
+
+tail:
+    cmp x0, x2
+    b.eq done           // LENGTH was a multiple of 4
+
+tail_loop:              // the last 1-3 elements, one at a time
+    ldr w5, [x0]
+    add w5, w5, #1
+    str w5, [x0], #4
+    cmp x0, x2
+    b.ne tail_loop
+
+done:
+    adr x0, my_array    // stop QEMU: status 0 if every element is 1
+    mov x1, #LENGTH
+    b _exit_unless_ones
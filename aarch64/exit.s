@@ -0,0 +1,49 @@
+// _exit: stop QEMU with the status in w0, the AArch64 counterpart of
+// rvlib's _exit. The RISC-V virt board has the sifive_test device for
+// that; the Arm one does not, so this asks QEMU itself through Arm
+// semihosting: SYS_EXIT (0x18) in x0, a pointer to {reason, status} in
+// x1, then hlt #0xf000. QEMU has to be started with -semihosting (every
+// target in the Makefile does), or the hlt is an undefined instruction.
+//
+// _exit_unless_ones is where the array_ops programs go when they are
+// done: what ../array_ops's make run checks with --dump my_array, as an
+// exit status, since QEMU has no way to print memory once it stops.
+
+.section .data
+.balign 8
+exit_block:
+    .quad 0x20026       // reason: ADP_Stopped_ApplicationExit
+    .quad 0             // status
+
+.section .text
+.global _exit
+.type _exit, %function
+
+_exit:
+    adr x1, exit_block
+    str x0, [x1, #8]    // status = w0 (writing w0 zeroed the top half of x0)
+    mov x0, #0x18       // SYS_EXIT
+    hlt #0xf000
+    b .                 // not reached
+
+// _exit_unless_ones(x0 = array, x1 = elements): _exit(0) if every 32-bit
+// element is 1, else _exit(how many are not)
+.global _exit_unless_ones
+.type _exit_unless_ones, %function
+
+_exit_unless_ones:
+    add x1, x0, x1, lsl #2  // x1 = end of the array
+    mov w2, #0              // elements that are not 1
+    cmp x0, x1
+    b.eq ones_counted
+
+next_one:
+    ldr w3, [x0], #4
+    cmp w3, #1
+    cinc w2, w2, ne
+    cmp x0, x1
+    b.ne next_one
+
+ones_counted:
+    mov w0, w2
+    b _exit
@@ -0,0 +1,28 @@
+// ../m.s in AArch64: add 2 to w20 five times
+//
+// x19-x21 stand in for s1-s3, the first callee-saved registers on both
+// sides. The loop is the same 3 instructions: RISC-V's bnez compares s3
+// with zero itself, and here subs sets the flags as it counts down so
+// b.ne has nothing left to compare. 5 cycles a pass either way (1 each,
+// plus 2 for the taken branch back). make count measures both.
+//
+// ../m.s ends at done with nothing after it; this one stops QEMU through
+// _exit (exit.s) with status 0 if w20 came to 10.
+
+.section .text
+.global _start
+
+_start:                 // where the link starts it, like the other programs here
+_initialize:
+    mov w19, #2
+    mov w21, #5
+
+_add_two_five_times:
+    add w20, w19, w20
+    subs w21, w21, #1
+    b.ne _add_two_five_times
+
+done:
+    cmp w20, #10
+    cset w0, ne         // status 0 if w20 = 10, 1 if not
+    b _exit
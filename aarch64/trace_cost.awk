@@ -0,0 +1,231 @@
+# trace_cost.awk - rvsim's counts for a program that only QEMU can run
+#
+#   awk [-v stop=LABEL] [-v elements=N] -f trace_cost.awk prog.dis qemu.log
+#
+# prog.dis is objdump -d --no-show-raw-insn of the program and qemu.log
+# what QEMU writes with -singlestep -d exec,nochain: one "Trace" line per
+# instruction executed, with its pc. Replaying those pcs against the
+# listing gives what rvsim --profile prints for an rv32 ELF, with the same
+# in-order timing (sim.h's RV_TIMING_DEFAULT):
+#
+#  - one cycle per instruction
+#  - load_use (1) more when it reads a register the instruction just
+#    before it loaded (w6 and x6 are the same register, so are v0 and q0;
+#    ld1 {v0.4s-v3.4s} loads all four)
+#  - taken_branch (2) more when the next pc is not the next instruction:
+#    a branch that went to its target, or any jump, call or return
+#
+# so the same kernel built for rv32 and for AArch64 can be compared
+# instruction for instruction and cycle for cycle (make count). Either
+# ISA's listing works; the two are told apart by objdump's "file format"
+# line.
+#
+# stop         count up to the first time the pc reaches this label, like
+#              rvsim --stop (default done); without it, everything counts
+# elements     also print instructions and cycles per element, like
+#              rvsim --elements
+# load_use, taken_branch  the penalties in cycles (default 1 and 2)
+
+BEGIN {
+    if (stop == "") stop = "done"
+    if (load_use == "") load_use = 1
+    if (taken_branch == "") taken_branch = 2
+}
+
+# ---- the listing -------------------------------------------------------
+
+FNR == NR && /file format/ {
+    aarch64 = $0 ~ /aarch64/
+    next
+}
+
+# 0000000040000000 <_start>:
+FNR == NR && /^[0-9a-f]+ <[^>]+>:$/ {
+    label = $2
+    gsub(/[<>:]/, "", label)
+    address[label] = strip($1)
+    next
+}
+
+#     40000010:	ldr	w6, [x1, x2, lsl #2]
+FNR == NR && /^ *[0-9a-f]+:[ \t]/ {
+    line = $0
+    sub(/[ \t]+\/\/.*/, "", line)       # AArch64 comments
+    sub(/[ \t]+# .*/, "", line)         # RISC-V ones
+    sub(/<[^>]*>/, "", line)            # target labels
+    pc = line
+    sub(/:.*/, "", pc)
+    pc = strip(pc)
+    sub(/^[^:]*:[ \t]*/, "", line)
+    mnemonic = line
+    sub(/[ \t].*/, "", mnemonic)
+    operands = line
+    if (!sub(/^[^ \t]+[ \t]+/, "", operands))
+        operands = ""
+    op[pc] = mnemonic
+    where[pc] = label
+    reads[pc] = " " registers(reads_first(mnemonic) ? operands : after_first(operands)) " "
+    if (is_load(mnemonic)) {
+        loaded = operands
+        sub(/[\[(].*/, "", loaded)      # the registers before the address
+        writes[pc] = registers(loaded)
+    }
+    if (previous_pc != "")
+        fallthrough[previous_pc] = pc
+    previous_pc = pc
+    next
+}
+
+FNR == NR { next }
+
+# ---- the trace ---------------------------------------------------------
+
+# Trace 0: 0x7f0c3c000100 [00000000/0000000040000010/00000000/01000000] loop
+/^Trace/ {
+    pc = $0
+    sub(/^[^[]*\[/, "", pc)
+    split(pc, field, "/")
+    pc = strip(field[2])
+    if (stopped)
+        next
+    if (current != "")
+        retire(current, pc)
+    if ((stop in address) && pc == address[stop]) {
+        stopped = 1
+        current = ""
+        next
+    }
+    current = pc
+}
+
+END {
+    if (current != "")
+        retire(current, "")
+    if (!(stop in address))
+        printf("no label %s: counted everything\n", stop)
+    else if (!stopped)
+        printf("never reached %s: counted everything\n", stop)
+    printf("instructions: %d\n", instructions)
+    printf("cycles:       %d (CPI %.2f)\n", cycles, instructions ? cycles / instructions : 0)
+    printf("loads:        %d\nstores:       %d\n", loads, stores)
+    printf("branches:     %d (%d taken)\n", branches, taken_branches)
+    printf("load-use:     %d stalls\n", stalls)
+    if (elements > 0)
+        printf("per element:  %.2f instructions, %.2f cycles (%d elements)\n",
+               instructions / elements, cycles / elements, elements)
+    printf("\n%-26s %12s %14s %7s %6s\n", "label", "instructions", "cycles", "cycles%", "CPI")
+    for (i = 1; i <= label_count; i++) {
+        l = labels[i]
+        printf("%-26s %12d %14d %6.2f%% %6.2f\n", l, label_instructions[l], label_cycles[l],
+               cycles ? 100 * label_cycles[l] / cycles : 0,
+               label_cycles[l] / label_instructions[l])
+    }
+}
+
+# ---- helpers -----------------------------------------------------------
+
+# pc, executed, then next (empty at the end of the trace)
+function retire(pc, next_pc,    cost, l, r, n, name) {
+    cost = 1
+    if (pending != "") {
+        n = split(pending, name, " ")
+        for (r = 1; r <= n; r++) {
+            if (index(reads[pc], " " name[r] " ")) {
+                cost += load_use
+                stalls++
+                break
+            }
+        }
+    }
+    pending = writes[pc]
+    if (next_pc != "" && next_pc != fallthrough[pc]) {
+        cost += taken_branch
+        taken = 1
+    } else {
+        taken = 0
+    }
+    if (is_branch(op[pc])) {
+        branches++
+        taken_branches += taken
+    }
+    if (is_load(op[pc]))
+        loads++
+    else if (is_store(op[pc]))
+        stores++
+    instructions++
+    cycles += cost
+    l = (pc in where) ? where[pc] : "?"
+    if (!(l in label_instructions))
+        labels[++label_count] = l
+    label_instructions[l]++
+    label_cycles[l] += cost
+}
+
+function strip(hex) {
+    hex = tolower(hex)
+    gsub(/[ \t]/, "", hex)
+    sub(/^0x/, "", hex)
+    sub(/^0+/, "", hex)
+    return hex == "" ? "0" : hex
+}
+
+function is_load(m) {
+    return aarch64 ? m ~ /^(ldr|ldur|ldp|ldnp|ld[1-4]|ldar|ldxr|ldax)/ : m ~ /^l[bhw]u?$/
+}
+
+function is_store(m) {
+    return aarch64 ? m ~ /^(str|stur|stp|stnp|st[1-4]|stlr|stxr|stlx)/ : m ~ /^s[bhw]$/
+}
+
+# Conditional branches only, as rvsim counts them
+function is_branch(m) {
+    return aarch64 ? m ~ /^(b\.|cbn?z|tbn?z)/ : m ~ /^b/
+}
+
+# Instructions whose first operand is a source, not the destination
+function reads_first(m) {
+    if (aarch64)
+        return is_store(m) || is_branch(m) ||
+               m ~ /^(cmp|cmn|tst|ccmp|ccmn|fcmp|br|blr|ret|msr|movk|mla|mls|fmla|fmls|bsl|bit|bif)$/
+    return is_store(m) || is_branch(m) || m ~ /^(jr|jalr|ret)$/
+}
+
+function after_first(operands) {
+    return sub(/^[^,]*,/, "", operands) ? operands : ""
+}
+
+# The register names in operands, one space between each: AArch64's
+# w/x, q/d/s/h/b and v names become rN and vN, vector register ranges are
+# spelt out, and immediates, shifts and the like are dropped
+function registers(operands,    n, token, i, out, t, from, to, range) {
+    n = split(operands, token, /[ \t,()\[\]{}!]+/)
+    out = ""
+    for (i = 1; i <= n; i++) {
+        t = token[i]
+        if (aarch64 && t ~ /^v[0-9]+\.[0-9]*[bhsd]-v[0-9]+/) {
+            split(t, range, "-")
+            from = range[1]
+            to = range[2]
+            sub(/^v/, "", from)
+            sub(/\..*/, "", from)
+            sub(/^v/, "", to)
+            sub(/\..*/, "", to)
+            for (from += 0; from != (to + 1) % 32; from = (from + 1) % 32)
+                out = out " v" from
+            continue
+        }
+        if (aarch64) {
+            if (t ~ /^[wx][0-9]+$/)
+                t = "r" substr(t, 2)
+            else if (t ~ /^[vqdshb][0-9]+(\.[0-9]*[bhsdq])?$/) {
+                sub(/\..*/, "", t)
+                t = "v" substr(t, 2)
+            } else if (t == "wsp") {
+                t = "sp"
+            }
+        }
+        if (t ~ /^[a-z][a-z0-9]*$/)
+            out = out " " t
+    }
+    return substr(out, 2)
+}
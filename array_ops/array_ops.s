@@ -28,7 +28,7 @@
 # Used in lw/sw instructions to access that specific element
 
 # ================================================================
-# Core logic (just 8 instructions in the loop):
+# Core logic (just 8 instructions in the loop; `make cost` counts them):
 # beq - check if done
 # slli - calculate byte offset
 # add - calculate element address
@@ -0,0 +1,59 @@
+# array_ops.s's job (add 1 to every element of my_array) with the RISC-V
+# vector extension (RVV 1.0), for any LENGTH
+#
+# Strip-mining: each pass asks vsetvli for up to a1 elements and gets
+# vl = min(a1, VLMAX) of them, where VLMAX = LMUL * VLEN / 32. With m4
+# (four vector registers per operand) and QEMU's default VLEN of 128 bits
+# that is 16 words per pass. The loop then loads vl words, adds 1 to all
+# of them, stores them back and moves on. The last pass just gets a
+# smaller vl, so no scalar tail loop is needed.
+#
+# 8 instructions per 16 elements = 0.5 per element, against 8 in
+# array_ops.s. make per-element measures it.
+#
+# Build with -march=rv32iv_zicsr. QEMU needs -cpu rv32,v=true (make
+# startqemu-rvv), and the vector unit is off after reset until mstatus.VS
+# is set, so until then every vector instruction traps as illegal.
+#
+# No compressed instructions, even if the -march string has c: rvsim
+# (make per-element, make run-all) only runs 32-bit ones.
+
+# Register Roles
+# a0 - pointer to the next element
+# a1 - elements left
+# t0 - vl: elements this pass
+# t1 - vl * 4 bytes
+# v0-v3 - the elements (one LMUL=4 register group)
+
+.option norvc
+
+# How many elements: make compile-rvv LENGTH=1000 overrides this
+.ifndef LENGTH
+.equ LENGTH, 3
+.endif
+
+.section .data
+my_array:
+    .zero 4 * LENGTH    # LENGTH words of 0
+
+.section .text
+.global _start
+
+_start:
+    li t0, 0x200        # mstatus.VS = Initial: turn the vector unit on
+    csrs mstatus, t0
+    la a0, my_array
+    li a1, LENGTH
+
+loop:
+    vsetvli t0, a1, e32, m4, ta, ma    # t0 = vl = min(a1, 16) 32-bit elements
+    vle32.v v0, (a0)    # v0-v3 = the next vl elements
+    vadd.vi v0, v0, 1   # + 1, all of them at once
+    vse32.v v0, (a0)    # store them back
+    sub a1, a1, t0      # that many fewer left
+    slli t1, t0, 2
+    add a0, a0, t1      # pointer += vl * 4 bytes
+    bnez a1, loop
+
+done:
+    j done              # infinite loop when finished
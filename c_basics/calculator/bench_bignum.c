@@ -0,0 +1,94 @@
+/*
+ * bench_bignum.c - Cost of big-number mode compared to the double path
+ *
+ * For each operand size it times double add/multiply (the existing path),
+ * bignum add, schoolbook multiply and Karatsuba multiply, and checks that
+ * both multiply algorithms agree before reporting.
+ *
+ * Build and run with: make bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void random_digits(char *buf, int digits) {
+    buf[0] = '1' + rand() % 9;
+    for (int i = 1; i < digits; i++)
+        buf[i] = '0' + rand() % 10;
+    buf[digits] = '\0';
+}
+
+// Double the batch size until one batch takes at least 50 ms, so the clock
+// reads do not dominate the fast double operations
+#define TIME_OP(label, op)                                                   \
+    do {                                                                     \
+        long batch = 1;                                                      \
+        double elapsed;                                                      \
+        while (1) {                                                          \
+            double start = now_ns();                                         \
+            for (long i = 0; i < batch; i++) {                               \
+                op;                                                          \
+            }                                                                \
+            elapsed = now_ns() - start;                                      \
+            if (elapsed >= 50e6)                                             \
+                break;                                                       \
+            batch *= 2;                                                      \
+        }                                                                    \
+        printf("  %-22s %14.1f ns/op\n", label, elapsed / batch);           \
+    } while (0)
+
+int main(void) {
+    static const int sizes[] = {9, 90, 900, 9000, 90000};
+    volatile double da = 1.2345678901234567e15, db = 9.876543210987654e14;
+    volatile double dr;
+
+    srand(42);
+    printf("=== Big-number mode vs double path (Karatsuba threshold %d limbs) ===\n",
+           BN_KARATSUBA_THRESHOLD);
+    TIME_OP("double add", dr = da + db);
+    TIME_OP("double multiply", dr = da * db);
+    (void)dr;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int digits = sizes[s];
+        char *buf = malloc(digits + 1);
+        bignum a, b, r1, r2;
+        bn_init(&a);
+        bn_init(&b);
+        bn_init(&r1);
+        bn_init(&r2);
+        random_digits(buf, digits);
+        bn_from_string(&a, buf);
+        random_digits(buf, digits);
+        bn_from_string(&b, buf);
+
+        bn_mul(&r1, &a, &b);
+        bn_mul_schoolbook(&r2, &a, &b);
+        if (bn_cmp(&r1, &r2) != 0) {
+            printf("❌ Karatsuba and schoolbook disagree at %d digits!\n", digits);
+            return 1;
+        }
+
+        printf("\n%d-digit operands (%zu limbs):\n", digits, a.len);
+        TIME_OP("bignum add", bn_add(&r1, &a, &b));
+        TIME_OP("bignum schoolbook mul", bn_mul_schoolbook(&r2, &a, &b));
+        TIME_OP("bignum karatsuba mul", bn_mul(&r1, &a, &b));
+
+        bn_free(&a);
+        bn_free(&b);
+        bn_free(&r1);
+        bn_free(&r2);
+        free(buf);
+    }
+    return 0;
+}
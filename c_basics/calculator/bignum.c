@@ -0,0 +1,534 @@
+/*
+ * bignum.c - Arbitrary-precision integer arithmetic (see bignum.h)
+ *
+ * The mag_* helpers work on raw limb arrays and know nothing about signs;
+ * the bn_* functions handle signs, allocation and aliasing (result may be
+ * the same object as an operand).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bignum.h"
+
+// ---------------------------------------------------------------------------
+// Magnitude helpers (little-endian base 10^9 limb arrays)
+// ---------------------------------------------------------------------------
+
+static size_t mag_trim(const uint32_t *a, size_t n) {
+    while (n > 0 && a[n - 1] == 0)
+        n--;
+    return n;
+}
+
+static int mag_cmp(const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    if (an != bn)
+        return an < bn ? -1 : 1;
+    for (size_t i = an; i-- > 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// r = a + b, r needs max(an, bn) + 1 limbs; r may alias a or b
+static size_t mag_add(uint32_t *r, const uint32_t *a, size_t an,
+                      const uint32_t *b, size_t bn) {
+    if (an < bn) {
+        const uint32_t *t = a; a = b; b = t;
+        size_t tn = an; an = bn; bn = tn;
+    }
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        uint32_t s = a[i] + b[i] + carry;
+        carry = s >= BN_BASE;
+        r[i] = carry ? s - BN_BASE : s;
+    }
+    for (; i < an; i++) {
+        uint32_t s = a[i] + carry;
+        carry = s >= BN_BASE;
+        r[i] = carry ? s - BN_BASE : s;
+    }
+    r[i] = carry;
+    return mag_trim(r, an + 1);
+}
+
+// r = a - b, requires a >= b; r may alias a
+static size_t mag_sub(uint32_t *r, const uint32_t *a, size_t an,
+                      const uint32_t *b, size_t bn) {
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        uint32_t sub = b[i] + borrow;
+        borrow = a[i] < sub;
+        r[i] = borrow ? a[i] + BN_BASE - sub : a[i] - sub;
+    }
+    for (; i < an; i++) {
+        if (!borrow) {
+            // no more borrow: the rest of a passes through untouched
+            if (r != a)
+                memcpy(r + i, a + i, (an - i) * sizeof(uint32_t));
+            break;
+        }
+        borrow = a[i] == 0;
+        r[i] = borrow ? BN_BASE - 1 : a[i] - 1;
+    }
+    return mag_trim(r, an);
+}
+
+// r[off..] += x; r has room for the carry (caller guarantees the sum fits)
+static void mag_add_at(uint32_t *r, size_t off, const uint32_t *x, size_t xn) {
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < xn; i++) {
+        uint32_t s = r[off + i] + x[i] + carry;
+        carry = s >= BN_BASE;
+        r[off + i] = carry ? s - BN_BASE : s;
+    }
+    for (; carry; i++) {
+        uint32_t s = r[off + i] + 1;
+        carry = s >= BN_BASE;
+        r[off + i] = carry ? 0 : s;
+    }
+}
+
+// r = a * b, writes all an + bn limbs of r; r must not alias a or b
+static void mag_mul_school(uint32_t *r, const uint32_t *a, size_t an,
+                           const uint32_t *b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    for (size_t i = 0; i < an; i++) {
+        uint64_t ai = a[i];
+        uint64_t carry = 0;
+        if (ai == 0)
+            continue;
+        for (size_t j = 0; j < bn; j++) {
+            uint64_t cur = r[i + j] + ai * b[j] + carry;
+            carry = cur / BN_BASE;
+            r[i + j] = (uint32_t)(cur % BN_BASE);
+        }
+        r[i + bn] = (uint32_t)carry;
+    }
+}
+
+static int mag_mul(uint32_t *r, const uint32_t *a, size_t an,
+                   const uint32_t *b, size_t bn);
+
+// Unbalanced operands: multiply b by slices of a that are as long as b
+static int mag_mul_sliced(uint32_t *r, const uint32_t *a, size_t an,
+                          const uint32_t *b, size_t bn) {
+    uint32_t *part = malloc((2 * bn) * sizeof(uint32_t));
+    if (part == NULL)
+        return -1;
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    for (size_t off = 0; off < an; off += bn) {
+        size_t sn = an - off < bn ? an - off : bn;
+        if (mag_mul(part, a + off, sn, b, bn) != 0) {
+            free(part);
+            return -1;
+        }
+        mag_add_at(r, off, part, mag_trim(part, sn + bn));
+    }
+    free(part);
+    return 0;
+}
+
+// Karatsuba: a*b = z2*B^2m + z1*B^m + z0 with
+// z1 = (a0 + a1)(b0 + b1) - z0 - z2, i.e. three half-size products not four
+static int mag_mul(uint32_t *r, const uint32_t *a, size_t an,
+                   const uint32_t *b, size_t bn) {
+    if (an < BN_KARATSUBA_THRESHOLD || bn < BN_KARATSUBA_THRESHOLD) {
+        mag_mul_school(r, a, an, b, bn);
+        return 0;
+    }
+    if (an >= 2 * bn)
+        return mag_mul_sliced(r, a, an, b, bn);
+    if (bn >= 2 * an)
+        return mag_mul_sliced(r, b, bn, a, an);
+
+    size_t m = (an > bn ? an : bn) / 2;
+    size_t a0n = mag_trim(a, m), a1n = an - m;
+    size_t b0n = mag_trim(b, m), b1n = bn - m;
+    const uint32_t *a1 = a + m, *b1 = b + m;
+
+    // one scratch block: sa | sb | z0 | z1 | z2
+    size_t san = m + 2, sbn = m + 2;   // a1 may be m + 1 limbs long
+    size_t need = san + sbn + 2 * m + (san + sbn) + (a1n + b1n);
+    uint32_t *scratch = malloc(need * sizeof(uint32_t));
+    if (scratch == NULL)
+        return -1;
+    uint32_t *sa = scratch;
+    uint32_t *sb = sa + san;
+    uint32_t *z0 = sb + sbn;
+    uint32_t *z1 = z0 + 2 * m;
+    uint32_t *z2 = z1 + san + sbn;
+
+    san = mag_add(sa, a, a0n, a1, a1n);
+    sbn = mag_add(sb, b, b0n, b1, b1n);
+
+    int err = mag_mul(z0, a, a0n, b, b0n);
+    err |= mag_mul(z2, a1, a1n, b1, b1n);
+    err |= mag_mul(z1, sa, san, sb, sbn);
+    if (err) {
+        free(scratch);
+        return -1;
+    }
+    size_t z0n = mag_trim(z0, a0n + b0n);
+    size_t z2n = mag_trim(z2, a1n + b1n);
+    size_t z1n = mag_trim(z1, san + sbn);
+    z1n = mag_sub(z1, z1, z1n, z0, z0n);
+    z1n = mag_sub(z1, z1, z1n, z2, z2n);
+
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    memcpy(r, z0, z0n * sizeof(uint32_t));
+    mag_add_at(r, 2 * m, z2, z2n);
+    mag_add_at(r, m, z1, z1n);
+    free(scratch);
+    return 0;
+}
+
+// q = a / d for a single-limb divisor, returns the remainder; q may alias a
+static uint32_t mag_divmod_small(uint32_t *q, const uint32_t *a, size_t an,
+                                 uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = an; i-- > 0;) {
+        uint64_t cur = rem * BN_BASE + a[i];
+        q[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+    return (uint32_t)rem;
+}
+
+// r = a * m for a single-limb multiplier, r needs an + 1 limbs
+static size_t mag_mul_small(uint32_t *r, const uint32_t *a, size_t an,
+                            uint32_t m) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < an; i++) {
+        uint64_t cur = (uint64_t)a[i] * m + carry;
+        r[i] = (uint32_t)(cur % BN_BASE);
+        carry = cur / BN_BASE;
+    }
+    r[an] = (uint32_t)carry;
+    return an + 1;
+}
+
+// ---------------------------------------------------------------------------
+// bignum objects
+// ---------------------------------------------------------------------------
+
+void bn_init(bignum *n) {
+    n->sign = 0;
+    n->len = 0;
+    n->cap = 0;
+    n->limbs = NULL;
+}
+
+void bn_free(bignum *n) {
+    free(n->limbs);
+    bn_init(n);
+}
+
+static int bn_reserve(bignum *n, size_t cap) {
+    if (n->cap >= cap)
+        return 0;
+    uint32_t *limbs = realloc(n->limbs, cap * sizeof(uint32_t));
+    if (limbs == NULL)
+        return -1;
+    n->limbs = limbs;
+    n->cap = cap;
+    return 0;
+}
+
+// Replace dst with src, taking ownership of src's storage
+static void bn_move(bignum *dst, bignum *src) {
+    free(dst->limbs);
+    *dst = *src;
+    bn_init(src);
+}
+
+static void bn_normalize(bignum *n) {
+    n->len = mag_trim(n->limbs, n->len);
+    if (n->len == 0)
+        n->sign = 0;
+}
+
+int bn_copy(bignum *dst, const bignum *src) {
+    if (dst == src)
+        return 0;
+    if (bn_reserve(dst, src->len) != 0)
+        return -1;
+    if (src->len > 0)
+        memcpy(dst->limbs, src->limbs, src->len * sizeof(uint32_t));
+    dst->len = src->len;
+    dst->sign = src->sign;
+    return 0;
+}
+
+int bn_from_long(bignum *n, long long value) {
+    // work in unsigned so LLONG_MIN does not overflow when negated
+    unsigned long long mag = value < 0 ? 0ULL - (unsigned long long)value
+                                       : (unsigned long long)value;
+    if (bn_reserve(n, 3) != 0)
+        return -1;
+    n->len = 0;
+    while (mag > 0) {
+        n->limbs[n->len++] = (uint32_t)(mag % BN_BASE);
+        mag /= BN_BASE;
+    }
+    n->sign = value < 0 ? -1 : (value > 0);
+    return 0;
+}
+
+int bn_from_string(bignum *n, const char *str) {
+    const char *p = str;
+    int sign = 1;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p == '+' || *p == '-') {
+        sign = *p == '-' ? -1 : 1;
+        p++;
+    }
+    const char *digits = p;
+    while (*p >= '0' && *p <= '9')
+        p++;
+    size_t ndigits = (size_t)(p - digits);
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    if (ndigits == 0 || *p != '\0')
+        return -1;
+
+    if (bn_reserve(n, ndigits / BN_BASE_DIGITS + 1) != 0)
+        return -1;
+    n->len = 0;
+    // walk the digits from the least significant end, nine at a time
+    for (size_t end = ndigits; end > 0;) {
+        size_t start = end > BN_BASE_DIGITS ? end - BN_BASE_DIGITS : 0;
+        uint32_t limb = 0;
+        for (size_t i = start; i < end; i++)
+            limb = limb * 10 + (uint32_t)(digits[i] - '0');
+        n->limbs[n->len++] = limb;
+        end = start;
+    }
+    n->sign = sign;
+    bn_normalize(n);
+    return 0;
+}
+
+char *bn_to_string(const bignum *n) {
+    char *out = malloc(n->len * BN_BASE_DIGITS + 3);
+    if (out == NULL)
+        return NULL;
+    if (n->len == 0) {
+        strcpy(out, "0");
+        return out;
+    }
+    char *p = out;
+    if (n->sign < 0)
+        *p++ = '-';
+    p += sprintf(p, "%u", n->limbs[n->len - 1]);
+    for (size_t i = n->len - 1; i-- > 0;)
+        p += sprintf(p, "%09u", n->limbs[i]);
+    return out;
+}
+
+void bn_print(const bignum *n) {
+    char *s = bn_to_string(n);
+    if (s == NULL) {
+        printf("❌ ERROR: Out of memory!\n");
+        return;
+    }
+    printf("%s", s);
+    free(s);
+}
+
+int bn_cmp(const bignum *a, const bignum *b) {
+    if (a->sign != b->sign)
+        return a->sign < b->sign ? -1 : 1;
+    int c = mag_cmp(a->limbs, a->len, b->limbs, b->len);
+    return a->sign < 0 ? -c : c;
+}
+
+// result = a + (b_sign * |b|), the shared body of bn_add and bn_sub
+static int bn_add_signed(bignum *result, const bignum *a, const bignum *b,
+                         int b_sign) {
+    if (b_sign == 0)
+        return bn_copy(result, a);
+
+    bignum tmp;
+    bn_init(&tmp);
+    size_t cap = (a->len > b->len ? a->len : b->len) + 1;
+    if (bn_reserve(&tmp, cap) != 0)
+        return -1;
+    if (a->sign == 0 || a->sign == b_sign) {
+        tmp.len = mag_add(tmp.limbs, a->limbs, a->len, b->limbs, b->len);
+        tmp.sign = b_sign;
+    } else {
+        int c = mag_cmp(a->limbs, a->len, b->limbs, b->len);
+        if (c >= 0) {
+            tmp.len = mag_sub(tmp.limbs, a->limbs, a->len, b->limbs, b->len);
+            tmp.sign = a->sign;
+        } else {
+            tmp.len = mag_sub(tmp.limbs, b->limbs, b->len, a->limbs, a->len);
+            tmp.sign = b_sign;
+        }
+    }
+    bn_normalize(&tmp);
+    bn_move(result, &tmp);
+    return 0;
+}
+
+int bn_add(bignum *result, const bignum *a, const bignum *b) {
+    return bn_add_signed(result, a, b, b->sign);
+}
+
+int bn_sub(bignum *result, const bignum *a, const bignum *b) {
+    return bn_add_signed(result, a, b, -b->sign);
+}
+
+static int bn_mul_with(bignum *result, const bignum *a, const bignum *b,
+                       int use_karatsuba) {
+    if (a->sign == 0 || b->sign == 0) {
+        result->len = 0;
+        result->sign = 0;
+        return 0;
+    }
+    bignum tmp;
+    bn_init(&tmp);
+    if (bn_reserve(&tmp, a->len + b->len) != 0)
+        return -1;
+    if (use_karatsuba) {
+        if (mag_mul(tmp.limbs, a->limbs, a->len, b->limbs, b->len) != 0) {
+            bn_free(&tmp);
+            return -1;
+        }
+    } else {
+        mag_mul_school(tmp.limbs, a->limbs, a->len, b->limbs, b->len);
+    }
+    tmp.len = a->len + b->len;
+    tmp.sign = a->sign * b->sign;
+    bn_normalize(&tmp);
+    bn_move(result, &tmp);
+    return 0;
+}
+
+int bn_mul(bignum *result, const bignum *a, const bignum *b) {
+    return bn_mul_with(result, a, b, 1);
+}
+
+int bn_mul_schoolbook(bignum *result, const bignum *a, const bignum *b) {
+    return bn_mul_with(result, a, b, 0);
+}
+
+// Knuth TAOCP vol. 2, 4.3.1 Algorithm D, in base 10^9.
+// Quotient truncates toward zero and the remainder takes the sign of a,
+// matching C's / and % on int.
+int bn_divmod(bignum *quotient, bignum *remainder, const bignum *a,
+              const bignum *b) {
+    if (b->sign == 0)
+        return -1;
+
+    bignum q, r;
+    bn_init(&q);
+    bn_init(&r);
+
+    if (mag_cmp(a->limbs, a->len, b->limbs, b->len) < 0) {
+        // |a| < |b|: quotient 0, remainder a
+        if (bn_copy(&r, a) != 0)
+            return -1;
+    } else if (b->len == 1) {
+        if (bn_reserve(&q, a->len) != 0 || bn_reserve(&r, 1) != 0) {
+            bn_free(&q);
+            bn_free(&r);
+            return -1;
+        }
+        r.limbs[0] = mag_divmod_small(q.limbs, a->limbs, a->len, b->limbs[0]);
+        q.len = a->len;
+        r.len = 1;
+        q.sign = a->sign * b->sign;
+        r.sign = a->sign;
+    } else {
+        size_t n = b->len, m = a->len - b->len;
+        uint32_t *u = malloc((a->len + 1 + n + 1) * sizeof(uint32_t));
+        if (u == NULL || bn_reserve(&q, m + 1) != 0 || bn_reserve(&r, n) != 0) {
+            free(u);
+            bn_free(&q);
+            bn_free(&r);
+            return -1;
+        }
+        uint32_t *v = u + a->len + 1;
+
+        // D1: scale so the top divisor limb is at least BASE / 2
+        uint32_t d = BN_BASE / (b->limbs[n - 1] + 1);
+        mag_mul_small(u, a->limbs, a->len, d);
+        mag_mul_small(v, b->limbs, n, d);   // v[n] ends up zero, unused
+
+        uint64_t vtop = v[n - 1], vnext = v[n - 2];
+        for (size_t j = m + 1; j-- > 0;) {
+            // D3: estimate qhat from the top two limbs, correct at most twice
+            uint64_t num = (uint64_t)u[j + n] * BN_BASE + u[j + n - 1];
+            uint64_t qhat = num / vtop, rhat = num % vtop;
+            while (qhat >= BN_BASE ||
+                   qhat * vnext > rhat * BN_BASE + u[j + n - 2]) {
+                qhat--;
+                rhat += vtop;
+                if (rhat >= BN_BASE)
+                    break;
+            }
+
+            // D4: u[j..j+n] -= qhat * v
+            uint64_t carry = 0;
+            int64_t borrow = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t p = qhat * v[i] + carry;
+                carry = p / BN_BASE;
+                int64_t t = (int64_t)u[i + j] - (int64_t)(p % BN_BASE) - borrow;
+                borrow = t < 0;
+                u[i + j] = (uint32_t)(t < 0 ? t + BN_BASE : t);
+            }
+            int64_t t = (int64_t)u[j + n] - (int64_t)carry - borrow;
+
+            if (t < 0) {
+                // D6: qhat was one too large, add v back
+                u[j + n] = (uint32_t)(t + BN_BASE);
+                qhat--;
+                uint32_t c = 0;
+                for (size_t i = 0; i < n; i++) {
+                    uint32_t s = u[i + j] + v[i] + c;
+                    c = s >= BN_BASE;
+                    u[i + j] = c ? s - BN_BASE : s;
+                }
+                u[j + n] = (u[j + n] + c) % BN_BASE;
+            } else {
+                u[j + n] = (uint32_t)t;
+            }
+            q.limbs[j] = (uint32_t)qhat;
+        }
+
+        // D8: unscale the remainder
+        mag_divmod_small(r.limbs, u, n, d);
+        free(u);
+        q.len = m + 1;
+        r.len = n;
+        q.sign = a->sign * b->sign;
+        r.sign = a->sign;
+    }
+
+    bn_normalize(&q);
+    bn_normalize(&r);
+    if (quotient != NULL)
+        bn_move(quotient, &q);
+    if (remainder != NULL)
+        bn_move(remainder, &r);
+    bn_free(&q);
+    bn_free(&r);
+    return 0;
+}
+
+int bn_abs(bignum *result, const bignum *a) {
+    if (bn_copy(result, a) != 0)
+        return -1;
+    if (result->sign < 0)
+        result->sign = 1;
+    return 0;
+}
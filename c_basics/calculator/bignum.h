@@ -0,0 +1,51 @@
+/*
+ * bignum.h - Arbitrary-precision integers for the calculator's big-number mode
+ *
+ * Numbers are stored sign-magnitude as little-endian limbs in base 10^9, so
+ * every limb holds exactly nine decimal digits and printing needs no division.
+ * Multiplication switches from schoolbook to Karatsuba once both operands
+ * have at least BN_KARATSUBA_THRESHOLD limbs.
+ *
+ * All functions returning int use the calculator convention:
+ * 0 on success, -1 on error (bad input, division by zero, out of memory).
+ */
+
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BN_BASE 1000000000u
+#define BN_BASE_DIGITS 9
+
+// Limb count at which bn_mul switches to Karatsuba (override with -D)
+#ifndef BN_KARATSUBA_THRESHOLD
+#define BN_KARATSUBA_THRESHOLD 32
+#endif
+
+typedef struct {
+    int sign;          // -1, 0 or +1 (0 only for the value zero)
+    size_t len;        // limbs in use, no leading zero limbs
+    size_t cap;        // limbs allocated
+    uint32_t *limbs;   // limbs[0] is the least significant
+} bignum;
+
+void bn_init(bignum *n);
+void bn_free(bignum *n);
+int bn_copy(bignum *dst, const bignum *src);
+int bn_from_long(bignum *n, long long value);
+int bn_from_string(bignum *n, const char *str);
+char *bn_to_string(const bignum *n);   // caller frees
+void bn_print(const bignum *n);
+
+int bn_cmp(const bignum *a, const bignum *b);
+int bn_add(bignum *result, const bignum *a, const bignum *b);
+int bn_sub(bignum *result, const bignum *a, const bignum *b);
+int bn_mul(bignum *result, const bignum *a, const bignum *b);
+int bn_mul_schoolbook(bignum *result, const bignum *a, const bignum *b);
+int bn_divmod(bignum *quotient, bignum *remainder, const bignum *a,
+              const bignum *b);
+int bn_abs(bignum *result, const bignum *a);
+
+#endif
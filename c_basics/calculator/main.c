@@ -1,16 +1,22 @@
 /* 
  * main.c - Main entry point for calculator program
- * Features: 2, 8, 14, 17, 20
+ * Features: 2, 8, 14, 17, 19, 20
  */
 
  #include <stdio.h>
  #include <string.h>
  #include <float.h>
+ #include <limits.h>
+ #include <math.h>
+ #include <stdlib.h>
+
+ #include "bignum.h"
+ #include "fast_input.h"
 
  int clear_input_buffer() {
     int c;
     static int clear_count = 0;  // Feature 3: Static variable to count clears
-    while ((c = getchar()) != '\n' && c != EOF);
+    while ((c = fast_getchar()) != '\n' && c != EOF);
     clear_count++;
     return clear_count;
 }
@@ -25,27 +31,74 @@
     printf("➗ d) Division\n");
     printf("📈 e) Circle Area\n");
     printf("|x| f) Absolute Integer Value\n");
+    printf("🔢 b) Toggle Big-Number Mode (exact integers)\n");
     printf("📊 h) Show History\n");
     printf("🚪 q) Quit\n");
     printf("Enter choice: ");
-    scanf(" %c", &choice);
-    clear_input_buffer();  // Clear the newline left by scanf
+    fast_scan_char(&choice);
+    clear_input_buffer();  // Clear the newline left by the scan
     return choice;
  }
 
 void get_number(char prompt[], double *number) {
     printf(prompt);
-    scanf("%lf", number);
-    clear_input_buffer();  // Clear the newline left by scanf
+    fast_scan_double(number);
+    clear_input_buffer();  // Clear the newline left by the scan
+}
+
+// Feature 19: One line of any length, in a buffer that doubles until the
+// newline fits; NULL at end of input (or out of memory). Caller frees.
+char *read_whole_line(void) {
+    size_t size = 256, used = 0;
+    char *line = malloc(size);
+    if (line == NULL)
+        return NULL;
+    while (fast_read_line(line + used, (int)(size - used)) != NULL) {
+        used += strlen(line + used);
+        if (used > 0 && line[used - 1] == '\n')
+            return line;
+        if (used == size - 1) {
+            char *bigger = realloc(line, size * 2);
+            if (bigger == NULL) {
+                free(line);
+                return NULL;
+            }
+            line = bigger;
+            size *= 2;
+        }
+    }
+    if (used > 0)
+        return line;        // the last line, with no newline before EOF
+    free(line);
+    return NULL;
+}
+
+// Feature 19: Big-number mode reads whole lines so any number of digits fits
+void get_big_number(char prompt[], bignum *number) {
+    while (1) {
+        printf("%s", prompt);
+        char *line = read_whole_line();
+        if (line == NULL) {
+            bn_from_long(number, 0);
+            return;
+        }
+        int status = bn_from_string(number, line);
+        free(line);
+        if (status == 0) {
+            return;
+        }
+        printf("❌ ERROR: Big-number mode takes whole numbers only, please try again!\n");
+    }
 }
 
 int add_numbers(double a, double b, double *result) {
-    if (*result < a || *result < b) {
-        printf("❌ ERROR: Overflow! Result is too large!\n");
+    *result = a + b;
+    // a double only overflows to infinity, so check after the add
+    if (isinf(*result) && !isinf(a) && !isinf(b)) {
+        printf("❌ ERROR: Overflow! Result is too large, try big-number mode (b)!\n");
         *result = 0;
         return -1;
     }
-    *result = a + b;
     return 0;
 }
 
@@ -70,17 +123,68 @@ int divide_numbers(double a, double b, double *result) {
 
 unsigned int absolute_value(int number) {
     // Feature 6: Unsigned integer operations
-    if (number > 4294967295 || number < -4294967295){
-        printf("❌ ERROR: Number is too large or small for unsigned int!\n");
-        return 0;
-    }
-
+    // Negate in unsigned arithmetic so INT_MIN maps to 2147483648 instead of
+    // overflowing; every int magnitude fits in an unsigned int.
     if (number < 0) {
-        return (unsigned int)(-number);
+        return 0u - (unsigned int)number;
     }
     return (unsigned int)number;
 }
 
+// Feature 19: Exact integer arithmetic for the big-number mode
+int big_operation(char choice) {
+    bignum a, b, result, remainder;
+    int status = 0;
+    bn_init(&a);
+    bn_init(&b);
+    bn_init(&result);
+    bn_init(&remainder);
+
+    get_big_number("Enter first number: ", &a);
+    if (choice != 'f') {
+        get_big_number("Enter second number: ", &b);
+    }
+    switch (choice) {
+        case 'a':
+            status = bn_add(&result, &a, &b);
+            break;
+        case 's':
+            status = bn_sub(&result, &a, &b);
+            break;
+        case 'm':
+            status = bn_mul(&result, &a, &b);
+            break;
+        case 'd':
+            if (b.sign == 0) {
+                printf("❌ ERROR: Division by zero is undefined!\n");
+                status = -1;
+                break;
+            }
+            status = bn_divmod(&result, &remainder, &a, &b);
+            break;
+        case 'f':
+            status = bn_abs(&result, &a);
+            break;
+    }
+    if (status == 0) {
+        printf("Result: ");
+        bn_print(&result);
+        if (choice == 'd' && remainder.sign != 0) {
+            printf(" remainder ");
+            bn_print(&remainder);
+        }
+        printf("\n");
+    } else if (choice != 'd') {
+        printf("❌ ERROR: Out of memory!\n");
+    }
+
+    bn_free(&a);
+    bn_free(&b);
+    bn_free(&result);
+    bn_free(&remainder);
+    return status;
+}
+
 
 
 double circle_area(double radius) {
@@ -103,18 +207,29 @@ double circle_area(double radius) {
     printf("└─────────────┴──────────┴─────────────────┴──────────────────┘\n");
     printf("💡 Tip: The calculator will automatically detect overflow and suggest better data types!\n");
     printf("Press any key to continue to the main menu...\n");
-    getchar();  // Wait for user to press a key
+    fast_getchar();  // Wait for user to press a key
 
  }
 
  int main() {
      memory_info();
-     char choice;
+     char choice = '\0';
+     int big_mode = 0;
      while (choice != 'q') {
         double number1;
         double number2;
         double result;
         choice = choose_operation();
+        if (choice == 'b') {
+            big_mode = !big_mode;
+            printf("Big-number mode %s\n", big_mode ? "ON 🔢" : "OFF");
+            continue;
+        }
+        if (big_mode && (choice == 'a' || choice == 's' || choice == 'm' ||
+                         choice == 'd' || choice == 'f')) {
+            big_operation(choice);
+            continue;
+        }
         if (choice == 'a' || choice == 's' || choice == 'm' || choice == 'd') {
             get_number("Enter first number: ", &number1);
             get_number("Enter second number: ", &number2);
@@ -144,6 +259,10 @@ double circle_area(double radius) {
                 break;
             case 'f':
                 get_number("Enter integer number: ", &number1);
+                if (number1 < INT_MIN || number1 > INT_MAX) {
+                    printf("❌ ERROR: Number does not fit in an int, try big-number mode (b)!\n");
+                    break;
+                }
                 printf("Result: %u\n", absolute_value((int)number1));
                 break;
             case 'q':
@@ -0,0 +1,123 @@
+/*
+ * bench_fast_input.c - scanf/strtod versus the fast_input reader and parser
+ *
+ * Writes a file of random numbers (a mix of short hand-typed values and
+ * full 17-digit doubles), then reads it back:
+ *   1. scanf("%lf") on stdin, as the calculators used to
+ *   2. fast_scan_double on the same stdin (block reads + Eisel-Lemire)
+ *   3. strtod versus fast_strtod on the in-memory text (parsing only)
+ * Every pass must produce bit-identical values or the benchmark fails.
+ *
+ * Build and run with: make bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fast_input.h"
+
+#define COUNT 4000000
+#define BENCH_FILE "bench_numbers.txt"
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Order-sensitive checksum of the exact bit patterns read
+static uint64_t mix(uint64_t sum, double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return (sum ^ bits) * 0x100000001B3ULL;
+}
+
+static void report(const char *label, double seconds, size_t bytes) {
+    printf("  %-26s %8.1f ns/number %8.1f MB/s\n", label,
+           seconds * 1e9 / COUNT, bytes / seconds / 1e6);
+}
+
+int main(void) {
+    FILE *out = fopen(BENCH_FILE, "w");
+    if (out == NULL) {
+        perror(BENCH_FILE);
+        return 1;
+    }
+    for (int i = 0; i < COUNT; i++) {
+        uint64_t r = next_random();
+        if (r & 1) {
+            fprintf(out, "%.2f\n", (double)(r >> 40) / 100.0);
+        } else {
+            fprintf(out, "%.17g\n", (double)(r >> 11) * 0x1p-53 * 1e6 - 5e5);
+        }
+    }
+    size_t bytes = (size_t)ftell(out);
+    fclose(out);
+
+    printf("=== Parsing %d numbers (%.1f MB) ===\n", COUNT, bytes / 1e6);
+
+    // 1. scanf on stdin
+    if (freopen(BENCH_FILE, "r", stdin) == NULL) {
+        perror(BENCH_FILE);
+        return 1;
+    }
+    uint64_t scanf_sum = 0;
+    double d, start = now_s();
+    while (scanf("%lf", &d) == 1)
+        scanf_sum = mix(scanf_sum, d);
+    report("scanf(\"%lf\")", now_s() - start, bytes);
+
+    // 2. fast_scan_double on the same descriptor, rewound
+    lseek(STDIN_FILENO, 0, SEEK_SET);
+    uint64_t fast_sum = 0;
+    start = now_s();
+    while (fast_scan_double(&d) == 1)
+        fast_sum = mix(fast_sum, d);
+    report("fast_scan_double", now_s() - start, bytes);
+
+    // 3. parsing only, from memory
+    char *text = malloc(bytes + 1);
+    FILE *in = fopen(BENCH_FILE, "r");
+    if (text == NULL || in == NULL || fread(text, 1, bytes, in) != bytes) {
+        printf("❌ could not reload %s\n", BENCH_FILE);
+        return 1;
+    }
+    fclose(in);
+    text[bytes] = '\0';
+
+    uint64_t strtod_sum = 0, fast_strtod_sum = 0;
+    char *p = text, *end;
+    start = now_s();
+    for (int i = 0; i < COUNT; i++, p = end)
+        strtod_sum = mix(strtod_sum, strtod(p, &end));
+    report("strtod", now_s() - start, bytes);
+
+    p = text;
+    start = now_s();
+    for (int i = 0; i < COUNT; i++, p = end)
+        fast_strtod_sum = mix(fast_strtod_sum, fast_strtod(p, &end));
+    report("fast_strtod", now_s() - start, bytes);
+
+    free(text);
+    remove(BENCH_FILE);
+
+    if (fast_sum != scanf_sum || fast_strtod_sum != strtod_sum ||
+        strtod_sum != scanf_sum) {
+        printf("❌ Results differ from the C library!\n");
+        return 1;
+    }
+    printf("✅ All passes read bit-identical values\n");
+    return 0;
+}
@@ -0,0 +1,464 @@
+/*
+ * fast_input.c - Buffered stdin reader and fast float parsing (see fast_input.h)
+ *
+ * Reading: stdin is pulled in with read(2) one large block at a time instead
+ * of one getchar() per character.
+ *
+ * Scanning: the scan_*_token helpers follow glibc's vfscanf rules character
+ * for character, collecting the same token and consuming the same input on
+ * both success and failure. The token is then converted with fast_strtod /
+ * fast_strtof, and like glibc the scan fails only when nothing of the token
+ * converts (so "1e" reads as 1 and "100ergs" as 100).
+ *
+ * Converting: numbers with at most 19 significant digits take Clinger's
+ * exact fast path when both the digits and the power of ten are exact in
+ * floating point, otherwise the Eisel-Lemire algorithm: multiply the
+ * normalized digits by a 128-bit power of five and read the rounded
+ * mantissa straight off the top bits. When the discarded bits are too
+ * close to a rounding boundary to decide, or the result would be
+ * subnormal/overflow, hex, inf/nan or longer than 19 digits, we fall back
+ * to the C library, so results always match strtod/strtof bit for bit.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fast_input.h"
+#include "pow5_table.h"
+
+// C-locale character classes, inlined: the <ctype.h> versions go through
+// the locale tables on every character
+static inline int is_digit(int c) { return c >= '0' && c <= '9'; }
+static inline int is_space(int c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+static inline int to_lower(int c) { return c >= 'A' && c <= 'Z' ? c + 32 : c; }
+static inline int is_xdigit(int c) {
+    return is_digit(c) || (to_lower(c) >= 'a' && to_lower(c) <= 'f');
+}
+
+// ---------------------------------------------------------------------------
+// Block reader
+// ---------------------------------------------------------------------------
+
+static unsigned char in_buf[FAST_INPUT_BUFFER_SIZE];
+static size_t in_pos = 0, in_end = 0;
+static int in_eof = 0;
+
+static int refill(void) {
+    if (in_eof)
+        return 0;
+    // stdio flushes line-buffered stdout before blocking on stdin; do the
+    // same so prompts printed without a newline appear
+    fflush(stdout);
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, in_buf, sizeof(in_buf));
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        in_eof = 1;
+        return 0;
+    }
+    in_pos = 0;
+    in_end = (size_t)n;
+    return 1;
+}
+
+static inline int peek(void) {
+    if (in_pos == in_end && !refill())
+        return EOF;
+    return in_buf[in_pos];
+}
+
+int fast_getchar(void) {
+    int c = peek();
+    if (c != EOF)
+        in_pos++;
+    return c;
+}
+
+// Skip whitespace and return the next character without consuming it
+static int skip_space(void) {
+    int c;
+    while ((c = peek()) != EOF && is_space(c))
+        in_pos++;
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// Token buffer
+// ---------------------------------------------------------------------------
+
+static char *tok = NULL;
+static size_t tok_len = 0, tok_cap = 0;
+
+static void tok_grow(void) {
+    size_t cap = tok_cap ? tok_cap * 2 : 64;
+    char *grown = realloc(tok, cap);
+    if (grown == NULL) {
+        fprintf(stderr, "fast_input: out of memory\n");
+        exit(1);
+    }
+    tok = grown;
+    tok_cap = cap;
+}
+
+static inline void tok_push(int c) {
+    if (tok_len + 1 >= tok_cap)
+        tok_grow();
+    tok[tok_len++] = (char)c;
+    tok[tok_len] = '\0';
+}
+
+// Consume and collect the expected letters; glibc consumes the first
+// character that does not match too, so we do the same
+static int match_word(const char *word) {
+    for (; *word; word++) {
+        int c = fast_getchar();
+        if (c == EOF || to_lower(c) != *word)
+            return 0;
+        tok_push(c);
+    }
+    return 1;
+}
+
+// Collect a scanf %f/%lf token. Returns 1 if there is something to
+// convert, 0 on a matching failure and EOF on end of input.
+static int scan_real_token(void) {
+    tok_len = 0;
+    int c = skip_space();
+    if (c == EOF)
+        return EOF;
+
+    int got_sign = 0;
+    if (c == '-' || c == '+') {
+        tok_push(c);
+        in_pos++;
+        got_sign = 1;
+        if ((c = peek()) == EOF)
+            return 0;
+    }
+
+    if (to_lower(c) == 'n') {
+        return match_word("nan");
+    }
+    if (to_lower(c) == 'i') {
+        if (!match_word("inf"))
+            return 0;
+        c = peek();
+        if (c != EOF && to_lower(c) == 'i')
+            return match_word("inity");
+        return 1;
+    }
+
+    int hex = 0, got_digit = 0, got_dot = 0, got_e = 0;
+    char exp_char = 'e';
+    if (c == '0') {
+        tok_push(c);
+        in_pos++;
+        c = peek();
+        if (c != EOF && to_lower(c) == 'x') {
+            tok_push(c);
+            in_pos++;
+            hex = 1;
+            exp_char = 'p';
+            c = peek();
+        } else {
+            got_digit = 1;
+        }
+    }
+
+    while (c != EOF) {
+        if (is_digit(c) || (hex && !got_e && is_xdigit(c))) {
+            tok_push(c);
+            got_digit = 1;
+        } else if (got_e && tok[tok_len - 1] == exp_char && (c == '-' || c == '+')) {
+            tok_push(c);
+        } else if (got_digit && !got_e && to_lower(c) == exp_char) {
+            tok_push(exp_char);
+            got_e = got_dot = 1;
+        } else if (!got_dot && c == '.') {
+            tok_push(c);
+            got_dot = 1;
+        } else {
+            break;   // not part of the number, left in the input
+        }
+        in_pos++;
+        c = peek();
+    }
+
+    if ((int)tok_len == got_sign || (hex && (int)tok_len == 2 + got_sign))
+        return 0;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Decimal to binary conversion
+// ---------------------------------------------------------------------------
+
+#define MAX_FAST_DIGITS 19   // every 19-digit decimal fits in a uint64_t
+
+static const double exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static const float exact_pow10f[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+// Split a plain decimal into digits w and exponent q (value = w * 10^q) the
+// way strtod reads it. Returns 0 for anything the fast path does not handle
+// (hex, inf/nan, no digits, more than 19 significant digits).
+static int parse_decimal(const char *str, int *negative, uint64_t *w, int *q,
+                         const char **end) {
+    const char *p = str;
+    while (is_space(*p))
+        p++;
+    *negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        p++;
+    if (!is_digit(*p) && *p != '.')
+        return 0;
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        return 0;
+
+    uint64_t mant = 0;
+    int digits = 0, seen_digit = 0;
+    long exp10 = 0;
+
+    while (*p == '0') {
+        seen_digit = 1;
+        p++;
+    }
+    for (; is_digit(*p); p++) {
+        if (++digits > MAX_FAST_DIGITS)
+            return 0;
+        mant = mant * 10 + (uint64_t)(*p - '0');
+        seen_digit = 1;
+    }
+    if (*p == '.') {
+        p++;
+        if (digits == 0) {
+            // zeros right after the point only move the exponent
+            for (; *p == '0'; p++) {
+                exp10--;
+                seen_digit = 1;
+            }
+        }
+        for (; is_digit(*p); p++) {
+            if (++digits > MAX_FAST_DIGITS)
+                return 0;
+            mant = mant * 10 + (uint64_t)(*p - '0');
+            exp10--;
+            seen_digit = 1;
+        }
+    }
+    if (!seen_digit)
+        return 0;
+
+    // an exponent only counts if at least one digit follows e[sign]
+    if (*p == 'e' || *p == 'E') {
+        const char *e = p + 1;
+        int exp_negative = *e == '-';
+        if (*e == '-' || *e == '+')
+            e++;
+        if (is_digit(*e)) {
+            long value = 0;
+            for (; is_digit(*e); e++) {
+                if (value < 100000)   // far outside any double's range
+                    value = value * 10 + (*e - '0');
+            }
+            exp10 += exp_negative ? -value : value;
+            p = e;
+        }
+    }
+
+    *w = mant;
+    *q = (int)exp10;
+    *end = p;
+    return 1;
+}
+
+// Eisel-Lemire: round w * 10^q to a mant_bits-bit mantissa (hidden bit
+// included). Returns 0 when the result cannot be decided from the 128-bit
+// product or is not a normal number.
+static int eisel_lemire(uint64_t w, int q, int mant_bits, int bias,
+                        int max_biased, uint64_t *mantissa, int *biased_exp) {
+    if (q < POW5_MIN || q > POW5_MAX)
+        return 0;
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+    const uint64_t *t = pow5_128[q - POW5_MIN];
+    unsigned __int128 high_prod = (unsigned __int128)w * t[0];
+    unsigned __int128 low_prod = (unsigned __int128)w * t[1];
+    uint64_t hi = (uint64_t)(high_prod >> 64);
+    uint64_t lo = (uint64_t)high_prod;
+    uint64_t carry_in = (uint64_t)(low_prod >> 64);
+    lo += carry_in;
+    if (lo < carry_in)
+        hi++;
+
+    // The product is exact to within two units of lo. Below the mantissa
+    // and round bit, the remaining bits ("sticky") must be clear of zero
+    // (an exact tie or exact value) and of all ones (a possible carry).
+    int upper = (int)(hi >> 63);
+    int shift = 62 - mant_bits + upper;
+    uint64_t mask = (1ULL << shift) - 1;
+    uint64_t sticky = hi & mask;
+    if ((sticky == 0 && lo < 2) || (sticky == mask && lo >= UINT64_MAX - 1))
+        return 0;
+
+    uint64_t m = hi >> shift;       // mantissa plus round bit
+    m = (m >> 1) + (m & 1);         // sticky is non-zero: round bit decides
+    // floor(q * log2(10)) computed as (217706 * q) >> 16
+    int e = (int)(((217706LL * q) >> 16) + 63 + upper - lz + bias);
+    if (m >> mant_bits) {           // rounding carried into a new bit
+        m >>= 1;
+        e++;
+    }
+    if (e < 1 || e > max_biased)
+        return 0;
+    *mantissa = m;
+    *biased_exp = e;
+    return 1;
+}
+
+double fast_strtod(const char *str, char **endptr) {
+    int negative, q;
+    uint64_t w;
+    const char *end;
+
+    if (parse_decimal(str, &negative, &w, &q, &end)) {
+        double d;
+        int done = 1;
+        if (w == 0) {
+            d = 0.0;
+        } else if (w <= (1ULL << 53) && q >= -22 && q <= 22) {
+            // Clinger: w and 10^|q| are both exact doubles, one rounding
+            d = (double)w;
+            d = q < 0 ? d / exact_pow10[-q] : d * exact_pow10[q];
+        } else {
+            uint64_t m;
+            int e;
+            done = eisel_lemire(w, q, 53, 1023, 2046, &m, &e);
+            if (done) {
+                uint64_t bits = ((uint64_t)e << 52) | (m & ((1ULL << 52) - 1));
+                memcpy(&d, &bits, sizeof(d));
+            }
+        }
+        if (done) {
+            if (endptr != NULL)
+                *endptr = (char *)end;
+            return negative ? -d : d;
+        }
+    }
+    return strtod(str, endptr);
+}
+
+float fast_strtof(const char *str, char **endptr) {
+    int negative, q;
+    uint64_t w;
+    const char *end;
+
+    if (parse_decimal(str, &negative, &w, &q, &end)) {
+        float f;
+        int done = 1;
+        if (w == 0) {
+            f = 0.0f;
+        } else if (w <= (1ULL << 24) && q >= -10 && q <= 10) {
+            f = (float)w;
+            f = q < 0 ? f / exact_pow10f[-q] : f * exact_pow10f[q];
+        } else {
+            uint64_t m;
+            int e;
+            done = eisel_lemire(w, q, 24, 127, 254, &m, &e);
+            if (done) {
+                uint32_t bits = ((uint32_t)e << 23) | (uint32_t)(m & ((1u << 23) - 1));
+                memcpy(&f, &bits, sizeof(f));
+            }
+        }
+        if (done) {
+            if (endptr != NULL)
+                *endptr = (char *)end;
+            return negative ? -f : f;
+        }
+    }
+    return strtof(str, endptr);
+}
+
+// ---------------------------------------------------------------------------
+// scanf replacements
+// ---------------------------------------------------------------------------
+
+int fast_scan_double(double *number) {
+    int status = scan_real_token();
+    if (status != 1)
+        return status;
+    char *end;
+    double d = fast_strtod(tok, &end);
+    if (end == tok)
+        return 0;
+    *number = d;
+    return 1;
+}
+
+int fast_scan_float(float *number) {
+    int status = scan_real_token();
+    if (status != 1)
+        return status;
+    char *end;
+    float f = fast_strtof(tok, &end);
+    if (end == tok)
+        return 0;
+    *number = f;
+    return 1;
+}
+
+int fast_scan_int(int *number) {
+    tok_len = 0;
+    int c = skip_space();
+    if (c == EOF)
+        return EOF;
+    if (c == '-' || c == '+') {
+        tok_push(c);
+        in_pos++;
+    }
+    while ((c = peek()) != EOF && is_digit(c)) {
+        tok_push(c);
+        in_pos++;
+    }
+    if (tok_len == 0 || (tok_len == 1 && (tok[0] == '-' || tok[0] == '+')))
+        return 0;
+    // glibc converts with strtol and narrows to int, so do the same
+    *number = (int)strtol(tok, NULL, 10);
+    return 1;
+}
+
+int fast_scan_char(char *choice) {
+    int c = skip_space();
+    if (c == EOF)
+        return EOF;
+    in_pos++;
+    *choice = (char)c;
+    return 1;
+}
+
+char *fast_read_line(char *line, int size) {
+    int n = 0;
+    while (n < size - 1) {
+        int c = fast_getchar();
+        if (c == EOF)
+            break;
+        line[n++] = (char)c;
+        if (c == '\n')
+            break;
+    }
+    if (n == 0)
+        return NULL;
+    line[n] = '\0';
+    return line;
+}
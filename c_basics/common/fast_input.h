@@ -0,0 +1,35 @@
+/*
+ * fast_input.h - Buffered stdin reader and fast float parsing for the calculators
+ *
+ * The fast_scan_* functions are drop-in replacements for the scanf calls the
+ * calculators make. They accept and reject exactly what glibc's scanf does
+ * (including what is left in the input after a match or a failure), and
+ * return the same values: 1 on success, 0 on a matching failure and EOF
+ * when input ends before anything was read.
+ *
+ * Input is read from file descriptor 0 in FAST_INPUT_BUFFER_SIZE blocks, so
+ * once a program uses these functions it must not mix in scanf/getchar on
+ * stdin. stdout is flushed before every block read so prompts still show.
+ */
+
+#ifndef FAST_INPUT_H
+#define FAST_INPUT_H
+
+#ifndef FAST_INPUT_BUFFER_SIZE
+#define FAST_INPUT_BUFFER_SIZE (64 * 1024)
+#endif
+
+// stdin replacements
+int fast_getchar(void);                       // getchar()
+int fast_scan_double(double *number);         // scanf("%lf", number)
+int fast_scan_float(float *number);           // scanf("%f", number)
+int fast_scan_int(int *number);               // scanf("%d", number)
+int fast_scan_char(char *choice);             // scanf(" %c", choice)
+char *fast_read_line(char *line, int size);   // fgets(line, size, stdin)
+
+// strtod/strtof replacements: correctly rounded (Eisel-Lemire with a
+// strtod fallback for the rare cases it cannot decide)
+double fast_strtod(const char *str, char **endptr);
+float fast_strtof(const char *str, char **endptr);
+
+#endif
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Generate pow5_table.h, the 128-bit powers of five used by fast_input.c.
+
+Entry q holds 5^q scaled by a power of two so it lies in [2^127, 2^128):
+truncated for q >= 0 and rounded up for q < 0, split into high and low
+64-bit halves. Run from this directory: python3 gen_pow5_table.py
+"""
+
+POW5_MIN = -342
+POW5_MAX = 308
+
+
+def entry(q):
+    if q >= 0:
+        v = 5 ** q
+        while v < (1 << 127):
+            v <<= 1
+        while v >= (1 << 128):
+            v >>= 1
+        return v
+    p = 5 ** -q
+    z = p.bit_length()          # smallest z with 2^z > 5^-q
+    v = -(-(1 << (127 + z)) // p)  # ceil(2^(127+z) / 5^-q)
+    assert (1 << 127) <= v < (1 << 128)
+    return v
+
+
+def main():
+    lines = [
+        "/*",
+        " * pow5_table.h - 128-bit normalized powers of five for fast_input.c",
+        " *",
+        " * Generated by gen_pow5_table.py, do not edit by hand.",
+        " */",
+        "",
+        "#ifndef POW5_TABLE_H",
+        "#define POW5_TABLE_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define POW5_MIN (%d)" % POW5_MIN,
+        "#define POW5_MAX %d" % POW5_MAX,
+        "",
+        "static const uint64_t pow5_128[][2] = {",
+    ]
+    for q in range(POW5_MIN, POW5_MAX + 1):
+        v = entry(q)
+        lines.append("    {0x%016xULL, 0x%016xULL}, // 5^%d" %
+                     (v >> 64, v & ((1 << 64) - 1), q))
+    lines += ["};", "", "#endif", ""]
+    with open("pow5_table.h", "w") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,201 @@
+/*
+ * bench_classify.c - run.c's is_prime / is_palindrome_num versus batch classify
+ *
+ * 1. Build a sieve up to INT_MAX and check it against run.c's is_prime on
+ *    every number below 2M, a random sample and the values around INT_MAX.
+ *    Miller-Rabin is checked against the sieve on the same values and
+ *    against known 64-bit primes and strong pseudoprimes.
+ * 2. Classify an array of random ints: run.c per number (on a sample, it
+ *    is too slow for the whole array), sieve lookups and Miller-Rabin
+ *    only. Then 64-bit Miller-Rabin, and palindromes old versus new.
+ *
+ *   ./bench_classify.exe [elements] [threads]    default 100M, one per CPU
+ *
+ * Build and run with: make bench_classify
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "classify.h"
+#include "run.h"
+
+#define DEFAULT_ELEMENTS 100000000
+#define EXHAUSTIVE_LIMIT 2000000
+#define REFERENCE_SAMPLE 200000
+#define U64_SAMPLE 1000000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void report(const char *label, double seconds, size_t count) {
+    printf("  %-34s %9.2f ns/number %9.1f M numbers/s\n", label, seconds * 1e9 / count,
+           count / seconds / 1e6);
+}
+
+static int check_value(const prime_sieve *sieve, int v) {
+    int expected = is_prime(v);
+    if (v >= 0 && prime_sieve_test(sieve, (uint32_t)v) != expected) {
+        printf("❌ sieve says %d for %d, is_prime says %d\n", !expected, v, expected);
+        return 0;
+    }
+    if (is_prime_u64((uint64_t)(v < 0 ? 0 : v)) != expected) {
+        printf("❌ Miller-Rabin says %d for %d, is_prime says %d\n", !expected, v, expected);
+        return 0;
+    }
+    return 1;
+}
+
+static int check_u64(void) {
+    static const struct {
+        uint64_t n;
+        int prime;
+    } known[] = {
+        {4294967291ULL, 1},                 // largest 32-bit prime
+        {4294967297ULL, 0},                 // 2^32 + 1 = 641 * 6700417
+        {2305843009213693951ULL, 1},        // 2^61 - 1
+        {18446744073709551557ULL, 1},       // largest 64-bit prime
+        {18446744073709551615ULL, 0},
+        {3215031751ULL, 0},                 // strong pseudoprime to 2, 3, 5, 7
+        {3825123056546413051ULL, 0},        // strong pseudoprime to 2..23
+        {1000000000000000003ULL, 1},
+        {999999999999999989ULL, 1},
+        {4611686014132420609ULL, 0},        // (2^31 - 1)^2
+    };
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++) {
+        if (is_prime_u64(known[i].n) != known[i].prime) {
+            printf("❌ Miller-Rabin is wrong for %llu\n", (unsigned long long)known[i].n);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t elements = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_ELEMENTS;
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+    printf("=== Sieve up to INT_MAX ===\n");
+    prime_sieve sieve;
+    double start = now_s();
+    if (!prime_sieve_init(&sieve, INT_MAX, threads)) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    double built = now_s() - start;
+    printf("  built in %.2f s (%.0f MiB, %.1f M numbers/s)\n", built,
+           ((size_t)sieve.limit / 128 + 1) * 8.0 / (1 << 20), sieve.limit / built / 1e6);
+
+    for (int v = -10; v < EXHAUSTIVE_LIMIT; v++) {
+        if (!check_value(&sieve, v))
+            return 1;
+    }
+    for (int v = INT_MAX - 100000; v < INT_MAX; v++) {
+        if (!check_value(&sieve, v))
+            return 1;
+    }
+    if (!check_value(&sieve, INT_MAX) || !check_value(&sieve, INT_MIN) || !check_u64())
+        return 1;
+    printf("  ✅ matches is_prime on 0..%d, the top 100K ints and known 64-bit values\n",
+           EXHAUSTIVE_LIMIT);
+
+    int *values = malloc(elements * sizeof(int));
+    unsigned char *flags = malloc(elements);
+    unsigned char *check = malloc(elements);
+    if (values == NULL || flags == NULL || check == NULL) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < elements; i++)
+        values[i] = (int)(next_random() >> 33);
+
+    printf("\n=== Primes in %zu random ints ===\n", elements);
+    size_t sample = elements < REFERENCE_SAMPLE ? elements : REFERENCE_SAMPLE;
+    int sample_primes = 0;
+    start = now_s();
+    for (size_t i = 0; i < sample; i++)
+        sample_primes += is_prime(values[i]);
+    report("run.c is_prime (sample)", now_s() - start, sample);
+
+    start = now_s();
+    classify_primes(&sieve, values, elements, flags, threads);
+    report("classify_primes (sieve)", now_s() - start, elements);
+
+    start = now_s();
+    classify_primes(NULL, values, elements, check, threads);
+    report("classify_primes (Miller-Rabin)", now_s() - start, elements);
+
+    size_t primes = 0;
+    int flagged_in_sample = 0;
+    for (size_t i = 0; i < elements; i++) {
+        primes += flags[i];
+        if (flags[i] != check[i]) {
+            printf("❌ sieve and Miller-Rabin disagree on %d\n", values[i]);
+            return 1;
+        }
+        if (i < sample)
+            flagged_in_sample += flags[i];
+    }
+    if (flagged_in_sample != sample_primes) {
+        printf("❌ classify_primes disagrees with is_prime on the sample\n");
+        return 1;
+    }
+    printf("  %zu primes (%.2f%%), all methods agree\n", primes, 100.0 * primes / elements);
+
+    uint64_t odd[1024];
+    size_t found = 0;
+    start = now_s();
+    for (size_t i = 0; i < U64_SAMPLE; i++) {
+        if ((i & 1023) == 0) {
+            for (int j = 0; j < 1024; j++)
+                odd[j] = next_random() | 1;
+        }
+        found += (size_t)is_prime_u64(odd[i & 1023]);
+    }
+    report("is_prime_u64 (random odd 64-bit)", now_s() - start, U64_SAMPLE);
+    printf("  %zu primes among them (%.2f%%, 2/ln(2^64) = 4.51%%)\n", found,
+           100.0 * found / U64_SAMPLE);
+
+    printf("\n=== Palindromes in %zu random ints ===\n", elements);
+    start = now_s();
+    for (size_t i = 0; i < elements; i++)
+        check[i] = (unsigned char)is_palindrome_num(values[i]);
+    report("run.c is_palindrome_num", now_s() - start, elements);
+
+    start = now_s();
+    classify_palindromes(values, elements, flags, threads);
+    report("classify_palindromes", now_s() - start, elements);
+    for (size_t i = 0; i < elements; i++) {
+        if (flags[i] != check[i]) {
+            printf("❌ is_palindrome_fast disagrees on %d\n", values[i]);
+            return 1;
+        }
+    }
+    for (int v = -1000; v < EXHAUSTIVE_LIMIT; v++) {
+        if (is_palindrome_fast(v) != is_palindrome_num(v)) {
+            printf("❌ is_palindrome_fast disagrees on %d\n", v);
+            return 1;
+        }
+    }
+    printf("✅ All results agree with run.c\n");
+
+    free(values);
+    free(flags);
+    free(check);
+    prime_sieve_free(&sieve);
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * bench_processor.c - PRACTICE 6's per-number Processor versus batched graphs
+ *
+ * 1. Check processor_apply (with and without a batch function, in place,
+ *    with thresholds) against processor_apply_one, and graph runs on 1 to
+ *    4 threads against applying the same chains one number at a time.
+ * 2. Time one call per number against one call per block, then a graph
+ *    with two chains over the same input on pools of growing size, and
+ *    print the registry's per-processor counters.
+ *
+ *   ./bench_processor.exe [elements]    default 10M
+ *
+ * Build and run with: make bench_processor
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "processor.h"
+#include "run.h"
+#include "transforms.h"
+
+#define DEFAULT_ELEMENTS 10000000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void report(const char *label, double seconds, size_t count) {
+    printf("  %-36s %8.2f ns/number %9.1f M numbers/s\n", label, seconds * 1e9 / count,
+           count / seconds / 1e6);
+}
+
+static int square(int n) {
+    return (int)((unsigned)n * (unsigned)n);
+}
+
+static void square_array(const int *in, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = square(in[i]);
+}
+
+enum { FACTORIAL_RUN_C, FACTORIAL_BATCH, COUNT_BITS, FIBONACCI, SQUARE, SQUARE_BATCH };
+
+static const Processor processors[] = {
+    [FACTORIAL_RUN_C] = {factorial, "Factorial Calculator", 10, NULL},
+    [FACTORIAL_BATCH] = {factorial_fast, "Factorial (batch)", 10, factorial_array},
+    [COUNT_BITS] = {count_bits_fast, "Count bits", INT_MAX, count_bits_array},
+    [FIBONACCI] = {fibonacci_fast, "Fibonacci", 46, fibonacci_array},
+    [SQUARE] = {square, "Square", INT_MAX, NULL},
+    [SQUARE_BATCH] = {square, "Square (batch)", 1000, square_array},
+};
+#define PROCESSOR_COUNT (sizeof(processors) / sizeof(processors[0]))
+
+// Two chains from one input: factorial -> count_bits and fibonacci -> square.
+// Only the two ends are written out.
+static int build_graph(processor_graph *graph, int *leaves) {
+    int factorial_node = processor_graph_add(graph, FACTORIAL_BATCH, PROCESSOR_GRAPH_INPUT);
+    leaves[0] = processor_graph_add(graph, COUNT_BITS, factorial_node);
+    int fibonacci_node = processor_graph_add(graph, FIBONACCI, PROCESSOR_GRAPH_INPUT);
+    leaves[1] = processor_graph_add(graph, SQUARE_BATCH, fibonacci_node);
+    return factorial_node >= 0 && leaves[0] >= 0 && fibonacci_node >= 0 && leaves[1] >= 0;
+}
+
+// What the graph computes, one number at a time
+static void chains_one_by_one(const int *in, size_t n, int *first, int *second) {
+    for (size_t i = 0; i < n; i++) {
+        first[i] = processor_apply_one(&processors[COUNT_BITS],
+                                       processor_apply_one(&processors[FACTORIAL_RUN_C], in[i]));
+        second[i] = processor_apply_one(&processors[SQUARE_BATCH],
+                                        processor_apply_one(&processors[FIBONACCI], in[i]));
+    }
+}
+
+static int check(processor_registry *registry) {
+    static int in[20000], out[20000], expected[20000], first[20000], second[20000];
+    for (int round = 0; round < 200; round++) {
+        size_t n = next_random() % 20000;
+        for (size_t i = 0; i < n; i++)
+            in[i] = (int)(next_random() % 64) - 8;
+        for (int id = 0; id < (int)PROCESSOR_COUNT; id++) {
+            for (size_t i = 0; i < n; i++)
+                expected[i] = processor_apply_one(&processors[id], in[i]);
+            processor_apply(registry, id, in, out, n);
+            if (memcmp(out, expected, n * sizeof(int)) != 0) {
+                printf("❌ processor_apply(\"%s\") is wrong\n", processors[id].description);
+                return 0;
+            }
+            memcpy(out, in, n * sizeof(int));
+            processor_apply(registry, id, out, out, n);
+            if (memcmp(out, expected, n * sizeof(int)) != 0) {
+                printf("❌ processor_apply(\"%s\") in place is wrong\n", processors[id].description);
+                return 0;
+            }
+        }
+
+        processor_graph graph;
+        processor_graph_init(&graph, registry);
+        int leaves[2];
+        if (!build_graph(&graph, leaves))
+            return 0;
+        int *outputs[4] = {NULL, NULL, NULL, NULL};
+        outputs[leaves[0]] = out;
+        outputs[leaves[1]] = expected;
+        chains_one_by_one(in, n, first, second);
+        for (int threads = 1; threads <= 4; threads++) {
+            processor_pool *pool = processor_pool_create(threads);
+            int ran = pool != NULL && processor_graph_run(&graph, pool, in, n, outputs);
+            processor_pool_destroy(pool);
+            if (!ran || memcmp(out, first, n * sizeof(int)) != 0 ||
+                memcmp(expected, second, n * sizeof(int)) != 0) {
+                printf("❌ graph on %d threads disagrees with the one-by-one chains\n", threads);
+                return 0;
+            }
+        }
+        processor_graph_free(&graph);
+    }
+    if (processor_find(registry, "Fibonacci") != FIBONACCI || processor_find(registry, "nope") != -1) {
+        printf("❌ processor_find is wrong\n");
+        return 0;
+    }
+    return 1;
+}
+
+static void print_stats(const processor_registry *registry) {
+    printf("\n  %-22s %10s %12s %10s\n", "processor", "calls", "elements", "ns/elem");
+    for (int id = 0; id < (int)registry->count; id++) {
+        processor_stats stats;
+        processor_stats_get(registry, id, &stats);
+        if (stats.elements == 0)
+            continue;
+        printf("  %-22s %10llu %12llu %10.2f\n", registry->processors[id].description,
+               (unsigned long long)stats.calls, (unsigned long long)stats.elements,
+               (double)stats.nanoseconds / stats.elements);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_ELEMENTS;
+
+    processor_registry registry;
+    processor_registry_init(&registry);
+    for (size_t i = 0; i < PROCESSOR_COUNT; i++) {
+        if (processor_register(&registry, &processors[i]) != (int)i) {
+            printf("❌ out of memory\n");
+            return 1;
+        }
+    }
+
+    printf("=== Checking against processor_apply_one ===\n");
+    if (!check(&registry))
+        return 1;
+    printf("  ✅ apply, in place, thresholds and graphs on 1-4 threads\n");
+    processor_stats_reset(&registry);
+
+    int *in = malloc(n * sizeof(int));
+    int *first = malloc(n * sizeof(int));
+    int *second = malloc(n * sizeof(int));
+    int *expected_first = malloc(n * sizeof(int));
+    int *expected_second = malloc(n * sizeof(int));
+    if (in == NULL || first == NULL || second == NULL || expected_first == NULL ||
+        expected_second == NULL) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++)
+        in[i] = (int)(next_random() % 50);
+    memset(second, 0, n * sizeof(int));     // keep page faults out of the timings
+
+    printf("\n=== Factorial over %zu numbers (threshold 10) ===\n", n);
+    double start = now_s();
+    for (size_t i = 0; i < n; i++)
+        first[i] = processor_apply_one(&processors[FACTORIAL_RUN_C], in[i]);
+    report("run.c factorial, one call per number", now_s() - start, n);
+    start = now_s();
+    processor_apply(&registry, FACTORIAL_BATCH, in, second, n);
+    report("factorial_array, one call per block", now_s() - start, n);
+    if (memcmp(first, second, n * sizeof(int)) != 0) {
+        printf("❌ results differ\n");
+        return 1;
+    }
+
+    printf("\n=== Graph: factorial -> count_bits, fibonacci -> square ===\n");
+    start = now_s();
+    chains_one_by_one(in, n, expected_first, expected_second);
+    report("one number at a time", now_s() - start, n);
+
+    processor_graph graph;
+    processor_graph_init(&graph, &registry);
+    int leaves[2];
+    if (!build_graph(&graph, leaves)) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    int *outputs[4] = {NULL, NULL, NULL, NULL};
+    outputs[leaves[0]] = first;
+    outputs[leaves[1]] = second;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        processor_pool *pool = processor_pool_create(threads);
+        if (pool == NULL) {
+            printf("❌ out of memory\n");
+            return 1;
+        }
+        memset(first, 0, n * sizeof(int));
+        start = now_s();
+        int ran = processor_graph_run(&graph, pool, in, n, outputs);
+        double t = now_s() - start;
+        processor_pool_destroy(pool);
+        if (!ran || memcmp(first, expected_first, n * sizeof(int)) != 0 ||
+            memcmp(second, expected_second, n * sizeof(int)) != 0) {
+            printf("❌ graph results differ on %d threads\n", threads);
+            return 1;
+        }
+        char label[48];
+        snprintf(label, sizeof(label), "graph, %d thread%s%s", threads, threads > 1 ? "s" : "",
+                 threads > cpus ? " (more than CPUs)" : "");
+        report(label, t, n);
+    }
+    print_stats(&registry);
+    printf("✅ All results agree\n");
+
+    processor_graph_free(&graph);
+    processor_registry_free(&registry);
+    free(in);
+    free(first);
+    free(second);
+    free(expected_first);
+    free(expected_second);
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * bench_simd_string.c - run.c's string helpers versus simd_string
+ *
+ * 1. Fuzz: every implementation this CPU supports is checked against the
+ *    run.c version on random strings of random length and alignment, and
+ *    the bytes around the string must be left alone.
+ * 2. Benchmark: each transform runs over a multi-megabyte string, once per
+ *    implementation, and we report the best of REPETITIONS runs in GB/s.
+ *
+ *   ./bench_simd_string.exe           fuzz, then benchmark
+ *   ./bench_simd_string.exe --test    fuzz only
+ *
+ * Build and run with: make bench (or make test)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "run.h"
+#include "simd_string.h"
+
+#define FUZZ_CASES 200000
+#define FUZZ_MAX_LEN 300
+#define GUARD 64               // bytes checked after each fuzz string
+#define BENCH_BYTES (16 << 20) // well past the last-level cache
+#define REPETITIONS 7
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Mostly text, with every other non-zero byte mixed in
+static char random_char(void) {
+    static const char text[] = "aeiouAEIOU bcdfgBCDFGxyzXYZ`{@[.,";
+    uint64_t r = next_random();
+    if (r & 3)
+        return text[(r >> 8) % (sizeof(text) - 1)];
+    return (char)((r >> 8) % 255 + 1);
+}
+
+typedef char *(*string_fn)(char *);
+
+typedef struct {
+    const char *name;
+    string_fn reference;
+    string_fn fast;
+} string_case;
+
+static const string_case string_cases[] = {
+    {"reverse", reverse_string, simd_reverse_string},
+    {"uppercase", uppercase_string, simd_uppercase_string},
+    {"remove_vowels", remove_vowels, simd_remove_vowels},
+};
+#define CASE_COUNT (int)(sizeof(string_cases) / sizeof(string_cases[0]))
+
+// Length-based entry points, in the same order as string_cases
+static size_t fast_n(int which, char *buf, size_t len) {
+    switch (which) {
+    case 0:
+        simd_reverse(buf, len);
+        return len;
+    case 1:
+        simd_uppercase(buf, len);
+        return len;
+    default:
+        return simd_remove_vowels_n(buf, len);
+    }
+}
+
+static int fuzz(enum simd_string_isa isa) {
+    static char input[FUZZ_MAX_LEN + 1];
+    static char expected[FUZZ_MAX_LEN + 1];
+    static _Alignas(64) char actual[64 + FUZZ_MAX_LEN + 1 + GUARD];
+
+    for (int n = 0; n < FUZZ_CASES; n++) {
+        size_t len = next_random() % (FUZZ_MAX_LEN + 1);
+        size_t offset = next_random() % 64;
+        int which = n % CASE_COUNT;
+        const string_case *c = &string_cases[which];
+        for (size_t i = 0; i < len; i++)
+            input[i] = random_char();
+        input[len] = '\0';
+
+        memcpy(expected, input, len + 1);
+        c->reference(expected);
+        size_t expected_len = strlen(expected);
+
+        // NUL-terminated drop-in
+        char *s = actual + offset;
+        memset(actual, 0x5A, sizeof(actual));
+        memcpy(s, input, len + 1);
+        if (c->fast(s) != s || strcmp(s, expected) != 0) {
+            printf("❌ %s %s differs (length %zu, offset %zu)\n",
+                   simd_string_isa_name(isa), c->name, len, offset);
+            return 0;
+        }
+        for (size_t i = 0; i < sizeof(actual); i++) {
+            if ((i < offset || i > offset + len) && actual[i] != 0x5A) {
+                printf("❌ %s %s wrote outside the string (length %zu, offset %zu)\n",
+                       simd_string_isa_name(isa), c->name, len, offset);
+                return 0;
+            }
+        }
+
+        // length-based, no terminator to rely on
+        memset(actual, 0x5A, sizeof(actual));
+        memcpy(s, input, len);
+        size_t got = fast_n(which, s, len);
+        if (got != expected_len || memcmp(s, expected, got) != 0) {
+            printf("❌ %s %s (length-based) differs (length %zu, offset %zu)\n",
+                   simd_string_isa_name(isa), c->name, len, offset);
+            return 0;
+        }
+        for (size_t i = 0; i < sizeof(actual); i++) {
+            if ((i < offset || i >= offset + len) && actual[i] != 0x5A) {
+                printf("❌ %s %s (length-based) wrote outside the buffer (length %zu, offset %zu)\n",
+                       simd_string_isa_name(isa), c->name, len, offset);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Best time for fn over a fresh copy of text, which is restored untimed
+static double best_time(string_fn fn, char *work, const char *text) {
+    double best = 1e30;
+    for (int r = 0; r < REPETITIONS; r++) {
+        memcpy(work, text, BENCH_BYTES + 1);
+        double start = now_s();
+        fn(work);
+        double elapsed = now_s() - start;
+        if (elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    int test_only = argc > 1 && strcmp(argv[1], "--test") == 0;
+    enum simd_string_isa fastest = simd_string_active();
+
+    printf("=== Fuzzing against run.c (%d cases per implementation) ===\n", FUZZ_CASES);
+    for (int isa = 0; isa < SIMD_STRING_ISA_COUNT; isa++) {
+        if (!simd_string_use((enum simd_string_isa)isa)) {
+            printf("  %-8s not supported on this CPU, skipped\n", simd_string_isa_name(isa));
+            continue;
+        }
+        if (!fuzz((enum simd_string_isa)isa))
+            return 1;
+        printf("  %-8s ✅\n", simd_string_isa_name(isa));
+    }
+    if (test_only)
+        return 0;
+
+    char *text = malloc(BENCH_BYTES + 1);
+    char *work = malloc(BENCH_BYTES + 1);
+    if (text == NULL || work == NULL) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < BENCH_BYTES; i++)
+        text[i] = random_char();
+    text[BENCH_BYTES] = '\0';
+
+    printf("\n=== %d MiB string, best of %d runs (default: %s) ===\n",
+           BENCH_BYTES >> 20, REPETITIONS, simd_string_isa_name(fastest));
+    printf("  %-14s %-8s %10s %10s\n", "transform", "version", "GB/s", "speedup");
+    for (int c = 0; c < CASE_COUNT; c++) {
+        double reference = best_time(string_cases[c].reference, work, text);
+        printf("  %-14s %-8s %10.2f %9.1fx\n", string_cases[c].name, "run.c",
+               BENCH_BYTES / reference / 1e9, 1.0);
+        for (int isa = 0; isa < SIMD_STRING_ISA_COUNT; isa++) {
+            if (!simd_string_use((enum simd_string_isa)isa))
+                continue;
+            double t = best_time(string_cases[c].fast, work, text);
+            printf("  %-14s %-8s %10.2f %9.1fx\n", "", simd_string_isa_name(isa),
+                   BENCH_BYTES / t / 1e9, reference / t);
+        }
+    }
+    simd_string_use(fastest);
+    free(text);
+    free(work);
+    return 0;
+}
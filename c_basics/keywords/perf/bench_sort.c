@@ -0,0 +1,182 @@
+/*
+ * bench_sort.c - run.c's comparator sorting versus the sort library
+ *
+ * For each size from 1K up to the limit (powers of ten), random full-range
+ * ints are sorted by:
+ *   qsort(compare_ascending)          the C library with run.c's comparator
+ *   bubble_sort(compare_ascending)    the run.c exercise, up to 10K only
+ *   sort_introsort(compare_ascending)
+ *   sort_ints, sort_radix, sort_parallel
+ * and random non-negative ints by digit sum:
+ *   bubble_sort(compare_by_digit_sum), up to 10K only
+ *   sort_introsort(compare_by_digit_sum)
+ *   sort_by_digit_sum (keys computed once)
+ * Every ascending result must match qsort's. Digit-sum results must be
+ * ordered by digit sum and, where bubble sort ran, match it exactly (both
+ * are stable).
+ *
+ *   ./bench_sort.exe [max_elements]     default 100M (1B needs about 28 GB)
+ *
+ * Build and run with: make bench_sort
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "run.h"
+#include "sort.h"
+
+#define DEFAULT_MAX_ELEMENTS 100000000
+#define BUBBLE_MAX 10000
+#define SMALL 100000            // sizes up to this are timed best of 5
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int qsort_ascending(const void *a, const void *b) {
+    return compare_ascending(*(const int *)a, *(const int *)b);
+}
+
+static size_t size;
+static int *input, *work;
+static int failed;
+
+static void run_bubble_ascending(void) { bubble_sort(work, (int)size, compare_ascending); }
+static void run_qsort(void) { qsort(work, size, sizeof(int), qsort_ascending); }
+static void run_introsort(void) { sort_introsort(work, size, compare_ascending); }
+static void run_sort_ints(void) { sort_ints(work, size); }
+static void run_radix(void) { failed |= !sort_radix(work, size); }
+static void run_parallel(void) { failed |= !sort_parallel(work, size, 0); }
+// Fixed thread counts, so the split and merge are checked on any host
+// (one thread per CPU is just sort_radix on a 1-CPU machine). sort_parallel
+// still takes at most one thread per 4096 elements, so 10000 and up.
+static void run_parallel_2(void) { failed |= !sort_parallel(work, size, 2); }
+static void run_parallel_3(void) { failed |= !sort_parallel(work, size, 3); }
+static void run_parallel_4(void) { failed |= !sort_parallel(work, size, 4); }
+static void run_bubble_digit_sum(void) { bubble_sort(work, (int)size, compare_by_digit_sum); }
+static void run_introsort_digit_sum(void) { sort_introsort(work, size, compare_by_digit_sum); }
+static void run_by_digit_sum(void) { failed |= !sort_by_digit_sum(work, size); }
+
+// Best time for run on a fresh copy of input (the copy is not timed)
+static double time_sort(void (*run)(void)) {
+    int reps = size <= SMALL ? 5 : 1;
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        memcpy(work, input, size * sizeof(int));
+        double start = now_s();
+        run();
+        double elapsed = now_s() - start;
+        if (elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+static void report(const char *name, double seconds) {
+    printf("  %-36s %10.2f ns/elem %10.1f M elems/s\n", name, seconds * 1e9 / size,
+           size / seconds / 1e6);
+}
+
+static int ordered_by_digit_sum(const int *arr, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        if (compare_by_digit_sum(arr[i - 1], arr[i]) > 0)
+            return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t max = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_MAX_ELEMENTS;
+
+    for (size = 1000; size <= max; size *= 10) {
+        input = malloc(size * sizeof(int));
+        work = malloc(size * sizeof(int));
+        int *expected = malloc(size * sizeof(int));
+        if (input == NULL || work == NULL || expected == NULL) {
+            printf("Not enough memory for %zu elements, stopping\n", size);
+            free(input);
+            free(work);
+            free(expected);
+            break;
+        }
+
+        // ascending, full range including INT_MIN/INT_MAX (a - b overflows)
+        for (size_t i = 0; i < size; i++)
+            input[i] = (int)(uint32_t)next_random();
+        input[0] = INT_MIN;
+        input[size - 1] = INT_MAX;
+        printf("=== %zu elements ===\n", size);
+
+        struct {
+            const char *name;
+            void (*run)(void);
+        } ascending[] = {
+            {"qsort(compare_ascending)", run_qsort},
+            {"bubble_sort(compare_ascending)", run_bubble_ascending},
+            {"sort_introsort(compare_ascending)", run_introsort},
+            {"sort_ints", run_sort_ints},
+            {"sort_radix", run_radix},
+            {"sort_parallel", run_parallel},
+            {"sort_parallel(2 threads)", run_parallel_2},
+            {"sort_parallel(3 threads)", run_parallel_3},
+            {"sort_parallel(4 threads)", run_parallel_4},
+        };
+        for (size_t a = 0; a < sizeof(ascending) / sizeof(ascending[0]); a++) {
+            if (ascending[a].run == run_bubble_ascending && size > BUBBLE_MAX)
+                continue;
+            report(ascending[a].name, time_sort(ascending[a].run));
+            if (a == 0) {
+                memcpy(expected, work, size * sizeof(int));
+            } else {
+                failed |= memcmp(work, expected, size * sizeof(int)) != 0;
+            }
+            if (failed) {
+                printf("❌ %s gave a different result\n", ascending[a].name);
+                return 1;
+            }
+        }
+
+        // digit sum, non-negative
+        for (size_t i = 0; i < size; i++)
+            input[i] = (int)(next_random() >> 33);
+        int have_bubble = size <= BUBBLE_MAX;
+        if (have_bubble) {
+            report("bubble_sort(compare_by_digit_sum)", time_sort(run_bubble_digit_sum));
+            memcpy(expected, work, size * sizeof(int));
+        }
+        report("sort_introsort(compare_by_digit_sum)", time_sort(run_introsort_digit_sum));
+        if (!ordered_by_digit_sum(work, size)) {
+            printf("❌ sort_introsort(compare_by_digit_sum) is out of order\n");
+            return 1;
+        }
+        report("sort_by_digit_sum", time_sort(run_by_digit_sum));
+        if (failed || !ordered_by_digit_sum(work, size) ||
+            (have_bubble && memcmp(work, expected, size * sizeof(int)) != 0)) {
+            printf("❌ sort_by_digit_sum gave a different result\n");
+            return 1;
+        }
+
+        free(input);
+        free(work);
+        free(expected);
+        if (size > SIZE_MAX / 10)
+            break;
+    }
+    printf("✅ All sorts agree\n");
+    return 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * bench_stream.c - PRACTICE 8's chain_string_transforms versus the chunked chain
+ *
+ * 1. Random chains of run.c and simd_string stages, with and without
+ *    reverses, over random strings: stream_chain_buffer and
+ *    stream_chain_file (from a file, and from a pipe) must give what
+ *    chain_string_transforms gives with the run.c helpers.
+ * 2. uppercase -> remove_vowels -> reverse over BENCH_BYTES through files,
+ *    then in memory: run.c's helpers and the simd_string kernels over the
+ *    whole string per stage versus chunks. The peak resident memory is
+ *    shown after each.
+ *
+ *   ./bench_stream.exe                          check, then benchmark
+ *   ./bench_stream.exe --chain STAGES [FILE]    run a chain from FILE (or
+ *       stdin) to stdout; STAGES is any of u (uppercase), v (remove
+ *       vowels) and r (reverse), applied left to right
+ *
+ * Build and run with: make bench_stream
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "run.h"
+#include "simd_string.h"
+#include "stream.h"
+
+#define FUZZ_CASES 3000
+#define FUZZ_MAX_LEN (3 * STREAM_CHUNK)
+#define BENCH_BYTES (256 << 20)
+#define MAX_STAGES 6
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static long peak_rss_mib(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+static void fill_text(char *s, size_t len) {
+    static const char letters[] = "aeiouAEIOUbcdfghBCDFGH xyzXYZ,.!\n0123456789";
+    for (size_t i = 0; i < len; i++)
+        s[i] = letters[next_random() % (sizeof(letters) - 1)];
+    s[len] = '\0';
+}
+
+// Parse "uvr..." into stages (the simd_string ones) and their run.c twins
+static size_t parse_stages(const char *spec, stream_stage *stages, stream_string_fn *reference) {
+    size_t count = 0;
+    for (; *spec && count < MAX_STAGES; spec++) {
+        switch (*spec) {
+        case 'u':
+            stages[count] = (stream_stage)STREAM_STAGE_BYTES(stream_uppercase);
+            reference[count++] = uppercase_string;
+            break;
+        case 'v':
+            stages[count] = (stream_stage)STREAM_STAGE_BYTES(stream_remove_vowels);
+            reference[count++] = remove_vowels;
+            break;
+        case 'r':
+            stages[count] = (stream_stage)STREAM_STAGE_REVERSE;
+            reference[count++] = reverse_string;
+            break;
+        default:
+            return 0;
+        }
+    }
+    return *spec ? 0 : count;
+}
+
+// in written to a pipe by a child process, so the chain cannot seek it
+static long long chain_from_pipe(const stream_stage *stages, size_t count, const char *in,
+                                 size_t len, FILE *out) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return -1;
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = write(fds[1], in + done, len - done);
+            if (n <= 0)
+                _exit(1);
+            done += (size_t)n;
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    FILE *reader = fdopen(fds[0], "r");
+    long long written = -1;
+    if (child > 0 && reader != NULL)
+        written = stream_chain_file(stages, count, reader, out);
+    if (reader != NULL)
+        fclose(reader);
+    else
+        close(fds[0]);
+    if (child > 0)
+        waitpid(child, NULL, 0);
+    return written;
+}
+
+// out's contents compared with expected; out is emptied for the next use
+static int output_matches(FILE *out, long long written, const char *expected, size_t len) {
+    static char got[FUZZ_MAX_LEN + 1];
+    rewind(out);
+    size_t n = fread(got, 1, sizeof(got), out);
+    rewind(out);
+    int ok = written == (long long)len && n == len && memcmp(got, expected, len) == 0;
+    return ftruncate(fileno(out), 0) == 0 && ok;
+}
+
+static int check(void) {
+    static char input[FUZZ_MAX_LEN + 1], expected[FUZZ_MAX_LEN + 1], buffer[FUZZ_MAX_LEN + 1];
+    stream_stage stages[MAX_STAGES];
+    stream_string_fn reference[MAX_STAGES];
+    FILE *in = tmpfile(), *out = tmpfile();
+    if (in == NULL || out == NULL) {
+        printf("❌ cannot create temporary files\n");
+        return 0;
+    }
+    for (int round = 0; round < FUZZ_CASES; round++) {
+        size_t len = next_random() % (round % 10 == 0 ? FUZZ_MAX_LEN : 100);
+        size_t count = next_random() % (MAX_STAGES + 1);
+        char spec[MAX_STAGES + 1];
+        for (size_t s = 0; s < count; s++)
+            spec[s] = "uvr"[next_random() % 3];
+        spec[count] = '\0';
+        parse_stages(spec, stages, reference);
+        // some chains use the run.c helpers themselves as string stages
+        for (size_t s = 0; s < count; s++) {
+            if (stages[s].kind != STREAM_REVERSE && (next_random() & 1))
+                stages[s] = (stream_stage)STREAM_STAGE_STRING(reference[s]);
+        }
+
+        fill_text(input, len);
+        memcpy(expected, input, len + 1);
+        chain_string_transforms(expected, reference, (int)count);
+        size_t expected_len = strlen(expected);
+
+        memcpy(buffer, input, len + 1);
+        size_t n = stream_chain_buffer(stages, count, buffer, len);
+        if (n != expected_len || memcmp(buffer, expected, n) != 0 || buffer[len] != '\0') {
+            printf("❌ stream_chain_buffer(\"%s\") differs on %zu bytes\n", spec, len);
+            return 0;
+        }
+
+        rewind(in);
+        if (ftruncate(fileno(in), 0) != 0 || fwrite(input, 1, len, in) != len || fflush(in) != 0) {
+            printf("❌ cannot write the temporary file\n");
+            return 0;
+        }
+        rewind(in);
+        long long written = stream_chain_file(stages, count, in, out);
+        if (!output_matches(out, written, expected, expected_len)) {
+            printf("❌ stream_chain_file(\"%s\") differs on %zu bytes\n", spec, len);
+            return 0;
+        }
+        if (round % 10 == 0) {
+            written = chain_from_pipe(stages, count, input, len, out);
+            if (!output_matches(out, written, expected, expected_len)) {
+                printf("❌ stream_chain_file(\"%s\") from a pipe differs on %zu bytes\n", spec,
+                       len);
+                return 0;
+            }
+        }
+    }
+    fclose(in);
+    fclose(out);
+
+    // string stages keep embedded NULs and run on each piece
+    stream_stage pieces[] = {STREAM_STAGE_STRING(uppercase_string),
+                             STREAM_STAGE_STRING(remove_vowels)};
+    char text[] = "abc\0\0ouch";
+    size_t n = stream_chain_buffer(pieces, 2, text, sizeof(text) - 1);
+    if (n != 6 || memcmp(text, "BC\0\0CH", 6) != 0) {
+        printf("❌ string stages mishandle embedded NULs\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int run_chain(const char *spec, const char *path) {
+    stream_stage stages[MAX_STAGES];
+    stream_string_fn reference[MAX_STAGES];
+    size_t count = parse_stages(spec, stages, reference);
+    if (count == 0) {
+        fprintf(stderr, "stages must be 1 to %d of u, v and r\n", MAX_STAGES);
+        return 2;
+    }
+    FILE *in = path == NULL || strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return 1;
+    }
+    long long written = stream_chain_file(stages, count, in, stdout);
+    if (written < 0)
+        perror("stream_chain_file");
+    if (in != stdin)
+        fclose(in);
+    return written < 0;
+}
+
+static void report(const char *label, double seconds) {
+    printf("  %-40s %8.1f ms %8.2f GB/s   peak RSS %4ld MiB\n", label, seconds * 1e3,
+           BENCH_BYTES / seconds / 1e9, peak_rss_mib());
+}
+
+static int bench(void) {
+    stream_stage stages[MAX_STAGES];
+    stream_string_fn reference[MAX_STAGES];
+    size_t count = parse_stages("uvr", stages, reference);
+
+    // files first, while the peak RSS is still small
+    printf("\n=== uppercase -> remove_vowels -> reverse, %d MiB ===\n", BENCH_BYTES >> 20);
+    FILE *in = tmpfile(), *out = fopen("/dev/null", "wb");
+    char *text = malloc((size_t)STREAM_CHUNK + 1);
+    if (in == NULL || out == NULL || text == NULL) {
+        printf("❌ cannot create the input\n");
+        return 0;
+    }
+    for (size_t done = 0; done < BENCH_BYTES; done += STREAM_CHUNK) {
+        fill_text(text, STREAM_CHUNK);
+        if (fwrite(text, 1, STREAM_CHUNK, in) != STREAM_CHUNK) {
+            printf("❌ cannot write the input\n");
+            return 0;
+        }
+    }
+    free(text);
+    fflush(in);
+    stream_stage forward[] = {STREAM_STAGE_BYTES(stream_uppercase),
+                              STREAM_STAGE_BYTES(stream_remove_vowels)};
+    rewind(in);
+    double start = now_s();
+    long long written = stream_chain_file(forward, 2, in, out);
+    report("file -> /dev/null, no reverse", now_s() - start);
+    rewind(in);
+    start = now_s();
+    long long reversed = stream_chain_file(stages, count, in, out);
+    report("file -> /dev/null, read backwards", now_s() - start);
+    if (written < 0 || written != reversed) {
+        printf("❌ the file chains disagree\n");
+        return 0;
+    }
+
+    char *expected = malloc(BENCH_BYTES + 1), *buffer = malloc(BENCH_BYTES + 1);
+    if (expected == NULL || buffer == NULL) {
+        printf("❌ out of memory\n");
+        return 0;
+    }
+    rewind(in);
+    if (fread(expected, 1, BENCH_BYTES, in) != BENCH_BYTES) {
+        printf("❌ cannot read the input back\n");
+        return 0;
+    }
+    expected[BENCH_BYTES] = '\0';
+    memcpy(buffer, expected, BENCH_BYTES + 1);
+    fclose(in);
+    fclose(out);
+
+    start = now_s();
+    chain_string_transforms(expected, reference, (int)count);
+    report("chain_string_transforms (run.c)", now_s() - start);
+    // the same kernels without the chunking, to separate the two effects
+    char *whole = malloc(BENCH_BYTES + 1);
+    if (whole == NULL) {
+        printf("❌ out of memory\n");
+        return 0;
+    }
+    memcpy(whole, buffer, BENCH_BYTES + 1);
+    start = now_s();
+    simd_uppercase(whole, BENCH_BYTES);
+    size_t whole_len = simd_remove_vowels_n(whole, BENCH_BYTES);
+    simd_reverse(whole, whole_len);
+    report("simd_string, whole string per stage", now_s() - start);
+
+    start = now_s();
+    size_t n = stream_chain_buffer(stages, count, buffer, BENCH_BYTES);
+    report("stream_chain_buffer", now_s() - start);
+    int same = n == strlen(expected) && (long long)n == written && memcmp(buffer, expected, n) == 0 &&
+               whole_len == n && memcmp(whole, expected, n) == 0;
+    free(whole);
+    free(expected);
+    free(buffer);
+    if (!same) {
+        printf("❌ stream_chain_buffer differs from chain_string_transforms\n");
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2 && strcmp(argv[1], "--chain") == 0)
+        return run_chain(argv[2], argc > 3 ? argv[3] : NULL);
+    if (argc > 1) {
+        fprintf(stderr, "usage: %s [--chain STAGES [FILE]]\n", argv[0]);
+        return 2;
+    }
+
+    printf("=== Checking against chain_string_transforms ===\n");
+    if (!check())
+        return 1;
+    printf("  ✅ %d random chains, from memory, a file and a pipe\n", FUZZ_CASES);
+    if (!bench())
+        return 1;
+    printf("✅ All chains agree with run.c\n");
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * bench_transforms.c - run.c's factorial/fibonacci/count_bits versus transforms
+ *
+ * 1. Check the fast versions against run.c (fibonacci only up to 30, the
+ *    naive recursion is too slow past that; beyond it against a plain
+ *    wrapping loop), the checked variants at their limits, and every
+ *    supported array implementation against the scalar functions.
+ * 2. Time run.c per element, the fast scalar functions and the array
+ *    versions on ELEMENTS ints, and popcount_buffer on a large buffer.
+ *
+ * Build and run with: make bench_transforms
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "run.h"
+#include "transforms.h"
+
+#define ELEMENTS 10000000
+#define FIBONACCI_SAMPLE 2000       // run.c's fibonacci on inputs up to 25
+#define BUFFER_BYTES (64 << 20)
+#define FUZZ_ROUNDS 2000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// fibonacci by repeated wrapping addition, as run.c's would wrap
+static int fibonacci_loop(int n) {
+    if (n <= 1)
+        return n;
+    uint32_t a = 0, b = 1;
+    for (int i = 1; i < n; i++) {
+        uint32_t next = a + b;
+        a = b;
+        b = next;
+    }
+    return (int)b;
+}
+
+// Mix of small, table-sized, large and negative inputs
+static int random_input(void) {
+    uint64_t r = next_random();
+    switch (r & 3) {
+    case 0:
+        return (int)((r >> 8) % 50) - 3;
+    case 1:
+        return (int)((r >> 8) % 100);
+    case 2:
+        return (int)(r >> 32);
+    default:
+        return (int)((r >> 8) % 5000);
+    }
+}
+
+static int check_scalar(void) {
+    for (int n = -100; n <= 1000; n++) {
+        if (factorial_fast(n) != factorial(n)) {
+            printf("❌ factorial_fast(%d) = %d, run.c gives %d\n", n, factorial_fast(n), factorial(n));
+            return 0;
+        }
+    }
+    for (int n = -20; n <= 30; n++) {
+        if (fibonacci_fast(n) != fibonacci(n)) {
+            printf("❌ fibonacci_fast(%d) differs from run.c\n", n);
+            return 0;
+        }
+    }
+    for (int n = 31; n <= 20000; n++) {
+        if (fibonacci_fast(n) != fibonacci_loop(n)) {
+            printf("❌ fibonacci_fast(%d) differs from the wrapping loop\n", n);
+            return 0;
+        }
+    }
+    if (fibonacci_fast(INT_MAX) != fibonacci_loop(INT_MAX)) {
+        printf("❌ fibonacci_fast(INT_MAX) differs from the wrapping loop\n");
+        return 0;
+    }
+    for (int i = 0; i < 1000000; i++) {
+        int n = (int)(uint32_t)next_random();
+        if (count_bits_fast(n) != count_bits(n)) {
+            printf("❌ count_bits_fast(%d) differs from run.c\n", n);
+            return 0;
+        }
+    }
+
+    int value;
+    uint64_t value_u64;
+    int ok = factorial_checked(12, &value) && value == 479001600 && !factorial_checked(13, &value) &&
+             factorial_u64_checked(20, &value_u64) && value_u64 == 2432902008176640000ULL &&
+             !factorial_u64_checked(21, &value_u64) &&
+             fibonacci_checked(46, &value) && value == 1836311903 && !fibonacci_checked(47, &value) &&
+             fibonacci_u64_checked(93, &value_u64) && value_u64 == 12200160415121876738ULL &&
+             !fibonacci_u64_checked(94, &value_u64) && !fibonacci_u64_checked(-1, &value_u64);
+    // compare results, not addresses: count_bits_fast is an ifunc, and its
+    // address taken here and inside transforms.c need not be equal
+    for (int n = -50; n <= 50; n++) {
+        ok = ok && get_transformer('f')(n) == factorial_fast(n) &&
+             get_transformer('b')(n) == count_bits_fast(n) && get_transformer('F')(n) == fibonacci_fast(n);
+    }
+    ok = ok && get_transformer('x') == NULL && get_array_transformer('x') == NULL;
+    if (!ok) {
+        printf("❌ checked variants or get_transformer are wrong\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int check_arrays(enum transform_isa isa) {
+    static int input[1000], output[1000];
+    static unsigned char buffer[4096];
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t count = next_random() % 1000;
+        for (size_t i = 0; i < count; i++)
+            input[i] = random_input();
+        const char codes[] = "fbF";
+        for (int c = 0; c < 3; c++) {
+            transform_fn scalar = get_transformer(codes[c]);
+            get_array_transformer(codes[c])(input, output, count);
+            for (size_t i = 0; i < count; i++) {
+                if (output[i] != scalar(input[i])) {
+                    printf("❌ %s '%c' array gives %d for %d, expected %d\n",
+                           transforms_isa_name(isa), codes[c], output[i], input[i], scalar(input[i]));
+                    return 0;
+                }
+            }
+        }
+
+        size_t offset = next_random() % 64, bytes = next_random() % (sizeof(buffer) - 64);
+        uint64_t expected = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            buffer[offset + i] = (unsigned char)next_random();
+            expected += (uint64_t)count_bits(buffer[offset + i]);
+        }
+        if (popcount_buffer(buffer + offset, bytes) != expected) {
+            printf("❌ %s popcount_buffer is wrong (%zu bytes)\n", transforms_isa_name(isa), bytes);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int *input, *output;
+static size_t count;
+static volatile int sink;
+
+static double time_scalar(transform_fn f, size_t n) {
+    int sum = 0;
+    double start = now_s();
+    for (size_t i = 0; i < n; i++)
+        sum += f(input[i]);
+    double elapsed = now_s() - start;
+    sink = sum;
+    return elapsed * 1e9 / n;
+}
+
+static double time_array(transform_array_fn f) {
+    double start = now_s();
+    f(input, output, count);
+    return (now_s() - start) * 1e9 / count;
+}
+
+static void bench(const char *title, char code, transform_fn reference, size_t reference_count) {
+    printf("  %s\n", title);
+    double base = time_scalar(reference, reference_count);
+    printf("    %-22s %9.3f ns/elem\n", "run.c", base);
+    double fast = time_scalar(get_transformer(code), count);
+    printf("    %-22s %9.3f ns/elem %9.1fx\n", "fast (per call)", fast, base / fast);
+    for (int isa = 0; isa < TRANSFORM_ISA_COUNT; isa++) {
+        if (!transforms_use((enum transform_isa)isa))
+            continue;
+        char label[32];
+        snprintf(label, sizeof(label), "array (%s)", transforms_isa_name(isa));
+        double t = time_array(get_array_transformer(code));
+        printf("    %-22s %9.3f ns/elem %9.1fx\n", label, t, base / t);
+    }
+}
+
+int main(void) {
+    enum transform_isa fastest = transforms_active();
+    printf("=== Checking against run.c ===\n");
+    if (!check_scalar())
+        return 1;
+    for (int isa = 0; isa < TRANSFORM_ISA_COUNT; isa++) {
+        if (!transforms_use((enum transform_isa)isa)) {
+            printf("  %-8s not supported on this CPU, skipped\n", transforms_isa_name(isa));
+            continue;
+        }
+        if (!check_arrays((enum transform_isa)isa))
+            return 1;
+        printf("  %-8s ✅\n", transforms_isa_name(isa));
+    }
+
+    count = ELEMENTS;
+    input = malloc(count * sizeof(int));
+    output = malloc(count * sizeof(int));
+    unsigned char *buffer = malloc(BUFFER_BYTES);
+    if (input == NULL || output == NULL || buffer == NULL) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+
+    printf("\n=== %d ints (default: %s) ===\n", ELEMENTS, transforms_isa_name(fastest));
+    for (size_t i = 0; i < count; i++)
+        input[i] = (int)(next_random() % 21);
+    bench("factorial, n in 0..20", 'f', factorial, count);
+
+    for (size_t i = 0; i < count; i++)
+        input[i] = (int)(next_random() % 26);
+    bench("fibonacci, n in 0..25 (run.c on a sample)", 'F', fibonacci, FIBONACCI_SAMPLE);
+
+    for (size_t i = 0; i < count; i++)
+        input[i] = (int)(uint32_t)next_random();
+    bench("count_bits, any int", 'b', count_bits, count);
+
+    printf("\n=== popcount_buffer over %d MiB ===\n", BUFFER_BYTES >> 20);
+    for (size_t i = 0; i < BUFFER_BYTES; i++)
+        buffer[i] = (unsigned char)next_random();
+    uint64_t expected = 0;
+    for (int isa = 0; isa < TRANSFORM_ISA_COUNT; isa++) {
+        if (!transforms_use((enum transform_isa)isa))
+            continue;
+        double start = now_s();
+        uint64_t bits = popcount_buffer(buffer, BUFFER_BYTES);
+        double t = now_s() - start;
+        if (isa == 0)
+            expected = bits;
+        else if (bits != expected) {
+            printf("❌ %s popcount_buffer disagrees\n", transforms_isa_name(isa));
+            return 1;
+        }
+        printf("    %-22s %9.2f GB/s\n", transforms_isa_name(isa), BUFFER_BYTES / t / 1e9);
+    }
+    transforms_use(fastest);
+    printf("✅ All versions agree with run.c\n");
+
+    free(input);
+    free(output);
+    free(buffer);
+    return 0;
+}
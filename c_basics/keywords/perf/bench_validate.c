@@ -0,0 +1,254 @@
+/*
+ * bench_validate.c - PRACTICE 2's validators one at a time versus bitmasks
+ *
+ * 1. Fuzz validate_range on every supported ISA level (random bounds,
+ *    including empty and full-int ranges, and odd lengths), and check
+ *    validate_columns and the engine against run.c's validators row by row.
+ * 2. Time rows of random records through is_prime, is_palindrome_num,
+ *    is_valid_age and is_valid_score: every validator on every row, the
+ *    same with && in the listed order, one mask per validator, and the
+ *    engine with the listed order and with its own.
+ *
+ *   ./bench_validate.exe [rows]    default 10M
+ *
+ * Build and run with: make bench_validate
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "run.h"
+#include "validate.h"
+
+#define DEFAULT_ROWS 10000000
+#define FUZZ_ROUNDS 3000
+#define VALIDATOR_COUNT 4
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void report(const char *label, double seconds, size_t rows) {
+    printf("  %-38s %8.2f ns/row %9.1f M rows/s\n", label, seconds * 1e9 / rows,
+           rows / seconds / 1e6);
+}
+
+static int bit(const uint64_t *mask, size_t row) {
+    return (int)(mask[row / 64] >> (row % 64) & 1);
+}
+
+// The validators in PRACTICE 2's order
+static const validator validators[VALIDATOR_COUNT] = {
+    VALIDATOR_FN("is_prime", is_prime),
+    VALIDATOR_FN("is_palindrome_num", is_palindrome_num),
+    VALIDATOR_RANGE("is_valid_age", 0, 150),
+    VALIDATOR_RANGE("is_valid_score", 0, 100),
+};
+static int (*const run_c[VALIDATOR_COUNT])(int) = {is_prime, is_palindrome_num, is_valid_age,
+                                                   is_valid_score};
+
+// A quarter of the rows look like real ages/scores, the rest are anything
+static int random_row(void) {
+    uint64_t r = next_random();
+    if ((r & 3) == 0)
+        return (int)((r >> 8) % 250) - 50;
+    return (int)((r >> 8) % 2000000);
+}
+
+static int random_bound(void) {
+    static const int edges[] = {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX};
+    uint64_t r = next_random();
+    switch (r % 3) {
+    case 0:
+        return edges[(r >> 8) % 7];
+    case 1:
+        return (int)((r >> 8) % 2001) - 1000;
+    default:
+        return (int)(r >> 32);
+    }
+}
+
+static int fuzz_range(enum validate_isa isa) {
+    static int values[1000];
+    static uint64_t mask[VALIDATE_MASK_WORDS(1000) + 1];
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t count = next_random() % 1000;
+        int lo = random_bound(), hi = random_bound();
+        for (size_t i = 0; i < count; i++) {
+            uint64_t near_lo = (unsigned)lo + next_random() % 5 - 2;
+            values[i] = (next_random() & 1) ? random_bound() : (int)(uint32_t)near_lo;
+        }
+        mask[VALIDATE_MASK_WORDS(count)] = 0x5A5A;  // must be left alone
+        validate_range(values, count, lo, hi, mask);
+        for (size_t i = 0; i < VALIDATE_MASK_WORDS(count) * 64; i++) {
+            int expected = i < count && values[i] >= lo && values[i] <= hi;
+            if (bit(mask, i) != expected) {
+                printf("❌ %s validate_range(%d, %d) is wrong at row %zu\n", validate_isa_name(isa),
+                       lo, hi, i);
+                return 0;
+            }
+        }
+        if (mask[VALIDATE_MASK_WORDS(count)] != 0x5A5A) {
+            printf("❌ %s validate_range wrote past the mask\n", validate_isa_name(isa));
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_rows(const int *values, size_t rows, uint64_t *const *masks, const uint64_t *pass) {
+    for (size_t i = 0; i < rows; i++) {
+        int all = 1;
+        for (int j = 0; j < VALIDATOR_COUNT; j++) {
+            int expected = run_c[j](values[i]);
+            all &= expected;
+            if (masks != NULL && bit(masks[j], i) != expected) {
+                printf("❌ %s mask is wrong for %d\n", validators[j].name, values[i]);
+                return 0;
+            }
+        }
+        if (pass != NULL && bit(pass, i) != all) {
+            printf("❌ engine is wrong for %d\n", values[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t rows = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_ROWS;
+    enum validate_isa fastest = validate_active();
+
+    printf("=== Checking validate_range ===\n");
+    for (int isa = 0; isa < VALIDATE_ISA_COUNT; isa++) {
+        if (!validate_use((enum validate_isa)isa)) {
+            printf("  %-8s not supported on this CPU, skipped\n", validate_isa_name(isa));
+            continue;
+        }
+        if (!fuzz_range((enum validate_isa)isa))
+            return 1;
+        printf("  %-8s ✅\n", validate_isa_name(isa));
+    }
+    validate_use(fastest);
+
+    int *values = malloc(rows * sizeof(int));
+    uint64_t *storage = calloc((VALIDATOR_COUNT + 1) * VALIDATE_MASK_WORDS(rows), sizeof(uint64_t));
+    unsigned char *flags = malloc(rows);
+    if (values == NULL || storage == NULL || flags == NULL) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    uint64_t *masks[VALIDATOR_COUNT];
+    for (int j = 0; j < VALIDATOR_COUNT; j++)
+        masks[j] = storage + j * VALIDATE_MASK_WORDS(rows);
+    uint64_t *pass = storage + VALIDATOR_COUNT * VALIDATE_MASK_WORDS(rows);
+    for (size_t i = 0; i < rows; i++)
+        values[i] = random_row();
+
+    printf("\n=== %zu rows through 4 validators (default: %s) ===\n", rows,
+           validate_isa_name(fastest));
+    double start = now_s();
+    for (size_t i = 0; i < rows; i++) {
+        int all = 1;
+        for (int j = 0; j < VALIDATOR_COUNT; j++)
+            all &= run_c[j](values[i]);
+        flags[i] = (unsigned char)all;
+    }
+    report("run.c, every validator on every row", now_s() - start, rows);
+
+    start = now_s();
+    size_t listed = 0;
+    for (size_t i = 0; i < rows; i++) {
+        int v = values[i];
+        listed += is_prime(v) && is_palindrome_num(v) && is_valid_age(v) && is_valid_score(v);
+    }
+    report("run.c, && in the listed order", now_s() - start, rows);
+
+    start = now_s();
+    validate_columns(validators, VALIDATOR_COUNT, values, rows, masks);
+    report("validate_columns (one mask each)", now_s() - start, rows);
+
+    validator_engine engine;
+    if (!validator_engine_init(&engine, validators, VALIDATOR_COUNT)) {
+        printf("❌ out of memory\n");
+        return 1;
+    }
+    engine.adaptive = 0;
+    start = now_s();
+    size_t passed_fixed = validator_engine_run(&engine, values, rows, pass);
+    report("engine, listed order", now_s() - start, rows);
+
+    validator_engine_reset(&engine);
+    engine.adaptive = 1;
+    start = now_s();
+    size_t passed = validator_engine_run(&engine, values, rows, pass);
+    report("engine, ranked by cost per rejection", now_s() - start, rows);
+
+    size_t expected = 0;
+    for (size_t i = 0; i < rows; i++)
+        expected += flags[i];
+    if (passed != expected || passed_fixed != expected || listed != expected ||
+        !check_rows(values, rows < 2000000 ? rows : 2000000, masks, pass)) {
+        printf("❌ results differ (%zu, %zu and %zu rows pass, expected %zu)\n", passed,
+               passed_fixed, listed, expected);
+        return 1;
+    }
+    for (size_t i = 0; i < rows; i++) {
+        if (bit(pass, i) != flags[i]) {
+            printf("❌ engine is wrong for %d\n", values[i]);
+            return 1;
+        }
+    }
+
+    printf("\n  engine order and counters:\n");
+    for (size_t k = 0; k < engine.count; k++) {
+        size_t j = engine.order[k];
+        const validator_stats *s = &engine.stats[j];
+        printf("  %zu. %-20s tested %10llu passed %10llu %8.2f ns/row\n", k + 1, validators[j].name,
+               (unsigned long long)s->tested, (unsigned long long)s->passed,
+               s->tested ? (double)s->nanoseconds / s->tested : 0.0);
+    }
+
+    printf("\n=== is_valid_age alone ===\n");
+    start = now_s();
+    for (size_t i = 0; i < rows; i++)
+        flags[i] = (unsigned char)is_valid_age(values[i]);
+    report("run.c is_valid_age", now_s() - start, rows);
+    for (int isa = 0; isa < VALIDATE_ISA_COUNT; isa++) {
+        if (!validate_use((enum validate_isa)isa))
+            continue;
+        char label[48];
+        snprintf(label, sizeof(label), "validate_range (%s)", validate_isa_name(isa));
+        start = now_s();
+        validate_range(values, rows, 0, 150, masks[0]);
+        report(label, now_s() - start, rows);
+        for (size_t i = 0; i < rows; i++) {
+            if (bit(masks[0], i) != flags[i]) {
+                printf("❌ %s validate_range is wrong for %d\n", validate_isa_name(isa), values[i]);
+                return 1;
+            }
+        }
+    }
+    validate_use(fastest);
+    printf("✅ %zu of %zu rows pass, all methods agree with run.c\n", passed, rows);
+
+    validator_engine_free(&engine);
+    free(values);
+    free(storage);
+    free(flags);
+    return 0;
+}
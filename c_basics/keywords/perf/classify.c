@@ -0,0 +1,319 @@
+/*
+ * classify.c - Batch prime and palindrome tests (see classify.h)
+ *
+ * Sieve: the odd primes up to sqrt(limit) come from a small plain sieve.
+ * The odd-only bitmap is then filled one SEGMENT_BITS segment (32 KiB) at
+ * a time: set every bit, then clear the multiples of each base prime that
+ * fall in the segment. The segment stays in L1 while every prime crosses
+ * it. Threads take contiguous runs of segments, and segments are whole
+ * words, so no two threads ever write the same word.
+ *
+ * Miller-Rabin: bases 2, 7, 61 are exact below 2^32 and the first twelve
+ * primes below 2^64. Above 2^32 the modular products are done in
+ * Montgomery form, so each step is two 64x64->128 multiplies with no
+ * division.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "classify.h"
+
+#define SEGMENT_BITS (32 * 1024 * 8)
+#define THREAD_MIN_ITEMS 65536      // smaller jobs are not worth a thread
+
+// ---------------------------------------------------------------------------
+// Running a range over threads
+// ---------------------------------------------------------------------------
+
+typedef void (*range_fn)(void *ctx, size_t begin, size_t end);
+
+typedef struct {
+    range_fn fn;
+    void *ctx;
+    size_t begin, end;
+} range_task;
+
+static void *run_range(void *arg) {
+    range_task *t = arg;
+    t->fn(t->ctx, t->begin, t->end);
+    return NULL;
+}
+
+// fn(ctx, begin, end) over [0, count) in one contiguous slice per thread
+static void parallel_for(size_t count, size_t min_per_thread, int threads, range_fn fn, void *ctx) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if ((size_t)threads > count / min_per_thread + 1)
+        threads = (int)(count / min_per_thread + 1);
+    if (threads <= 1) {
+        fn(ctx, 0, count);
+        return;
+    }
+    range_task *tasks = malloc((size_t)threads * sizeof(*tasks));
+    pthread_t *ids = malloc((size_t)threads * sizeof(*ids));
+    char *started = calloc((size_t)threads, 1);
+    if (tasks == NULL || ids == NULL || started == NULL) {
+        free(tasks);
+        free(ids);
+        free(started);
+        fn(ctx, 0, count);
+        return;
+    }
+    for (int t = 0; t < threads; t++) {
+        tasks[t] = (range_task){fn, ctx, count * t / threads, count * (t + 1) / threads};
+        if (t > 0 && pthread_create(&ids[t], NULL, run_range, &tasks[t]) == 0)
+            started[t] = 1;
+    }
+    run_range(&tasks[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t])
+            pthread_join(ids[t], NULL);
+        else
+            run_range(&tasks[t]);
+    }
+    free(tasks);
+    free(ids);
+    free(started);
+}
+
+// ---------------------------------------------------------------------------
+// Segmented sieve
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t *bits;
+    size_t words;
+    const uint32_t *primes;     // odd primes up to sqrt(limit)
+    size_t prime_count;
+} sieve_job;
+
+// Odd primes up to limit with a plain sieve (limit is at most 65535 here)
+static uint32_t *odd_primes_up_to(uint32_t limit, size_t *count) {
+    unsigned char *composite = calloc(limit + 1, 1);
+    uint32_t *primes = malloc((limit / 2 + 1) * sizeof(*primes));
+    *count = 0;
+    if (composite == NULL || primes == NULL) {
+        free(composite);
+        free(primes);
+        return NULL;
+    }
+    for (uint32_t i = 3; i <= limit; i += 2) {
+        if (composite[i])
+            continue;
+        primes[(*count)++] = i;
+        for (uint32_t j = i * i; j <= limit; j += 2 * i)
+            composite[j] = 1;
+    }
+    free(composite);
+    return primes;
+}
+
+static void sieve_segments(void *ctx, size_t first, size_t last) {
+    sieve_job *job = ctx;
+    const size_t words_per_segment = SEGMENT_BITS / 64;
+    for (size_t segment = first; segment < last; segment++) {
+        size_t lo_word = segment * words_per_segment;
+        size_t hi_word = lo_word + words_per_segment;
+        if (hi_word > job->words)
+            hi_word = job->words;
+        uint64_t *bits = job->bits;
+        memset(bits + lo_word, 0xFF, (hi_word - lo_word) * sizeof(uint64_t));
+
+        uint64_t lo_bit = (uint64_t)lo_word * 64, hi_bit = (uint64_t)hi_word * 64;
+        uint64_t lo_number = 2 * lo_bit + 1, hi_number = 2 * hi_bit - 1;
+        for (size_t i = 0; i < job->prime_count; i++) {
+            uint64_t p = job->primes[i];
+            uint64_t start = p * p;
+            if (start > hi_number)
+                break;
+            if (start < lo_number) {
+                // first odd multiple of p in the segment
+                start = (lo_number + p - 1) / p * p;
+                if ((start & 1) == 0)
+                    start += p;
+            }
+            for (uint64_t bit = start >> 1; bit < hi_bit; bit += p)
+                bits[bit >> 6] &= ~(1ULL << (bit & 63));
+        }
+    }
+}
+
+int prime_sieve_init(prime_sieve *sieve, uint32_t limit, int threads) {
+    sieve_job job;
+    job.words = ((size_t)limit >> 7) + 1;
+    job.bits = malloc(job.words * sizeof(uint64_t));
+    uint32_t root = 1;
+    while ((uint64_t)(root + 1) * (root + 1) <= limit)
+        root++;
+    uint32_t *primes = odd_primes_up_to(root, &job.prime_count);
+    if (job.bits == NULL || primes == NULL) {
+        free(job.bits);
+        free(primes);
+        return 0;
+    }
+    job.primes = primes;
+
+    size_t segments = (job.words + SEGMENT_BITS / 64 - 1) / (SEGMENT_BITS / 64);
+    parallel_for(segments, 1, threads, sieve_segments, &job);
+    job.bits[0] &= ~1ULL;       // 1 is not prime
+
+    free(primes);
+    sieve->bits = job.bits;
+    sieve->limit = limit;
+    return 1;
+}
+
+void prime_sieve_free(prime_sieve *sieve) {
+    free(sieve->bits);
+    sieve->bits = NULL;
+    sieve->limit = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Miller-Rabin
+// ---------------------------------------------------------------------------
+
+static uint64_t pow_mod_32(uint64_t base, uint64_t exp, uint64_t n) {
+    uint64_t result = 1;
+    base %= n;
+    for (; exp; exp >>= 1) {
+        if (exp & 1)
+            result = result * base % n;
+        base = base * base % n;
+    }
+    return result;
+}
+
+// a * b / 2^64 mod n for a, b < n, with inv = n^-1 mod 2^64
+static inline uint64_t mont_mul(uint64_t a, uint64_t b, uint64_t n, uint64_t inv) {
+    unsigned __int128 t = (unsigned __int128)a * b;
+    uint64_t m = (uint64_t)t * inv;
+    uint64_t mn_high = (uint64_t)(((unsigned __int128)m * n) >> 64);
+    uint64_t t_high = (uint64_t)(t >> 64);
+    // the low halves of t and m*n are equal, so t - m*n = (t_high - mn_high) * 2^64
+    return t_high >= mn_high ? t_high - mn_high : t_high - mn_high + n;
+}
+
+static int is_prime_64(uint64_t n) {
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    uint64_t inv = n;           // Newton's iteration, 5 steps reach 64 bits
+    for (int i = 0; i < 5; i++)
+        inv *= 2 - n * inv;
+    uint64_t one = (0 - n) % n; // 2^64 mod n, i.e. 1 in Montgomery form
+    uint64_t minus_one = n - one;
+    uint64_t d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+
+    for (size_t b = 0; b < sizeof(bases) / sizeof(bases[0]); b++) {
+        uint64_t base = (uint64_t)(((unsigned __int128)bases[b] << 64) % n);
+        uint64_t x = one;
+        for (uint64_t e = d; e; e >>= 1) {
+            if (e & 1)
+                x = mont_mul(x, base, n, inv);
+            base = mont_mul(base, base, n, inv);
+        }
+        if (x == one || x == minus_one)
+            continue;
+        int r = 1;
+        for (; r < s; r++) {
+            x = mont_mul(x, x, n, inv);
+            if (x == minus_one)
+                break;
+        }
+        if (r == s)
+            return 0;
+    }
+    return 1;
+}
+
+int is_prime_u64(uint64_t n) {
+    static const uint32_t small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    if (n < 2)
+        return 0;
+    for (size_t i = 0; i < sizeof(small_primes) / sizeof(small_primes[0]); i++) {
+        if (n % small_primes[i] == 0)
+            return n == small_primes[i];
+    }
+    if (n < 41 * 41)
+        return 1;
+    if (n >> 32)
+        return is_prime_64(n);
+
+    static const uint64_t bases[] = {2, 7, 61};
+    uint64_t d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+    for (size_t b = 0; b < 3; b++) {
+        uint64_t x = pow_mod_32(bases[b], d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        int r = 1;
+        for (; r < s; r++) {
+            x = x * x % n;
+            if (x == n - 1)
+                break;
+        }
+        if (r == s)
+            return 0;
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Palindromes and the batch entry points
+// ---------------------------------------------------------------------------
+
+int is_palindrome_fast(int n) {
+    if (n < 0 || (n % 10 == 0 && n != 0))
+        return 0;
+    // move digits from the end of n onto rev until rev has half of them
+    int rev = 0;
+    while (n > rev) {
+        rev = rev * 10 + n % 10;
+        n /= 10;
+    }
+    return n == rev || n == rev / 10;
+}
+
+typedef struct {
+    const prime_sieve *sieve;
+    const int *values;
+    unsigned char *out;
+} classify_job;
+
+static void classify_prime_range(void *ctx, size_t begin, size_t end) {
+    classify_job *job = ctx;
+    const prime_sieve *sieve = job->sieve;
+    for (size_t i = begin; i < end; i++) {
+        int v = job->values[i];
+        if (v < 0)
+            job->out[i] = 0;
+        else if (sieve != NULL && (uint32_t)v <= sieve->limit)
+            job->out[i] = (unsigned char)prime_sieve_test(sieve, (uint32_t)v);
+        else
+            job->out[i] = (unsigned char)is_prime_u64((uint64_t)v);
+    }
+}
+
+static void classify_palindrome_range(void *ctx, size_t begin, size_t end) {
+    classify_job *job = ctx;
+    for (size_t i = begin; i < end; i++)
+        job->out[i] = (unsigned char)is_palindrome_fast(job->values[i]);
+}
+
+void classify_primes(const prime_sieve *sieve, const int *values, size_t count,
+                     unsigned char *out, int threads) {
+    classify_job job = {sieve, values, out};
+    parallel_for(count, THREAD_MIN_ITEMS, threads, classify_prime_range, &job);
+}
+
+void classify_palindromes(const int *values, size_t count, unsigned char *out, int threads) {
+    classify_job job = {NULL, values, out};
+    parallel_for(count, THREAD_MIN_ITEMS, threads, classify_palindrome_range, &job);
+}
@@ -0,0 +1,52 @@
+/*
+ * classify.h - Batch prime and palindrome tests for int arrays
+ *
+ * run.c's is_prime does trial division for every number, which costs up to
+ * ~46K divisions for a prime near INT_MAX. Here a sieve is built once and
+ * then answers each number with a single bit lookup.
+ *
+ * The sieve keeps one bit per odd number up to its limit (INT_MAX needs
+ * 128 MiB) and is built in L1-sized segments, spread over threads.
+ * Numbers above the limit go to a deterministic Miller-Rabin test, which
+ * is exact for every 64-bit value.
+ *
+ * Results match run.c's is_prime and is_palindrome_num exactly, including
+ * 0 for negative numbers.
+ */
+
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t *bits;     // bit i: is 2i+1 prime
+    uint32_t limit;     // largest number covered
+} prime_sieve;
+
+// Build a sieve covering 0..limit with threads threads (<= 0: one per
+// CPU). Returns 0 if out of memory.
+int prime_sieve_init(prime_sieve *sieve, uint32_t limit, int threads);
+void prime_sieve_free(prime_sieve *sieve);
+
+// n must be <= sieve->limit
+static inline int prime_sieve_test(const prime_sieve *sieve, uint32_t n) {
+    if (n < 3)
+        return n == 2;
+    return (n & 1) && (sieve->bits[n >> 7] >> ((n >> 1) & 63)) & 1;
+}
+
+// Deterministic Miller-Rabin, exact for all 64-bit n
+int is_prime_u64(uint64_t n);
+
+// Same result as run.c's is_palindrome_num, reversing only half the digits
+int is_palindrome_fast(int n);
+
+// out[i] = is_prime(values[i]) / is_palindrome_num(values[i]), split over
+// threads (<= 0: one per CPU). sieve may be NULL (Miller-Rabin only).
+void classify_primes(const prime_sieve *sieve, const int *values, size_t count,
+                     unsigned char *out, int threads);
+void classify_palindromes(const int *values, size_t count, unsigned char *out, int threads);
+
+#endif
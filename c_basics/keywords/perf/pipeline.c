@@ -0,0 +1,73 @@
+/*
+ * pipeline.c - Fused map/filter/reduce over int arrays (see pipeline.h)
+ *
+ * pipeline_run pulls PIPELINE_BLOCK inputs into a stack buffer with the
+ * first stage, runs every later stage over the buffer in place (filters
+ * compact it, so later stages only see survivors) and folds the block into
+ * the accumulator before moving on.
+ */
+
+#include "pipeline.h"
+
+void map_array(const int *input, size_t size, int *output, pipeline_unary_fn transform) {
+    for (size_t i = 0; i < size; i++)
+        output[i] = transform(input[i]);
+}
+
+size_t filter_array(const int *input, size_t size, int *result, pipeline_unary_fn predicate) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (predicate(input[i]))
+            result[count++] = input[i];
+    }
+    return count;
+}
+
+int reduce_array(const int *input, size_t size, int initial, pipeline_binary_fn operation) {
+    int acc = initial;
+    for (size_t i = 0; i < size; i++)
+        acc = operation(acc, input[i]);
+    return acc;
+}
+
+// Run stages over a block: the first reads from input, the rest work in
+// place on block. Returns how many values are left in block.
+static size_t run_block(const pipeline *p, const int *input, size_t count, int *block) {
+    if (p->stage_count == 0) {
+        for (size_t i = 0; i < count; i++)
+            block[i] = input[i];
+        return count;
+    }
+    const int *from = input;
+    for (size_t s = 0; s < p->stage_count; s++) {
+        const pipeline_stage *stage = &p->stages[s];
+        if (stage->kind == PIPELINE_MAP) {
+            map_array(from, count, block, stage->fn);
+        } else {
+            count = filter_array(from, count, block, stage->fn);
+        }
+        from = block;
+    }
+    return count;
+}
+
+int pipeline_run(const pipeline *p, const int *input, size_t size) {
+    int block[PIPELINE_BLOCK];
+    int acc = p->initial;
+    for (size_t start = 0; start < size; start += PIPELINE_BLOCK) {
+        size_t count = size - start < PIPELINE_BLOCK ? size - start : PIPELINE_BLOCK;
+        count = run_block(p, input + start, count, block);
+        acc = reduce_array(block, count, acc, p->reduce);
+    }
+    return acc;
+}
+
+size_t pipeline_collect(const pipeline *p, const int *input, size_t size, int *output) {
+    size_t total = 0;
+    for (size_t start = 0; start < size; start += PIPELINE_BLOCK) {
+        size_t count = size - start < PIPELINE_BLOCK ? size - start : PIPELINE_BLOCK;
+        // survivors only move left, so output itself can be the block
+        total += run_block(p, input + start, count, output + total);
+    }
+    return total;
+}
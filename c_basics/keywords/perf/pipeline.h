@@ -0,0 +1,72 @@
+/*
+ * pipeline.h - Fused map/filter/reduce over int arrays
+ *
+ * run.c's practice exercises chain map_array, filter_array and reduce_array
+ * as separate passes: every stage walks the whole array through an
+ * int (*)(int) pointer and hands the next stage a full-size temporary.
+ * Here the stages run together instead, one PIPELINE_BLOCK-element block
+ * at a time, so the intermediate values stay in L1 and the input is read
+ * once.
+ *
+ * Two forms:
+ *   pipeline_run         any chain of map/filter stages plus a reduce,
+ *                        given as function pointers at run time
+ *   PIPELINE_FUSED(...)  defines a static inline map->filter->reduce for
+ *                        stages known at compile time, so the compiler
+ *                        inlines them into one loop it can vectorize
+ *                        (GCC does so from -O3)
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+
+#ifndef PIPELINE_BLOCK
+#define PIPELINE_BLOCK 2048     // 8 KiB of ints, half of a small L1
+#endif
+
+typedef int (*pipeline_unary_fn)(int);
+typedef int (*pipeline_binary_fn)(int, int);
+
+// The separate passes from run.c's practice exercises (the unfused baseline)
+void map_array(const int *input, size_t size, int *output, pipeline_unary_fn transform);
+size_t filter_array(const int *input, size_t size, int *result, pipeline_unary_fn predicate);
+int reduce_array(const int *input, size_t size, int initial, pipeline_binary_fn operation);
+
+enum pipeline_stage_kind { PIPELINE_MAP, PIPELINE_FILTER };
+
+typedef struct {
+    enum pipeline_stage_kind kind;
+    pipeline_unary_fn fn;       // transform for MAP, predicate for FILTER
+} pipeline_stage;
+
+typedef struct {
+    const pipeline_stage *stages;
+    size_t stage_count;
+    pipeline_binary_fn reduce;  // NULL for pipeline_collect-only use
+    int initial;
+} pipeline;
+
+// Run every stage over input and fold what survives with reduce
+int pipeline_run(const pipeline *p, const int *input, size_t size);
+
+// Run every stage and store what survives in output (at most size ints);
+// returns how many. The reduce is not used.
+size_t pipeline_collect(const pipeline *p, const int *input, size_t size, int *output);
+
+// Define `static inline int name(const int *input, size_t size, int initial)`
+// computing reduce_array(filter_array(map_array(input))) in one loop. map,
+// predicate and operation must be visible at the point of use (static
+// inline functions or function-like macros) to get inlined.
+#define PIPELINE_FUSED(name, map, predicate, operation)                       \
+    static inline int name(const int *input, size_t size, int initial) {     \
+        int acc = initial;                                                    \
+        for (size_t i = 0; i < size; i++) {                                   \
+            int value = map(input[i]);                                        \
+            acc = predicate(value) ? operation(acc, value) : acc;             \
+        }                                                                     \
+        return acc;                                                           \
+    }
+
+#endif
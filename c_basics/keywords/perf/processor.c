@@ -0,0 +1,333 @@
+/*
+ * processor.c - Processor registry, graphs and the thread pool (see processor.h)
+ *
+ * A graph run splits the input into PROCESSOR_BLOCK-value blocks that the
+ * pool's threads claim one at a time from a shared counter. Each thread
+ * has one scratch block per node; a node the caller wants in full writes
+ * straight into its output array instead, and its children read it there.
+ *
+ * Timing counters are bumped once per block with relaxed atomics, so
+ * threads sharing a processor do not serialize on them.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "processor.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Double *capacity until it holds count + 1 items; 0 if out of memory
+static int grow(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity)
+        return 1;
+    size_t wanted = *capacity ? *capacity * 2 : 8;
+    void *bigger = realloc(*items, wanted * size);
+    if (bigger == NULL)
+        return 0;
+    *items = bigger;
+    *capacity = wanted;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Processors and the registry
+// ---------------------------------------------------------------------------
+
+int processor_apply_one(const Processor *p, int value) {
+    if (value > p->threshold)
+        return value;
+    if (p->transform != NULL)
+        return p->transform(value);
+    int out;
+    p->batch(&value, &out, 1);
+    return out;
+}
+
+// out = p(in) for one block of at most PROCESSOR_BLOCK values
+static void run_block(const Processor *p, const int *in, int *out, size_t n) {
+    if (p->batch == NULL) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = in[i] > p->threshold ? in[i] : p->transform(in[i]);
+    } else if (p->threshold == INT_MAX) {
+        p->batch(in, out, n);
+    } else {
+        // via a temporary, so in is still there to restore when out == in
+        int transformed[PROCESSOR_BLOCK];
+        p->batch(in, transformed, n);
+        // a mask rather than ?: so it compiles without a branch to mispredict
+        for (size_t i = 0; i < n; i++) {
+            int keep = -(in[i] > p->threshold);
+            out[i] = (in[i] & keep) | (transformed[i] & ~keep);
+        }
+    }
+}
+
+static void run_timed(processor_registry *registry, int id, const int *in, int *out, size_t n) {
+    uint64_t start = now_ns();
+    run_block(&registry->processors[id], in, out, n);
+    processor_stats *stats = &registry->stats[id];
+    __atomic_fetch_add(&stats->nanoseconds, now_ns() - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->elements, n, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->calls, 1, __ATOMIC_RELAXED);
+}
+
+void processor_registry_init(processor_registry *registry) {
+    registry->processors = NULL;
+    registry->stats = NULL;
+    registry->count = registry->capacity = 0;
+}
+
+void processor_registry_free(processor_registry *registry) {
+    free(registry->processors);
+    free(registry->stats);
+    processor_registry_init(registry);
+}
+
+int processor_register(processor_registry *registry, const Processor *p) {
+    if (p->transform == NULL && p->batch == NULL)
+        return -1;
+    size_t capacity = registry->capacity;
+    if (!grow((void **)&registry->processors, &capacity, registry->count, sizeof(Processor)))
+        return -1;
+    capacity = registry->capacity;
+    if (!grow((void **)&registry->stats, &capacity, registry->count, sizeof(processor_stats)))
+        return -1;
+    registry->capacity = capacity;
+    registry->processors[registry->count] = *p;
+    memset(&registry->stats[registry->count], 0, sizeof(processor_stats));
+    return (int)registry->count++;
+}
+
+int processor_find(const processor_registry *registry, const char *description) {
+    for (size_t i = 0; i < registry->count; i++) {
+        if (strcmp(registry->processors[i].description, description) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+void processor_apply(processor_registry *registry, int id, const int *in, int *out, size_t n) {
+    for (size_t start = 0; start < n; start += PROCESSOR_BLOCK) {
+        size_t count = n - start < PROCESSOR_BLOCK ? n - start : PROCESSOR_BLOCK;
+        run_timed(registry, id, in + start, out + start, count);
+    }
+}
+
+void processor_stats_get(const processor_registry *registry, int id, processor_stats *stats) {
+    const processor_stats *s = &registry->stats[id];
+    stats->calls = __atomic_load_n(&s->calls, __ATOMIC_RELAXED);
+    stats->elements = __atomic_load_n(&s->elements, __ATOMIC_RELAXED);
+    stats->nanoseconds = __atomic_load_n(&s->nanoseconds, __ATOMIC_RELAXED);
+}
+
+void processor_stats_reset(processor_registry *registry) {
+    memset(registry->stats, 0, registry->count * sizeof(processor_stats));
+}
+
+// ---------------------------------------------------------------------------
+// Thread pool
+// ---------------------------------------------------------------------------
+
+typedef void (*pool_job)(void *ctx, int worker);
+
+struct processor_pool {
+    pthread_t *ids;
+    int threads;                // workers plus the calling thread
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+    unsigned long generation;   // bumped for every job
+    int busy;                   // workers still in the current job
+    int stopping;
+    pool_job job;
+    void *ctx;
+};
+
+typedef struct {
+    processor_pool *pool;
+    int worker;
+} worker_arg;
+
+static void *worker_main(void *arg) {
+    worker_arg self = *(worker_arg *)arg;
+    free(arg);
+    processor_pool *pool = self.pool;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->stopping)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->stopping)
+            break;
+        seen = pool->generation;
+        pool_job job = pool->job;
+        void *ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+        job(ctx, self.worker);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+processor_pool *processor_pool_create(int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    processor_pool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+        return NULL;
+    pool->ids = malloc((size_t)threads * sizeof(pthread_t));
+    if (pool->ids == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->threads = 1;
+    // workers that fail to start just leave the pool smaller
+    for (int t = 1; t < threads; t++) {
+        worker_arg *arg = malloc(sizeof(*arg));
+        if (arg == NULL)
+            break;
+        *arg = (worker_arg){pool, pool->threads};
+        if (pthread_create(&pool->ids[pool->threads], NULL, worker_main, arg) != 0) {
+            free(arg);
+            break;
+        }
+        pool->threads++;
+    }
+    return pool;
+}
+
+void processor_pool_destroy(processor_pool *pool) {
+    if (pool == NULL)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 1; t < pool->threads; t++)
+        pthread_join(pool->ids[t], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    free(pool->ids);
+    free(pool);
+}
+
+int processor_pool_threads(const processor_pool *pool) {
+    return pool == NULL ? 1 : pool->threads;
+}
+
+// job(ctx, worker) on every thread, worker 0 being the caller; returns
+// when all of them are done
+static void pool_run(processor_pool *pool, pool_job job, void *ctx) {
+    if (pool == NULL || pool->threads == 1) {
+        job(ctx, 0);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->ctx = ctx;
+    pool->busy = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    job(ctx, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// ---------------------------------------------------------------------------
+// Graphs
+// ---------------------------------------------------------------------------
+
+void processor_graph_init(processor_graph *graph, processor_registry *registry) {
+    graph->registry = registry;
+    graph->nodes = NULL;
+    graph->count = graph->capacity = 0;
+}
+
+void processor_graph_free(processor_graph *graph) {
+    free(graph->nodes);
+    processor_graph_init(graph, graph->registry);
+}
+
+int processor_graph_add(processor_graph *graph, int processor, int input) {
+    if (processor < 0 || (size_t)processor >= graph->registry->count)
+        return -1;
+    if (input != PROCESSOR_GRAPH_INPUT && (input < 0 || (size_t)input >= graph->count))
+        return -1;
+    if (!grow((void **)&graph->nodes, &graph->capacity, graph->count, sizeof(processor_node)))
+        return -1;
+    graph->nodes[graph->count] = (processor_node){processor, input};
+    return (int)graph->count++;
+}
+
+typedef struct {
+    const processor_graph *graph;
+    const int *in;
+    size_t n, blocks;
+    int *const *outputs;
+    int *scratch;               // graph->count blocks per thread
+    size_t next_block;          // claimed with an atomic add
+} graph_job;
+
+// Where node i's results for the block at start go
+static int *node_output(const graph_job *job, int *scratch, size_t i, size_t start) {
+    if (job->outputs != NULL && job->outputs[i] != NULL)
+        return job->outputs[i] + start;
+    return scratch + i * PROCESSOR_BLOCK;
+}
+
+static void run_graph_blocks(void *ctx, int worker) {
+    graph_job *job = ctx;
+    const processor_graph *graph = job->graph;
+    int *scratch = job->scratch + (size_t)worker * graph->count * PROCESSOR_BLOCK;
+    for (;;) {
+        size_t block = __atomic_fetch_add(&job->next_block, 1, __ATOMIC_RELAXED);
+        if (block >= job->blocks)
+            break;
+        size_t start = block * PROCESSOR_BLOCK;
+        size_t count = job->n - start < PROCESSOR_BLOCK ? job->n - start : PROCESSOR_BLOCK;
+        for (size_t i = 0; i < graph->count; i++) {
+            const processor_node *node = &graph->nodes[i];
+            const int *from = node->input == PROCESSOR_GRAPH_INPUT
+                                  ? job->in + start
+                                  : node_output(job, scratch, (size_t)node->input, start);
+            run_timed(graph->registry, node->processor, from, node_output(job, scratch, i, start),
+                      count);
+        }
+    }
+}
+
+int processor_graph_run(const processor_graph *graph, processor_pool *pool, const int *in,
+                        size_t n, int *const *outputs) {
+    if (graph->count == 0 || n == 0)
+        return 1;
+    graph_job job = {graph, in, n, (n + PROCESSOR_BLOCK - 1) / PROCESSOR_BLOCK, outputs, NULL, 0};
+    size_t threads = (size_t)processor_pool_threads(pool);
+    job.scratch = malloc(threads * graph->count * PROCESSOR_BLOCK * sizeof(int));
+    if (job.scratch == NULL)
+        return 0;
+    pool_run(pool, run_graph_blocks, &job);
+    free(job.scratch);
+    return 1;
+}
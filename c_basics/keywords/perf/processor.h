@@ -0,0 +1,107 @@
+/*
+ * processor.h - PRACTICE 6's struct Processor, run a block at a time
+ *
+ * run.c's exercise applies a Processor (an int -> int function, a
+ * description and a threshold) to one number per call. Here a Processor
+ * also has a batch entry point that transforms a whole block per call
+ * (transforms.h's *_array functions fit it as is), and processors are
+ * registered once and wired into a graph:
+ *
+ *   processor_registry   owns the processors and their timing counters
+ *   processor_graph      nodes that each feed one processor the output of
+ *                        the graph input or of an earlier node, so one
+ *                        input can fan out into several chains
+ *   processor_pool       worker threads that share the blocks of a run
+ *
+ * processor_graph_run walks the input PROCESSOR_BLOCK values at a time and
+ * pushes each block through every node before taking the next, so the
+ * intermediate results stay in cache. Only the nodes the caller asks for
+ * are written out in full.
+ *
+ * Threshold: values above it pass through unchanged (factorial with 10
+ * only computes 0! to 10!). INT_MAX applies the processor to everything.
+ */
+
+#ifndef PROCESSOR_H
+#define PROCESSOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PROCESSOR_BLOCK
+#define PROCESSOR_BLOCK 4096    // 16 KiB of ints per node and thread
+#endif
+
+#define PROCESSOR_GRAPH_INPUT (-1)
+
+typedef int (*processor_fn)(int);
+typedef void (*processor_batch_fn)(const int *in, int *out, size_t n);
+
+typedef struct Processor {
+    processor_fn transform;
+    const char *description;
+    int threshold;
+    processor_batch_fn batch;   // NULL: transform is called per element
+} Processor;
+
+typedef struct {
+    uint64_t calls;             // blocks (or processor_apply calls)
+    uint64_t elements;
+    uint64_t nanoseconds;       // summed over threads
+} processor_stats;
+
+typedef struct {
+    Processor *processors;
+    processor_stats *stats;
+    size_t count, capacity;
+} processor_registry;
+
+typedef struct {
+    int processor;              // registry id
+    int input;                  // node id, or PROCESSOR_GRAPH_INPUT
+} processor_node;
+
+typedef struct {
+    processor_registry *registry;
+    processor_node *nodes;
+    size_t count, capacity;
+} processor_graph;
+
+typedef struct processor_pool processor_pool;
+
+// The exercise itself: one number, threshold applied
+int processor_apply_one(const Processor *p, int value);
+
+// Registry; functions returning an id give -1 on failure (out of memory,
+// not found, bad id). The registry copies the Processor but keeps the
+// description pointer.
+void processor_registry_init(processor_registry *registry);
+void processor_registry_free(processor_registry *registry);
+int processor_register(processor_registry *registry, const Processor *p);
+int processor_find(const processor_registry *registry, const char *description);
+
+// out = p(in) for n values, one batch call per block; out may be in
+void processor_apply(processor_registry *registry, int id, const int *in, int *out, size_t n);
+
+void processor_stats_get(const processor_registry *registry, int id, processor_stats *stats);
+void processor_stats_reset(processor_registry *registry);
+
+// Graph: nodes may only read from earlier nodes, so it is acyclic and
+// already in execution order
+void processor_graph_init(processor_graph *graph, processor_registry *registry);
+void processor_graph_free(processor_graph *graph);
+int processor_graph_add(processor_graph *graph, int processor, int input);
+
+// Run every node over in[0..n). outputs has one pointer per node: n ints
+// receive that node's results, NULL means the node is only an intermediate.
+// pool may be NULL to run on the calling thread. Returns 0 if scratch
+// memory cannot be allocated, 1 otherwise.
+int processor_graph_run(const processor_graph *graph, processor_pool *pool, const int *in,
+                        size_t n, int *const *outputs);
+
+// threads <= 0: one per CPU. The calling thread counts as one of them.
+processor_pool *processor_pool_create(int threads);
+void processor_pool_destroy(processor_pool *pool);
+int processor_pool_threads(const processor_pool *pool);
+
+#endif
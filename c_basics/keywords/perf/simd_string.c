@@ -0,0 +1,619 @@
+/*
+ * simd_string.c - Vectorized string helpers (see simd_string.h)
+ *
+ * uppercase: branchless. Adding 0x80 - 'a' moves 'a'..'z' to the bottom of
+ * the signed byte range, so one signed compare finds every lowercase
+ * letter and an XOR with 0x20 flips just those. Because uppercasing twice
+ * changes nothing, the last partial vector is done as a full vector that
+ * overlaps the previous one.
+ *
+ * reverse: swap a vector from each end, reversing the bytes with a shuffle
+ * (pshufb, plus a lane swap for AVX2, or vpermb for AVX-512). The middle
+ * is finished with two overlapping vectors, which is safe because both are
+ * loaded before either is stored.
+ *
+ * remove_vowels: find the vowels (pcmpistrm/pcmpestrm for SSE4.2, byte
+ * compares against the case-folded input otherwise), then compress the
+ * kept bytes. SSE4.2/AVX2 have no byte compress, so each 8 bytes are
+ * packed with a pshufb control looked up by their 8-bit keep mask and
+ * stored as a whole 8 bytes; the next store overwrites the unused part.
+ * AVX-512 VBMI2 compresses a whole 64-byte vector in one instruction.
+ * Writing in place is safe since the output never gets ahead of the input.
+ *
+ * The NUL-terminated versions make a single pass with aligned loads, so
+ * they never read past the page holding the terminator (reading a little
+ * past the NUL this way is what the C library's own string functions do).
+ * Stores never go past the NUL.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_STRING_X86 1
+#endif
+
+#include "simd_string.h"
+
+// Bit k set for the k-th letter of the alphabet that is a vowel (a e i o u)
+#define VOWEL_BITS ((1u << 0) | (1u << 4) | (1u << 8) | (1u << 14) | (1u << 20))
+
+static inline int is_vowel(unsigned char c) {
+    unsigned k = (unsigned char)(c | 0x20) - 'a';
+    return k < 26 && (VOWEL_BITS >> k) & 1;
+}
+
+static inline char to_upper(char c) {
+    return (char)(c ^ (((unsigned)(unsigned char)c - 'a' < 26u) << 5));
+}
+
+// ---------------------------------------------------------------------------
+// Plain C
+// ---------------------------------------------------------------------------
+
+static void reverse_scalar(char *buf, size_t len) {
+    char *left = buf, *right = buf + len;
+    while (right - left >= 2) {
+        char tmp = *left;
+        *left++ = *--right;
+        *right = tmp;
+    }
+}
+
+static void uppercase_scalar(char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        buf[i] = to_upper(buf[i]);
+}
+
+static size_t remove_vowels_scalar(char *buf, size_t len) {
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        buf[j] = buf[i];
+        j += !is_vowel(buf[i]);
+    }
+    return j;
+}
+
+static char *uppercase_string_scalar(char *str) {
+    for (char *p = str; *p; p++)
+        *p = to_upper(*p);
+    return str;
+}
+
+static char *remove_vowels_string_scalar(char *str) {
+    char *dst = str, *src = str;
+    for (; *src; src++) {
+        *dst = *src;
+        dst += !is_vowel(*src);
+    }
+    *dst = '\0';
+    return str;
+}
+
+#ifdef SIMD_STRING_X86
+
+// pshufb controls that pack the set bytes of an 8-bit mask to the front;
+// 0x80 zeroes the unused bytes. Filled in by simd_string_init.
+static uint64_t compress_lut[256];
+
+static void build_compress_lut(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        uint64_t control = 0x8080808080808080ULL;
+        int out = 0;
+        for (int i = 0; i < 8; i++) {
+            if (mask & (1 << i)) {
+                control &= ~(0xFFULL << (out * 8));
+                control |= (uint64_t)i << (out * 8);
+                out++;
+            }
+        }
+        compress_lut[mask] = control;
+    }
+}
+
+#define LANE_HIGH_HALF 0x0808080808080808ULL
+
+// ---------------------------------------------------------------------------
+// SSE4.2 (16 bytes at a time)
+// ---------------------------------------------------------------------------
+
+#define SSE_TARGET __attribute__((target("sse4.2,popcnt")))
+#define VOWEL_SET_MODE (_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK)
+
+SSE_TARGET static inline __m128i uppercase_16(__m128i v) {
+    __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - 'a')));
+    __m128i lower = _mm_cmplt_epi8(shifted, _mm_set1_epi8((char)(-128 + 26)));
+    return _mm_xor_si128(v, _mm_and_si128(lower, _mm_set1_epi8(0x20)));
+}
+
+SSE_TARGET static inline __m128i reverse_16(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                             7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// Store the bytes of v selected by the 16-bit keep mask at dst, return how
+// many. Writes up to dst + 16.
+SSE_TARGET static inline size_t compress_16(char *dst, __m128i v, unsigned keep) {
+    unsigned lo = keep & 0xFF, hi = keep >> 8;
+    __m128i control = _mm_set_epi64x((long long)(compress_lut[hi] + LANE_HIGH_HALF),
+                                     (long long)compress_lut[lo]);
+    __m128i packed = _mm_shuffle_epi8(v, control);
+    size_t low_count = (size_t)__builtin_popcount(lo);
+    _mm_storel_epi64((__m128i *)dst, packed);
+    _mm_storel_epi64((__m128i *)(dst + low_count), _mm_unpackhi_epi64(packed, packed));
+    return low_count + (size_t)__builtin_popcount(hi);
+}
+
+SSE_TARGET static void reverse_sse42(char *buf, size_t len) {
+    char *left = buf, *right = buf + len;
+    while (right - left >= 32) {
+        __m128i a = _mm_loadu_si128((const __m128i *)left);
+        __m128i b = _mm_loadu_si128((const __m128i *)(right - 16));
+        _mm_storeu_si128((__m128i *)left, reverse_16(b));
+        _mm_storeu_si128((__m128i *)(right - 16), reverse_16(a));
+        left += 16;
+        right -= 16;
+    }
+    if (right - left >= 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)left);
+        __m128i b = _mm_loadu_si128((const __m128i *)(right - 16));
+        _mm_storeu_si128((__m128i *)left, reverse_16(b));
+        _mm_storeu_si128((__m128i *)(right - 16), reverse_16(a));
+        return;
+    }
+    reverse_scalar(left, (size_t)(right - left));
+}
+
+SSE_TARGET static void uppercase_sse42(char *buf, size_t len) {
+    if (len < 16) {
+        uppercase_scalar(buf, len);
+        return;
+    }
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        _mm_storeu_si128((__m128i *)(buf + i), uppercase_16(v));
+    }
+    if (i < len) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + len - 16));
+        _mm_storeu_si128((__m128i *)(buf + len - 16), uppercase_16(v));
+    }
+}
+
+SSE_TARGET static size_t remove_vowels_sse42(char *buf, size_t len) {
+    const __m128i vowels = _mm_setr_epi8('a', 'e', 'i', 'o', 'u', 'A', 'E', 'I',
+                                         'O', 'U', 0, 0, 0, 0, 0, 0);
+    size_t i = 0, j = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        // explicit lengths, since a length-based buffer may hold NULs
+        __m128i found = _mm_cmpestrm(vowels, 10, v, 16, VOWEL_SET_MODE);
+        j += compress_16(buf + j, v, ~(unsigned)_mm_cvtsi128_si32(found) & 0xFFFF);
+    }
+    for (; i < len; i++) {
+        buf[j] = buf[i];
+        j += !is_vowel(buf[i]);
+    }
+    return j;
+}
+
+SSE_TARGET static char *uppercase_string_sse42(char *str) {
+    char *p = str;
+    for (; ((uintptr_t)p & 15) != 0; p++) {
+        if (*p == '\0')
+            return str;
+        *p = to_upper(*p);
+    }
+    for (;; p += 16) {
+        __m128i v = _mm_load_si128((const __m128i *)p);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0)
+            break;
+        _mm_store_si128((__m128i *)p, uppercase_16(v));
+    }
+    uppercase_string_scalar(p);
+    return str;
+}
+
+SSE_TARGET static char *remove_vowels_string_sse42(char *str) {
+    const __m128i vowels = _mm_setr_epi8('a', 'e', 'i', 'o', 'u', 'A', 'E', 'I',
+                                         'O', 'U', 0, 0, 0, 0, 0, 0);
+    char *src = str, *dst = str;
+    for (; ((uintptr_t)src & 15) != 0; src++) {
+        if (*src == '\0') {
+            *dst = '\0';
+            return str;
+        }
+        *dst = *src;
+        dst += !is_vowel(*src);
+    }
+    for (;; src += 16) {
+        __m128i v = _mm_load_si128((const __m128i *)src);
+        // implicit length: the block is known to have no NUL once this passes
+        if (_mm_cmpistrz(vowels, v, VOWEL_SET_MODE))
+            break;
+        __m128i found = _mm_cmpistrm(vowels, v, VOWEL_SET_MODE);
+        dst += compress_16(dst, v, ~(unsigned)_mm_cvtsi128_si32(found) & 0xFFFF);
+    }
+    for (; *src; src++) {
+        *dst = *src;
+        dst += !is_vowel(*src);
+    }
+    *dst = '\0';
+    return str;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 (32 bytes at a time)
+// ---------------------------------------------------------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+
+AVX2_TARGET static inline __m256i uppercase_32(__m256i v) {
+    __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - 'a')));
+    __m256i lower = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)), shifted);
+    return _mm256_xor_si256(v, _mm256_and_si256(lower, _mm256_set1_epi8(0x20)));
+}
+
+AVX2_TARGET static inline __m256i reverse_32(__m256i v) {
+    const __m256i in_lane = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                             15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, in_lane), 0x4E);
+}
+
+// Mask of the bytes of v that are vowels, either case
+AVX2_TARGET static inline unsigned vowels_32(__m256i v) {
+    __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i found = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('a'));
+    found = _mm256_or_si256(found, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('e')));
+    found = _mm256_or_si256(found, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('i')));
+    found = _mm256_or_si256(found, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('o')));
+    found = _mm256_or_si256(found, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('u')));
+    return (unsigned)_mm256_movemask_epi8(found);
+}
+
+// 32-byte version of compress_16. Writes up to dst + 32.
+AVX2_TARGET static inline size_t compress_32(char *dst, __m256i v, unsigned keep) {
+    unsigned k0 = keep & 0xFF, k1 = (keep >> 8) & 0xFF;
+    unsigned k2 = (keep >> 16) & 0xFF, k3 = keep >> 24;
+    __m256i control = _mm256_set_epi64x((long long)(compress_lut[k3] + LANE_HIGH_HALF),
+                                        (long long)compress_lut[k2],
+                                        (long long)(compress_lut[k1] + LANE_HIGH_HALF),
+                                        (long long)compress_lut[k0]);
+    __m256i packed = _mm256_shuffle_epi8(v, control);
+    __m128i low = _mm256_castsi256_si128(packed);
+    __m128i high = _mm256_extracti128_si256(packed, 1);
+    size_t c0 = (size_t)__builtin_popcount(k0), c1 = (size_t)__builtin_popcount(k1);
+    size_t c2 = (size_t)__builtin_popcount(k2);
+    _mm_storel_epi64((__m128i *)dst, low);
+    _mm_storel_epi64((__m128i *)(dst + c0), _mm_unpackhi_epi64(low, low));
+    _mm_storel_epi64((__m128i *)(dst + c0 + c1), high);
+    _mm_storel_epi64((__m128i *)(dst + c0 + c1 + c2), _mm_unpackhi_epi64(high, high));
+    return c0 + c1 + c2 + (size_t)__builtin_popcount(k3);
+}
+
+AVX2_TARGET static void reverse_avx2(char *buf, size_t len) {
+    char *left = buf, *right = buf + len;
+    while (right - left >= 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)left);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(right - 32));
+        _mm256_storeu_si256((__m256i *)left, reverse_32(b));
+        _mm256_storeu_si256((__m256i *)(right - 32), reverse_32(a));
+        left += 32;
+        right -= 32;
+    }
+    if (right - left >= 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)left);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(right - 32));
+        _mm256_storeu_si256((__m256i *)left, reverse_32(b));
+        _mm256_storeu_si256((__m256i *)(right - 32), reverse_32(a));
+        return;
+    }
+    reverse_sse42(left, (size_t)(right - left));
+}
+
+AVX2_TARGET static void uppercase_avx2(char *buf, size_t len) {
+    if (len < 32) {
+        uppercase_sse42(buf, len);
+        return;
+    }
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        _mm256_storeu_si256((__m256i *)(buf + i), uppercase_32(v));
+    }
+    if (i < len) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + len - 32));
+        _mm256_storeu_si256((__m256i *)(buf + len - 32), uppercase_32(v));
+    }
+}
+
+AVX2_TARGET static size_t remove_vowels_avx2(char *buf, size_t len) {
+    size_t i = 0, j = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        j += compress_32(buf + j, v, ~vowels_32(v));
+    }
+    for (; i < len; i++) {
+        buf[j] = buf[i];
+        j += !is_vowel(buf[i]);
+    }
+    return j;
+}
+
+AVX2_TARGET static char *uppercase_string_avx2(char *str) {
+    char *p = str;
+    for (; ((uintptr_t)p & 31) != 0; p++) {
+        if (*p == '\0')
+            return str;
+        *p = to_upper(*p);
+    }
+    for (;; p += 32) {
+        __m256i v = _mm256_load_si256((const __m256i *)p);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())) != 0)
+            break;
+        _mm256_store_si256((__m256i *)p, uppercase_32(v));
+    }
+    uppercase_string_scalar(p);
+    return str;
+}
+
+AVX2_TARGET static char *remove_vowels_string_avx2(char *str) {
+    char *src = str, *dst = str;
+    for (; ((uintptr_t)src & 31) != 0; src++) {
+        if (*src == '\0') {
+            *dst = '\0';
+            return str;
+        }
+        *dst = *src;
+        dst += !is_vowel(*src);
+    }
+    for (;; src += 32) {
+        __m256i v = _mm256_load_si256((const __m256i *)src);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256())) != 0)
+            break;
+        dst += compress_32(dst, v, ~vowels_32(v));
+    }
+    for (; *src; src++) {
+        *dst = *src;
+        dst += !is_vowel(*src);
+    }
+    *dst = '\0';
+    return str;
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 BW/VBMI/VBMI2 (64 bytes at a time, masked loads/stores for edges)
+// ---------------------------------------------------------------------------
+
+#define AVX512_TARGET __attribute__((target("avx512bw,avx512vbmi,avx512vbmi2,popcnt")))
+
+// Bytes [0, n) of a 64-byte vector, n <= 64
+static inline uint64_t first_bytes(size_t n) {
+    return n >= 64 ? ~0ULL : (1ULL << n) - 1;
+}
+
+AVX512_TARGET static inline __m512i uppercase_64(__m512i v, __mmask64 active) {
+    __mmask64 lower = _mm512_mask_cmplt_epu8_mask(
+        active, _mm512_sub_epi8(v, _mm512_set1_epi8('a')), _mm512_set1_epi8(26));
+    return _mm512_mask_sub_epi8(v, lower, v, _mm512_set1_epi8(0x20));
+}
+
+AVX512_TARGET static inline __mmask64 vowels_64(__m512i v) {
+    __m512i folded = _mm512_or_si512(v, _mm512_set1_epi8(0x20));
+    return _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('a')) |
+           _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('e')) |
+           _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('i')) |
+           _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('o')) |
+           _mm512_cmpeq_epi8_mask(folded, _mm512_set1_epi8('u'));
+}
+
+AVX512_TARGET static void reverse_avx512(char *buf, size_t len) {
+    const __m512i iota = _mm512_set_epi8(
+        63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48,
+        47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32,
+        31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i reversed = _mm512_sub_epi8(_mm512_set1_epi8(63), iota);
+    char *left = buf, *right = buf + len;
+    while (right - left >= 128) {
+        __m512i a = _mm512_loadu_si512(left);
+        __m512i b = _mm512_loadu_si512(right - 64);
+        _mm512_storeu_si512(left, _mm512_permutexvar_epi8(reversed, b));
+        _mm512_storeu_si512(right - 64, _mm512_permutexvar_epi8(reversed, a));
+        left += 64;
+        right -= 64;
+    }
+    if (right - left >= 64) {
+        __m512i a = _mm512_loadu_si512(left);
+        __m512i b = _mm512_loadu_si512(right - 64);
+        _mm512_storeu_si512(left, _mm512_permutexvar_epi8(reversed, b));
+        _mm512_storeu_si512(right - 64, _mm512_permutexvar_epi8(reversed, a));
+        return;
+    }
+    // fewer than 64 bytes left: one masked vector, byte k takes byte n-1-k
+    size_t n = (size_t)(right - left);
+    __mmask64 active = first_bytes(n);
+    __m512i v = _mm512_maskz_loadu_epi8(active, left);
+    __m512i control = _mm512_sub_epi8(_mm512_set1_epi8((char)(n - 1)), iota);
+    _mm512_mask_storeu_epi8(left, active, _mm512_permutexvar_epi8(control, v));
+}
+
+AVX512_TARGET static void uppercase_avx512(char *buf, size_t len) {
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m512i v = _mm512_loadu_si512(buf + i);
+        _mm512_storeu_si512(buf + i, uppercase_64(v, ~0ULL));
+    }
+    if (i < len) {
+        __mmask64 active = first_bytes(len - i);
+        __m512i v = _mm512_maskz_loadu_epi8(active, buf + i);
+        _mm512_mask_storeu_epi8(buf + i, active, uppercase_64(v, active));
+    }
+}
+
+AVX512_TARGET static size_t remove_vowels_avx512(char *buf, size_t len) {
+    size_t i = 0, j = 0;
+    // compress in a register and store all 64 bytes: the memory form of
+    // vpcompressb is much slower, and the spare bytes land on input that
+    // has already been read
+    for (; i + 64 <= len; i += 64) {
+        __m512i v = _mm512_loadu_si512(buf + i);
+        __mmask64 keep = ~vowels_64(v);
+        _mm512_storeu_si512(buf + j, _mm512_maskz_compress_epi8(keep, v));
+        j += (size_t)__builtin_popcountll(keep);
+    }
+    if (i < len) {
+        __mmask64 active = first_bytes(len - i);
+        __m512i v = _mm512_maskz_loadu_epi8(active, buf + i);
+        __mmask64 keep = active & ~vowels_64(v);
+        _mm512_mask_compressstoreu_epi8(buf + j, keep, v);
+        j += (size_t)__builtin_popcountll(keep);
+    }
+    return j;
+}
+
+// The NUL-terminated versions load whole aligned blocks, including the part
+// of the first block before str, and mask off what is not the string
+
+AVX512_TARGET static char *uppercase_string_avx512(char *str) {
+    char *block = (char *)((uintptr_t)str & ~(uintptr_t)63);
+    __mmask64 active = ~0ULL << (str - block);
+    for (;; block += 64, active = ~0ULL) {
+        __m512i v = _mm512_load_si512(block);
+        __mmask64 nul = _mm512_mask_cmpeq_epi8_mask(active, v, _mm512_setzero_si512());
+        if (nul != 0) {
+            active &= (nul & -nul) - 1;
+            _mm512_mask_storeu_epi8(block, active, uppercase_64(v, active));
+            return str;
+        }
+        _mm512_mask_storeu_epi8(block, active, uppercase_64(v, active));
+    }
+}
+
+AVX512_TARGET static char *remove_vowels_string_avx512(char *str) {
+    char *block = (char *)((uintptr_t)str & ~(uintptr_t)63);
+    char *dst = str;
+    __mmask64 active = ~0ULL << (str - block);
+    // first block through the masked store: a full store from dst would
+    // run past the end of the block
+    __m512i v = _mm512_load_si512(block);
+    __mmask64 nul = _mm512_mask_cmpeq_epi8_mask(active, v, _mm512_setzero_si512());
+    for (;;) {
+        if (nul != 0)
+            active &= (nul & -nul) - 1;
+        __mmask64 keep = active & ~vowels_64(v);
+        _mm512_mask_compressstoreu_epi8(dst, keep, v);
+        dst += __builtin_popcountll(keep);
+        if (nul != 0)
+            break;
+        // whole blocks: dst is never past the block start, so all 64 bytes
+        // can be stored
+        for (;;) {
+            block += 64;
+            v = _mm512_load_si512(block);
+            nul = _mm512_cmpeq_epi8_mask(v, _mm512_setzero_si512());
+            if (nul != 0)
+                break;
+            keep = ~vowels_64(v);
+            _mm512_storeu_si512(dst, _mm512_maskz_compress_epi8(keep, v));
+            dst += __builtin_popcountll(keep);
+        }
+        active = ~0ULL;
+    }
+    *dst = '\0';
+    return str;
+}
+
+#endif // SIMD_STRING_X86
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    void (*reverse)(char *, size_t);
+    void (*uppercase)(char *, size_t);
+    size_t (*remove_vowels)(char *, size_t);
+    char *(*uppercase_string)(char *);
+    char *(*remove_vowels_string)(char *);
+} implementation;
+
+static const implementation implementations[SIMD_STRING_ISA_COUNT] = {
+    [SIMD_STRING_SCALAR] = {"scalar", reverse_scalar, uppercase_scalar, remove_vowels_scalar,
+                            uppercase_string_scalar, remove_vowels_string_scalar},
+#ifdef SIMD_STRING_X86
+    [SIMD_STRING_SSE42] = {"sse4.2", reverse_sse42, uppercase_sse42, remove_vowels_sse42,
+                           uppercase_string_sse42, remove_vowels_string_sse42},
+    [SIMD_STRING_AVX2] = {"avx2", reverse_avx2, uppercase_avx2, remove_vowels_avx2,
+                          uppercase_string_avx2, remove_vowels_string_avx2},
+    [SIMD_STRING_AVX512] = {"avx512", reverse_avx512, uppercase_avx512, remove_vowels_avx512,
+                            uppercase_string_avx512, remove_vowels_string_avx512},
+#else
+    [SIMD_STRING_SSE42] = {"sse4.2", NULL, NULL, NULL, NULL, NULL},
+    [SIMD_STRING_AVX2] = {"avx2", NULL, NULL, NULL, NULL, NULL},
+    [SIMD_STRING_AVX512] = {"avx512", NULL, NULL, NULL, NULL, NULL},
+#endif
+};
+
+static const implementation *selected = &implementations[SIMD_STRING_SCALAR];
+
+int simd_string_supported(enum simd_string_isa isa) {
+    switch (isa) {
+    case SIMD_STRING_SCALAR:
+        return 1;
+#ifdef SIMD_STRING_X86
+    case SIMD_STRING_SSE42:
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("ssse3") &&
+               __builtin_cpu_supports("popcnt");
+    case SIMD_STRING_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case SIMD_STRING_AVX512:
+        return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi") &&
+               __builtin_cpu_supports("avx512vbmi2") && __builtin_cpu_supports("popcnt");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int simd_string_use(enum simd_string_isa isa) {
+    if (!simd_string_supported(isa))
+        return 0;
+    selected = &implementations[isa];
+    return 1;
+}
+
+enum simd_string_isa simd_string_active(void) {
+    return (enum simd_string_isa)(selected - implementations);
+}
+
+const char *simd_string_isa_name(enum simd_string_isa isa) {
+    return isa < SIMD_STRING_ISA_COUNT ? implementations[isa].name : "unknown";
+}
+
+// Runs before main(), so the table and the choice are in place before any
+// thread can call in
+__attribute__((constructor)) static void simd_string_init(void) {
+#ifdef SIMD_STRING_X86
+    __builtin_cpu_init();
+    build_compress_lut();
+#endif
+    for (int isa = SIMD_STRING_ISA_COUNT - 1; isa > SIMD_STRING_SCALAR; isa--) {
+        if (simd_string_use((enum simd_string_isa)isa))
+            break;
+    }
+}
+
+char *simd_reverse_string(char *str) {
+    selected->reverse(str, strlen(str));
+    return str;
+}
+
+char *simd_uppercase_string(char *str) { return selected->uppercase_string(str); }
+char *simd_remove_vowels(char *str) { return selected->remove_vowels_string(str); }
+
+void simd_reverse(char *buf, size_t len) { selected->reverse(buf, len); }
+void simd_uppercase(char *buf, size_t len) { selected->uppercase(buf, len); }
+size_t simd_remove_vowels_n(char *buf, size_t len) { return selected->remove_vowels(buf, len); }
@@ -0,0 +1,43 @@
+/*
+ * simd_string.h - Vectorized versions of run.c's string helpers
+ *
+ * The *_string functions are drop-in replacements for reverse_string,
+ * uppercase_string and remove_vowels (same char *(*)(char *) signature,
+ * same results). The length-based functions work on a buffer of known
+ * size and do not look at or write a terminating NUL.
+ *
+ * Every call goes through the implementation picked for this CPU on first
+ * use: AVX-512 (BW + VBMI + VBMI2), AVX2, SSE4.2 or plain C. simd_string_use
+ * forces a level, which the benchmark and fuzz tests use to cover them all.
+ */
+
+#ifndef SIMD_STRING_H
+#define SIMD_STRING_H
+
+#include <stddef.h>
+
+enum simd_string_isa {
+    SIMD_STRING_SCALAR,
+    SIMD_STRING_SSE42,
+    SIMD_STRING_AVX2,
+    SIMD_STRING_AVX512,
+    SIMD_STRING_ISA_COUNT
+};
+
+// Drop-in replacements for the run.c helpers (NUL-terminated, in place)
+char *simd_reverse_string(char *str);
+char *simd_uppercase_string(char *str);
+char *simd_remove_vowels(char *str);
+
+// The same transforms on len bytes; remove_vowels returns the new length
+void simd_reverse(char *buf, size_t len);
+void simd_uppercase(char *buf, size_t len);
+size_t simd_remove_vowels_n(char *buf, size_t len);
+
+// Implementation selection
+int simd_string_supported(enum simd_string_isa isa);
+int simd_string_use(enum simd_string_isa isa);   // 0 if not supported here
+enum simd_string_isa simd_string_active(void);
+const char *simd_string_isa_name(enum simd_string_isa isa);
+
+#endif
@@ -0,0 +1,398 @@
+/*
+ * sort.c - Sorting for int arrays (see sort.h)
+ *
+ * Introsort is written once as a macro and instantiated twice: with the
+ * caller's comparator and with a plain < that the compiler inlines.
+ *
+ * The radix sorts treat ints as unsigned with the sign bit flipped, which
+ * orders them correctly, and count all four bytes in one pass over the
+ * input before scattering.
+ *
+ * sort_parallel radix-sorts one slice per thread, then merges pairs of runs
+ * level by level. Each merge is itself split between threads along its
+ * "merge path" (a binary search per split point finds how many elements
+ * come from each run), so the last level, a single merge, still uses every
+ * thread.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sort.h"
+
+#define INSERTION_THRESHOLD 16
+#define SIGN_FLIP 0x80000000u
+
+void bubble_sort(int arr[], int size, sort_comparator compare) {
+    for (int i = 0; i < size - 1; i++) {
+        for (int j = 0; j < size - 1 - i; j++) {
+            if (compare(arr[j], arr[j + 1]) > 0) {
+                int tmp = arr[j];
+                arr[j] = arr[j + 1];
+                arr[j + 1] = tmp;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Introsort
+// ---------------------------------------------------------------------------
+
+static int floor_log2(size_t n) {
+    int log = 0;
+    while (n >>= 1)
+        log++;
+    return log;
+}
+
+static inline void swap_ints(int *a, int *b) {
+    int tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// LESS(x, y) may use `compare`, which every function passes along
+#define DEFINE_INTROSORT(prefix, LESS)                                                \
+    static void prefix##_insertion(int *a, size_t n, sort_comparator compare) {      \
+        for (size_t i = 1; i < n; i++) {                                             \
+            int value = a[i];                                                        \
+            size_t j = i;                                                            \
+            for (; j > 0 && LESS(value, a[j - 1]); j--)                              \
+                a[j] = a[j - 1];                                                     \
+            a[j] = value;                                                            \
+        }                                                                            \
+        (void)compare;                                                               \
+    }                                                                                \
+                                                                                     \
+    static void prefix##_sift_down(int *a, size_t root, size_t n,                    \
+                                   sort_comparator compare) {                        \
+        int value = a[root];                                                         \
+        for (size_t child; (child = 2 * root + 1) < n; root = child) {               \
+            if (child + 1 < n && LESS(a[child], a[child + 1]))                       \
+                child++;                                                             \
+            if (!LESS(value, a[child]))                                              \
+                break;                                                               \
+            a[root] = a[child];                                                      \
+        }                                                                            \
+        a[root] = value;                                                             \
+        (void)compare;                                                               \
+    }                                                                                \
+                                                                                     \
+    static void prefix##_heapsort(int *a, size_t n, sort_comparator compare) {       \
+        for (size_t i = n / 2; i-- > 0;)                                             \
+            prefix##_sift_down(a, i, n, compare);                                    \
+        for (size_t end = n - 1; end > 0; end--) {                                   \
+            swap_ints(&a[0], &a[end]);                                               \
+            prefix##_sift_down(a, 0, end, compare);                                  \
+        }                                                                            \
+    }                                                                                \
+                                                                                     \
+    static void prefix##_loop(int *a, size_t n, int depth, sort_comparator compare) { \
+        while (n > INSERTION_THRESHOLD) {                                            \
+            if (depth-- == 0) {                                                      \
+                prefix##_heapsort(a, n, compare);                                    \
+                return;                                                              \
+            }                                                                        \
+            /* median of three, which also leaves sentinels at both ends */          \
+            size_t mid = n / 2;                                                      \
+            if (LESS(a[mid], a[0]))                                                  \
+                swap_ints(&a[mid], &a[0]);                                           \
+            if (LESS(a[n - 1], a[mid])) {                                            \
+                swap_ints(&a[n - 1], &a[mid]);                                       \
+                if (LESS(a[mid], a[0]))                                              \
+                    swap_ints(&a[mid], &a[0]);                                       \
+            }                                                                        \
+            int pivot = a[mid];                                                      \
+            size_t i = 0, j = n - 1;                                                 \
+            for (;;) {                                                               \
+                do                                                                   \
+                    i++;                                                             \
+                while (LESS(a[i], pivot));                                           \
+                do                                                                   \
+                    j--;                                                             \
+                while (LESS(pivot, a[j]));                                           \
+                if (i >= j)                                                          \
+                    break;                                                           \
+                swap_ints(&a[i], &a[j]);                                             \
+            }                                                                        \
+            /* recurse into the smaller side, loop on the larger */                  \
+            size_t left = j + 1;                                                     \
+            if (left < n - left) {                                                   \
+                prefix##_loop(a, left, depth, compare);                              \
+                a += left;                                                           \
+                n -= left;                                                           \
+            } else {                                                                 \
+                prefix##_loop(a + left, n - left, depth, compare);                   \
+                n = left;                                                            \
+            }                                                                        \
+        }                                                                            \
+        prefix##_insertion(a, n, compare);                                           \
+    }
+
+#define COMPARATOR_LESS(x, y) (compare((x), (y)) < 0)
+#define ASCENDING_LESS(x, y) ((x) < (y))
+
+DEFINE_INTROSORT(comparator, COMPARATOR_LESS)
+DEFINE_INTROSORT(ascending, ASCENDING_LESS)
+
+void sort_introsort(int *arr, size_t n, sort_comparator compare) {
+    if (n > 1)
+        comparator_loop(arr, n, 2 * floor_log2(n), compare);
+}
+
+void sort_ints(int *arr, size_t n) {
+    if (n > 1)
+        ascending_loop(arr, n, 2 * floor_log2(n), NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Radix sorts
+// ---------------------------------------------------------------------------
+
+// Sort keys (ints viewed as unsigned) using tmp, leaving the result in keys
+static void radix_sort_with(unsigned *keys, unsigned *tmp, size_t n) {
+    if (n < 2)
+        return;
+    size_t counts[4][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        unsigned key = keys[i] ^ SIGN_FLIP;
+        counts[0][key & 0xFF]++;
+        counts[1][(key >> 8) & 0xFF]++;
+        counts[2][(key >> 16) & 0xFF]++;
+        counts[3][key >> 24]++;
+    }
+
+    unsigned *src = keys, *dst = tmp;
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = pass * 8;
+        size_t *count = counts[pass];
+        if (count[((src[0] ^ SIGN_FLIP) >> shift) & 0xFF] == n)
+            continue;   // every key has the same byte here
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++)
+            dst[count[((src[i] ^ SIGN_FLIP) >> shift) & 0xFF]++] = src[i];
+        unsigned *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != keys)
+        memcpy(keys, src, n * sizeof(*keys));
+}
+
+int sort_radix(int *arr, size_t n) {
+    if (n <= 64) {
+        sort_ints(arr, n);
+        return 1;
+    }
+    unsigned *tmp = malloc(n * sizeof(*tmp));
+    if (tmp == NULL)
+        return 0;
+    radix_sort_with((unsigned *)arr, tmp, n);
+    free(tmp);
+    return 1;
+}
+
+int sort_by_key(int *arr, size_t n, int (*key)(int)) {
+    if (n < 2)
+        return 1;
+    // (flipped key << 32 | value): sorting on the top half is stable
+    uint64_t *pairs = malloc(2 * n * sizeof(*pairs));
+    if (pairs == NULL)
+        return 0;
+    uint64_t *src = pairs, *dst = pairs + n;
+    size_t counts[4][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        unsigned k = (unsigned)key(arr[i]) ^ SIGN_FLIP;
+        src[i] = (uint64_t)k << 32 | (unsigned)arr[i];
+        counts[0][k & 0xFF]++;
+        counts[1][(k >> 8) & 0xFF]++;
+        counts[2][(k >> 16) & 0xFF]++;
+        counts[3][k >> 24]++;
+    }
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = 32 + pass * 8;
+        size_t *count = counts[pass];
+        if (count[(src[0] >> shift) & 0xFF] == n)
+            continue;
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++)
+            dst[count[(src[i] >> shift) & 0xFF]++] = src[i];
+        uint64_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    for (size_t i = 0; i < n; i++)
+        arr[i] = (int)(unsigned)src[i];
+    free(pairs);
+    return 1;
+}
+
+// Same as run.c's compare_by_digit_sum: negative numbers count as 0
+static int digit_sum(int n) {
+    int sum = 0;
+    while (n > 0) {
+        sum += n % 10;
+        n /= 10;
+    }
+    return sum;
+}
+
+int sort_by_digit_sum(int *arr, size_t n) { return sort_by_key(arr, n, digit_sum); }
+
+// ---------------------------------------------------------------------------
+// Parallel merge sort
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const unsigned *a, *b;      // the two runs (b empty: plain copy)
+    size_t a_len, b_len;
+    unsigned *out;
+    unsigned *keys, *tmp;       // for the initial radix sort of a slice
+    size_t n;
+} sort_task;
+
+// Where output position d falls in a merge of a and b: how many elements
+// of a come first (ties go to a, so the merge is stable)
+static size_t merge_path(const int *a, size_t a_len, const int *b, size_t b_len, size_t d) {
+    size_t lo = d > b_len ? d - b_len : 0;
+    size_t hi = d < a_len ? d : a_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] <= b[d - mid - 1])
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void *run_slice_sort(void *arg) {
+    sort_task *t = arg;
+    radix_sort_with(t->keys, t->tmp, t->n);
+    return NULL;
+}
+
+static void *run_merge(void *arg) {
+    sort_task *t = arg;
+    const int *a = (const int *)t->a, *b = (const int *)t->b;
+    int *out = (int *)t->out;
+    size_t i = 0, j = 0, k = 0;
+    while (i < t->a_len && j < t->b_len)
+        out[k++] = b[j] < a[i] ? b[j++] : a[i++];
+    memcpy(out + k, a + i, (t->a_len - i) * sizeof(int));
+    k += t->a_len - i;
+    memcpy(out + k, b + j, (t->b_len - j) * sizeof(int));
+    return NULL;
+}
+
+// Run tasks on their own threads (the first on this one), then wait
+static void run_tasks(sort_task *tasks, size_t count, void *(*fn)(void *)) {
+    pthread_t *threads = malloc(count * sizeof(*threads));
+    char *started = calloc(count, 1);
+    for (size_t i = 1; i < count; i++) {
+        if (threads != NULL && started != NULL &&
+            pthread_create(&threads[i], NULL, fn, &tasks[i]) == 0)
+            started[i] = 1;
+    }
+    fn(&tasks[0]);
+    for (size_t i = 1; i < count; i++) {
+        if (started != NULL && started[i])
+            pthread_join(threads[i], NULL);
+        else
+            fn(&tasks[i]);
+    }
+    free(threads);
+    free(started);
+}
+
+int sort_parallel(int *arr, size_t n, int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if ((size_t)threads > n / 4096 + 1)
+        threads = (int)(n / 4096 + 1);   // not worth a thread per few KiB
+    if (threads == 1)
+        return sort_radix(arr, n);
+
+    unsigned *scratch = malloc(n * sizeof(*scratch));
+    sort_task *tasks = malloc((size_t)threads * sizeof(*tasks));
+    size_t *bounds = malloc(((size_t)threads + 1) * sizeof(*bounds));
+    if (scratch == NULL || tasks == NULL || bounds == NULL) {
+        free(scratch);
+        free(tasks);
+        free(bounds);
+        return 0;
+    }
+
+    // 1. one slice per thread, each radix sorted with its part of scratch
+    size_t runs = (size_t)threads;
+    for (size_t i = 0; i <= runs; i++)
+        bounds[i] = n * i / runs;
+    for (size_t i = 0; i < runs; i++) {
+        tasks[i].keys = (unsigned *)arr + bounds[i];
+        tasks[i].tmp = scratch + bounds[i];
+        tasks[i].n = bounds[i + 1] - bounds[i];
+    }
+    run_tasks(tasks, runs, run_slice_sort);
+
+    // 2. merge pairs of runs from src into dst until one run is left,
+    // giving each pair an equal share of the threads
+    unsigned *src = (unsigned *)arr, *dst = scratch;
+    while (runs > 1) {
+        size_t pairs = (runs + 1) / 2, count = 0;
+        size_t per_pair = (size_t)threads / pairs > 0 ? (size_t)threads / pairs : 1;
+        for (size_t p = 0; p < pairs; p++) {
+            size_t lo = bounds[2 * p], split = bounds[2 * p + 1];
+            size_t hi = 2 * p + 2 <= runs ? bounds[2 * p + 2] : split;
+            const int *a = (const int *)src + lo, *b = (const int *)src + split;
+            size_t a_len = split - lo, b_len = hi - split;
+            size_t parts = b_len == 0 ? 1 : per_pair;
+            for (size_t s = 0; s < parts; s++) {
+                size_t d0 = (a_len + b_len) * s / parts;
+                size_t d1 = (a_len + b_len) * (s + 1) / parts;
+                size_t i0 = merge_path(a, a_len, b, b_len, d0);
+                size_t i1 = merge_path(a, a_len, b, b_len, d1);
+                if (count == (size_t)threads) {
+                    run_tasks(tasks, count, run_merge);
+                    count = 0;
+                }
+                sort_task *t = &tasks[count++];
+                t->a = (const unsigned *)a + i0;
+                t->a_len = i1 - i0;
+                t->b = (const unsigned *)b + (d0 - i0);
+                t->b_len = (d1 - i1) - (d0 - i0);
+                t->out = dst + lo + d0;
+            }
+            bounds[p] = lo;
+        }
+        bounds[pairs] = n;
+        if (count > 0)
+            run_tasks(tasks, count, run_merge);
+        runs = pairs;
+        unsigned *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != (unsigned *)arr)
+        memcpy(arr, src, n * sizeof(int));
+
+    free(scratch);
+    free(tasks);
+    free(bounds);
+    return 1;
+}
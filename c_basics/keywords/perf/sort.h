@@ -0,0 +1,40 @@
+/*
+ * sort.h - Sorting for int arrays, replacing run.c's comparator bubble sort
+ *
+ *   sort_introsort      any int comparator (run.c's compare_* work as is):
+ *                       quicksort with median-of-three, heapsort when the
+ *                       recursion gets too deep, insertion sort for small
+ *                       ranges. O(n log n) worst case, not stable.
+ *   sort_ints           ascending, the same algorithm with the comparison
+ *                       inlined
+ *   sort_radix          ascending LSD radix sort, 8 bits per pass; passes
+ *                       where every key has the same byte are skipped
+ *   sort_by_key         stable sort by key(x), with each key computed
+ *                       once up front instead of on every comparison
+ *   sort_by_digit_sum   sort_by_key with run.c's digit sum, giving exactly
+ *                       what a stable sort with compare_by_digit_sum gives
+ *   sort_parallel       sorts slices on separate threads, then merges
+ *                       them pairwise, also in parallel
+ *
+ * The functions that need scratch memory return 0 if it cannot be
+ * allocated (the array is then left unsorted), 1 otherwise.
+ */
+
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+
+typedef int (*sort_comparator)(int, int);
+
+// The exercise from run.c, kept as the baseline: O(n^2), stable
+void bubble_sort(int arr[], int size, sort_comparator compare);
+
+void sort_introsort(int *arr, size_t n, sort_comparator compare);
+void sort_ints(int *arr, size_t n);
+int sort_radix(int *arr, size_t n);
+int sort_by_key(int *arr, size_t n, int (*key)(int));
+int sort_by_digit_sum(int *arr, size_t n);
+int sort_parallel(int *arr, size_t n, int threads);   // threads <= 0: one per CPU
+
+#endif
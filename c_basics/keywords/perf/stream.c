@@ -0,0 +1,160 @@
+/*
+ * stream.c - Chunked string transform chain (see stream.h)
+ *
+ * A chunk goes through every stage in place before the next one is read.
+ * Stages only ever shrink a chunk, so in stream_chain_buffer the result of
+ * each chunk can be moved down to the end of the output so far, which
+ * never overtakes the input still to be read.
+ *
+ * Reading back to front: the chunk at the end of the input is read first
+ * and reversed in memory, then the one before it, and so on. That is the
+ * reversed input, a chunk at a time, for the rest of the chain.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "simd_string.h"
+#include "stream.h"
+
+char *chain_string_transforms(char *str, stream_string_fn transforms[], int count) {
+    for (int i = 0; i < count; i++)
+        str = transforms[i](str);
+    return str;
+}
+
+size_t stream_uppercase(char *buf, size_t len) {
+    simd_uppercase(buf, len);
+    return len;
+}
+
+size_t stream_remove_vowels(char *buf, size_t len) {
+    return simd_remove_vowels_n(buf, len);
+}
+
+// fn on each NUL-separated piece of buf[0..len), keeping the NULs between
+// them. buf[len] must be writable and is put back afterwards.
+static size_t apply_string(stream_string_fn fn, char *buf, size_t len) {
+    char saved = buf[len];
+    buf[len] = '\0';
+    size_t read = 0, written = 0;
+    while (read <= len) {
+        size_t piece = strlen(buf + read);
+        const char *result = fn(buf + read);
+        size_t n = strlen(result);
+        memmove(buf + written, result, n);
+        written += n;
+        read += piece + 1;
+        if (read <= len)
+            buf[written++] = '\0';
+    }
+    buf[len] = saved;
+    return written;
+}
+
+static int reverses(const stream_stage *stages, size_t count) {
+    int odd = 0;
+    for (size_t s = 0; s < count; s++)
+        odd ^= stages[s].kind == STREAM_REVERSE;
+    return odd;
+}
+
+// Every stage but the reverses over one chunk; buf[len] must be writable
+static size_t run_stages(const stream_stage *stages, size_t count, char *buf, size_t len) {
+    for (size_t s = 0; s < count && len > 0; s++) {
+        if (stages[s].kind == STREAM_STRING)
+            len = apply_string(stages[s].string, buf, len);
+        else if (stages[s].kind == STREAM_BYTES)
+            len = stages[s].bytes(buf, len);
+    }
+    return len;
+}
+
+size_t stream_chain_buffer(const stream_stage *stages, size_t count, char *buf, size_t len) {
+    if (reverses(stages, count))
+        simd_reverse(buf, len);
+    size_t written = 0;
+    for (size_t start = 0; start < len; start += STREAM_CHUNK) {
+        size_t n = len - start < STREAM_CHUNK ? len - start : STREAM_CHUNK;
+        n = run_stages(stages, count, buf + start, n);
+        memmove(buf + written, buf + start, n);
+        written += n;
+    }
+    return written;
+}
+
+// Stages over one chunk and out; 0 on a write error
+static int emit(const stream_stage *stages, size_t count, char *chunk, size_t n, FILE *out,
+                long long *written) {
+    n = run_stages(stages, count, chunk, n);
+    if (fwrite(chunk, 1, n, out) != n)
+        return 0;
+    *written += (long long)n;
+    return 1;
+}
+
+static long long chain_forward(const stream_stage *stages, size_t count, FILE *in, FILE *out) {
+    char chunk[STREAM_CHUNK + 1];
+    long long written = 0;
+    size_t n;
+    while ((n = fread(chunk, 1, STREAM_CHUNK, in)) > 0) {
+        if (!emit(stages, count, chunk, n, out, &written))
+            return -1;
+    }
+    return ferror(in) ? -1 : written;
+}
+
+// in must be seekable; it is read from its end back to where it was
+static long long chain_backward(const stream_stage *stages, size_t count, FILE *in, FILE *out) {
+    char chunk[STREAM_CHUNK + 1];
+    off_t first = ftello(in);
+    if (first < 0 || fseeko(in, 0, SEEK_END) != 0)
+        return -1;
+    off_t position = ftello(in);
+    long long written = 0;
+    while (position > first) {
+        size_t n = position - first < STREAM_CHUNK ? (size_t)(position - first) : STREAM_CHUNK;
+        position -= (off_t)n;
+        if (fseeko(in, position, SEEK_SET) != 0 || fread(chunk, 1, n, in) != n) {
+            if (!ferror(in))
+                errno = EIO;    // the file shrank under us
+            return -1;
+        }
+        simd_reverse(chunk, n);
+        if (!emit(stages, count, chunk, n, out, &written))
+            return -1;
+    }
+    return written;
+}
+
+long long stream_chain_file(const stream_stage *stages, size_t count, FILE *in, FILE *out) {
+    long long written;
+    if (!reverses(stages, count)) {
+        written = chain_forward(stages, count, in, out);
+    } else if (ftello(in) >= 0) {
+        written = chain_backward(stages, count, in, out);
+    } else {
+        // not seekable: copy it to a temporary file and read that backwards
+        FILE *spool = tmpfile();
+        if (spool == NULL)
+            return -1;
+        char chunk[STREAM_CHUNK];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+            if (fwrite(chunk, 1, n, spool) != n) {
+                fclose(spool);
+                return -1;
+            }
+        }
+        if (ferror(in) || fflush(spool) != 0 || fseeko(spool, 0, SEEK_SET) != 0) {
+            fclose(spool);
+            return -1;
+        }
+        written = chain_backward(stages, count, spool, out);
+        fclose(spool);
+    }
+    if (written >= 0 && fflush(out) != 0)
+        return -1;
+    return written;
+}
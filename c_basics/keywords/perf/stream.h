@@ -0,0 +1,66 @@
+/*
+ * stream.h - PRACTICE 8's string transform chain, one chunk at a time
+ *
+ * chain_string_transforms (the exercise) calls each char *(*)(char *) on
+ * the whole string in turn, so a long string is streamed through memory
+ * once per stage. The chain here takes STREAM_CHUNK bytes at a time
+ * through every stage while they are still in L1, and works on a file or
+ * stdin of any size with a fixed-size buffer.
+ *
+ * Stages other than reverse must be byte-local: what happens to a byte
+ * may not depend on the bytes around it. uppercase_string and
+ * remove_vowels are, so chunk boundaries do not matter to them, and a
+ * stage may drop bytes (remove_vowels does) but never add any. Reverse is
+ * not a stage that runs per chunk: because the other stages are
+ * byte-local it commutes with them, so an odd number of reverses means
+ * reading the input back to front and an even number cancels out.
+ */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#ifndef STREAM_CHUNK
+#define STREAM_CHUNK (16 * 1024)
+#endif
+
+typedef char *(*stream_string_fn)(char *str);          // run.c's helpers
+typedef size_t (*stream_bytes_fn)(char *buf, size_t len);  // returns new length
+
+enum stream_stage_kind {
+    STREAM_STRING,      // NUL-terminated, run once per NUL-separated piece
+    STREAM_BYTES,       // length-based
+    STREAM_REVERSE
+};
+
+typedef struct {
+    enum stream_stage_kind kind;
+    stream_string_fn string;
+    stream_bytes_fn bytes;
+} stream_stage;
+
+#define STREAM_STAGE_STRING(fn) {STREAM_STRING, (fn), NULL}
+#define STREAM_STAGE_BYTES(fn) {STREAM_BYTES, NULL, (fn)}
+#define STREAM_STAGE_REVERSE {STREAM_REVERSE, NULL, NULL}
+
+// The exercise from run.c, kept as the baseline: every stage over the
+// whole string
+char *chain_string_transforms(char *str, stream_string_fn transforms[], int count);
+
+// Length-based stages backed by simd_string.h
+size_t stream_uppercase(char *buf, size_t len);
+size_t stream_remove_vowels(char *buf, size_t len);
+
+// The chain over len bytes in place; returns the new length. buf[len] must
+// be writable (a NUL-terminated string is fine); it is left as it was.
+size_t stream_chain_buffer(const stream_stage *stages, size_t count, char *buf, size_t len);
+
+// The chain from in to out with one STREAM_CHUNK buffer. With a reverse,
+// a seekable in is read back to front; anything else (a pipe) is first
+// copied to a temporary file. Returns the bytes written, or -1 on a read
+// or write error (errno is set).
+long long stream_chain_file(const stream_stage *stages, size_t count, FILE *in, FILE *out);
+
+#endif
@@ -0,0 +1,409 @@
+/*
+ * transforms.c - Fast factorial, fibonacci and count_bits (see transforms.h)
+ *
+ * Tables: every factorial and fibonacci value that fits 64 bits (20! and
+ * F(93)), plus factorial modulo 2^32, which is what run.c's int factorial
+ * wraps around to. That is 0 from 34! on, since 34! has 32 factors of two,
+ * so 35 entries cover every int. All are filled in by transforms_init.
+ *
+ * fibonacci_fast past the table uses fast doubling,
+ *   F(2k) = F(k) (2 F(k+1) - F(k)),  F(2k+1) = F(k)^2 + F(k+1)^2,
+ * in unsigned 32-bit arithmetic, which wraps exactly like run.c's int
+ * additions would.
+ *
+ * The array versions clamp each input to a table index and gather
+ * (vpgatherdd), so a whole vector is looked up at once. count_bits uses
+ * vpopcntd on AVX-512, and on AVX2 a 16-entry table of nibble bit counts
+ * looked up with vpshufb, twice per byte (Mula's method).
+ */
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSFORMS_X86 1
+#endif
+
+#include "transforms.h"
+
+#define FACTORIAL_U64_MAX 20
+#define FIBONACCI_U64_MAX 93
+#define FACTORIAL_INT_MAX 12        // 13! no longer fits an int
+#define FIBONACCI_INT_MAX 46        // nor does F(47)
+#define FACTORIAL_WRAP_ENTRIES 35   // n! mod 2^32 for 0..34, 0 after that
+#define FIBONACCI_TABLE_ENTRIES (FIBONACCI_INT_MAX + 1)
+
+static uint64_t factorial_u64[FACTORIAL_U64_MAX + 1];
+static uint64_t fibonacci_u64[FIBONACCI_U64_MAX + 1];
+static int factorial_wrapped[FACTORIAL_WRAP_ENTRIES];
+static int fibonacci_int[FIBONACCI_TABLE_ENTRIES];
+
+// ---------------------------------------------------------------------------
+// Scalar
+// ---------------------------------------------------------------------------
+
+int factorial_fast(int n) {
+    if (n < 0)
+        n = 0;      // run.c: n <= 1 gives 1
+    return n < FACTORIAL_WRAP_ENTRIES ? factorial_wrapped[n] : 0;
+}
+
+static uint32_t fibonacci_mod_2_32(unsigned n) {
+    uint32_t a = 0, b = 1;      // F(k), F(k+1) for k = the bits of n seen so far
+    for (int bit = 31 - __builtin_clz(n); bit >= 0; bit--) {
+        uint32_t doubled = a * (2 * b - a);
+        uint32_t doubled_next = a * a + b * b;
+        if ((n >> bit) & 1) {
+            a = doubled_next;
+            b = doubled + doubled_next;
+        } else {
+            a = doubled;
+            b = doubled_next;
+        }
+    }
+    return a;
+}
+
+int fibonacci_fast(int n) {
+    if (n <= 1)
+        return n;
+    if (n <= FIBONACCI_INT_MAX)
+        return fibonacci_int[n];
+    return (int)fibonacci_mod_2_32((unsigned)n);
+}
+
+__attribute__((target_clones("popcnt", "default")))
+int count_bits_fast(int n) {
+    return __builtin_popcount((unsigned)n);
+}
+
+int factorial_checked(int n, int *result) {
+    if (n > FACTORIAL_INT_MAX)
+        return 0;
+    *result = factorial_fast(n);
+    return 1;
+}
+
+int factorial_u64_checked(int n, uint64_t *result) {
+    if (n > FACTORIAL_U64_MAX)
+        return 0;
+    *result = factorial_u64[n < 0 ? 0 : n];
+    return 1;
+}
+
+int fibonacci_checked(int n, int *result) {
+    if (n > FIBONACCI_INT_MAX)
+        return 0;
+    *result = fibonacci_fast(n);
+    return 1;
+}
+
+int fibonacci_u64_checked(int n, uint64_t *result) {
+    if (n < 0 || n > FIBONACCI_U64_MAX)
+        return 0;   // run.c gives n itself for negative n
+    *result = fibonacci_u64[n];
+    return 1;
+}
+
+static void factorial_array_scalar(const int *input, int *output, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        output[i] = factorial_fast(input[i]);
+}
+
+static void fibonacci_array_scalar(const int *input, int *output, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        output[i] = fibonacci_fast(input[i]);
+}
+
+// Plain C popcount: bits per 2, 4, then 8 bits, then summed by a multiply
+static inline unsigned popcount_32(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (x * 0x01010101u) >> 24;
+}
+
+static inline unsigned popcount_64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned)((x * 0x0101010101010101ULL) >> 56);
+}
+
+static void count_bits_array_scalar(const int *input, int *output, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        output[i] = (int)popcount_32((uint32_t)input[i]);
+}
+
+static uint64_t popcount_buffer_scalar(const void *buffer, size_t bytes) {
+    const unsigned char *p = buffer;
+    uint64_t total = 0;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        total += popcount_64(word);
+    }
+    for (; i < bytes; i++)
+        total += popcount_32(p[i]);
+    return total;
+}
+
+#ifdef TRANSFORMS_X86
+
+// ---------------------------------------------------------------------------
+// AVX2 (8 ints at a time)
+// ---------------------------------------------------------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET static void factorial_array_avx2(const int *input, int *output, size_t count) {
+    const __m256i last = _mm256_set1_epi32(FACTORIAL_WRAP_ENTRIES - 1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i n = _mm256_loadu_si256((const __m256i *)(input + i));
+        __m256i index = _mm256_min_epi32(_mm256_max_epi32(n, _mm256_setzero_si256()), last);
+        // the last entry is 0, like every n! mod 2^32 past it
+        __m256i value = _mm256_i32gather_epi32(factorial_wrapped, index, 4);
+        _mm256_storeu_si256((__m256i *)(output + i), value);
+    }
+    factorial_array_scalar(input + i, output + i, count - i);
+}
+
+AVX2_TARGET static void fibonacci_array_avx2(const int *input, int *output, size_t count) {
+    const __m256i last = _mm256_set1_epi32(FIBONACCI_INT_MAX);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i n = _mm256_loadu_si256((const __m256i *)(input + i));
+        if (!_mm256_testz_si256(_mm256_cmpgt_epi32(n, last), _mm256_set1_epi32(-1))) {
+            fibonacci_array_scalar(input + i, output + i, 8);   // past the table
+            continue;
+        }
+        __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), n);
+        __m256i value = _mm256_i32gather_epi32(
+            fibonacci_int, _mm256_max_epi32(n, _mm256_setzero_si256()), 4);
+        _mm256_storeu_si256((__m256i *)(output + i), _mm256_blendv_epi8(value, n, negative));
+    }
+    fibonacci_array_scalar(input + i, output + i, count - i);
+}
+
+// Bits set in each byte of v
+AVX2_TARGET static inline __m256i popcount_bytes(__m256i v) {
+    const __m256i nibble_bits = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_and_si256(v, low_nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(nibble_bits, lo),
+                           _mm256_shuffle_epi8(nibble_bits, hi));
+}
+
+AVX2_TARGET static void count_bits_array_avx2(const int *input, int *output, size_t count) {
+    const __m256i ones_8 = _mm256_set1_epi8(1), ones_16 = _mm256_set1_epi16(1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i bytes = popcount_bytes(_mm256_loadu_si256((const __m256i *)(input + i)));
+        // byte counts -> 16-bit pair sums -> 32-bit sums
+        __m256i words = _mm256_maddubs_epi16(bytes, ones_8);
+        _mm256_storeu_si256((__m256i *)(output + i), _mm256_madd_epi16(words, ones_16));
+    }
+    count_bits_array_scalar(input + i, output + i, count - i);
+}
+
+AVX2_TARGET static uint64_t popcount_buffer_avx2(const void *buffer, size_t bytes) {
+    const unsigned char *p = buffer;
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    while (i + 32 <= bytes) {
+        // byte counters reach at most 8 * 31 = 248 before they are summed
+        __m256i counts = _mm256_setzero_si256();
+        for (int n = 0; n < 31 && i + 32 <= bytes; n++, i += 32)
+            counts = _mm256_add_epi8(counts, popcount_bytes(_mm256_loadu_si256((const __m256i *)(p + i))));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + popcount_buffer_scalar(p + i, bytes - i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 F + VPOPCNTDQ (16 ints at a time, masked tails)
+// ---------------------------------------------------------------------------
+
+#define AVX512_TARGET __attribute__((target("avx512f,avx512vpopcntdq")))
+
+static inline __mmask16 first_lanes(size_t n) {
+    return n >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << n) - 1);
+}
+
+AVX512_TARGET static void factorial_array_avx512(const int *input, int *output, size_t count) {
+    const __m512i last = _mm512_set1_epi32(FACTORIAL_WRAP_ENTRIES - 1);
+    for (size_t i = 0; i < count; i += 16) {
+        __mmask16 active = first_lanes(count - i);
+        __m512i n = _mm512_maskz_loadu_epi32(active, input + i);
+        __m512i index = _mm512_min_epi32(_mm512_max_epi32(n, _mm512_setzero_si512()), last);
+        __m512i value = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), active, index,
+                                                    factorial_wrapped, 4);
+        _mm512_mask_storeu_epi32(output + i, active, value);
+    }
+}
+
+AVX512_TARGET static void fibonacci_array_avx512(const int *input, int *output, size_t count) {
+    const __m512i last = _mm512_set1_epi32(FIBONACCI_INT_MAX);
+    for (size_t i = 0; i < count; i += 16) {
+        __mmask16 active = first_lanes(count - i);
+        __m512i n = _mm512_maskz_loadu_epi32(active, input + i);
+        __mmask16 past_table = _mm512_mask_cmpgt_epi32_mask(active, n, last);
+        __mmask16 negative = _mm512_cmplt_epi32_mask(n, _mm512_setzero_si512());
+        __mmask16 lookup = active & ~past_table & ~negative;
+        __m512i value = _mm512_mask_i32gather_epi32(n, lookup, n, fibonacci_int, 4);
+        _mm512_mask_storeu_epi32(output + i, active, value);
+        for (unsigned m = past_table; m != 0; m &= m - 1) {
+            size_t lane = i + (size_t)__builtin_ctz(m);
+            output[lane] = fibonacci_fast(input[lane]);
+        }
+    }
+}
+
+AVX512_TARGET static void count_bits_array_avx512(const int *input, int *output, size_t count) {
+    for (size_t i = 0; i < count; i += 16) {
+        __mmask16 active = first_lanes(count - i);
+        __m512i n = _mm512_maskz_loadu_epi32(active, input + i);
+        _mm512_mask_storeu_epi32(output + i, active, _mm512_popcnt_epi32(n));
+    }
+}
+
+AVX512_TARGET static uint64_t popcount_buffer_avx512(const void *buffer, size_t bytes) {
+    const unsigned char *p = buffer;
+    __m512i total = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= bytes; i += 64)
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i)));
+    return (uint64_t)_mm512_reduce_add_epi64(total) + popcount_buffer_scalar(p + i, bytes - i);
+}
+
+#endif // TRANSFORMS_X86
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    transform_array_fn factorial, fibonacci, count_bits;
+    uint64_t (*popcount_buffer)(const void *, size_t);
+} implementation;
+
+static const implementation implementations[TRANSFORM_ISA_COUNT] = {
+    [TRANSFORM_SCALAR] = {"scalar", factorial_array_scalar, fibonacci_array_scalar,
+                          count_bits_array_scalar, popcount_buffer_scalar},
+#ifdef TRANSFORMS_X86
+    [TRANSFORM_AVX2] = {"avx2", factorial_array_avx2, fibonacci_array_avx2,
+                        count_bits_array_avx2, popcount_buffer_avx2},
+    [TRANSFORM_AVX512] = {"avx512", factorial_array_avx512, fibonacci_array_avx512,
+                          count_bits_array_avx512, popcount_buffer_avx512},
+#else
+    [TRANSFORM_AVX2] = {"avx2", NULL, NULL, NULL, NULL},
+    [TRANSFORM_AVX512] = {"avx512", NULL, NULL, NULL, NULL},
+#endif
+};
+
+static const implementation *selected = &implementations[TRANSFORM_SCALAR];
+
+int transforms_supported(enum transform_isa isa) {
+    switch (isa) {
+    case TRANSFORM_SCALAR:
+        return 1;
+#ifdef TRANSFORMS_X86
+    case TRANSFORM_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case TRANSFORM_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int transforms_use(enum transform_isa isa) {
+    if (!transforms_supported(isa))
+        return 0;
+    selected = &implementations[isa];
+    return 1;
+}
+
+enum transform_isa transforms_active(void) {
+    return (enum transform_isa)(selected - implementations);
+}
+
+const char *transforms_isa_name(enum transform_isa isa) {
+    return isa < TRANSFORM_ISA_COUNT ? implementations[isa].name : "unknown";
+}
+
+// Runs before main(): fills the tables and picks the best implementation
+__attribute__((constructor)) static void transforms_init(void) {
+    factorial_u64[0] = 1;
+    for (int n = 1; n <= FACTORIAL_U64_MAX; n++)
+        factorial_u64[n] = factorial_u64[n - 1] * (uint64_t)n;
+    uint32_t wrapped = 1;
+    for (int n = 0; n < FACTORIAL_WRAP_ENTRIES; n++) {
+        wrapped *= n > 1 ? (uint32_t)n : 1;
+        factorial_wrapped[n] = (int)wrapped;
+    }
+    fibonacci_u64[0] = 0;
+    fibonacci_u64[1] = 1;
+    for (int n = 2; n <= FIBONACCI_U64_MAX; n++)
+        fibonacci_u64[n] = fibonacci_u64[n - 1] + fibonacci_u64[n - 2];
+    for (int n = 0; n < FIBONACCI_TABLE_ENTRIES; n++)
+        fibonacci_int[n] = (int)fibonacci_u64[n];
+
+#ifdef TRANSFORMS_X86
+    __builtin_cpu_init();
+#endif
+    for (int isa = TRANSFORM_ISA_COUNT - 1; isa > TRANSFORM_SCALAR; isa--) {
+        if (transforms_use((enum transform_isa)isa))
+            break;
+    }
+}
+
+void factorial_array(const int *input, int *output, size_t count) {
+    selected->factorial(input, output, count);
+}
+
+void fibonacci_array(const int *input, int *output, size_t count) {
+    selected->fibonacci(input, output, count);
+}
+
+void count_bits_array(const int *input, int *output, size_t count) {
+    selected->count_bits(input, output, count);
+}
+
+uint64_t popcount_buffer(const void *buffer, size_t bytes) {
+    return selected->popcount_buffer(buffer, bytes);
+}
+
+transform_fn get_transformer(char operation_code) {
+    switch (operation_code) {
+    case 'f':
+        return factorial_fast;
+    case 'b':
+        return count_bits_fast;
+    case 'F':
+        return fibonacci_fast;
+    default:
+        return NULL;
+    }
+}
+
+transform_array_fn get_array_transformer(char operation_code) {
+    switch (operation_code) {
+    case 'f':
+        return factorial_array;
+    case 'b':
+        return count_bits_array;
+    case 'F':
+        return fibonacci_array;
+    default:
+        return NULL;
+    }
+}
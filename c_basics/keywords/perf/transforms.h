@@ -0,0 +1,64 @@
+/*
+ * transforms.h - Fast versions of run.c's factorial, fibonacci and count_bits
+ *
+ *   fibonacci_fast   fast doubling: O(log n) instead of run.c's O(phi^n)
+ *                    double recursion
+ *   factorial_fast   table lookup instead of n recursive calls
+ *   count_bits_fast  one popcnt instruction where the CPU has it
+ *
+ * They return exactly what run.c's int versions return, including the
+ * values those wrap around to once the result no longer fits an int
+ * (factorial past 12, fibonacci past 46). The *_checked variants report
+ * overflow instead: they return 0 and leave *result alone.
+ *
+ * The *_array versions transform whole buffers with AVX2 or AVX-512 when
+ * the CPU has them (picked on first use, or forced with transforms_use).
+ */
+
+#ifndef TRANSFORMS_H
+#define TRANSFORMS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum transform_isa {
+    TRANSFORM_SCALAR,
+    TRANSFORM_AVX2,
+    TRANSFORM_AVX512,
+    TRANSFORM_ISA_COUNT
+};
+
+typedef int (*transform_fn)(int);
+typedef void (*transform_array_fn)(const int *input, int *output, size_t count);
+
+// Drop-in replacements for the run.c functions
+int factorial_fast(int n);
+int fibonacci_fast(int n);
+int count_bits_fast(int n);
+
+// Overflow-checked: 1 and the exact value in *result, or 0 if it does not fit
+int factorial_checked(int n, int *result);
+int factorial_u64_checked(int n, uint64_t *result);
+int fibonacci_checked(int n, int *result);
+int fibonacci_u64_checked(int n, uint64_t *result);
+
+// output[i] = f(input[i]); output may be input
+void factorial_array(const int *input, int *output, size_t count);
+void fibonacci_array(const int *input, int *output, size_t count);
+void count_bits_array(const int *input, int *output, size_t count);
+
+// Total number of set bits in a buffer
+uint64_t popcount_buffer(const void *buffer, size_t bytes);
+
+// PRACTICE 10 from run.c: 'f' factorial, 'b' count_bits, 'F' fibonacci,
+// NULL for anything else
+transform_fn get_transformer(char operation_code);
+transform_array_fn get_array_transformer(char operation_code);
+
+// Implementation selection, as in simd_string.h
+int transforms_supported(enum transform_isa isa);
+int transforms_use(enum transform_isa isa);       // 0 if not supported here
+enum transform_isa transforms_active(void);
+const char *transforms_isa_name(enum transform_isa isa);
+
+#endif
@@ -0,0 +1,320 @@
+/*
+ * validate.c - Column validators and the short-circuiting engine (see validate.h)
+ *
+ * Range test: lo <= v <= hi is the same as (unsigned)(v - lo) <= hi - lo,
+ * one subtract and one unsigned compare. AVX-512 compares straight into a
+ * mask register (vpcmpud); AVX2 has no unsigned compare, so it checks
+ * min(d, span) == d and takes the sign bits with vmovmskps.
+ *
+ * Every kernel ANDs into the mask it is given and skips words that are
+ * already 0, which is what lets the engine hand later validators only the
+ * rows that are still alive.
+ *
+ * Engine order: the counters from the engine's own passes only say how a
+ * validator does on the rows left over by the ones before it, which would
+ * keep a bad first order in place. So before each block every validator
+ * also runs on its own over one word (64 rows) of it, and the order is
+ * ranked from those samples by nanoseconds per rejected row: its cost
+ * divided by how much work it saves the ones after it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VALIDATE_X86 1
+#endif
+
+#include "validate.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Up to 64 rows, bit i set where values[i] - lo <= span
+static uint64_t range_word_scalar(const int *values, size_t n, uint32_t lo, uint32_t span) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < n; i++)
+        bits |= (uint64_t)((uint32_t)values[i] - lo <= span) << i;
+    return bits;
+}
+
+static void range_and_scalar(const int *values, size_t words, uint32_t lo, uint32_t span,
+                             uint64_t *mask) {
+    for (size_t w = 0; w < words; w++) {
+        if (mask[w])
+            mask[w] &= range_word_scalar(values + w * 64, 64, lo, span);
+    }
+}
+
+#ifdef VALIDATE_X86
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+AVX2_TARGET static void range_and_avx2(const int *values, size_t words, uint32_t lo, uint32_t span,
+                                       uint64_t *mask) {
+    const __m256i base = _mm256_set1_epi32((int)lo);
+    const __m256i limit = _mm256_set1_epi32((int)span);
+    for (size_t w = 0; w < words; w++) {
+        if (mask[w] == 0)
+            continue;
+        const int *v = values + w * 64;
+        uint64_t bits = 0;
+        for (int k = 0; k < 8; k++) {
+            __m256i d = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(v + 8 * k)), base);
+            __m256i in = _mm256_cmpeq_epi32(_mm256_min_epu32(d, limit), d);
+            bits |= (uint64_t)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(in)) << (8 * k);
+        }
+        mask[w] &= bits;
+    }
+}
+
+AVX512_TARGET static void range_and_avx512(const int *values, size_t words, uint32_t lo,
+                                           uint32_t span, uint64_t *mask) {
+    const __m512i base = _mm512_set1_epi32((int)lo);
+    const __m512i limit = _mm512_set1_epi32((int)span);
+    for (size_t w = 0; w < words; w++) {
+        if (mask[w] == 0)
+            continue;
+        const int *v = values + w * 64;
+        uint64_t bits = 0;
+        for (int k = 0; k < 4; k++) {
+            __m512i d = _mm512_sub_epi32(_mm512_loadu_si512(v + 16 * k), base);
+            bits |= (uint64_t)_mm512_cmple_epu32_mask(d, limit) << (16 * k);
+        }
+        mask[w] &= bits;
+    }
+}
+
+#endif // VALIDATE_X86
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+typedef void (*range_and_fn)(const int *values, size_t words, uint32_t lo, uint32_t span,
+                             uint64_t *mask);
+
+typedef struct {
+    const char *name;
+    range_and_fn range_and;
+} implementation;
+
+static const implementation implementations[VALIDATE_ISA_COUNT] = {
+    [VALIDATE_SCALAR] = {"scalar", range_and_scalar},
+#ifdef VALIDATE_X86
+    [VALIDATE_AVX2] = {"avx2", range_and_avx2},
+    [VALIDATE_AVX512] = {"avx512", range_and_avx512},
+#else
+    [VALIDATE_AVX2] = {"avx2", NULL},
+    [VALIDATE_AVX512] = {"avx512", NULL},
+#endif
+};
+
+static const implementation *selected = &implementations[VALIDATE_SCALAR];
+
+int validate_supported(enum validate_isa isa) {
+    switch (isa) {
+    case VALIDATE_SCALAR:
+        return 1;
+#ifdef VALIDATE_X86
+    case VALIDATE_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case VALIDATE_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int validate_use(enum validate_isa isa) {
+    if (!validate_supported(isa))
+        return 0;
+    selected = &implementations[isa];
+    return 1;
+}
+
+enum validate_isa validate_active(void) {
+    return (enum validate_isa)(selected - implementations);
+}
+
+const char *validate_isa_name(enum validate_isa isa) {
+    return isa < VALIDATE_ISA_COUNT ? implementations[isa].name : "unknown";
+}
+
+// Runs before main() and picks the best implementation
+__attribute__((constructor)) static void validate_init(void) {
+#ifdef VALIDATE_X86
+    __builtin_cpu_init();
+#endif
+    for (int isa = VALIDATE_ISA_COUNT - 1; isa > VALIDATE_SCALAR; isa--) {
+        if (validate_use((enum validate_isa)isa))
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Masks
+// ---------------------------------------------------------------------------
+
+// Set the bits of rows [0, count), clear the rest of the last word
+static void fill_rows(uint64_t *mask, size_t count) {
+    size_t words = count / 64;
+    memset(mask, 0xFF, words * sizeof(uint64_t));
+    if (count % 64)
+        mask[words] = (1ULL << (count % 64)) - 1;
+}
+
+static uint64_t count_rows(const uint64_t *mask, size_t words) {
+    uint64_t rows = 0;
+    for (size_t w = 0; w < words; w++)
+        rows += (uint64_t)__builtin_popcountll(mask[w]);
+    return rows;
+}
+
+static void range_and(const int *values, size_t count, int lo, int hi, uint64_t *mask) {
+    if (lo > hi) {
+        memset(mask, 0, VALIDATE_MASK_WORDS(count) * sizeof(uint64_t));
+        return;
+    }
+    uint32_t base = (uint32_t)lo, span = (uint32_t)hi - (uint32_t)lo;
+    size_t words = count / 64;
+    selected->range_and(values, words, base, span, mask);
+    if (count % 64)
+        mask[words] &= range_word_scalar(values + words * 64, count % 64, base, span);
+}
+
+// Clear the bits of the rows fn rejects, calling it only for rows still set
+static void fn_and(const int *values, size_t count, validator_fn fn, uint64_t *mask) {
+    for (size_t w = 0; w < VALIDATE_MASK_WORDS(count); w++) {
+        uint64_t todo = mask[w], rejected = 0;
+        while (todo) {
+            int bit = __builtin_ctzll(todo);
+            todo &= todo - 1;
+            if (!fn(values[w * 64 + bit]))
+                rejected |= 1ULL << bit;
+        }
+        mask[w] &= ~rejected;
+    }
+}
+
+static void validator_and(const validator *v, const int *values, size_t count, uint64_t *mask) {
+    if (v->fn == NULL)
+        range_and(values, count, v->lo, v->hi, mask);
+    else
+        fn_and(values, count, v->fn, mask);
+}
+
+void validate_range(const int *values, size_t count, int lo, int hi, uint64_t *mask) {
+    fill_rows(mask, count);
+    range_and(values, count, lo, hi, mask);
+}
+
+void validate_columns(const validator *validators, size_t validator_count, const int *values,
+                      size_t count, uint64_t *const *masks) {
+    for (size_t j = 0; j < validator_count; j++) {
+        fill_rows(masks[j], count);
+        validator_and(&validators[j], values, count, masks[j]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Engine
+// ---------------------------------------------------------------------------
+
+int validator_engine_init(validator_engine *engine, const validator *validators, size_t count) {
+    engine->validators = validators;
+    engine->count = count;
+    engine->order = malloc(count * sizeof(size_t));
+    engine->stats = malloc(count * sizeof(validator_stats));
+    engine->adaptive = 1;
+    if (engine->order == NULL || engine->stats == NULL) {
+        validator_engine_free(engine);
+        return 0;
+    }
+    validator_engine_reset(engine);
+    return 1;
+}
+
+void validator_engine_free(validator_engine *engine) {
+    free(engine->order);
+    free(engine->stats);
+    engine->order = NULL;
+    engine->stats = NULL;
+    engine->count = 0;
+}
+
+void validator_engine_reset(validator_engine *engine) {
+    for (size_t j = 0; j < engine->count; j++)
+        engine->order[j] = j;
+    memset(engine->stats, 0, engine->count * sizeof(validator_stats));
+}
+
+static double rank(const validator_stats *stats) {
+    if (stats->sampled == 0)
+        return 0;
+    return (double)stats->sampled_nanoseconds / (double)(stats->sampled - stats->sampled_passed + 1);
+}
+
+// Each validator on its own over one word of the block
+static void sample(validator_engine *engine, const int *values, size_t rows, size_t block) {
+    size_t word = block % VALIDATE_MASK_WORDS(rows);
+    size_t n = rows - word * 64 < 64 ? rows - word * 64 : 64;
+    for (size_t j = 0; j < engine->count; j++) {
+        uint64_t mask;
+        fill_rows(&mask, n);
+        uint64_t begin = now_ns();
+        validator_and(&engine->validators[j], values + word * 64, n, &mask);
+        validator_stats *stats = &engine->stats[j];
+        stats->sampled_nanoseconds += now_ns() - begin;
+        stats->sampled += n;
+        stats->sampled_passed += (uint64_t)__builtin_popcountll(mask);
+    }
+}
+
+// Insertion sort by rank: a handful of validators, and ties keep their order
+static void rerank(validator_engine *engine) {
+    for (size_t i = 1; i < engine->count; i++) {
+        size_t j = engine->order[i];
+        double r = rank(&engine->stats[j]);
+        size_t k = i;
+        for (; k > 0 && rank(&engine->stats[engine->order[k - 1]]) > r; k--)
+            engine->order[k] = engine->order[k - 1];
+        engine->order[k] = j;
+    }
+}
+
+size_t validator_engine_run(validator_engine *engine, const int *values, size_t count,
+                            uint64_t *pass) {
+    size_t total = 0;
+    for (size_t start = 0; start < count; start += VALIDATE_BLOCK) {
+        size_t rows = count - start < VALIDATE_BLOCK ? count - start : VALIDATE_BLOCK;
+        size_t words = VALIDATE_MASK_WORDS(rows);
+        uint64_t *alive = pass + start / 64;
+        fill_rows(alive, rows);
+        uint64_t live = rows;
+        if (engine->adaptive) {
+            sample(engine, values + start, rows, start / VALIDATE_BLOCK);
+            rerank(engine);
+        }
+        for (size_t k = 0; k < engine->count && live > 0; k++) {
+            size_t j = engine->order[k];
+            uint64_t begin = now_ns();
+            validator_and(&engine->validators[j], values + start, rows, alive);
+            uint64_t left = count_rows(alive, words);
+            validator_stats *stats = &engine->stats[j];
+            stats->nanoseconds += now_ns() - begin;
+            stats->tested += live;
+            stats->passed += left;
+            live = left;
+        }
+        total += live;
+    }
+    return total;
+}
@@ -0,0 +1,93 @@
+/*
+ * validate.h - PRACTICE 2's validator array, run over whole columns
+ *
+ * run.c's exercise calls is_prime, is_palindrome_num, is_valid_age and
+ * is_valid_score one at a time on one number. Here a list of validators
+ * runs over a column of values and the results are bitmasks, bit i of
+ * word i / 64 for row i:
+ *
+ *   validate_columns   one mask per validator, every row through every
+ *                      validator
+ *   validator_engine   one mask of the rows that pass all of them. Each
+ *                      block of rows goes through the validators in turn,
+ *                      and later ones only look at the rows still alive.
+ *                      The order is re-ranked before every block from the
+ *                      measured cost and pass rate, cheapest rejection
+ *                      first.
+ *
+ * A range validator (lo <= v <= hi, like is_valid_age and is_valid_score)
+ * is a single unsigned compare per value, done 8 (AVX2) or 16 (AVX-512) at
+ * a time; any other int (*)(int) is called only for the rows still alive.
+ */
+
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef VALIDATE_BLOCK
+#define VALIDATE_BLOCK 4096     // rows per block, a multiple of 64
+#endif
+
+#define VALIDATE_MASK_WORDS(rows) (((rows) + 63) / 64)
+
+enum validate_isa {
+    VALIDATE_SCALAR,
+    VALIDATE_AVX2,
+    VALIDATE_AVX512,
+    VALIDATE_ISA_COUNT
+};
+
+typedef int (*validator_fn)(int);
+
+typedef struct {
+    const char *name;
+    validator_fn fn;            // NULL for a range validator
+    int lo, hi;                 // range: lo <= value <= hi
+} validator;
+
+// Initializers, e.g. validator v[] = {VALIDATOR_RANGE("age", 0, 150), ...}
+#define VALIDATOR_RANGE(name, lo, hi) {(name), NULL, (lo), (hi)}
+#define VALIDATOR_FN(name, fn) {(name), (fn), 0, 0}
+
+typedef struct {
+    uint64_t tested;            // rows this validator looked at
+    uint64_t passed;
+    uint64_t nanoseconds;
+    uint64_t sampled;           // the same, on its own over a sample of
+    uint64_t sampled_passed;    // each block; what the order is based on
+    uint64_t sampled_nanoseconds;
+} validator_stats;
+
+typedef struct {
+    const validator *validators;
+    size_t count;
+    size_t *order;              // current position -> validator index
+    validator_stats *stats;
+    int adaptive;               // 0 keeps the order as given
+} validator_engine;
+
+// mask gets VALIDATE_MASK_WORDS(count) words: bit set where lo <= value <= hi
+void validate_range(const int *values, size_t count, int lo, int hi, uint64_t *mask);
+
+// masks[j] gets validator j's result for every row
+void validate_columns(const validator *validators, size_t validator_count, const int *values,
+                      size_t count, uint64_t *const *masks);
+
+// 0 if out of memory. The engine keeps the validators pointer.
+int validator_engine_init(validator_engine *engine, const validator *validators, size_t count);
+void validator_engine_free(validator_engine *engine);
+void validator_engine_reset(validator_engine *engine);     // stats and order
+
+// pass gets the rows that pass every validator; returns how many
+size_t validator_engine_run(validator_engine *engine, const int *values, size_t count,
+                            uint64_t *pass);
+
+// Implementation selection, as in simd_string.h
+int validate_supported(enum validate_isa isa);
+int validate_use(enum validate_isa isa);          // 0 if not supported here
+enum validate_isa validate_active(void);
+const char *validate_isa_name(enum validate_isa isa);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef RUN_H
+#define RUN_H
+
+// Helper functions implemented in run.c
+
+// String manipulation functions
+char *reverse_string(char *str);
+char *uppercase_string(char *str);
+char *remove_vowels(char *str);
+
+// Validation functions
+int is_valid_age(int age);
+int is_valid_score(int score);
+int is_prime(int n);
+int is_palindrome_num(int n);
+
+// Comparison functions for sorting
+int compare_ascending(int a, int b);
+int compare_descending(int a, int b);
+int compare_by_digit_sum(int a, int b);
+
+// Transformation functions
+int factorial(int n);
+int fibonacci(int n);
+int count_bits(int n);
+
+#endif
@@ -1,8 +1,11 @@
 #include <stdio.h>
 
+#include "fast_input.h"
+#include "operations.h"
+
 void clear_input_buffer() {
     int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+    while ((c = fast_getchar()) != '\n' && c != EOF);
 }
 
 void get_number(char prompt[], float *num_ptr) {
@@ -10,7 +13,7 @@ void get_number(char prompt[], float *num_ptr) {
 
     do{
         printf(prompt);
-        if (scanf("%f", num_ptr) != 1) {
+        if (fast_scan_float(num_ptr) != 1) {
             clear_input_buffer();
             printf("Invalid input! Please try again.\n");
             invalid_input = 1;
@@ -28,8 +31,8 @@ void choose_operation( char *choice) {
     printf("m) Multiplication\n");
     printf("d) Division\n");
     printf("Enter choice: ");
-    scanf(" %c", choice);
-    clear_input_buffer();  // Clear the newline left by scanf
+    fast_scan_char(choice);
+    clear_input_buffer();  // Clear the newline left by the scan
 }
 
 void addtion(float a, float b, float *result) {
@@ -59,7 +62,7 @@ void get_boolean(char prompt[], int *bool_ptr) {
 
     do{
         printf(prompt);
-        if (scanf("%d", bool_ptr) != 1) {
+        if (fast_scan_int(bool_ptr) != 1) {
             clear_input_buffer();
             printf("Invalid input! Please try again.\n");
             invalid_input = 1;
@@ -70,6 +73,8 @@ void get_boolean(char prompt[], int *bool_ptr) {
     } while(invalid_input);
 }
 
+// Built without main() under -DUNIT_TEST so tests/ can link the operations
+#ifndef UNIT_TEST
 int main(){
     printf("Welcome to the calculator!\n");
     int repeat = 1;
@@ -111,4 +116,5 @@ int main(){
         clear_input_buffer();
     }
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,10 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+// Calculator operations implemented in main.c
+void addtion(float a, float b, float *result);
+void subtraction(float a, float b, float *result);
+void multiplication(float a, float b, float *result);
+void division(float a, float b, float *result);
+
+#endif
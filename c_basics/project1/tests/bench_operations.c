@@ -0,0 +1,143 @@
+/*
+ * bench_operations.c - Micro-benchmarks for the calculator operations
+ *
+ * Each operation runs over a fixed array of random operands: a warmup pass,
+ * then REPETITIONS timed runs of ITERATIONS calls. We report the mean,
+ * standard deviation and best run in ns/op.
+ *
+ *   ./bench_operations                       print results
+ *   ./bench_operations --save FILE           also save them as a baseline
+ *   ./bench_operations --compare FILE        print change against a baseline
+ *
+ * The operations are called through ../main.c's non-inline definitions in
+ * libproject1.a, so this measures the real call, not a folded constant.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "operations.h"
+
+#define OPERANDS 4096           // 32 KiB of operands, fits in L1
+#define WARMUP_ITERATIONS 1000000
+#define ITERATIONS 4000000
+#define REPETITIONS 15
+
+typedef void (*operation)(float, float, float *);
+
+typedef struct {
+    const char *name;
+    operation op;
+    double mean, stddev, best;
+} benchmark;
+
+static float lhs[OPERANDS], rhs[OPERANDS];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double run(operation op, long iterations) {
+    float result, sink = 0;
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        op(lhs[i & (OPERANDS - 1)], rhs[i & (OPERANDS - 1)], &result);
+        sink += result;
+    }
+    double elapsed = now_ns() - start;
+    // keep the results live so the loop cannot be dropped
+    volatile float keep = sink;
+    (void)keep;
+    return elapsed / iterations;
+}
+
+static void measure(benchmark *b) {
+    double samples[REPETITIONS], sum = 0, sq = 0;
+    run(b->op, WARMUP_ITERATIONS);
+    b->best = INFINITY;
+    for (int r = 0; r < REPETITIONS; r++) {
+        samples[r] = run(b->op, ITERATIONS);
+        sum += samples[r];
+        if (samples[r] < b->best)
+            b->best = samples[r];
+    }
+    b->mean = sum / REPETITIONS;
+    for (int r = 0; r < REPETITIONS; r++)
+        sq += (samples[r] - b->mean) * (samples[r] - b->mean);
+    b->stddev = sqrt(sq / (REPETITIONS - 1));
+}
+
+// Baseline files hold one "name mean" line per operation
+static double baseline_mean(const char *path, const char *name) {
+    FILE *f = fopen(path, "r");
+    char line_name[64];
+    double mean;
+    if (f == NULL)
+        return -1;
+    while (fscanf(f, "%63s %lf", line_name, &mean) == 2) {
+        if (strcmp(line_name, name) == 0) {
+            fclose(f);
+            return mean;
+        }
+    }
+    fclose(f);
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    const char *save_path = NULL, *compare_path = NULL;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--save") == 0) {
+            save_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare_path = argv[i + 1];
+        }
+    }
+
+    benchmark benchmarks[] = {
+        {"addtion", addtion, 0, 0, 0},
+        {"subtraction", subtraction, 0, 0, 0},
+        {"multiplication", multiplication, 0, 0, 0},
+        {"division", division, 0, 0, 0},
+    };
+    int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    srand(1);
+    for (int i = 0; i < OPERANDS; i++) {
+        lhs[i] = (float)(rand() % 20000 - 10000) / 7.0f;
+        rhs[i] = (float)(rand() % 20000 + 1) / 3.0f;   // never zero
+    }
+
+    printf("%-16s %10s %10s %10s", "operation", "mean ns/op", "stddev", "best");
+    if (compare_path != NULL)
+        printf(" %10s", "vs base");
+    printf("\n");
+
+    FILE *save = save_path != NULL ? fopen(save_path, "w") : NULL;
+    for (int i = 0; i < count; i++) {
+        benchmark *b = &benchmarks[i];
+        measure(b);
+        printf("%-16s %10.3f %10.3f %10.3f", b->name, b->mean, b->stddev, b->best);
+        if (compare_path != NULL) {
+            double base = baseline_mean(compare_path, b->name);
+            if (base > 0)
+                printf(" %+9.1f%%", (b->mean - base) / base * 100.0);
+            else
+                printf(" %10s", "n/a");
+        }
+        printf("\n");
+        if (save != NULL)
+            fprintf(save, "%s %.6f\n", b->name, b->mean);
+    }
+    if (save != NULL) {
+        fclose(save);
+        printf("Baseline saved to %s\n", save_path);
+    }
+    return 0;
+}
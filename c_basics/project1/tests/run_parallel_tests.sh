@@ -0,0 +1,170 @@
+#!/bin/bash
+
+# Parallel integration test runner for the calculator
+#
+# Runs every scenario in scenarios.txt concurrently, each in its own temp
+# directory with its own output file, under a per-test timeout. Prints one
+# line per case with its wall time and writes a JUnit XML report.
+#
+# Usage: ./run_parallel_tests.sh [-j jobs] [-t timeout_seconds] [-o report.xml] [scenarios.txt]
+
+# A path from the command line, relative to the caller's directory
+absolute() {
+    case $1 in
+        /*) printf '%s' "$1" ;;
+        *) printf '%s' "$PWD/$1" ;;
+    esac
+}
+
+JOBS=$(nproc 2>/dev/null || echo 4)
+TIMEOUT=10
+REPORT=test-results.xml
+SCENARIOS=scenarios.txt
+BINARY="$(cd "$(dirname "$0")/.." && pwd)/main.exe"
+OUTPUT_LINES=20
+
+while getopts "j:t:o:" opt; do
+    case $opt in
+        j) JOBS=$OPTARG ;;
+        t) TIMEOUT=$OPTARG ;;
+        o) REPORT=$(absolute "$OPTARG") ;;
+        *) echo "Usage: $0 [-j jobs] [-t timeout_seconds] [-o report.xml] [scenarios.txt]"; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+[ -n "$1" ] && SCENARIOS=$(absolute "$1")
+
+# The defaults live next to this script; paths given on the command line
+# were made absolute above, so they still mean the caller's directory
+cd "$(dirname "$0")"
+
+if [ ! -x "$BINARY" ]; then
+    echo "✗ $BINARY not found, build it first (make ../main.exe)"
+    exit 2
+fi
+
+RUN_DIR=$(mktemp -d "${TMPDIR:-/tmp}/calc-tests.XXXXXX")
+trap 'rm -rf "$RUN_DIR"' EXIT
+
+now_ms() {
+    date +%s%3N
+}
+
+trim() {
+    local s=$1
+    s="${s#"${s%%[![:space:]]*}"}"
+    s="${s%"${s##*[![:space:]]}"}"
+    printf '%s' "$s"
+}
+
+xml_escape() {
+    sed -e 's/&/\&amp;/g' -e 's/</\&lt;/g' -e 's/>/\&gt;/g' -e 's/"/\&quot;/g'
+}
+
+# Run one scenario inside $RUN_DIR/<index>/ and leave its verdict in files:
+# status (pass|fail|timeout), time_ms, message, output.txt
+run_case() {
+    local dir=$1 input=$2 expectations=$3
+    cd "$dir" || return
+
+    local start end status=pass message=""
+    start=$(now_ms)
+    printf '%b' "$input" | timeout "$TIMEOUT" "$BINARY" > output.txt 2>&1
+    local code=$?
+    end=$(now_ms)
+
+    if [ $code -eq 124 ]; then
+        status=timeout
+        message="timed out after ${TIMEOUT}s"
+    else
+        local expectation
+        while IFS= read -r expectation; do
+            expectation=$(trim "$expectation")
+            if [[ $expectation =~ ^\>=([0-9]+)\ (.*)$ ]]; then
+                local wanted=${BASH_REMATCH[1]} text=${BASH_REMATCH[2]} found
+                found=$(grep -cF -- "$text" output.txt)
+                if [ "$found" -lt "$wanted" ]; then
+                    status=fail
+                    message="expected '$text' at least $wanted times, found $found"
+                    break
+                fi
+            elif ! grep -qF -- "$expectation" output.txt; then
+                status=fail
+                message="expected output to contain '$expectation'"
+                break
+            fi
+        done <<< "$(printf '%s' "$expectations" | sed 's/ && /\n/g')"
+    fi
+
+    echo "$status" > status
+    echo $((end - start)) > time_ms
+    printf '%s' "$message" > message
+}
+
+# Read scenarios, start each one as soon as a job slot is free
+names=()
+suite_start=$(now_ms)
+while IFS= read -r line || [ -n "$line" ]; do
+    [[ -z "${line//[[:space:]]/}" || $line =~ ^[[:space:]]*# ]] && continue
+    IFS='|' read -r name input expectations <<< "$line"
+    name=$(trim "$name")
+    input=$(trim "$input")
+    expectations=$(trim "$expectations")
+
+    index=${#names[@]}
+    names+=("$name")
+    mkdir -p "$RUN_DIR/$index"
+
+    while [ "$(jobs -rp | wc -l)" -ge "$JOBS" ]; do
+        wait -n
+    done
+    run_case "$RUN_DIR/$index" "$input" "$expectations" &
+done < "$SCENARIOS"
+wait
+suite_ms=$(( $(now_ms) - suite_start ))
+
+# Report in scenario order
+echo "Running ${#names[@]} integration scenarios ($JOBS parallel, ${TIMEOUT}s timeout)..."
+failures=0
+total_ms=0
+cases_xml=""
+for index in "${!names[@]}"; do
+    dir="$RUN_DIR/$index"
+    name=${names[$index]}
+    status=$(cat "$dir/status")
+    time_ms=$(cat "$dir/time_ms")
+    message=$(cat "$dir/message")
+    total_ms=$((total_ms + time_ms))
+    seconds=$(printf '%d.%03d' $((time_ms / 1000)) $((time_ms % 1000)))
+
+    cases_xml+="    <testcase classname=\"calculator.integration\" name=\"$(printf '%s' "$name" | xml_escape)\" time=\"$seconds\">"$'\n'
+    if [ "$status" = pass ]; then
+        printf '✓ %-28s %6s ms\n' "$name" "$time_ms"
+    else
+        failures=$((failures + 1))
+        printf '✗ %-28s %6s ms  %s\n' "$name" "$time_ms" "$message"
+        # a hung calculator can print forever, so only keep the tail
+        tail -n "$OUTPUT_LINES" "$dir/output.txt" | sed 's/^/    | /'
+        echo
+        cases_xml+="      <failure message=\"$(printf '%s' "$message" | xml_escape)\" type=\"$status\"/>"$'\n'
+        cases_xml+="      <system-out>$(tail -n "$OUTPUT_LINES" "$dir/output.txt" | xml_escape)</system-out>"$'\n'
+    fi
+    cases_xml+="    </testcase>"$'\n'
+done
+
+suite_seconds=$(printf '%d.%03d' $((suite_ms / 1000)) $((suite_ms % 1000)))
+{
+    echo '<?xml version="1.0" encoding="UTF-8"?>'
+    echo "<testsuites tests=\"${#names[@]}\" failures=\"$failures\" time=\"$suite_seconds\">"
+    echo "  <testsuite name=\"calculator.integration\" tests=\"${#names[@]}\" failures=\"$failures\" errors=\"0\" time=\"$suite_seconds\">"
+    printf '%s' "$cases_xml"
+    echo "  </testsuite>"
+    echo "</testsuites>"
+} > "$REPORT"
+
+echo "Wall time ${suite_ms} ms (sum of cases ${total_ms} ms), report written to $REPORT"
+if [ $failures -ne 0 ]; then
+    echo "✗ $failures of ${#names[@]} scenarios failed"
+    exit 1
+fi
+echo "Integration tests completed!"
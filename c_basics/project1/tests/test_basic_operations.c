@@ -1,29 +1,14 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
 #include <math.h>
 
-// Function implementations from main.c
-void addtion(float a, float b, float *result) {
-    *result = a + b;
-}
-
-void subtraction(float a, float b, float *result) {
-    *result = a - b;
-}
+// The operations come from ../main.c, linked in as libproject1.a
+#include "operations.h"
 
-void multiplication(float a, float b, float *result) {
-    *result = a * b;
-}
-
-void division(float a, float b, float *result) {
-    if (b == 0) {
-        printf("Error: Division by zero!\n");
-        *result = 0;
-    }
-    else {
-        *result = a / b;
-    }
-}
+#define PROPERTY_CASES 1000000
 
 // Test helper function
 int float_equals(float a, float b, float tolerance) {
@@ -127,13 +112,120 @@ void test_division() {
     printf("Division tests passed!\n");
 }
 
-int main() {
+// ---------------------------------------------------------------------------
+// Property-based tests: random floats (every finite bit pattern, so zeros,
+// subnormals and FLT_MAX show up too) checked against rules that must hold
+// for every input, not just a few hand-picked values.
+// ---------------------------------------------------------------------------
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static float random_float(void) {
+    float f;
+    do {
+        uint32_t bits = next_random();
+        // half the time stay in a calculator-like range instead
+        if (bits & 1) {
+            f = (float)((int32_t)next_random() % 2000000) / 1000.0f;
+        } else {
+            memcpy(&f, &bits, sizeof(f));
+        }
+    } while (isnan(f) || isinf(f));
+    return f;
+}
+
+// Same value, and same sign for zeros
+static int same_float(float a, float b) {
+    if (isnan(a) && isnan(b))
+        return 1;
+    return a == b && signbit(a) == signbit(b);
+}
+
+static void report_failure(const char *property, float a, float b, float got,
+                           float expected) {
+    printf("Property '%s' failed for a=%.9g b=%.9g: got %.9g expected %.9g\n",
+           property, a, b, got, expected);
+    exit(1);
+}
+
+void test_properties() {
+    printf("Testing properties on %d random pairs (seed %u)...\n",
+           PROPERTY_CASES, rng_state);
+    for (int i = 0; i < PROPERTY_CASES; i++) {
+        float a = random_float(), b = random_float();
+        float r1, r2;
+
+        // Each operation is one correctly rounded float operation. double
+        // has more than twice float's precision, so rounding the double
+        // result to float gives exactly that answer.
+        addtion(a, b, &r1);
+        if (!same_float(r1, (float)((double)a + (double)b)))
+            report_failure("addition is correctly rounded", a, b, r1,
+                           (float)((double)a + (double)b));
+        subtraction(a, b, &r1);
+        if (!same_float(r1, (float)((double)a - (double)b)))
+            report_failure("subtraction is correctly rounded", a, b, r1,
+                           (float)((double)a - (double)b));
+        multiplication(a, b, &r1);
+        if (!same_float(r1, (float)((double)a * (double)b)))
+            report_failure("multiplication is correctly rounded", a, b, r1,
+                           (float)((double)a * (double)b));
+        if (b != 0) {
+            division(a, b, &r1);
+            if (!same_float(r1, (float)((double)a / (double)b)))
+                report_failure("division is correctly rounded", a, b, r1,
+                               (float)((double)a / (double)b));
+        }
+
+        // Algebraic identities
+        addtion(a, b, &r1);
+        addtion(b, a, &r2);
+        if (!same_float(r1, r2))
+            report_failure("a + b == b + a", a, b, r1, r2);
+        multiplication(a, b, &r1);
+        multiplication(b, a, &r2);
+        if (!same_float(r1, r2))
+            report_failure("a * b == b * a", a, b, r1, r2);
+        subtraction(a, b, &r1);
+        subtraction(b, a, &r2);
+        if (r1 != -r2)
+            report_failure("a - b == -(b - a)", a, b, r1, -r2);
+        addtion(a, 0.0f, &r1);
+        if (r1 != a)
+            report_failure("a + 0 == a", a, 0.0f, r1, a);
+        multiplication(a, 1.0f, &r1);
+        if (!same_float(r1, a))
+            report_failure("a * 1 == a", a, 1.0f, r1, a);
+        if (a != 0) {
+            division(a, a, &r1);
+            if (r1 != 1.0f)
+                report_failure("a / a == 1", a, a, r1, 1.0f);
+        }
+    }
+    printf("Property tests passed!\n");
+}
+
+int main(int argc, char *argv[]) {
+    // Optional seed so a failing property run can be reproduced
+    if (argc > 1) {
+        rng_state = (uint32_t)strtoul(argv[1], NULL, 10);
+        if (rng_state == 0)
+            rng_state = 1;
+    }
     printf("Running unit tests for calculator functions...\n\n");
     
     test_addition();
     test_subtraction();
     test_multiplication();
     test_division();
+    test_properties();
     
     printf("\nAll unit tests passed!\n");
     return 0;
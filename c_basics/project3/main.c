@@ -4,50 +4,11 @@
 #include <string.h>
 #include <time.h>
 
-// Enum for sensor types
-typedef enum {
-  UNK = -1,
-  TEMPERATURE,
-  HUMIDITY,
-  PRESSURE,
-} SensorType;
-
-// Enum for sensor status
-typedef enum { ACTIVE, INACTIVE, ERROR } SensorStatus;
-
-// Union for sensor-specific configuration and data
-typedef union {
-  struct {
-    short int min_range; // Temperature range min (Celsius)
-    short int max_range; // Temperature range max (Celsius)
-    float reading;       // Latest reading
-  } temperature;
-  struct {
-    float calibration; // Calibration factor
-    float reading;     // Latest reading
-  } humidity;
-  struct {
-    short int altitude; // Altitude compensation (meters)
-    float reading;      // Latest reading
-  } pressure;
-} SensorData;
-
-// Struct for Sensor
-typedef struct {
-  unsigned char id;
-  char name[20];
-  SensorType type;
-  SensorData data;
-  SensorStatus status;
-} Sensor;
-
-// Function prototypes
-void init_sensor(Sensor *sensors, unsigned char *count,
-                 unsigned char max_sensors);
-void read_sensor_data(Sensor *sensor);
-void process_sensor_data(Sensor *sensor);
-void display_sensors(Sensor *sensors, unsigned char count);
+#include "sensors.h"
 
+// Built without main() under -DUNIT_TEST so ../rvbench can link the
+// sensor processing
+#ifndef UNIT_TEST
 // Main function with sample usage
 int main() {
   Sensor sensors[10] = {0}; // Static array for max 10 sensors
@@ -84,6 +45,7 @@ int main() {
 
   return 0;
 }
+#endif
 
 // Function implementations (to be completed)
 void init_sensor(Sensor *sensors, unsigned char *count,
@@ -0,0 +1,51 @@
+// sensors.h - project3's sensor types and functions, shared with
+// ../rvbench, which times process_sensor_data on rv32
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+// Enum for sensor types
+typedef enum {
+  UNK = -1,
+  TEMPERATURE,
+  HUMIDITY,
+  PRESSURE,
+} SensorType;
+
+// Enum for sensor status
+typedef enum { ACTIVE, INACTIVE, ERROR } SensorStatus;
+
+// Union for sensor-specific configuration and data
+typedef union {
+  struct {
+    short int min_range; // Temperature range min (Celsius)
+    short int max_range; // Temperature range max (Celsius)
+    float reading;       // Latest reading
+  } temperature;
+  struct {
+    float calibration; // Calibration factor
+    float reading;     // Latest reading
+  } humidity;
+  struct {
+    short int altitude; // Altitude compensation (meters)
+    float reading;      // Latest reading
+  } pressure;
+} SensorData;
+
+// Struct for Sensor
+typedef struct {
+  unsigned char id;
+  char name[20];
+  SensorType type;
+  SensorData data;
+  SensorStatus status;
+} Sensor;
+
+// Function prototypes
+void init_sensor(Sensor *sensors, unsigned char *count,
+                 unsigned char max_sensors);
+void read_sensor_data(Sensor *sensor);
+void process_sensor_data(Sensor *sensor);
+void display_sensors(Sensor *sensors, unsigned char count);
+
+#endif
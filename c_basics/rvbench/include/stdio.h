@@ -0,0 +1,18 @@
+/*
+ * stdio.h - The part of <stdio.h> the benchmarked code uses, on rvlib
+ *
+ * riscv64-unknown-elf-gcc comes without a C library, so rvbench builds
+ * freestanding and finds these few headers first (-Iinclude). Output is
+ * rvlib's UART printf; scanf is the harness's stub.
+ */
+
+#ifndef RVBENCH_STDIO_H
+#define RVBENCH_STDIO_H
+
+#include "uart.h"
+
+#define EOF (-1)
+
+int scanf(const char *format, ...);
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * stdlib.h - rand and srand for the benchmarked code; bench_kernels.c
+ * defines them, with the C standard's example generator
+ */
+
+#ifndef RVBENCH_STDLIB_H
+#define RVBENCH_STDLIB_H
+
+#include <stddef.h>
+
+#define RAND_MAX 0x7fffffff
+
+int rand(void);
+void srand(unsigned seed);
+
+#endif
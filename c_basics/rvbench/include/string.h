@@ -0,0 +1,10 @@
+/*
+ * string.h - rvlib's memcpy, memmove, memset, memcmp and strlen
+ */
+
+#ifndef RVBENCH_STRING_H
+#define RVBENCH_STRING_H
+
+#include "rvlib.h"
+
+#endif
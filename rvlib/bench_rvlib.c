@@ -0,0 +1,205 @@
+/*
+ * bench_rvlib.c - Check and time rvlib's routines on QEMU's virt board
+ *
+ * For every routine, a few alignments and sizes from 1 byte to 4 KiB:
+ * check the result against a plain byte loop, then count what one call
+ * costs with rdinstret and rdcycle, next to the byte loop's cost. Output
+ * goes to the UART through rvlib's printf, one line per case and size,
+ * with the byte loop's instret in the last column.
+ *
+ * QEMU has no timing model, so make bench runs it with -icount, where both
+ * counters count instructions. main returns the number of failed checks,
+ * which crt0.s turns into QEMU's exit status.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rvlib.h"
+#include "uart.h"
+
+#define MAX_SIZE 4096
+
+static const size_t sizes[] = {1, 3, 8, 16, 64, 256, 1024, MAX_SIZE};
+
+enum routine { MEMCPY, MEMMOVE, MEMSET, MEMCMP, STRLEN };
+
+typedef struct {
+    enum routine routine;
+    const char *name;
+    unsigned dst_offset, src_offset;    // bytes past a word boundary
+    int overlap;                        // memmove: src this many bytes below dst
+} bench_case;
+
+static const bench_case cases[] = {
+    {MEMCPY, "aligned", 0, 0, 0},
+    {MEMCPY, "dst+1 src+2", 1, 2, 0},
+    {MEMMOVE, "dst above src", 0, 0, 4},
+    {MEMMOVE, "dst below src", 0, 0, -4},
+    {MEMSET, "aligned", 0, 0, 0},
+    {MEMSET, "dst+3", 3, 0, 0},
+    {MEMCMP, "aligned", 0, 0, 0},
+    {MEMCMP, "a+1 b+2", 1, 2, 0},
+    {STRLEN, "aligned", 0, 0, 0},
+    {STRLEN, "s+1", 1, 0, 0},
+};
+
+static const char *const routine_names[] = {"memcpy", "memmove", "memset", "memcmp", "strlen"};
+
+// Room for the largest size, the offsets and memmove's overlap either way
+static uint32_t dst_words[(MAX_SIZE + 64) / 4], src_words[(MAX_SIZE + 64) / 4];
+static uint32_t expect_words[(MAX_SIZE + 64) / 4];
+
+static uint32_t read_instret(void) {
+    uint32_t value;
+    __asm__ volatile("rdinstret %0" : "=r"(value));
+    return value;
+}
+
+static uint32_t read_cycle(void) {
+    uint32_t value;
+    __asm__ volatile("rdcycle %0" : "=r"(value));
+    return value;
+}
+
+// The byte loops rvlib replaces, as the reference and the baseline. The
+// Makefile keeps gcc from turning them back into library calls.
+static __attribute__((noinline)) void *byte_memcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    while (n--)
+        *d++ = *s++;
+    return dst;
+}
+
+static __attribute__((noinline)) void *byte_memmove(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    if (d <= s) {
+        while (n--)
+            *d++ = *s++;
+    } else {
+        while (n--)
+            d[n] = s[n];
+    }
+    return dst;
+}
+
+static __attribute__((noinline)) void *byte_memset(void *dst, int c, size_t n) {
+    uint8_t *d = dst;
+    while (n--)
+        *d++ = (uint8_t)c;
+    return dst;
+}
+
+static __attribute__((noinline)) int byte_memcmp(const void *a, const void *b, size_t n) {
+    const uint8_t *x = a, *y = b;
+    for (size_t i = 0; i < n; i++)
+        if (x[i] != y[i])
+            return x[i] - y[i];
+    return 0;
+}
+
+static __attribute__((noinline)) size_t byte_strlen(const char *s) {
+    size_t n = 0;
+    while (s[n] != '\0')
+        n++;
+    return n;
+}
+
+static uint8_t *dst_at(const bench_case *c) {
+    return (uint8_t *)dst_words + 16 + c->dst_offset;
+}
+
+static uint8_t *src_at(const bench_case *c) {
+    uint8_t *base = c->routine == MEMMOVE ? (uint8_t *)dst_words + 16 : (uint8_t *)src_words;
+    return base + 16 + c->src_offset - c->overlap;
+}
+
+// Fresh contents for both buffers: bytes that are never zero, so strlen
+// only stops at the terminator. xorshift, since rv32i has no multiply
+// and there is no libgcc to supply one.
+static void fill(uint32_t seed) {
+    uint8_t *dst = (uint8_t *)dst_words, *src = (uint8_t *)src_words;
+    for (size_t i = 0; i < sizeof dst_words; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        dst[i] = (uint8_t)seed | 1;
+        src[i] = (uint8_t)(seed >> 8) | 1;
+    }
+}
+
+// One call of the case's routine, rvlib's or the byte loop; its result
+// as a number
+static uint32_t call(const bench_case *c, size_t n, int byte_loop) {
+    uint8_t *dst = dst_at(c), *src = src_at(c);
+    switch (c->routine) {
+    case MEMCPY:
+        return (uint32_t)(uintptr_t)(byte_loop ? byte_memcpy : memcpy)(dst, src, n);
+    case MEMMOVE:
+        return (uint32_t)(uintptr_t)(byte_loop ? byte_memmove : memmove)(dst, src, n);
+    case MEMSET:
+        return (uint32_t)(uintptr_t)(byte_loop ? byte_memset : memset)(dst, 0xA5, n);
+    case MEMCMP:
+        return (uint32_t)(byte_loop ? byte_memcmp : memcmp)(dst, src, n);
+    case STRLEN:
+        return (uint32_t)(byte_loop ? byte_strlen : strlen)((const char *)dst);
+    }
+    return 0;
+}
+
+// Set the buffers up for a case of n bytes: memcmp gets equal buffers (the
+// slowest case, comparing all n), strlen a terminator after n bytes
+static void prepare(const bench_case *c, size_t n) {
+    fill(0x1234u + (uint32_t)n);
+    if (c->routine == MEMCMP)
+        byte_memcpy(dst_at(c), src_at(c), n);
+    if (c->routine == STRLEN)
+        dst_at(c)[n] = '\0';
+}
+
+// rvlib's result and buffer must match the byte loop's; 1 if not
+static int check(const bench_case *c, size_t n) {
+    prepare(c, n);
+    uint32_t expect = call(c, n, 1);
+    byte_memcpy(expect_words, dst_words, sizeof dst_words);
+    prepare(c, n);
+    uint32_t result = call(c, n, 0);
+    return result != expect || byte_memcmp(expect_words, dst_words, sizeof dst_words) != 0;
+}
+
+// With the UART idle, so no interrupt lands inside the call
+static void measure(const bench_case *c, size_t n, int byte_loop, uint32_t *instret,
+                    uint32_t *cycles) {
+    prepare(c, n);
+    uart_flush();
+    uint32_t i0 = read_instret(), c0 = read_cycle();
+    call(c, n, byte_loop);
+    uint32_t c1 = read_cycle(), i1 = read_instret();
+    *instret = i1 - i0;
+    *cycles = c1 - c0;
+}
+
+int main(void) {
+    int failures = 0;
+    uart_init();
+    printf("%-9s%-14s%7s%10s%10s%11s\n", "routine", "case", "bytes", "instret", "cycles",
+           "byte loop");
+    for (size_t i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+        const bench_case *c = &cases[i];
+        for (size_t s = 0; s < sizeof sizes / sizeof sizes[0]; s++) {
+            size_t n = sizes[s];
+            uint32_t instret, cycles, byte_instret, byte_cycles;
+            int failed = check(c, n);
+            measure(c, n, 0, &instret, &cycles);
+            measure(c, n, 1, &byte_instret, &byte_cycles);
+            printf("%-9s%-14s%7u%10u%10u%11u%s\n", routine_names[c->routine], c->name,
+                   (unsigned)n, (unsigned)instret, (unsigned)cycles, (unsigned)byte_instret,
+                   failed ? "  FAILED" : "");
+            failures += failed;
+        }
+    }
+    uart_flush();
+    return failures;
+}
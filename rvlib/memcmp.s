@@ -0,0 +1,96 @@
+# int memcmp(const void *a, const void *b, size_t n)
+#
+# The difference of the first pair of bytes that differ, as unsigned chars,
+# or 0.
+#
+# When a and b are equally aligned it compares bytes up to a word boundary
+# (the unaligned head), then two words per pass. At the first pair of words
+# that differ it goes back to bytes for those four, which finds the first
+# differing byte whatever the byte order. The last 0-3 bytes (the tail),
+# buffers under 8 bytes, and buffers that are aligned differently are
+# compared a byte at a time.
+
+# Register Roles
+# a0 - next byte of a, then the result
+# a1 - next byte of b
+# a2 - bytes left
+# t0 - end of the current loop (an address in a)
+# t1-t4 - data in flight
+
+.section .text.memcmp
+.global memcmp
+.type memcmp, @function
+
+memcmp:
+    li t0, 8
+    bltu a2, t0, memcmp_bytes
+    xor t1, a0, a1
+    andi t1, t1, 3
+    bnez t1, memcmp_bytes
+
+    andi t1, a0, 3
+    beqz t1, memcmp_aligned
+    li t0, 4
+    sub t1, t0, t1          # 1-3 bytes up to the next word
+    sub a2, a2, t1
+    add t0, a0, t1
+memcmp_head:
+    lbu t1, 0(a0)
+    lbu t2, 0(a1)
+    addi a0, a0, 1
+    addi a1, a1, 1
+    bne t1, t2, memcmp_differ
+    bne a0, t0, memcmp_head
+
+memcmp_aligned:
+    andi t0, a2, -8
+    beqz t0, memcmp_words
+    add t0, t0, a0          # end of the 8-byte pairs
+memcmp_pair:
+    lw t1, 0(a0)
+    lw t2, 0(a1)
+    lw t3, 4(a0)
+    lw t4, 4(a1)
+    bne t1, t2, memcmp_word_differs
+    addi a0, a0, 4
+    addi a1, a1, 4
+    bne t3, t4, memcmp_word_differs
+    addi a0, a0, 4
+    addi a1, a1, 4
+    bne a0, t0, memcmp_pair
+
+memcmp_words:
+    andi t0, a2, 4
+    beqz t0, memcmp_tail
+    lw t1, 0(a0)
+    lw t2, 0(a1)
+    bne t1, t2, memcmp_word_differs
+    addi a0, a0, 4
+    addi a1, a1, 4
+
+memcmp_tail:
+    andi a2, a2, 3
+memcmp_bytes:
+    beqz a2, memcmp_equal
+    add t0, a0, a2
+memcmp_byte:
+    lbu t1, 0(a0)
+    lbu t2, 0(a1)
+    addi a0, a0, 1
+    addi a1, a1, 1
+    bne t1, t2, memcmp_differ
+    bne a0, t0, memcmp_byte
+memcmp_equal:
+    li a0, 0
+    ret
+
+# a0 and a1 point at the words that differ
+memcmp_word_differs:
+    li a2, 4
+    j memcmp_bytes
+
+memcmp_differ:
+    sub a0, t1, t2
+    ret
+
+.size memcmp, . - memcmp
@@ -0,0 +1,148 @@
+# void *memcpy(void *dst, const void *src, size_t n)
+#
+# rv32i has no unaligned word access worth using, so a word copy needs
+# both pointers on a word boundary. The plan:
+#
+# 1. Under 8 bytes, just copy bytes: lining up would cost more than it saves.
+# 2. Copy 1-3 bytes until dst is word aligned (the unaligned head).
+# 3. If src is now aligned too, copy 32 bytes per pass with eight lw and
+#    then eight sw, so no sw waits on the lw just before it. Then single
+#    words, then the last 0-3 bytes (the unaligned tail).
+# 4. If src is not aligned (src and dst differ mod 4), still store whole
+#    words: load the aligned words src straddles and shift two of them
+#    together for each word of dst. Every lw stays inside an aligned word
+#    that holds at least one byte of src, so it never reads past the page.
+#
+# Per 32 bytes that is 19 instructions for the aligned copy against 160 for
+# a byte loop. make bench measures each case.
+#
+# Forward only: safe when dst is below src even if they overlap, which is
+# what memmove relies on.
+
+# Register Roles
+# a0 - dst, returned unchanged
+# a1 - next src byte
+# a2 - bytes left
+# a3 - next dst byte
+# a4 - src rounded down to a word (step 4)
+# a5, a6 - right and left shift in bits that line src up with dst (step 4)
+# t0 - end of the current loop (a dst address)
+# t1-t6, a7 - data in flight
+
+.section .text.memcpy
+.global memcpy
+.type memcpy, @function
+
+memcpy:
+    mv a3, a0
+    li t0, 8
+    bltu a2, t0, memcpy_bytes
+
+    andi t1, a3, 3
+    beqz t1, memcpy_aligned
+    li t2, 4
+    sub t1, t2, t1          # 1-3 bytes up to dst's next word
+    sub a2, a2, t1
+    add t0, a3, t1
+memcpy_head:
+    lbu t2, 0(a1)
+    addi a1, a1, 1
+    sb t2, 0(a3)
+    addi a3, a3, 1
+    bne a3, t0, memcpy_head
+
+memcpy_aligned:
+    andi t1, a1, 3
+    bnez t1, memcpy_shifted
+    andi t0, a2, -32
+    beqz t0, memcpy_words
+    add t0, t0, a3          # end of the 32-byte blocks
+memcpy_block:
+    lw t1, 0(a1)
+    lw t2, 4(a1)
+    lw t3, 8(a1)
+    lw t4, 12(a1)
+    lw t5, 16(a1)
+    lw t6, 20(a1)
+    lw a6, 24(a1)
+    lw a7, 28(a1)
+    sw t1, 0(a3)
+    sw t2, 4(a3)
+    sw t3, 8(a3)
+    sw t4, 12(a3)
+    sw t5, 16(a3)
+    sw t6, 20(a3)
+    sw a6, 24(a3)
+    sw a7, 28(a3)
+    addi a1, a1, 32
+    addi a3, a3, 32
+    bne a3, t0, memcpy_block
+
+memcpy_words:
+    andi t0, a2, 28         # whole words left after the blocks
+    beqz t0, memcpy_tail
+    add t0, t0, a3
+memcpy_word:
+    lw t1, 0(a1)
+    addi a1, a1, 4
+    sw t1, 0(a3)
+    addi a3, a3, 4
+    bne a3, t0, memcpy_word
+
+memcpy_tail:
+    andi a2, a2, 3
+memcpy_bytes:
+    beqz a2, memcpy_done
+    add t0, a3, a2
+memcpy_byte:
+    lbu t1, 0(a1)
+    addi a1, a1, 1
+    sb t1, 0(a3)
+    addi a3, a3, 1
+    bne a3, t0, memcpy_byte
+memcpy_done:
+    ret
+
+# dst is aligned, src is 1-3 bytes past a word: each dst word is the top of
+# one src word and the bottom of the next
+memcpy_shifted:
+    sub a4, a1, t1          # a4 = src rounded down
+    slli a5, t1, 3          # a5 = 8, 16 or 24
+    neg a6, a5              # sll only uses the low 5 bits: 32 - a5
+    andi t0, a2, -8
+    beqz t0, memcpy_shifted_one
+    add t0, t0, a3          # end of the 8-byte pairs
+    lw t1, 0(a4)
+memcpy_shifted_pair:
+    lw t2, 4(a4)
+    lw t3, 8(a4)
+    srl t1, t1, a5
+    sll t4, t2, a6
+    or t1, t1, t4
+    srl t2, t2, a5
+    sll t4, t3, a6
+    or t2, t2, t4
+    sw t1, 0(a3)
+    sw t2, 4(a3)
+    mv t1, t3               # the next pair starts with this word
+    addi a4, a4, 8
+    addi a3, a3, 8
+    bne a3, t0, memcpy_shifted_pair
+
+memcpy_shifted_one:
+    andi t0, a2, 4
+    beqz t0, memcpy_shifted_done
+    lw t1, 0(a4)
+    lw t2, 4(a4)
+    srl t1, t1, a5
+    sll t2, t2, a6
+    or t1, t1, t2
+    sw t1, 0(a3)
+    addi a4, a4, 4
+    addi a3, a3, 4
+memcpy_shifted_done:
+    srli t1, a5, 3
+    add a1, a4, t1          # back to a byte pointer for the tail
+    j memcpy_tail
+
+.size memcpy, . - memcpy
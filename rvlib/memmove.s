@@ -0,0 +1,92 @@
+# void *memmove(void *dst, const void *src, size_t n)
+#
+# When dst is below src, or the two do not overlap at all, memcpy's forward
+# copy is already right: one unsigned compare, dst - src >= n, covers both.
+#
+# Otherwise dst overlaps the end of src and the copy has to run backwards,
+# from the last byte down. If dst and src are equally aligned it copies
+# bytes down to a word boundary, then 16 bytes per pass (four lw, then four
+# sw), then words, then the first 0-3 bytes. If they are not, it copies
+# bytes: overlapping moves between differently aligned buffers are rare
+# enough not to carry memcpy's shifting loop a second time.
+
+# Register Roles
+# a0 - dst, returned unchanged
+# a1 - one past the next src byte (the copy walks down)
+# a2 - bytes left
+# a3 - one past the next dst byte
+# t0 - end of the current loop (a dst address)
+# t1-t4 - data in flight
+
+.section .text.memmove
+.global memmove
+.type memmove, @function
+
+memmove:
+    sub t0, a0, a1
+    bltu t0, a2, memmove_backward
+    tail memcpy
+
+memmove_backward:
+    add a1, a1, a2
+    add a3, a0, a2
+    li t0, 8
+    bltu a2, t0, memmove_bytes
+    xor t1, a1, a3
+    andi t1, t1, 3
+    bnez t1, memmove_bytes
+
+    andi t1, a3, 3          # 0-3 bytes down to dst's word boundary
+    beqz t1, memmove_aligned
+    sub a2, a2, t1
+    sub t0, a3, t1
+memmove_head:
+    lbu t2, -1(a1)
+    addi a1, a1, -1
+    sb t2, -1(a3)
+    addi a3, a3, -1
+    bne a3, t0, memmove_head
+
+memmove_aligned:
+    andi t0, a2, -16
+    beqz t0, memmove_words
+    sub t0, a3, t0          # bottom of the 16-byte blocks
+memmove_block:
+    lw t1, -4(a1)
+    lw t2, -8(a1)
+    lw t3, -12(a1)
+    lw t4, -16(a1)
+    sw t1, -4(a3)
+    sw t2, -8(a3)
+    sw t3, -12(a3)
+    sw t4, -16(a3)
+    addi a1, a1, -16
+    addi a3, a3, -16
+    bne a3, t0, memmove_block
+
+memmove_words:
+    andi t0, a2, 12         # whole words left after the blocks
+    beqz t0, memmove_tail
+    sub t0, a3, t0
+memmove_word:
+    lw t1, -4(a1)
+    addi a1, a1, -4
+    sw t1, -4(a3)
+    addi a3, a3, -4
+    bne a3, t0, memmove_word
+
+memmove_tail:
+    andi a2, a2, 3
+memmove_bytes:
+    beqz a2, memmove_done
+    sub t0, a3, a2
+memmove_byte:
+    lbu t1, -1(a1)
+    addi a1, a1, -1
+    sb t1, -1(a3)
+    addi a3, a3, -1
+    bne a3, t0, memmove_byte
+memmove_done:
+    ret
+
+.size memmove, . - memmove
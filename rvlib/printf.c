@@ -0,0 +1,276 @@
+/*
+ * printf.c - printf, snprintf and friends without malloc or libgcc (see
+ * uart.h for what they support)
+ *
+ * One formatter writes through an emit callback: into the UART ring for
+ * printf, into the caller's buffer for snprintf. printf collects its
+ * output in a 64-byte buffer on the stack and hands the ring whole chunks.
+ *
+ * rv32i has no divide and -nostdlib has no libgcc to do it in software, so
+ * decimal digits come from subtracting powers of ten (at most 9 per digit)
+ * and hex and octal ones from shifts.
+ */
+
+#include <stdint.h>
+
+#include "uart.h"
+
+typedef void (*emit_fn)(void *context, const char *bytes, size_t n);
+
+typedef struct {
+    emit_fn emit;
+    void *context;
+    int count;                  // bytes formatted so far
+} output;
+
+static void put(output *out, const char *bytes, size_t n) {
+    out->emit(out->context, bytes, n);
+    out->count += (int)n;
+}
+
+static void pad(output *out, char c, int n) {
+    char spaces[16];
+    for (size_t i = 0; i < sizeof spaces; i++)
+        spaces[i] = c;
+    for (; n > 0; n -= (int)sizeof spaces)
+        put(out, spaces, n < (int)sizeof spaces ? (size_t)n : sizeof spaces);
+}
+
+static const uint64_t powers_of_ten[] = {
+    10000000000000000000u, 1000000000000000000u, 100000000000000000u,
+    10000000000000000u, 1000000000000000u, 100000000000000u, 10000000000000u,
+    1000000000000u, 100000000000u, 10000000000u, 1000000000u, 100000000u,
+    10000000u, 1000000u, 100000u, 10000u, 1000u, 100u, 10u, 1u,
+};
+
+// value's digits, ending just before end; returns where they start
+static char *digits(uint64_t value, unsigned base, int upper, char *end) {
+    const char *set = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+    if (base != 10) {
+        // constant shifts: a variable 64-bit one could be a libgcc call
+        do {
+            *--p = set[value & (base - 1)];
+            value = base == 16 ? value >> 4 : value >> 3;
+        } while (value != 0);
+        return p;
+    }
+    // Most significant first: skip the powers above value (all of the
+    // first ten for a 32-bit one), then count subtractions
+    size_t count = sizeof powers_of_ten / sizeof powers_of_ten[0], i = value >> 32 ? 0 : 10;
+    while (i < count - 1 && value < powers_of_ten[i])
+        i++;
+    p -= count - i;
+    for (char *q = p; i < count; i++) {
+        char digit = '0';
+        while (value >= powers_of_ten[i]) {
+            value -= powers_of_ten[i];
+            digit++;
+        }
+        *q++ = digit;
+    }
+    return p;
+}
+
+enum { FLAG_LEFT = 1, FLAG_ZERO = 2, FLAG_PLUS = 4, FLAG_SPACE = 8 };
+
+static int format(emit_fn emit, void *context, const char *f, va_list args) {
+    output out = {emit, context, 0};
+    while (*f != '\0') {
+        const char *literal = f;
+        while (*f != '\0' && *f != '%')
+            f++;
+        if (f > literal)
+            put(&out, literal, (size_t)(f - literal));
+        if (*f == '\0')
+            break;
+        const char *spec = f++;     // the '%', for printing a bad one as is
+
+        int flags = 0;
+        for (;; f++) {
+            if (*f == '-') flags |= FLAG_LEFT;
+            else if (*f == '0') flags |= FLAG_ZERO;
+            else if (*f == '+') flags |= FLAG_PLUS;
+            else if (*f == ' ') flags |= FLAG_SPACE;
+            else break;
+        }
+        int width = 0, precision = -1;
+        if (*f == '*') {
+            width = va_arg(args, int);
+            if (width < 0)
+                flags |= FLAG_LEFT, width = -width;
+            f++;
+        }
+        for (; *f >= '0' && *f <= '9'; f++)
+            width = width * 10 + (*f - '0');
+        if (*f == '.') {
+            f++;
+            precision = 0;
+            if (*f == '*') {
+                precision = va_arg(args, int);
+                f++;
+            }
+            for (; *f >= '0' && *f <= '9'; f++)
+                precision = precision * 10 + (*f - '0');
+        }
+        int size = 0;           // -2 hh, -1 h, 0 int, 1 long, 2 long long
+        for (;; f++) {
+            if (*f == 'h') size--;
+            else if (*f == 'l') size++;
+            else if (*f == 'z') size = sizeof(size_t) > 4 ? 2 : 0;
+            else break;
+        }
+
+        char buffer[24], *end = buffer + sizeof buffer, *text = end;
+        const char *prefix = "";
+        size_t length;
+        switch (*f) {
+        case 'd':
+        case 'i': {
+            int64_t value = size >= 2 ? va_arg(args, long long)
+                          : size == 1 ? va_arg(args, long) : va_arg(args, int);
+            if (size == -1) value = (short)value;
+            if (size <= -2) value = (signed char)value;
+            uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+            prefix = value < 0 ? "-" : flags & FLAG_PLUS ? "+" : flags & FLAG_SPACE ? " " : "";
+            text = digits(magnitude, 10, 0, end);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'p': {
+            uint64_t value;
+            if (*f == 'p') {
+                value = (uintptr_t)va_arg(args, void *);
+                prefix = "0x";
+            } else {
+                value = size >= 2 ? va_arg(args, unsigned long long)
+                      : size == 1 ? va_arg(args, unsigned long) : va_arg(args, unsigned);
+                if (size == -1) value = (unsigned short)value;
+                if (size <= -2) value = (unsigned char)value;
+            }
+            unsigned base = *f == 'o' ? 8 : *f == 'u' ? 10 : 16;
+            text = digits(value, base, *f == 'X', end);
+            break;
+        }
+        case 'c':
+            *--text = (char)va_arg(args, int);
+            precision = -1;
+            break;
+        case 's': {
+            const char *s = va_arg(args, const char *);
+            if (s == NULL)
+                s = "(null)";
+            for (length = 0; s[length] != '\0' && (precision < 0 || (int)length < precision);)
+                length++;
+            int fill = width - (int)length;
+            if (!(flags & FLAG_LEFT))
+                pad(&out, ' ', fill);
+            put(&out, s, length);
+            if (flags & FLAG_LEFT)
+                pad(&out, ' ', fill);
+            f++;
+            continue;
+        }
+        case '%':
+            put(&out, "%", 1);
+            f++;
+            continue;
+        default:                // not a conversion: print it as written
+            if (*f == '\0')
+                put(&out, spec, (size_t)(f - spec));
+            else
+                put(&out, spec, (size_t)(++f - spec));
+            continue;
+        }
+        f++;
+
+        // sign or 0x, zeros up to the precision (or the width, for the 0
+        // flag), the digits; spaces before or after for the width
+        length = (size_t)(end - text);
+        int zeros = 0;
+        if (precision >= 0) {
+            if (precision == 0 && length == 1 && *text == '0')
+                length = 0;     // %.0d of 0 prints nothing
+            zeros = precision - (int)length;
+        }
+        int prefix_length = 0;
+        while (prefix[prefix_length] != '\0')
+            prefix_length++;
+        if ((flags & FLAG_ZERO) && !(flags & FLAG_LEFT) && precision < 0)
+            zeros = width - prefix_length - (int)length;
+        if (zeros < 0)
+            zeros = 0;
+        int fill = width - prefix_length - zeros - (int)length;
+        if (!(flags & FLAG_LEFT))
+            pad(&out, ' ', fill);
+        put(&out, prefix, (size_t)prefix_length);
+        pad(&out, '0', zeros);
+        put(&out, text, length);
+        if (flags & FLAG_LEFT)
+            pad(&out, ' ', fill);
+    }
+    return out.count;
+}
+
+typedef struct {
+    char *buffer;
+    size_t size, used;          // used counts every byte, even ones cut off
+} string_sink;
+
+static void emit_string(void *context, const char *bytes, size_t n) {
+    string_sink *sink = context;
+    for (size_t i = 0; i < n; i++, sink->used++)
+        if (sink->used + 1 < sink->size)
+            sink->buffer[sink->used] = bytes[i];
+}
+
+int vsnprintf(char *buffer, size_t size, const char *format_string, va_list args) {
+    string_sink sink = {buffer, size, 0};
+    int n = format(emit_string, &sink, format_string, args);
+    if (size > 0)
+        buffer[sink.used < size ? sink.used : size - 1] = '\0';
+    return n;
+}
+
+int snprintf(char *buffer, size_t size, const char *format_string, ...) {
+    va_list args;
+    va_start(args, format_string);
+    int n = vsnprintf(buffer, size, format_string, args);
+    va_end(args);
+    return n;
+}
+
+typedef struct {
+    char chunk[64];
+    size_t used;
+} uart_sink;
+
+static void emit_uart(void *context, const char *bytes, size_t n) {
+    uart_sink *sink = context;
+    for (size_t i = 0; i < n; i++) {
+        if (sink->used == sizeof sink->chunk) {
+            uart_write(sink->chunk, sink->used);
+            sink->used = 0;
+        }
+        sink->chunk[sink->used++] = bytes[i];
+    }
+}
+
+int vprintf(const char *format_string, va_list args) {
+    uart_sink sink;
+    sink.used = 0;
+    int n = format(emit_uart, &sink, format_string, args);
+    uart_write(sink.chunk, sink.used);
+    return n;
+}
+
+int printf(const char *format_string, ...) {
+    va_list args;
+    va_start(args, format_string);
+    int n = vprintf(format_string, args);
+    va_end(args);
+    return n;
+}
@@ -0,0 +1,38 @@
+/*
+ * profile.h - Sample the pc on the CLINT timer (profile.s)
+ *
+ * Every period ticks of the 10 MHz machine timer (100 instructions per
+ * tick under QEMU's -icount shift=0), the interrupt's mepc goes into
+ * buffer. At the end, profile_report prints the samples on the UART and
+ * rvsim/rvprof.exe turns the output into a flat profile by label:
+ *
+ *   uint32_t samples[PROFILE_HEADER_WORDS + 8192];
+ *   profile_start(10, samples, sizeof samples / sizeof samples[0]);
+ *   work();
+ *   profile_report();
+ *
+ *   qemu-system-riscv32 ... -kernel prog.elf > prog.out
+ *   ../rvsim/rvprof.exe prog.elf prog.out
+ *
+ * or ../rvsim/rvsim.exe --quiet prog.elf > prog.out in place of QEMU.
+ *
+ * An exception, a `j .` or a full buffer ends the program there and
+ * prints the report by itself. profile_start takes over mtvec and
+ * mscratch: a program that profiles leaves out uart_init (printf still
+ * works, by polling). Assembly programs without crt0 start through
+ * profile_boot.s instead.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROFILE_HEADER_WORDS 8  // the start of buffer is profile.s's state
+
+void profile_start(uint32_t period, uint32_t *buffer, size_t words);
+// Stop sampling and print what was taken
+void profile_report(void);
+
+#endif
@@ -0,0 +1,267 @@
+# profile: sample the pc on the CLINT timer interrupt (see profile.h)
+#
+# profile_start points mtvec at profile_trap and arms mtimecmp. Every
+# period timer ticks profile_trap appends mepc, the pc the interrupt
+# landed on, to the buffer and re-arms. Hot code is where the samples pile
+# up. rvsim/rvprof.exe turns them back into labels. It runs the same
+# under QEMU and under rvsim, which raises the timer interrupt itself
+# (make profile and make profile-sim).
+#
+# The handler uses no stack and only the registers it saves in the
+# buffer's header, so it works under assembly programs like ../m.s that
+# never set sp and use any register they like. mscratch holds the
+# buffer's address while sampling is on.
+#
+# Any exception also ends up in profile_trap: the program has stopped
+# (falling off the end of m.s runs into the illegal zero word below), so
+# it records mcause and mepc, prints the profile and ends the run. So does a
+# sample that lands on `j .`, the "done: j done" that array_ops.s and
+# others end with (mcause is then the timer interrupt's), and one that
+# finds the buffer full (STOP_FULL), so a loop that never ends still
+# gets its profile.
+#
+# Buffer layout, by byte offset (HEADER_WORDS words of header):
+#   0  samples taken          4  room for samples      8  period in ticks
+#  12  mcause that ended the run, -1 while it runs    16  its mepc
+#      (or STOP_FULL)
+#  20  saved t1              24  saved t2             28  saved t3
+#  32  the samples
+#
+# profile_report prints the header and the samples in hex on the UART:
+#
+#   rvprof <period> <samples> <room> <mcause> <mepc>
+#   <up to 8 samples per line>
+#   rvprof end
+
+# Register Roles (profile_trap)
+# t0 - the buffer (swapped with mscratch, which holds the program's t0)
+# t1 - samples taken, then scratch
+# t2 - room, then scratch
+# t3 - scratch (the sampled instruction, then where it goes)
+
+# Register Roles (profile_report)
+# a0, a1 - the word to print and what follows it
+# a2 - samples left to print
+# a3 - next sample
+# a4 - samples printed on this line
+# a5 - the buffer
+# t0 - return address of put_word and put_string, t6 of put_char
+# t1-t4 - scratch
+
+.equ CLINT_MTIMECMP, 0x02004000     # hart 0's, 64 bits
+.equ CLINT_MTIME, 0x0200BFF8        # 10 MHz on the virt board
+.equ UART, 0x10000000               # NS16550: THR at 0, LSR at 5
+.equ UART_LSR_THRE, 0x20
+.equ TEST_DEVICE, 0x100000          # sifive_test, as in crt0.s
+.equ TEST_PASS, 0x5555
+.equ MIE_MTIE, 0x80
+.equ MSTATUS_MIE, 8
+.equ HEADER_WORDS, 8
+.equ J_SELF, 0x6f                   # jal x0, 0: `j .`
+.equ STOP_FULL, -2                  # in place of an mcause: no room left
+
+.section .text.profile
+.balign 4
+
+# Whatever is linked just before this file runs into this word if it
+# falls off its end: an illegal instruction, like the zeros after m.s
+# in an unprofiled build
+.global profile_end_of_program
+profile_end_of_program:
+    .word 0
+
+# void profile_start(uint32_t period, uint32_t *buffer, size_t words)
+.global profile_start
+.type profile_start, @function
+
+profile_start:
+    sw zero, 0(a1)
+    addi a2, a2, -HEADER_WORDS
+    sw a2, 4(a1)
+    sw a0, 8(a1)
+    li t0, -1
+    sw t0, 12(a1)
+    sw zero, 16(a1)
+    csrw mscratch, a1
+    la t0, profile_trap
+    csrw mtvec, t0
+
+    li t0, CLINT_MTIME
+read_mtime:                 # high, low, high again: the low half may carry
+    lw t2, 4(t0)
+    lw t1, 0(t0)
+    lw t3, 4(t0)
+    bne t2, t3, read_mtime
+    add a0, t1, a0
+    sltu t1, a0, t1
+    add t2, t2, t1
+    li t0, CLINT_MTIMECMP
+    li t1, -1
+    sw t1, 4(t0)            # no early match while the halves change
+    sw a0, 0(t0)
+    sw t2, 4(t0)
+
+    li t0, MIE_MTIE
+    csrs mie, t0
+    csrsi mstatus, MSTATUS_MIE
+    ret
+
+.size profile_start, . - profile_start
+
+.global profile_trap
+.type profile_trap, @function
+.balign 4                   # mtvec's low two bits are the mode
+
+profile_trap:
+    csrrw t0, mscratch, t0
+    sw t1, 20(t0)
+    sw t2, 24(t0)
+    sw t3, 28(t0)
+    csrr t1, mcause
+    bgez t1, stopped        # interrupts have the top bit set
+
+    lw t1, 0(t0)
+    lw t2, 4(t0)
+    bgeu t1, t2, buffer_full
+    csrr t2, mepc
+    lw t3, 0(t2)
+    addi t3, t3, -J_SELF
+    beqz t3, idle
+    slli t3, t1, 2
+    add t3, t3, t0
+    sw t2, HEADER_WORDS*4(t3)
+    addi t1, t1, 1
+    sw t1, 0(t0)
+
+    # next sample a period after this one was due, so the spacing stays
+    # even however long the handler took
+    li t1, CLINT_MTIMECMP
+    lw t2, 0(t1)
+    lw t3, 8(t0)
+    add t3, t2, t3
+    sltu t2, t3, t2
+    sw t3, 0(t1)
+    lw t3, 4(t1)
+    add t3, t3, t2
+    sw t3, 4(t1)
+
+resume:
+    lw t1, 20(t0)
+    lw t2, 24(t0)
+    lw t3, 28(t0)
+    csrrw t0, mscratch, t0
+    mret
+
+buffer_full:
+    li t1, STOP_FULL
+    j stopped
+idle:                       # "done: j done": as good as stopped
+    csrr t1, mcause
+stopped:
+    sw t1, 12(t0)
+    csrr t1, mepc
+    sw t1, 16(t0)
+    csrw mscratch, t0       # where profile_report looks for the buffer
+    call profile_report
+    li t0, TEST_DEVICE
+    li t1, TEST_PASS
+    sw t1, 0(t0)
+stopped_loop:
+    j stopped_loop
+
+.size profile_trap, . - profile_trap
+
+# void profile_report(void): stop sampling and print the buffer
+.global profile_report
+.type profile_report, @function
+
+profile_report:
+    li t0, MIE_MTIE
+    csrc mie, t0
+    csrr a5, mscratch
+
+    la a0, report_start
+    jal t0, put_string
+    lw a0, 8(a5)
+    li a1, ' '
+    jal t0, put_word
+    lw a0, 0(a5)
+    jal t0, put_word
+    lw a0, 4(a5)
+    jal t0, put_word
+    lw a0, 12(a5)
+    jal t0, put_word
+    lw a0, 16(a5)
+    li a1, '\n'
+    jal t0, put_word
+
+    lw a2, 0(a5)
+    addi a3, a5, HEADER_WORDS*4
+    li a4, 0
+    beqz a2, report_done
+report_sample:
+    lw a0, 0(a3)
+    addi a3, a3, 4
+    addi a2, a2, -1
+    addi a4, a4, 1
+    li a1, ' '
+    li t1, 8
+    beq a4, t1, end_line
+    bnez a2, put_sample
+end_line:
+    li a1, '\n'
+    li a4, 0
+put_sample:
+    jal t0, put_word
+    bnez a2, report_sample
+
+report_done:
+    la a0, report_end
+    jal t0, put_string
+    ret
+
+.size profile_report, . - profile_report
+
+# a0 as 8 hex digits, then the character in a1; returns through t0
+put_word:
+    li t1, 28
+put_digit:
+    srl t2, a0, t1
+    andi t2, t2, 15
+    addi t2, t2, '0'
+    li t3, '9'
+    bleu t2, t3, digit_ready
+    addi t2, t2, 'a' - '9' - 1
+digit_ready:
+    jal t6, put_char
+    addi t1, t1, -4
+    bgez t1, put_digit
+    mv t2, a1
+    jal t6, put_char
+    jr t0
+
+# The NUL-terminated string at a0; returns through t0
+put_string:
+    lbu t2, 0(a0)
+    beqz t2, put_string_done
+    jal t6, put_char
+    addi a0, a0, 1
+    j put_string
+put_string_done:
+    jr t0
+
+# The byte in t2, once the UART has room; returns through t6
+put_char:
+    li t3, UART
+put_char_wait:
+    lbu t4, 5(t3)
+    andi t4, t4, UART_LSR_THRE
+    beqz t4, put_char_wait
+    sb t2, 0(t3)
+    jr t6
+
+.section .rodata.profile
+report_start:
+    .string "rvprof "
+report_end:
+    .string "rvprof end\n"
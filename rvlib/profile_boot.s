@@ -0,0 +1,49 @@
+# profile_boot: start the sampling profiler (profile.s), then run the
+# program linked right after this file
+#
+# For assembly programs with no crt0, like ../m.s. Link this first, the
+# program next and profile.s last, with the program's own linker script:
+#
+#   riscv64-unknown-elf-gcc -nostdlib -march=rv32i_zicsr -mabi=ilp32 -Wl,-Tm.ld \
+#       -Wa,--defsym,PROFILE_PERIOD=10 rvlib/profile_boot.s m.s rvlib/profile.s
+#
+# so this code is at 0x80000000, where QEMU starts, and falls straight
+# into the program's first instruction. The samples go in RAM well past
+# anything m.ld or array_ops.ld lays out: they only cover the first
+# 4 KiB.
+#
+# PROFILE_PERIOD is in CLINT ticks: 10 MHz, or one tick per 100
+# instructions under QEMU's -icount shift=0.
+
+# Register Roles
+# a0 - the period
+# a1 - the sample buffer
+# a2 - its size in words
+
+.ifndef PROFILE_PERIOD
+.equ PROFILE_PERIOD, 10
+.endif
+.equ PROFILE_BUFFER, 0x80100000
+.equ PROFILE_WORDS, 0x40000         # 1 MiB: about 262000 samples
+
+.section .text
+.global profile_boot
+.type profile_boot, @function
+
+profile_boot:
+    li a0, PROFILE_PERIOD
+    li a1, PROFILE_BUFFER
+    li a2, PROFILE_WORDS
+    call profile_start
+    # the program sees these as it would straight after reset
+    li ra, 0
+    li t0, 0
+    li t1, 0
+    li t2, 0
+    li t3, 0
+    li a0, 0
+    li a1, 0
+    li a2, 0
+    # fall through into the program
+
+.size profile_boot, . - profile_boot
@@ -0,0 +1,33 @@
+/*
+ * rvlib.h - Bulk memory routines for the sandbox's -nostdlib rv32i builds
+ *
+ * The usual string.h functions, in hand-written rv32i assembly (one .s
+ * file each). They move whole words wherever the buffers allow it and
+ * handle the unaligned bytes at either end separately; each file's header
+ * says how.
+ *
+ * gcc emits calls to memcpy, memset, memmove and memcmp by itself (struct
+ * copies, zeroing loops, -O2 loop idioms) even with -nostdlib, so a
+ * program that links librv.a gets these instead of undefined references.
+ *
+ * librv.a also has the startup code for C programs linked with virt.ld
+ * (crt0.s), which ends in _exit, and sbrk for virt.ld's heap.
+ */
+
+#ifndef RVLIB_H
+#define RVLIB_H
+
+#include <stddef.h>
+
+void *memcpy(void *dst, const void *src, size_t n);
+void *memmove(void *dst, const void *src, size_t n);
+void *memset(void *dst, int c, size_t n);
+int memcmp(const void *a, const void *b, size_t n);
+size_t strlen(const char *s);
+
+// Ends the program: QEMU exits with status, see crt0.s
+void _exit(int status) __attribute__((noreturn));
+// The old end of the heap, moved by increment; (void *)-1 when full
+void *sbrk(ptrdiff_t increment);
+
+#endif
@@ -0,0 +1,40 @@
+# void *sbrk(ptrdiff_t increment)
+#
+# Hands out virt.ld's heap (__heap_start to __heap_end) from the bottom
+# up: returns the old end of the used part and moves it by increment,
+# or returns (void *)-1 and changes nothing if that would leave the heap.
+# A negative increment gives memory back. This is the whole allocator a
+# malloc needs underneath it.
+
+# Register Roles
+# a0 - increment, then the result
+# a1 - address of heap_used
+# a2 - current end of the used heap
+# a3 - the new end
+
+.section .sdata.sbrk
+heap_used:
+    .word __heap_start
+
+.section .text.sbrk
+.global sbrk
+.type sbrk, @function
+
+sbrk:
+    la a1, heap_used
+    lw a2, 0(a1)
+    add a3, a2, a0
+    la t0, __heap_start
+    la t1, __heap_end
+    bltu a3, t0, sbrk_fail
+    bltu t1, a3, sbrk_fail
+    # an increment big enough to wrap a3 around lands it outside the heap
+    # too, so these two compares cover every case
+    sw a3, 0(a1)
+    mv a0, a2
+    ret
+sbrk_fail:
+    li a0, -1
+    ret
+
+.size sbrk, . - sbrk
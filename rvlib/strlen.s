@@ -0,0 +1,59 @@
+# size_t strlen(const char *s)
+#
+# Checks bytes up to s's first word boundary (the unaligned head), then a
+# whole word per pass: (w - 0x01010101) & ~w & 0x80808080 is nonzero
+# exactly when some byte of w is zero. The word holding the terminator is
+# then searched a byte at a time from its low (first) byte.
+#
+# Reading the rest of that last word past the terminator is safe: an
+# aligned word never straddles a page or the end of RAM.
+#
+# 7 instructions per 4 bytes against 16 for a byte loop.
+
+# Register Roles
+# a0 - s
+# a1 - next byte to check
+# a2 - 0x01010101
+# a3 - 0x80808080
+# t0 - the word (or byte) being checked
+# t1, t2 - scratch
+
+.section .text.strlen
+.global strlen
+.type strlen, @function
+
+strlen:
+    mv a1, a0
+strlen_head:
+    andi t1, a1, 3
+    beqz t1, strlen_aligned
+    lbu t0, 0(a1)
+    beqz t0, strlen_done
+    addi a1, a1, 1
+    j strlen_head
+
+strlen_aligned:
+    li a2, 0x01010101
+    slli a3, a2, 7          # 0x80808080
+strlen_word:
+    lw t0, 0(a1)
+    addi a1, a1, 4
+    sub t1, t0, a2
+    not t2, t0
+    and t1, t1, t2
+    and t1, t1, a3
+    beqz t1, strlen_word
+
+    addi a1, a1, -4         # back to the word with the zero in it
+strlen_find:
+    andi t1, t0, 0xff
+    beqz t1, strlen_done
+    srli t0, t0, 8
+    addi a1, a1, 1
+    j strlen_find
+
+strlen_done:
+    sub a0, a1, a0
+    ret
+
+.size strlen, . - strlen
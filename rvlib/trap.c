@@ -0,0 +1,65 @@
+/*
+ * trap.c - Interrupt dispatch and the PLIC (see trap.h)
+ */
+
+#include "trap.h"
+#include "rvlib.h"
+#include "uart.h"
+
+// The virt board's PLIC; context 0 is hart 0 in machine mode
+#define PLIC_BASE 0x0C000000u
+#define PLIC_PRIORITY(irq) ((volatile uint32_t *)(uintptr_t)(PLIC_BASE + 4 * (irq)))
+#define PLIC_ENABLE(irq) ((volatile uint32_t *)(uintptr_t)(PLIC_BASE + 0x2000 + 4 * ((irq) / 32)))
+#define PLIC_THRESHOLD ((volatile uint32_t *)(uintptr_t)(PLIC_BASE + 0x200000))
+#define PLIC_CLAIM ((volatile uint32_t *)(uintptr_t)(PLIC_BASE + 0x200004))
+
+#define MCAUSE_INTERRUPT 0x80000000u
+
+void trap_entry(void);
+void trap_dispatch(uint32_t mcause);
+
+static trap_handler interrupt_handlers[16];
+static trap_handler irq_handlers[PLIC_SOURCES];
+
+void trap_init(void) {
+    __asm__ volatile("csrw mtvec, %0" ::"r"(trap_entry));
+}
+
+void trap_on_interrupt(unsigned cause, trap_handler handler) {
+    if (cause >= 16)
+        return;
+    interrupt_handlers[cause] = handler;
+    __asm__ volatile("csrs mie, %0" ::"r"(1u << cause));
+}
+
+// Every claimed source goes to its handler, then back to the PLIC
+static void plic_dispatch(void) {
+    uint32_t irq;
+    while ((irq = *PLIC_CLAIM) != 0) {
+        if (irq < PLIC_SOURCES && irq_handlers[irq] != 0)
+            irq_handlers[irq]();
+        *PLIC_CLAIM = irq;
+    }
+}
+
+void plic_on_irq(unsigned irq, trap_handler handler) {
+    if (irq == 0 || irq >= PLIC_SOURCES)
+        return;
+    irq_handlers[irq] = handler;
+    *PLIC_PRIORITY(irq) = 1;
+    *PLIC_ENABLE(irq) |= 1u << (irq % 32);
+    *PLIC_THRESHOLD = 0;
+    trap_on_interrupt(TRAP_EXTERNAL, plic_dispatch);
+}
+
+void trap_dispatch(uint32_t mcause) {
+    if ((mcause & MCAUSE_INTERRUPT) == 0) {
+        uart_flush();           // what the program printed before it went wrong
+        _exit(TRAP_EXIT_EXCEPTION + (int)mcause);
+    }
+    uint32_t cause = mcause & ~MCAUSE_INTERRUPT;
+    if (cause < 16 && interrupt_handlers[cause] != 0)
+        interrupt_handlers[cause]();
+    else
+        __asm__ volatile("csrc mie, %0" ::"r"(1u << (cause & 31)));  // nobody wants it
+}
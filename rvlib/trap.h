@@ -0,0 +1,55 @@
+/*
+ * trap.h - Machine-mode interrupts on the virt board
+ *
+ * trap_init points mtvec at trap_entry (trap_entry.s), which saves the
+ * caller-saved registers and calls trap_dispatch. From there:
+ *
+ *  - an interrupt goes to the handler registered for its cause with
+ *    trap_on_interrupt (the CLINT timer is cause 7)
+ *  - an external interrupt is claimed from the PLIC and goes to the
+ *    handler registered for that source with plic_on_irq (UART0 is 10)
+ *  - an exception flushes the UART and ends the program with
+ *    _exit(TRAP_EXIT_EXCEPTION + mcause): there is nothing to return to
+ *
+ * Handlers run with interrupts off and must not wait on anything another
+ * interrupt would deliver.
+ */
+
+#ifndef TRAP_H
+#define TRAP_H
+
+#include <stdint.h>
+
+#define TRAP_TIMER 7            // machine timer interrupt
+#define TRAP_EXTERNAL 11        // machine external interrupt (the PLIC)
+#define TRAP_EXIT_EXCEPTION 0x100
+
+#define PLIC_UART0 10           // the virt board's PLIC source for UART0
+#define PLIC_SOURCES 96
+
+typedef void (*trap_handler)(void);
+
+// Install trap_entry in mtvec; interrupts stay off until interrupts_on
+void trap_init(void);
+// Run handler for interrupt cause (0-15) and enable it in mie
+void trap_on_interrupt(unsigned cause, trap_handler handler);
+// Run handler for PLIC source irq (1 to PLIC_SOURCES - 1) and enable it for
+// hart 0's machine mode
+void plic_on_irq(unsigned irq, trap_handler handler);
+
+// mstatus.MIE: interrupts_off returns whether they were on, for
+// interrupts_restore
+static inline void interrupts_on(void) { __asm__ volatile("csrsi mstatus, 8" ::: "memory"); }
+
+static inline int interrupts_off(void) {
+    uint32_t mstatus;
+    __asm__ volatile("csrrci %0, mstatus, 8" : "=r"(mstatus)::"memory");
+    return (mstatus & 8) != 0;
+}
+
+static inline void interrupts_restore(int were_on) {
+    if (were_on)
+        interrupts_on();
+}
+
+#endif
@@ -0,0 +1,57 @@
+# trap_entry: where mtvec points (see trap.h)
+#
+# A trap can land between any two instructions, so everything C may
+# clobber has to survive it: ra, t0-t6 and a0-a7, 16 words. s0-s11 are
+# the C handler's to save, and C code hands gp, tp and sp back unchanged.
+# The frame is 64 bytes, which keeps sp 16-byte aligned.
+#
+# Then trap_dispatch(mcause) and mret back to mepc. Exceptions never
+# come back, so nothing here needs to step mepc past the instruction.
+
+.section .text.trap_entry
+.global trap_entry
+.type trap_entry, @function
+.balign 4                   # mtvec's low two bits are the mode
+
+trap_entry:
+    addi sp, sp, -64
+    sw ra, 0(sp)
+    sw t0, 4(sp)
+    sw t1, 8(sp)
+    sw t2, 12(sp)
+    sw t3, 16(sp)
+    sw t4, 20(sp)
+    sw t5, 24(sp)
+    sw t6, 28(sp)
+    sw a0, 32(sp)
+    sw a1, 36(sp)
+    sw a2, 40(sp)
+    sw a3, 44(sp)
+    sw a4, 48(sp)
+    sw a5, 52(sp)
+    sw a6, 56(sp)
+    sw a7, 60(sp)
+
+    csrr a0, mcause
+    call trap_dispatch
+
+    lw ra, 0(sp)
+    lw t0, 4(sp)
+    lw t1, 8(sp)
+    lw t2, 12(sp)
+    lw t3, 16(sp)
+    lw t4, 20(sp)
+    lw t5, 24(sp)
+    lw t6, 28(sp)
+    lw a0, 32(sp)
+    lw a1, 36(sp)
+    lw a2, 40(sp)
+    lw a3, 44(sp)
+    lw a4, 48(sp)
+    lw a5, 52(sp)
+    lw a6, 56(sp)
+    lw a7, 60(sp)
+    addi sp, sp, 64
+    mret
+
+.size trap_entry, . - trap_entry
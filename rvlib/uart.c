@@ -0,0 +1,124 @@
+/*
+ * uart.c - Interrupt-driven NS16550 output (see uart.h)
+ *
+ * The ring has one producer (uart_write) and one consumer (the interrupt
+ * handler, or whoever drains with interrupts off). Only the producer moves
+ * head and only the consumer moves tail, and the handler runs between two
+ * of the producer's instructions, never in the middle of one, so neither
+ * needs a lock. After queueing, uart_write sets IER's THR-empty enable; if
+ * the UART is idle that raises the interrupt at once. The handler clears
+ * it again when the ring runs dry.
+ */
+
+#include <stdint.h>
+
+#include "trap.h"
+#include "uart.h"
+
+#if UART_TX_BUFFER & (UART_TX_BUFFER - 1)
+#error "UART_TX_BUFFER must be a power of two"
+#endif
+
+#define UART_BASE ((volatile uint8_t *)0x10000000)
+#define UART_THR UART_BASE[0]   // write: transmit holding register
+#define UART_DLL UART_BASE[0]   // with LCR.DLAB: divisor, low byte
+#define UART_IER UART_BASE[1]
+#define UART_DLM UART_BASE[1]   // with LCR.DLAB: divisor, high byte
+#define UART_IIR UART_BASE[2]   // read
+#define UART_FCR UART_BASE[2]   // write
+#define UART_LCR UART_BASE[3]
+#define UART_MCR UART_BASE[4]
+#define UART_LSR UART_BASE[5]
+
+#define IER_THRE 0x02           // interrupt when the TX FIFO is empty
+#define FCR_ENABLE_CLEAR 0x07   // FIFOs on, both cleared
+#define LCR_8N1 0x03
+#define LCR_DLAB 0x80
+#define MCR_OUT2 0x08           // gates the IRQ line on PC-style boards
+#define LSR_THRE 0x20           // TX FIFO empty
+#define LSR_TEMT 0x40           // TX FIFO and shift register empty
+#define UART_FIFO 16
+#define UART_DIVISOR 2          // 3.6864 MHz / (16 * 115200), as QEMU's clock
+
+// volatile, so a byte is in the ring before head says it is
+static volatile char ring[UART_TX_BUFFER];
+static volatile uint32_t head, tail;    // free-running; head - tail bytes queued
+static int started;
+
+// Up to one FIFO-load from the ring, once the FIFO is empty. Consumer
+// side: interrupts must be off.
+static void drain(void) {
+    if ((UART_LSR & LSR_THRE) == 0)
+        return;
+    uint32_t t = tail;
+    for (int n = 0; n < UART_FIFO && t != head; n++, t++)
+        UART_THR = (uint8_t)ring[t % UART_TX_BUFFER];
+    tail = t;
+}
+
+static void uart_interrupt(void) {
+    (void)UART_IIR;             // acknowledges a THR-empty interrupt
+    drain();
+    if (tail == head)
+        UART_IER = 0;
+}
+
+void uart_init(void) {
+    UART_IER = 0;
+    UART_LCR = LCR_DLAB;
+    UART_DLL = UART_DIVISOR & 0xFF;
+    UART_DLM = UART_DIVISOR >> 8;
+    UART_LCR = LCR_8N1;
+    UART_FCR = FCR_ENABLE_CLEAR;
+    UART_MCR = MCR_OUT2;
+    trap_init();
+    plic_on_irq(PLIC_UART0, uart_interrupt);
+    started = 1;
+    interrupts_on();
+    if (tail != head)
+        UART_IER = IER_THRE;    // whatever was queued before
+}
+
+void uart_write(const char *bytes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        while (head - tail == UART_TX_BUFFER) {     // full: make room
+            int were_on = interrupts_off();
+            drain();
+            interrupts_restore(were_on);
+        }
+        ring[head % UART_TX_BUFFER] = bytes[i];
+        head = head + 1;
+    }
+    int were_on = interrupts_off();
+    if (started && were_on)
+        UART_IER = IER_THRE;
+    else
+        while (tail != head)    // nobody will take an interrupt: poll
+            drain();
+    interrupts_restore(were_on);
+}
+
+void uart_flush(void) {
+    while (tail != head) {
+        int were_on = interrupts_off();
+        drain();
+        interrupts_restore(were_on);
+    }
+    while ((UART_LSR & LSR_TEMT) == 0)
+        ;
+}
+
+int putchar(int c) {
+    char byte = (char)c;
+    uart_write(&byte, 1);
+    return (uint8_t)c;
+}
+
+int puts(const char *s) {
+    size_t n = 0;
+    while (s[n] != '\0')
+        n++;
+    uart_write(s, n);
+    uart_write("\n", 1);
+    return 0;
+}
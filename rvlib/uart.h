@@ -0,0 +1,50 @@
+/*
+ * uart.h - Console output on the virt board's NS16550 UART, and printf
+ *
+ * Writing only copies bytes into a TX ring buffer in RAM. The UART's
+ * "transmit holding register empty" interrupt, routed through the PLIC,
+ * moves them into its 16-byte FIFO a FIFO-load at a time, so a program
+ * that logs goes straight back to work instead of polling LSR for every
+ * character. Only when the ring is full does a write wait, draining the
+ * oldest bytes itself: output is never dropped.
+ *
+ * Before uart_init, with interrupts off, or inside a handler, writes are
+ * drained by polling, so printf works anywhere.
+ *
+ * The ring holds UART_TX_BUFFER bytes (a power of two, default 1024;
+ * build rvlib with -DUART_TX_BUFFER=4096 for more).
+ *
+ * printf, snprintf and vsnprintf format without any allocation or
+ * libgcc: %d %i %u %x %X %o %c %s %p and %%, the flags - 0 + and space,
+ * a width and precision (either may be *), and the l, ll, h, hh and z
+ * sizes. There is no floating point. printf's output goes through the
+ * ring; puts and putchar are there too, since gcc turns some printf calls
+ * into them.
+ */
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#ifndef UART_TX_BUFFER
+#define UART_TX_BUFFER 1024
+#endif
+
+// 8N1 with FIFOs, the PLIC route and the trap vector; turns interrupts on
+void uart_init(void);
+void uart_write(const char *bytes, size_t n);
+// Wait until every byte written so far has left the UART, e.g. before
+// _exit or before timing something the interrupts would disturb
+void uart_flush(void);
+
+int printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+int vprintf(const char *format, va_list args);
+int snprintf(char *buffer, size_t size, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+int vsnprintf(char *buffer, size_t size, const char *format, va_list args);
+int puts(const char *s);
+int putchar(int c);
+
+#endif
@@ -0,0 +1,1388 @@
+/*
+ * bench_sim.c - Check the rv32i simulator and measure its speed
+ *
+ * There is no RISC-V toolchain needed: the programs are assembled here
+ * with a few encoders and written out as small ELF files, which then go
+ * through the same loader as `make machinecode`'s main.elf.
+ *
+ * 1. One-instruction checks of every rv32i operation against C.
+ * 2. m.s as written (s2 = 10 after 17 instructions, then off the end),
+ *    array_ops.s as written (my_array = {1, 1, 1}, stops at `done`), and
+ *    a program that prints on UART0 and exits through sifive_test, and
+ *    one that takes the CLINT timer interrupt every 100 instructions.
+ *    1 and 2 run on each engine: decoding every fetch, the block cache,
+ *    and the block cache with x86-64 translation after DBT_THRESHOLD
+ *    entries (on x86-64 hosts).
+ * 3. Random programs, including stores into their own code, and a loop
+ *    that patches itself: the block cache and the translated code must
+ *    end every run (and every run cut short by an instruction limit) in
+ *    exactly the state, with the same counters and cycles, as decoding
+ *    every fetch.
+ * 4. The vector subset op by op against C, and array_ops.s next to its
+ *    unrolled and RVV versions (array_ops_unrolled.s, array_ops_rvv.s):
+ *    all three must add 1 to every element and nothing else, in the
+ *    expected number of instructions, and their instructions and cycles
+ *    per element are printed.
+ * 5. The disassembler (disasm.h): known words print as expected, and
+ *    every word it can name assembles back to itself. The static loop
+ *    costs (cfg.h) for m.s, array_ops.s and both loops of the unrolled
+ *    version: what one more iteration costs when run. rvprof.exe on
+ *    recorded ../rvlib/profile.s reports, one for each way a run ends.
+ *    And ../main.elf and the three array_ops ELFs as the toolchain built
+ *    them, where they have been built (make check in ../array_ops).
+ * 6. Both programs scaled up, with the loop counts and array size as
+ *    large as BENCH_*, for the MIPS figures of each engine, and the
+ *    disassembler's speed.
+ *
+ * Build and run with: make bench
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "block.h"
+#include "cfg.h"
+#include "dbt.h"
+#include "devices.h"
+#include "disasm.h"
+#include "elf32.h"
+#include "sim.h"
+
+#define BENCH_ADD_LOOPS 50000000u       // _add_two_five_times iterations
+#define BENCH_ARRAY_WORDS (4u << 20)    // array_ops elements
+#define BENCH_RAM (32u << 20)
+#define RANDOM_PROGRAMS 3000
+#define RANDOM_LENGTH 96
+#define DBT_THRESHOLD 2                 // low, so short programs get translated
+#define DISASM_WORDS 1000000u
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int failures = 0;
+
+enum engine { DECODE, BLOCKS, DBT, PROFILED };
+static const char *const engine_names[] = {"decoding every fetch", "block cache",
+                                           "x86-64 translation", "profiled"};
+static enum engine engine = DECODE;     // which engine the checks run on
+static enum engine last_engine = DBT;   // BLOCKS where there is no translation
+static unsigned dbt_threshold = DBT_THRESHOLD;
+
+static void report(const char *what, int ok) {
+    printf("%s %s\n", ok ? "✅" : "❌", what);
+    failures += !ok;
+}
+
+// --- encoders ---------------------------------------------------------
+
+enum { ZERO = 0, RA = 1, MEM = 4, T0 = 5, T1 = 6, T2 = 7, S1 = 9, A0 = 10, A1 = 11, A2 = 12,
+       A3 = 13, S2 = 18, S3 = 19, T3 = 28 };
+
+static uint32_t r_type(uint32_t f7, uint32_t rs2, uint32_t rs1, uint32_t f3, uint32_t rd,
+                       uint32_t op) {
+    return f7 << 25 | rs2 << 20 | rs1 << 15 | f3 << 12 | rd << 7 | op;
+}
+
+static uint32_t i_type(int32_t imm, uint32_t rs1, uint32_t f3, uint32_t rd, uint32_t op) {
+    return (uint32_t)imm << 20 | rs1 << 15 | f3 << 12 | rd << 7 | op;
+}
+
+static uint32_t s_type(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t f3) {
+    uint32_t u = (uint32_t)imm;
+    return (u >> 5 & 0x7F) << 25 | rs2 << 20 | rs1 << 15 | f3 << 12 | (u & 0x1F) << 7 | 0x23;
+}
+
+static uint32_t b_type(int32_t offset, uint32_t rs2, uint32_t rs1, uint32_t f3) {
+    uint32_t u = (uint32_t)offset;
+    return (u >> 12 & 1) << 31 | (u >> 5 & 0x3F) << 25 | rs2 << 20 | rs1 << 15 | f3 << 12 |
+           (u >> 1 & 0xF) << 8 | (u >> 11 & 1) << 7 | 0x63;
+}
+
+static uint32_t jal(uint32_t rd, int32_t offset) {
+    uint32_t u = (uint32_t)offset;
+    return (u >> 20 & 1) << 31 | (u >> 1 & 0x3FF) << 21 | (u >> 11 & 1) << 20 |
+           (u >> 12 & 0xFF) << 12 | rd << 7 | 0x6F;
+}
+
+static uint32_t addi(uint32_t rd, uint32_t rs1, int32_t imm) { return i_type(imm, rs1, 0, rd, 0x13); }
+static uint32_t lui(uint32_t rd, uint32_t value) { return (value & 0xFFFFF000u) | rd << 7 | 0x37; }
+static uint32_t auipc(uint32_t rd, uint32_t value) { return (value & 0xFFFFF000u) | rd << 7 | 0x17; }
+
+static uint32_t csrrw(uint32_t rd, uint32_t csr, uint32_t rs1) {
+    return csr << 20 | rs1 << 15 | 1 << 12 | rd << 7 | 0x73;
+}
+static uint32_t csrrs(uint32_t rd, uint32_t csr, uint32_t rs1) {
+    return csr << 20 | rs1 << 15 | 2 << 12 | rd << 7 | 0x73;
+}
+static uint32_t csrrsi(uint32_t rd, uint32_t csr, uint32_t bits) {
+    return csr << 20 | bits << 15 | 6 << 12 | rd << 7 | 0x73;
+}
+
+#define CSR_MSTATUS 0x300
+#define CSR_MIE 0x304
+#define CSR_MTVEC 0x305
+#define CSR_MEPC 0x341
+#define CSR_MCAUSE 0x342
+#define CSR_INSTRET 0xC02
+
+// RVV: vsetvli, unit-stride vle/vse (width field 0, 5 or 6 for 8, 16 or
+// 32 bits) and unmasked OP-V arithmetic (funct3 0 .vv, 3 .vi, 4 .vx)
+static uint32_t vsetvli(uint32_t rd, uint32_t rs1, uint32_t vtype) {
+    return (vtype & 0x7FF) << 20 | rs1 << 15 | 7 << 12 | rd << 7 | 0x57;
+}
+static uint32_t vload(uint32_t width, uint32_t vd, uint32_t rs1) {
+    return 1u << 25 | rs1 << 15 | width << 12 | vd << 7 | 0x07;
+}
+static uint32_t vstore(uint32_t width, uint32_t vs3, uint32_t rs1) {
+    return 1u << 25 | rs1 << 15 | width << 12 | vs3 << 7 | 0x27;
+}
+static uint32_t vop(uint32_t f6, uint32_t f3, uint32_t vd, uint32_t vs2, uint32_t vs1) {
+    return f6 << 26 | 1u << 25 | vs2 << 20 | (vs1 & 0x1F) << 15 | f3 << 12 | vd << 7 | 0x57;
+}
+
+#define VTYPE_E32_M4 0xD2       // e32, m4, ta, ma
+
+// li as lui + addi, the way the assembler expands it (always two words)
+static void li(uint32_t *code, size_t *n, uint32_t rd, uint32_t value) {
+    uint32_t low = value & 0xFFF, high = value + (low >= 0x800 ? 0x1000 : 0);
+    code[(*n)++] = lui(rd, high);
+    code[(*n)++] = addi(rd, rd, (int32_t)(low << 20) >> 20);
+}
+
+// --- a minimal ELF writer ---------------------------------------------
+
+typedef struct {
+    const char *name;
+    uint32_t address;
+} label;
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+
+static void put32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> 8 * i);
+}
+
+// One PT_LOAD of image at RV_RAM_BASE, plus .symtab/.strtab with labels
+static int write_elf(const char *path, const void *image, uint32_t size, const label *labels,
+                     size_t count) {
+    uint32_t strtab_size = 1;
+    for (size_t i = 0; i < count; i++)
+        strtab_size += (uint32_t)strlen(labels[i].name) + 1;
+    static const char shstrtab[] = "\0.text\0.symtab\0.strtab\0.shstrtab";
+    uint32_t image_at = 52 + 32, symtab_at = image_at + size;
+    uint32_t symtab_size = (uint32_t)(count + 1) * 16;
+    uint32_t strtab_at = symtab_at + symtab_size, shstrtab_at = strtab_at + strtab_size;
+    uint32_t sections_at = (shstrtab_at + (uint32_t)sizeof(shstrtab) + 3) & ~3u;
+    uint32_t total = sections_at + 5 * 40;
+    uint8_t *file = calloc(total, 1);
+    if (file == NULL)
+        return 0;
+
+    memcpy(file, "\177ELF\1\1\1", 7);
+    put16(file + 16, 2);                // ET_EXEC
+    put16(file + 18, 243);              // EM_RISCV
+    put32(file + 20, 1);
+    put32(file + 24, RV_RAM_BASE);
+    put32(file + 28, 52);
+    put32(file + 32, sections_at);
+    put16(file + 40, 52);
+    put16(file + 42, 32);
+    put16(file + 44, 1);
+    put16(file + 46, 40);
+    put16(file + 48, 5);
+    put16(file + 50, 4);
+
+    uint8_t *ph = file + 52;
+    put32(ph, 1);                       // PT_LOAD
+    put32(ph + 4, image_at);
+    put32(ph + 8, RV_RAM_BASE);
+    put32(ph + 12, RV_RAM_BASE);
+    put32(ph + 16, size);
+    put32(ph + 20, size);
+    put32(ph + 24, 7);
+    memcpy(file + image_at, image, size);
+
+    uint32_t name = 1;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *sym = file + symtab_at + (i + 1) * 16;
+        put32(sym, name);
+        put32(sym + 4, labels[i].address);
+        put16(sym + 14, 1);             // .text
+        strcpy((char *)file + strtab_at + name, labels[i].name);
+        name += (uint32_t)strlen(labels[i].name) + 1;
+    }
+    memcpy(file + shstrtab_at, shstrtab, sizeof(shstrtab));
+
+    uint8_t *sh = file + sections_at;
+    // 1: .text
+    put32(sh + 40, 1);
+    put32(sh + 44, 1);
+    put32(sh + 48, 7);
+    put32(sh + 52, RV_RAM_BASE);
+    put32(sh + 56, image_at);
+    put32(sh + 60, size);
+    // 2: .symtab, linked to 3
+    put32(sh + 80, 7);
+    put32(sh + 84, 2);
+    put32(sh + 96, symtab_at);
+    put32(sh + 100, symtab_size);
+    put32(sh + 104, 3);
+    put32(sh + 108, 1);
+    put32(sh + 116, 16);
+    // 3: .strtab, 4: .shstrtab
+    put32(sh + 120, 15);
+    put32(sh + 124, 3);
+    put32(sh + 136, strtab_at);
+    put32(sh + 140, strtab_size);
+    put32(sh + 160, 23);
+    put32(sh + 164, 3);
+    put32(sh + 176, shstrtab_at);
+    put32(sh + 180, (uint32_t)sizeof(shstrtab));
+
+    FILE *f = fopen(path, "wb");
+    int ok = f != NULL && fwrite(file, 1, total, f) == total;
+    if (f != NULL && fclose(f) != 0)
+        ok = 0;
+    free(file);
+    return ok;
+}
+
+// --- the two sandbox programs -----------------------------------------
+
+// m.s with s3 = loops. loops < 2048 uses a single addi like the original
+// (so loops = 5 is m.s exactly, which falls off its end); bigger counts
+// need lui + addi and end in `j .` instead.
+static size_t build_add_two(uint32_t *code, uint32_t loops, label *labels) {
+    size_t n = 0;
+    code[n++] = addi(S1, ZERO, 2);
+    if (loops < 2048)
+        code[n++] = addi(S3, ZERO, (int32_t)loops);
+    else
+        li(code, &n, S3, loops);
+    uint32_t loop = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = r_type(0, S2, S1, 0, S2, 0x33);     // add s2, s1, s2
+    code[n++] = addi(S3, S3, -1);
+    code[n++] = b_type(-8, ZERO, S3, 1);            // bnez s3, _add_two_five_times
+    if (loops >= 2048)
+        code[n++] = jal(ZERO, 0);
+    labels[0] = (label){"_initialize", RV_RAM_BASE};
+    labels[1] = (label){"_add_two_five_times", loop};
+    return n;
+}
+
+// array_ops.s over words elements, with my_array right after the code the
+// way array_ops.ld places .data
+static size_t build_array_ops(uint32_t *code, uint32_t words, label *labels) {
+    size_t n = 0;
+    const uint32_t code_words = 14;
+    uint32_t array = RV_RAM_BASE + code_words * 4;
+    code[n++] = auipc(1, array - RV_RAM_BASE + 0x800);          // la x1, my_array
+    code[n++] = addi(1, 1, (int32_t)((array - RV_RAM_BASE) << 20) >> 20);
+    code[n++] = addi(2, ZERO, 0);
+    li(code, &n, 3, words);
+    uint32_t loop = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = b_type(32, 3, 2, 0);            // beq x2, x3, done
+    code[n++] = i_type(2, 2, 1, 4, 0x13);       // slli x4, x2, 2
+    code[n++] = r_type(0, 4, 1, 0, 5, 0x33);    // add x5, x1, x4
+    code[n++] = i_type(0, 5, 2, 6, 0x03);       // lw x6, 0(x5)
+    code[n++] = addi(6, 6, 1);
+    code[n++] = s_type(0, 6, 5, 2);             // sw x6, 0(x5)
+    code[n++] = addi(2, 2, 1);
+    code[n++] = jal(ZERO, -28);                 // j loop
+    uint32_t done = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = jal(ZERO, 0);                   // done: j done
+    labels[0] = (label){"_start", RV_RAM_BASE};
+    labels[1] = (label){"loop", loop};
+    labels[2] = (label){"done", done};
+    labels[3] = (label){"my_array", array};
+    if (n != code_words)
+        abort();
+    return n;
+}
+
+// array_ops_unrolled.s over words elements: four at a time through a
+// moving pointer, then the 0-3 left one at a time
+static size_t build_array_unrolled(uint32_t *code, uint32_t words, label *labels) {
+    size_t n = 0;
+    const uint32_t code_words = 31;
+    uint32_t array = RV_RAM_BASE + code_words * 4;
+    code[n++] = auipc(A0, array - RV_RAM_BASE + 0x800);        // la a0, my_array
+    code[n++] = addi(A0, A0, (int32_t)((array - RV_RAM_BASE) << 20) >> 20);
+    li(code, &n, A1, words);
+    code[n++] = i_type(2, A1, 1, T0, 0x13);     // slli t0, a1, 2
+    code[n++] = r_type(0, T0, A0, 0, A2, 0x33); // add a2, a0, t0
+    code[n++] = i_type(-4, A1, 7, T0, 0x13);    // andi t0, a1, -4
+    code[n++] = i_type(2, T0, 1, T0, 0x13);     // slli t0, t0, 2
+    code[n++] = r_type(0, T0, A0, 0, A3, 0x33); // add a3, a0, t0
+    code[n++] = b_type(60, A3, A0, 0);          // beq a0, a3, tail
+    uint32_t by_four = RV_RAM_BASE + (uint32_t)n * 4;
+    const uint32_t t[4] = {T0, T1, T2, T3};
+    for (int i = 0; i < 4; i++)
+        code[n++] = i_type(4 * i, A0, 2, t[i], 0x03);         // lw t<i>, 4i(a0)
+    for (int i = 0; i < 4; i++)
+        code[n++] = addi(t[i], t[i], 1);
+    for (int i = 0; i < 4; i++)
+        code[n++] = s_type(4 * i, t[i], A0, 2);               // sw t<i>, 4i(a0)
+    code[n++] = addi(A0, A0, 16);
+    code[n++] = b_type(-52, A3, A0, 1);         // bne a0, a3, by_four
+    code[n++] = b_type(24, A2, A0, 0);          // tail: beq a0, a2, done
+    code[n++] = i_type(0, A0, 2, T0, 0x03);     // tail_loop: lw t0, 0(a0)
+    code[n++] = addi(T0, T0, 1);
+    code[n++] = s_type(0, T0, A0, 2);
+    code[n++] = addi(A0, A0, 4);
+    code[n++] = b_type(-16, A2, A0, 1);         // bne a0, a2, tail_loop
+    uint32_t done = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = jal(ZERO, 0);
+    labels[0] = (label){"_start", RV_RAM_BASE};
+    labels[1] = (label){"by_four", by_four};
+    labels[2] = (label){"done", done};
+    labels[3] = (label){"my_array", array};
+    if (n != code_words)
+        abort();
+    return n;
+}
+
+// array_ops_rvv.s over words elements: vsetvli strip-mining, LMUL = 4
+static size_t build_array_rvv(uint32_t *code, uint32_t words, label *labels) {
+    size_t n = 0;
+    const uint32_t code_words = 15;
+    uint32_t array = RV_RAM_BASE + code_words * 4;
+    code[n++] = addi(T0, ZERO, 0x200);
+    code[n++] = csrrs(ZERO, 0x300, T0);         // csrs mstatus, t0
+    uint32_t la = array - (RV_RAM_BASE + (uint32_t)n * 4);       // la a0, my_array
+    code[n++] = auipc(A0, la + 0x800);
+    code[n++] = addi(A0, A0, (int32_t)(la << 20) >> 20);
+    li(code, &n, A1, words);
+    uint32_t loop = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = vsetvli(T0, A1, VTYPE_E32_M4);
+    code[n++] = vload(6, 0, A0);                // vle32.v v0, (a0)
+    code[n++] = vop(0x00, 3, 0, 0, 1);          // vadd.vi v0, v0, 1
+    code[n++] = vstore(6, 0, A0);               // vse32.v v0, (a0)
+    code[n++] = r_type(0x20, T0, A1, 0, A1, 0x33);              // sub a1, a1, t0
+    code[n++] = i_type(2, T0, 1, T1, 0x13);     // slli t1, t0, 2
+    code[n++] = r_type(0, T1, A0, 0, A0, 0x33); // add a0, a0, t1
+    code[n++] = b_type(-28, ZERO, A1, 1);       // bnez a1, loop
+    uint32_t done = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = jal(ZERO, 0);
+    labels[0] = (label){"_start", RV_RAM_BASE};
+    labels[1] = (label){"loop", loop};
+    labels[2] = (label){"done", done};
+    labels[3] = (label){"my_array", array};
+    if (n != code_words)
+        abort();
+    return n;
+}
+
+// --- checks -----------------------------------------------------------
+
+static void start_cpu(rv_cpu *cpu, uint32_t ram) {
+    if (!rv_cpu_init(cpu, RV_RAM_BASE, ram) ||
+        ((engine == BLOCKS || engine == DBT) && !rv_cpu_enable_blocks(cpu)) ||
+        (engine == DBT && !rv_cpu_enable_dbt(cpu, dbt_threshold))) {
+        printf("out of memory\n");
+        exit(1);
+    }
+}
+
+// Run code (ending in ebreak) with x1 = a, x2 = b and return x3
+static uint32_t run_one(const uint32_t *code, size_t n, uint32_t a, uint32_t b) {
+    rv_cpu cpu;
+    start_cpu(&cpu, 4096);
+    rv_cpu_write(&cpu, RV_RAM_BASE, code, n * 4);
+    cpu.x[1] = a;
+    cpu.x[2] = b;
+    cpu.x[MEM] = RV_RAM_BASE + 2048;
+    enum rv_stop stop = rv_run(&cpu, 100, 0);
+    uint32_t result = stop == RV_STOP_EBREAK ? cpu.x[3] : 0xDEADBEEF;
+    rv_cpu_free(&cpu);
+    return result;
+}
+
+static uint32_t reference_op(int kind, uint32_t a, uint32_t b, int32_t imm) {
+    switch (kind) {
+    case 0: return a + b;
+    case 1: return a - b;
+    case 2: return a << (b & 31);
+    case 3: return (int32_t)a < (int32_t)b;
+    case 4: return a < b;
+    case 5: return a ^ b;
+    case 6: return a >> (b & 31);
+    case 7: return (uint32_t)((int32_t)a >> (b & 31));
+    case 8: return a | b;
+    case 9: return a & b;
+    case 10: return a + (uint32_t)imm;
+    case 11: return (int32_t)a < imm;
+    case 12: return a < (uint32_t)imm;
+    case 13: return a ^ (uint32_t)imm;
+    case 14: return a | (uint32_t)imm;
+    case 15: return a & (uint32_t)imm;
+    case 16: return a << (imm & 31);
+    case 17: return a >> (imm & 31);
+    default: return (uint32_t)((int32_t)a >> (imm & 31));
+    }
+}
+
+static uint32_t encode_op(int kind, int32_t imm) {
+    static const uint32_t reg_f3[] = {0, 0, 1, 2, 3, 4, 5, 5, 6, 7};
+    static const uint32_t imm_f3[] = {0, 2, 3, 4, 6, 7, 1, 5, 5};
+    if (kind < 10) {
+        uint32_t f7 = kind == 1 || kind == 7 ? 0x20 : 0;
+        return r_type(f7, 2, 1, reg_f3[kind], 3, 0x33);
+    }
+    if (kind >= 16) {
+        uint32_t shamt = (uint32_t)imm & 31, f7 = kind == 18 ? 0x20 : 0;
+        return r_type(f7, shamt, 1, imm_f3[kind - 10], 3, 0x13);
+    }
+    return i_type(imm, 1, imm_f3[kind - 10], 3, 0x13);
+}
+
+static void check_alu(void) {
+    int ok = 1;
+    for (int i = 0; i < 20000 && ok; i++) {
+        int kind = (int)(next_random() % 19);
+        uint32_t a = (uint32_t)next_random(), b = (uint32_t)next_random();
+        if (i % 4 == 0)
+            b = a;              // equal operands for the compares
+        int32_t imm = (int32_t)(next_random() >> 52) - 2048;
+        uint32_t code[2] = {encode_op(kind, imm), 0x00100073};
+        uint32_t want = reference_op(kind, a, b, kind >= 16 ? (imm & 31) : imm);
+        ok = run_one(code, 2, a, b) == want;
+        if (!ok)
+            printf("   op %d a=0x%08x b=0x%08x imm=%d\n", kind, a, b, imm);
+    }
+    report("ALU register and immediate forms match C", ok);
+}
+
+static void check_memory_and_control(void) {
+    // sw x1, 0(x4); lb/lh/lw/lbu/lhu x3 back
+    static const struct { uint32_t f3; uint32_t want; } loads[] = {
+        {0, 0xFFFFFF80}, {1, 0xFFFF8180}, {2, 0x83828180}, {4, 0x80}, {5, 0x8180},
+    };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        uint32_t code[] = {s_type(0, 1, MEM, 2), i_type(0, MEM, loads[i].f3, 3, 0x03), 0x00100073};
+        ok &= run_one(code, 3, 0x83828180, 0) == loads[i].want;
+    }
+    uint32_t bytes[] = {s_type(1, 1, MEM, 0), s_type(2, 1, MEM, 1), i_type(0, MEM, 2, 3, 0x03),
+                        0x00100073};
+    ok &= run_one(bytes, 4, 0x1234ABCD, 0) == 0xABCDCD00;
+    report("loads sign/zero extend, stores write 1/2/4 bytes", ok);
+
+    // Each branch either skips `addi x3, x0, 1` or not
+    static const struct { uint32_t f3; uint32_t a, b; int taken; } branches[] = {
+        {0, 5, 5, 1}, {0, 5, 6, 0}, {1, 5, 6, 1}, {4, (uint32_t)-1, 0, 1}, {4, 0, (uint32_t)-1, 0},
+        {5, 0, (uint32_t)-1, 1}, {6, 0, (uint32_t)-1, 1}, {7, 0, (uint32_t)-1, 0}, {7, 3, 3, 1},
+    };
+    ok = 1;
+    for (size_t i = 0; i < sizeof(branches) / sizeof(branches[0]); i++) {
+        uint32_t code[] = {b_type(8, 2, 1, branches[i].f3), addi(3, ZERO, 1), 0x00100073};
+        ok &= run_one(code, 3, branches[i].a, branches[i].b) == (uint32_t)!branches[i].taken;
+    }
+    // jal/jalr link, lui/auipc
+    uint32_t calls[] = {jal(RA, 8), 0x00100073, i_type(0, RA, 0, 3, 0x67)};
+    ok &= run_one(calls, 3, 0, 0) == RV_RAM_BASE + 12;
+    uint32_t upper[] = {lui(3, 0xABCDE000), 0x00100073};
+    ok &= run_one(upper, 2, 0, 0) == 0xABCDE000;
+    uint32_t pcrel[] = {addi(0, 0, 0), auipc(3, 0x1000), 0x00100073};
+    ok &= run_one(pcrel, 3, 0, 0) == RV_RAM_BASE + 4 + 0x1000;
+    report("branches, jal/jalr, lui/auipc", ok);
+
+    rv_cpu cpu;
+    start_cpu(&cpu, 4096);
+    uint32_t fault[] = {lui(1, 0x10000000), i_type(0, 1, 2, 3, 0x03)};
+    rv_cpu_write(&cpu, RV_RAM_BASE, fault, sizeof(fault));
+    enum rv_stop stop = rv_run(&cpu, 100, 0);
+    ok = stop == RV_STOP_LOAD_FAULT && cpu.fault_address == 0x10000000 && cpu.instret == 1;
+    uint32_t illegal = 0xFFFFFFFF;
+    rv_cpu_write(&cpu, RV_RAM_BASE, &illegal, 4);
+    cpu.pc = RV_RAM_BASE;
+    ok &= rv_run(&cpu, 100, 0) == RV_STOP_ILLEGAL && cpu.pc == RV_RAM_BASE;
+    rv_cpu_free(&cpu);
+    report("faults and illegal instructions stop at the instruction", ok);
+}
+
+// --- the engines against each other -----------------------------------
+
+// A random instruction for slot i of an n-instruction program. Registers
+// x1-x3 and x5-x8 are scratch; x4 points into the middle of the 4 KiB of
+// RAM, so loads and stores reach both the data and the code below it.
+// Branches and jumps go forward, except for the odd one that goes back.
+static uint32_t random_instruction(size_t i, size_t n) {
+    static const uint32_t scratch[] = {1, 2, 3, 5, 6, 7, 8};
+    uint32_t rd = scratch[next_random() % 7], rs1 = scratch[next_random() % 7];
+    uint32_t rs2 = scratch[next_random() % 7];
+    int32_t imm = (int32_t)(next_random() >> 52) - 2048;
+    int32_t forward = 4 * (int32_t)(1 + next_random() % (n - i));
+    int32_t offset = next_random() % 8 == 0 ? -4 * (int32_t)(next_random() % (i + 1)) : forward;
+    switch (next_random() % 12) {
+    case 0: case 1: case 2:
+        return (encode_op((int)(next_random() % 10), 0) & ~(0x1Fu << 7 | 0x1Fu << 15 | 0x1Fu << 20)) |
+               rd << 7 | rs1 << 15 | rs2 << 20;
+    case 3: case 4: {
+        int kind = 10 + (int)(next_random() % 9);
+        return (encode_op(kind, imm) & ~(0x1Fu << 7 | 0x1Fu << 15)) | rd << 7 | rs1 << 15;
+    }
+    case 5:
+        return next_random() % 2 ? lui(rd, (uint32_t)next_random()) : auipc(rd, (uint32_t)next_random());
+    case 6: case 7: {
+        static const uint32_t loads[] = {0, 1, 2, 4, 5};
+        return i_type(imm, next_random() % 4 ? MEM : rs1, loads[next_random() % 5], rd, 0x03);
+    }
+    case 8:
+        return s_type(imm, rs2, next_random() % 4 ? MEM : rs1, (uint32_t)(next_random() % 3));
+    case 9: case 10: {
+        static const uint32_t conditions[] = {0, 1, 4, 5, 6, 7};
+        return b_type(offset, rs2, rs1, conditions[next_random() % 6]);
+    }
+    default:
+        if (next_random() % 2)
+            return jal(next_random() % 2 ? RA : ZERO, offset);
+        return i_type(0, rs1, 0, rd, 0x67);     // jalr to wherever rs1 points
+    }
+}
+
+static int same_state(const rv_cpu *a, const rv_cpu *b, enum rv_stop stop_a, enum rv_stop stop_b) {
+    return stop_a == stop_b && memcmp(a->x, b->x, sizeof(a->x)) == 0 && a->pc == b->pc &&
+           a->instret == b->instret && a->cycles == b->cycles && a->loads == b->loads &&
+           a->stores == b->stores && a->branches == b->branches &&
+           a->taken_branches == b->taken_branches && a->pending_load == b->pending_load &&
+           (stop_a < RV_STOP_FETCH_FAULT || a->fault_address == b->fault_address) &&
+           memcmp(a->ram, b->ram, a->ram_size) == 0;
+}
+
+static void check_engines_agree(void) {
+    int ok = 1;
+    uint64_t flushes = 0, translations = 0, compiled = 0, chained = 0;
+    for (int p = 0; p < RANDOM_PROGRAMS && ok; p++) {
+        uint32_t code[RANDOM_LENGTH + 1];
+        size_t n = 1 + next_random() % RANDOM_LENGTH;
+        for (size_t i = 0; i < n; i++)
+            code[i] = random_instruction(i, n);
+        code[n] = 0x00100073;   // ebreak
+        rv_cpu cpus[DBT + 1];
+        enum rv_stop stops[DBT + 1];
+        // A whole run (up to 5000 instructions, as loops can run forever),
+        // or a run in random steps. Translating from the first entry on
+        // sends faults and code writes through the translated code too.
+        uint64_t step = p % 2 ? 1 + next_random() % 7 : 5000;
+        dbt_threshold = 1 + p % 3;
+        for (engine = DECODE; engine <= last_engine; engine++) {
+            rv_cpu *cpu = &cpus[engine];
+            start_cpu(cpu, 4096);
+            rv_cpu_write(cpu, RV_RAM_BASE, code, (n + 1) * 4);
+            cpu->x[MEM] = RV_RAM_BASE + 2048;
+            uint64_t run = 0;
+            do {
+                stops[engine] = rv_run(cpu, step, 0);
+                run += step;
+            } while (stops[engine] == RV_STOP_LIMIT && run < 5000);
+        }
+        for (int e = BLOCKS; e <= (int)last_engine && ok; e++) {
+            ok = same_state(&cpus[DECODE], &cpus[e], stops[DECODE], stops[e]);
+            if (!ok)
+                printf("   program %d (%zu instructions): %s after %llu vs %s after %llu (%s)\n",
+                       p, n, rv_stop_name(stops[DECODE]), (unsigned long long)cpus[DECODE].instret,
+                       rv_stop_name(stops[e]), (unsigned long long)cpus[e].instret,
+                       engine_names[e]);
+        }
+        rv_blocks_stats stats = rv_blocks_get_stats(cpus[BLOCKS].blocks);
+        flushes += stats.flushes;
+        translations += stats.translations;
+        if (last_engine == DBT) {
+            stats = rv_blocks_get_stats(cpus[DBT].blocks);
+            compiled += stats.compiled;
+            chained += stats.chained;
+        }
+        for (int e = DECODE; e <= (int)last_engine; e++)
+            rv_cpu_free(&cpus[e]);
+    }
+    engine = DECODE;
+    dbt_threshold = DBT_THRESHOLD;
+    char line[200];
+    snprintf(line, sizeof(line),
+             "%d random programs end in the same state (%llu blocks decoded, %llu flushes)",
+             RANDOM_PROGRAMS, (unsigned long long)translations, (unsigned long long)flushes);
+    report(line, ok && flushes > 0);
+    if (last_engine == DBT) {
+        snprintf(line, sizeof(line), "... and translated (%llu blocks compiled, %llu exits chained)",
+                 (unsigned long long)compiled, (unsigned long long)chained);
+        report(line, ok && compiled > 0 && chained > 0);
+    }
+}
+
+// A loop that rewrites its first instruction, addi s2, s2, 1, to add 2
+// instead once the counter gets to 5: s2 = 5 * 1 + 5 * 2
+static void check_self_modifying(void) {
+    uint32_t code[16];
+    size_t n = 0;
+    code[n++] = addi(5, ZERO, 10);              // counter
+    code[n++] = addi(7, ZERO, 5);
+    li(code, &n, 6, addi(S2, S2, 2));           // the new instruction
+    code[n++] = auipc(8, 0);                    // x8 = address of loop
+    code[n++] = addi(8, 8, 8);
+    code[n++] = addi(S2, S2, 1);                // loop:
+    code[n++] = addi(5, 5, -1);
+    code[n++] = b_type(8, 7, 5, 1);             // bne x5, x7, skip
+    code[n++] = s_type(0, 6, 8, 2);             // sw x6, 0(x8)
+    code[n++] = b_type(-16, ZERO, 5, 1);        // skip: bnez x5, loop
+    code[n++] = 0x00100073;
+    int ok = 1;
+    for (engine = DECODE; engine <= last_engine; engine++) {
+        rv_cpu cpu;
+        start_cpu(&cpu, 4096);
+        rv_cpu_write(&cpu, RV_RAM_BASE, code, n * 4);
+        ok &= rv_run(&cpu, 1000, 0) == RV_STOP_EBREAK && cpu.x[S2] == 15;
+        if (engine != DECODE)
+            ok &= rv_blocks_get_stats(cpu.blocks).flushes == 1;
+        if (engine == DBT)
+            ok &= rv_blocks_get_stats(cpu.blocks).compiled > 0;
+        rv_cpu_free(&cpu);
+    }
+    engine = DECODE;
+    report("a loop that patches itself sees the new instruction", ok);
+}
+
+// --- vectors ----------------------------------------------------------
+
+enum { F6_VADD = 0x00, F6_VSUB = 0x02, F6_VRSUB = 0x03, F6_VAND = 0x09, F6_VOR = 0x0A,
+       F6_VXOR = 0x0B, F6_VMV = 0x17, F6_VSLL = 0x25, F6_VSRL = 0x28, F6_VSRA = 0x29 };
+
+static uint32_t reference_vop(uint32_t f6, uint32_t a, uint32_t b, unsigned bits) {
+    uint32_t mask = bits == 32 ? UINT32_MAX : (1u << bits) - 1, shift = b & (bits - 1);
+    a &= mask;
+    b &= mask;
+    int32_t signed_a = (int32_t)(a << (32 - bits)) >> (32 - bits);
+    switch (f6) {
+    case F6_VADD: return (a + b) & mask;
+    case F6_VSUB: return (a - b) & mask;
+    case F6_VRSUB: return (b - a) & mask;
+    case F6_VAND: return a & b;
+    case F6_VOR: return a | b;
+    case F6_VXOR: return a ^ b;
+    case F6_VSLL: return (a << shift) & mask;
+    case F6_VSRL: return a >> shift;
+    case F6_VSRA: return (uint32_t)(signed_a >> shift) & mask;
+    default: return b;          // vmv.v
+    }
+}
+
+// Every supported op in every form at SEW 8, 16 and 32, with a random vl:
+// vle both inputs, the op, vse the result, then compare with C
+static void check_vector_ops(void) {
+    static const uint32_t ops[] = {F6_VADD, F6_VSUB, F6_VRSUB, F6_VAND, F6_VOR,
+                                   F6_VXOR, F6_VMV,  F6_VSLL,  F6_VSRL, F6_VSRA};
+    int ok = 1;
+    for (unsigned sew = 0; sew < 3; sew++) {
+        unsigned bytes = 1u << sew, bits = 8 * bytes;
+        uint32_t width = sew == 0 ? 0 : sew + 4;             // vle8/16/32 width field
+        for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+            for (uint32_t form = 0; form <= 4; form++) {
+                uint32_t f6 = ops[o];
+                if ((form != 0 && form != 3 && form != 4) || (f6 == F6_VSUB && form == 3) ||
+                    (f6 == F6_VRSUB && form == 0))
+                    continue;
+                uint32_t imm = (uint32_t)(next_random() % 32), scalar = (uint32_t)next_random();
+                uint32_t count = 1 + (uint32_t)(next_random() % (16 / bytes + 2));
+                uint32_t code[10];
+                size_t n = 0;
+                code[n++] = addi(T0, ZERO, 0x200);
+                code[n++] = csrrs(ZERO, 0x300, T0);
+                code[n++] = vsetvli(T0, A1, 0xC0 | sew << 3);
+                code[n++] = vload(width, 8, A2);
+                code[n++] = vload(width, 16, A3);
+                code[n++] = vop(f6, form, 24, f6 == F6_VMV ? 0 : 8, form == 0 ? 16 : form == 3 ? imm : T1);
+                code[n++] = vstore(width, 24, A0);
+                code[n++] = 0x00100073;
+                uint8_t in1[64], in2[64], out[64];
+                for (int i = 0; i < 64; i++) {
+                    in1[i] = (uint8_t)next_random();
+                    in2[i] = (uint8_t)next_random();
+                }
+                rv_cpu cpu;
+                start_cpu(&cpu, 4096);
+                rv_cpu_write(&cpu, RV_RAM_BASE, code, n * 4);
+                rv_cpu_write(&cpu, RV_RAM_BASE + 1024, in1, sizeof(in1));
+                rv_cpu_write(&cpu, RV_RAM_BASE + 1536, in2, sizeof(in2));
+                cpu.x[A0] = RV_RAM_BASE + 2048;
+                cpu.x[A1] = count;
+                cpu.x[A2] = RV_RAM_BASE + 1024;
+                cpu.x[A3] = RV_RAM_BASE + 1536;
+                cpu.x[T1] = scalar;
+                uint32_t vl = count < 16 / bytes ? count : 16 / bytes;
+                ok &= rv_run(&cpu, 100, 0) == RV_STOP_EBREAK && cpu.x[T0] == vl;
+                rv_cpu_read(&cpu, RV_RAM_BASE + 2048, out, sizeof(out));
+                for (uint32_t i = 0; i < 64 / bytes; i++) {
+                    uint32_t a = 0, b = 0, got = 0;
+                    memcpy(&a, in1 + i * bytes, bytes);
+                    memcpy(&b, in2 + i * bytes, bytes);
+                    memcpy(&got, out + i * bytes, bytes);
+                    if (form == 3)
+                        b = f6 == F6_VSLL || f6 == F6_VSRL || f6 == F6_VSRA
+                                ? imm : (uint32_t)((int32_t)(imm << 27) >> 27);
+                    else if (form == 4)
+                        b = scalar;
+                    ok &= got == (i < vl ? reference_vop(f6, a, b, bits) : 0);
+                }
+                rv_cpu_free(&cpu);
+            }
+        }
+    }
+    report("vector add/sub/logic/shift/move at SEW 8, 16, 32 match C, up to vl", ok);
+
+    // The vector unit starts off, and an unsupported vtype (e64) sets vill
+    uint32_t off[2] = {vsetvli(T0, A1, VTYPE_E32_M4), 0x00100073};
+    uint32_t vill[5] = {addi(T0, ZERO, 0x200), csrrs(ZERO, 0x300, T0), vsetvli(T0, A1, 0x18),
+                        vop(F6_VADD, 3, 0, 0, 1), 0x00100073};
+    rv_cpu cpu;
+    start_cpu(&cpu, 4096);
+    rv_cpu_write(&cpu, RV_RAM_BASE, off, sizeof(off));
+    cpu.x[A1] = 5;
+    ok = rv_run(&cpu, 10, 0) == RV_STOP_ILLEGAL && cpu.pc == RV_RAM_BASE;
+    rv_cpu_free(&cpu);
+    start_cpu(&cpu, 4096);
+    rv_cpu_write(&cpu, RV_RAM_BASE, vill, sizeof(vill));
+    cpu.x[A1] = 5;
+    cpu.x[T0] = 1;
+    ok &= rv_run(&cpu, 10, 0) == RV_STOP_ILLEGAL && cpu.pc == RV_RAM_BASE + 12 && cpu.x[T0] == 0;
+    rv_cpu_free(&cpu);
+    report("vector instructions are illegal before mstatus.VS is set, and after vill", ok);
+}
+
+// --- the three array_ops versions --------------------------------------
+
+enum array_version { ORIGINAL, UNROLLED, RVV };
+static const char *const version_names[] = {"array_ops.s", "unrolled", "RVV, m4"};
+
+// Instructions over words elements, to the `j done`
+static uint64_t version_instret(enum array_version version, uint32_t words) {
+    switch (version) {
+    case ORIGINAL: return 5 + 8ull * words + 1;
+    case UNROLLED: return 11 + 14ull * (words / 4) + 5 * (words % 4);
+    default: return 6 + 8ull * (words == 0 ? 1 : (words + 15) / 16);     // 16 words a pass
+    }
+}
+
+// Run one over words elements (left in cpu); 1 if every element ends up 1,
+// the word after the array is untouched, and it stops at done
+static int run_version(enum array_version version, uint32_t words, rv_cpu *cpu) {
+    uint32_t code[32];
+    label labels[4];
+    size_t n = version == ORIGINAL   ? build_array_ops(code, words, labels)
+               : version == UNROLLED ? build_array_unrolled(code, words, labels)
+                                     : build_array_rvv(code, words, labels);
+    uint32_t ram = (uint32_t)n * 4 + 4 * words + 4096;
+    start_cpu(cpu, ram);
+    rv_cpu_write(cpu, RV_RAM_BASE, code, n * 4);
+    uint32_t sentinel = 0xDEADBEEF, after = labels[3].address + 4 * words;
+    rv_cpu_write(cpu, after, &sentinel, 4);
+    enum rv_stop stop = rv_run(cpu, 100ull * words + 1000, 0);
+    int ok = stop == RV_STOP_IDLE_LOOP && cpu->pc == labels[2].address;
+    for (uint32_t i = 0; i < words && ok; i++) {
+        uint32_t value = 0;
+        rv_cpu_read(cpu, labels[3].address + 4 * i, &value, 4);
+        ok = value == 1;
+    }
+    rv_cpu_read(cpu, after, &sentinel, 4);
+    return ok && sentinel == 0xDEADBEEF;
+}
+
+static void check_array_versions(void) {
+    int ok = 1;
+    for (int version = ORIGINAL; version <= RVV; version++) {
+        for (uint32_t words = 0; words <= 41 && ok; words++) {
+            rv_cpu cpu;
+            uint32_t length = words == 41 ? 1000 : words;
+            ok = run_version(version, length, &cpu) &&
+                 cpu.instret == version_instret(version, length);
+            if (!ok)
+                printf("   %s, %u elements: %llu instructions\n", version_names[version], length,
+                       (unsigned long long)cpu.instret);
+            rv_cpu_free(&cpu);
+        }
+    }
+    report("array_ops, unrolled and RVV add 1 to 0-40 and 1000 elements, nothing else", ok);
+}
+
+// Instructions and cycles per element of each version
+static void print_per_element(uint32_t words) {
+    for (int version = ORIGINAL; version <= RVV; version++) {
+        rv_cpu cpu;
+        if (!run_version(version, words, &cpu))
+            report(version_names[version], 0);
+        printf("   %9u %-12s %8.2f %8.2f\n", words, version_names[version],
+               (double)cpu.instret / words, (double)cpu.cycles / words);
+        rv_cpu_free(&cpu);
+    }
+}
+
+// --- programs ----------------------------------------------------------
+
+static int load(rv_cpu *cpu, rv_image *image, const char *path, uint32_t ram) {
+    char error[256];
+    start_cpu(cpu, ram);
+    if (!rv_load_elf(cpu, path, image, error, sizeof(error))) {
+        printf("   %s: %s\n", path, error);
+        rv_cpu_free(cpu);
+        return 0;
+    }
+    return 1;
+}
+
+static void check_programs(const char *add_path, const char *array_path) {
+    uint32_t code[32];
+    label labels[4];
+    size_t n = build_add_two(code, 5, labels);
+    int ok = write_elf(add_path, code, (uint32_t)n * 4, labels, 2);
+    rv_cpu cpu;
+    rv_image image;
+    ok = ok && load(&cpu, &image, add_path, 4096);
+    if (ok) {
+        rv_cpu_enable_profile(&cpu);
+        enum rv_stop stop = rv_run(&cpu, 1000, 0);
+        uint32_t loop_at = 0;
+        ok = stop == RV_STOP_ILLEGAL && cpu.x[S2] == 10 && cpu.instret == 17 &&
+             cpu.pc == RV_RAM_BASE + 20 && cpu.branches == 5 && cpu.taken_branches == 4 &&
+             rv_symbol_find(&image, "_add_two_five_times", &loop_at) &&
+             loop_at == RV_RAM_BASE + 8 && cpu.profile_instret[2] == 5;
+        // 4 taken branches at 2 extra cycles each
+        ok &= cpu.cycles == 17 + 4 * 2;
+        rv_image_free(&image);
+        rv_cpu_free(&cpu);
+    }
+    report("m.s: s2 = 10, then stops at the end of the code", ok);
+
+    n = build_array_ops(code, 3, labels);
+    uint32_t image_words[17];
+    memcpy(image_words, code, n * 4);
+    memset(image_words + n, 0, 3 * 4);
+    ok = write_elf(array_path, image_words, (uint32_t)(n + 3) * 4, labels, 4);
+    ok = ok && load(&cpu, &image, array_path, 4096);
+    if (ok) {
+        enum rv_stop stop = rv_run(&cpu, 1000, 0);
+        uint32_t array[3] = {0};
+        rv_cpu_read(&cpu, labels[3].address, array, sizeof(array));
+        const rv_symbol *at = rv_symbol_at(&image, cpu.pc);
+        ok = stop == RV_STOP_IDLE_LOOP && array[0] == 1 && array[1] == 1 && array[2] == 1 &&
+             at != NULL && strcmp(at->name, "done") == 0 && cpu.instret == 5 + 3 * 8 + 1 &&
+             cpu.loads == 3 && cpu.stores == 3;
+        // each lw is followed by the addi that uses it: one stall per element
+        ok &= cpu.cycles == cpu.instret + 3 * 1 + (3 + 1) * 2;
+        rv_image_free(&image);
+        rv_cpu_free(&cpu);
+    }
+    report("array_ops.s: my_array = {1, 1, 1}, stops at done", ok);
+}
+
+// What rvlib's programs do at the start and the end under QEMU: set up
+// mtvec, print on UART0 (polling LSR first) and fail through sifive_test
+// with code 3. rv_run_devices must do all of it and stop there.
+static void check_devices(void) {
+    uint32_t code[32];
+    size_t n = 0;
+    li(code, &n, T0, RV_RAM_BASE + 0x100);
+    code[n++] = 0x30529073;                     // csrw mtvec, t0
+    code[n++] = 0x30502373;                     // csrr t1, mtvec
+    li(code, &n, T0, RV_UART_BASE);
+    code[n++] = i_type(5, T0, 4, T2, 0x03);     // lbu t2, 5(t0): LSR
+    code[n++] = addi(A0, ZERO, 'h');
+    code[n++] = s_type(0, A0, T0, 0);           // sb a0, 0(t0)
+    code[n++] = addi(A0, ZERO, 'i');
+    code[n++] = s_type(0, A0, T0, 0);
+    li(code, &n, T0, RV_TEST_BASE);
+    li(code, &n, A0, 3u << 16 | 0x3333);
+    code[n++] = s_type(0, A0, T0, 2);           // sw a0, 0(t0)
+    code[n++] = jal(ZERO, 0);
+    int ok = 1;
+    rv_cpu cpu;
+    start_cpu(&cpu, 4096);
+    rv_cpu_write(&cpu, RV_RAM_BASE, code, n * 4);
+    FILE *uart = tmpfile();
+    rv_devices devices;
+    rv_devices_init(&devices, uart);
+    enum rv_stop stop = rv_run_devices(&cpu, &devices, 1000, 0);
+    char output[8] = {0};
+    if (uart != NULL) {
+        rewind(uart);
+        ok &= fread(output, 1, sizeof(output) - 1, uart) == 2;
+        fclose(uart);
+    }
+    ok &= stop == RV_STOP_EXIT && devices.exit_status == 3 && strcmp(output, "hi") == 0 &&
+          cpu.x[T1] == RV_RAM_BASE + 0x100 && cpu.x[T2] == 0x60 && cpu.instret == n - 1 &&
+          cpu.pc == RV_RAM_BASE + 4 * (uint32_t)(n - 1) && cpu.stores == 3 && cpu.loads == 1;
+    rv_cpu_free(&cpu);
+    report("sifive_test and UART0: prints \"hi\", exits with 3", ok);
+}
+
+// A sampler like ../rvlib/profile.s's: the timer interrupt every tick
+// records mepc and instret and re-arms, over a loop of 1000 instructions
+// and then a `j .` it has to wait in. The sample there skips mepc past it
+// onto a zero word, whose illegal-instruction trap ends the run. Every
+// sample must land exactly 100 instructions after the one before.
+static void check_timer(void) {
+    const uint32_t buffer = RV_RAM_BASE + 0x400, clint_mtimecmp = 0x02004000;
+    uint32_t code[64];
+    size_t n = 0, handler_at, idle_at;
+    handler_at = n;
+    li(code, &n, T0, 0);                        // la t0, handler (below)
+    code[n++] = csrrw(ZERO, CSR_MTVEC, T0);
+    li(code, &n, A1, buffer);
+    idle_at = n;
+    li(code, &n, S2, 0);                        // la s2, idle
+    li(code, &n, T0, clint_mtimecmp);
+    code[n++] = s_type(4, ZERO, T0, 2);         // sw zero, 4(t0)
+    code[n++] = addi(T1, ZERO, 1);
+    code[n++] = s_type(0, T1, T0, 2);           // mtimecmp = 1: at instret 100
+    code[n++] = addi(T1, ZERO, 0x80);
+    code[n++] = csrrs(ZERO, CSR_MIE, T1);       // csrs mie, t1: MTIE
+    code[n++] = csrrsi(ZERO, CSR_MSTATUS, 8);   // csrsi mstatus, 8: MIE
+    code[n++] = addi(S3, ZERO, 500);
+    uint32_t loop = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = addi(S3, S3, -1);
+    code[n++] = b_type(-4, ZERO, S3, 1);        // bnez s3, loop
+    uint32_t idle = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = jal(ZERO, 0);                   // idle: j .
+    code[n++] = 0;
+    uint32_t handler = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = csrrs(T2, CSR_INSTRET, ZERO);
+    code[n++] = s_type(4, T2, A1, 2);           // sw t2, 4(a1)
+    code[n++] = csrrs(T1, CSR_MCAUSE, ZERO);
+    code[n++] = b_type(44, ZERO, T1, 5);        // bgez t1, stopped
+    code[n++] = csrrs(T2, CSR_MEPC, ZERO);
+    code[n++] = s_type(0, T2, A1, 2);           // sw t2, 0(a1)
+    code[n++] = addi(A1, A1, 8);
+    code[n++] = i_type(0, T0, 2, T1, 0x03);     // lw t1, 0(t0): mtimecmp
+    code[n++] = addi(T1, T1, 1);
+    code[n++] = s_type(0, T1, T0, 2);
+    code[n++] = b_type(12, S2, T2, 1);          // bne t2, s2, resume
+    code[n++] = addi(T2, T2, 4);
+    code[n++] = csrrw(ZERO, CSR_MEPC, T2);      // step over the `j .`
+    code[n++] = 0x30200073;                     // resume: mret
+    uint32_t stopped = RV_RAM_BASE + (uint32_t)n * 4;
+    code[n++] = csrrs(A0, CSR_MEPC, ZERO);      // stopped: a0 = mepc
+    code[n++] = jal(ZERO, 0);                   // j .: the handler runs with MIE off
+    li(code, &handler_at, T0, handler);
+    li(code, &idle_at, S2, idle);
+
+    rv_cpu cpu;
+    start_cpu(&cpu, 4096);
+    rv_cpu_write(&cpu, RV_RAM_BASE, code, n * 4);
+    rv_devices devices;
+    rv_devices_init(&devices, NULL);
+    enum rv_stop stop = rv_run_devices(&cpu, &devices, 100000, 0);
+    uint32_t samples = (cpu.x[A1] - buffer) / 8;
+    // stopped at the handler's `j .`, MIE off and saved (on) in MPIE
+    int ok = stop == RV_STOP_IDLE_LOOP && cpu.pc == stopped + 4 && cpu.mcause == 2 &&
+             cpu.x[A0] == idle + 4 && (cpu.mstatus & 0x88) == 0x80 && samples >= 10 &&
+             samples == devices.interrupts;
+    for (uint32_t i = 0; ok && i < samples; i++) {
+        uint32_t sample[2];
+        rv_cpu_read(&cpu, buffer + 8 * i, sample, sizeof(sample));
+        int last = i == samples - 1;
+        ok = sample[1] == 100 * (i + 1) &&
+             (last ? sample[0] == idle : sample[0] - loop < 8);
+    }
+    rv_cpu_free(&cpu);
+    report("timer interrupt every 100 instructions, `j .` waits for it, illegal traps", ok);
+}
+
+// rvprof.exe (built next to this) on three reports as profile.s prints
+// them, against /tmp/rvsim_array_ops.elf's labels: one the program asked
+// for, one from a sample that found `j .` and one from a full buffer.
+// Each must say why it stopped and charge every sample to its label.
+static void check_rvprof(const char *array_path) {
+    static const struct {
+        const char *report, *stopped;
+        unsigned loop, start, done;     // samples per label
+    } cases[] = {
+        {"hi\nrvprof 0000000a 00000004 00000010 ffffffff 00000000\n"
+         "80000014 80000020 80000004 80000030\nrvprof end\n",
+         "stopped:      profile_report\n", 3, 1, 0},
+        {"rvprof 0000000a 0000000a 00000010 80000007 80000034\n"
+         "80000014 80000018 8000001c 80000020 80000024 80000028 8000002c 80000030\n"
+         "80000000 80000034\nrvprof end\n",
+         "stopped:      idle loop at 0x80000034 (done)\n", 8, 1, 1},
+        {"rvprof 00000001 00000002 00000002 fffffffe 80000028\n"
+         "80000028 80000028\nrvprof end\n",
+         "stopped:      sample buffer full at 0x80000028 (loop+0x14)\n", 2, 0, 0},
+    };
+    const char *report_path = "/tmp/rvsim_profile.out";
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        FILE *f = fopen(report_path, "w");
+        int ok = f != NULL && fputs(cases[i].report, f) >= 0;
+        if (f != NULL && fclose(f) != 0)
+            ok = 0;
+        char command[256], line[256];
+        snprintf(command, sizeof(command), "./rvprof.exe %s %s", array_path, report_path);
+        FILE *out = ok ? popen(command, "r") : NULL;
+        int stopped = 0, hi = 0;
+        unsigned loop = 0, start = 0, done = 0;
+        while (out != NULL && fgets(line, sizeof(line), out) != NULL) {
+            char name[64];
+            unsigned samples;
+            hi |= strcmp(line, "hi\n") == 0;
+            stopped |= strcmp(line, cases[i].stopped) == 0;
+            if (sscanf(line, "%63s %u", name, &samples) != 2)
+                continue;
+            if (strcmp(name, "loop") == 0)
+                loop = samples;
+            else if (strcmp(name, "_start") == 0)
+                start = samples;
+            else if (strcmp(name, "done") == 0)
+                done = samples;
+        }
+        ok = out != NULL && pclose(out) == 0 && stopped && hi == (i == 0) &&
+             loop == cases[i].loop && start == cases[i].start && done == cases[i].done;
+        char what[96];
+        snprintf(what, sizeof(what), "rvprof: %.*s", (int)strcspn(cases[i].stopped + 14, "\n"),
+                 cases[i].stopped + 14);
+        report(what, ok);
+    }
+}
+
+// The ELFs the toolchain builds from the real sources (make main.elf in
+// .., make compile compile-unrolled compile-rvv in ../array_ops), where
+// they have been built: each must run to done without an illegal
+// instruction (a compressed one, say) and leave s2 = 10, or every
+// element of my_array 1. The hand-encoded copies above cannot catch what
+// the assembler does with the -march string.
+static void check_built_programs(void) {
+    static const char *const paths[] = {
+        "../main.elf", "../array_ops/array_ops.elf", "../array_ops/array_ops_unrolled.elf",
+        "../array_ops/array_ops_rvv.elf",
+    };
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        FILE *f = fopen(paths[i], "rb");
+        if (f == NULL) {
+            printf("   (%s not built: skipped)\n", paths[i]);
+            continue;
+        }
+        fclose(f);
+        rv_cpu cpu;
+        rv_image image;
+        uint32_t done = 0, array = 0;
+        char what[96];
+        snprintf(what, sizeof(what), "%s runs to done", paths[i]);
+        if (!load(&cpu, &image, paths[i], 1u << 20)) {
+            report(what, 0);
+            continue;
+        }
+        rv_devices devices;
+        rv_devices_init(&devices, NULL);
+        int ok = rv_symbol_find(&image, "done", &done) &&
+                 rv_run_devices(&cpu, &devices, 10000000, done) == RV_STOP_PC;
+        if (!rv_symbol_find(&image, "my_array", &array)) {
+            ok &= cpu.x[S2] == 10;
+        } else {
+            // my_array runs to the end of its segment: LENGTH words
+            uint32_t words = 0;
+            for (size_t s = 0; s < image.segment_count; s++) {
+                const rv_segment *segment = &image.segments[s];
+                if (array - segment->address < segment->size)
+                    words = (segment->address + segment->size - array) / 4;
+            }
+            ok &= words > 0;
+            for (uint32_t w = 0; ok && w < words; w++) {
+                uint32_t value = 0;
+                ok = rv_cpu_read(&cpu, array + 4 * w, &value, 4) && value == 1;
+            }
+        }
+        report(what, ok);
+        rv_image_free(&image);
+        rv_cpu_free(&cpu);
+    }
+}
+
+// The run's MIPS
+// Words from m.s and the libraries, as objdump -M no-aliases prints them
+static const struct {
+    uint32_t insn;
+    const char *text;
+} known_words[] = {
+    {0x00200493, "addi    s1, zero, 2"},
+    {0x01248933, "add     s2, s1, s2"},
+    {0xfff98993, "addi    s3, s3, -1"},
+    {0xfe099ce3, "bne     s3, zero, 0x7ffffff8"},
+    {0x0000006f, "jal     zero, 0x80000000"},
+    {0x02faf9b7, "lui     s3, 0x2faf"},
+    {0x00812303, "lw      t1, 8(sp)"},
+    {0xfe512e23, "sw      t0, -4(sp)"},
+    {0x41f55513, "srai    a0, a0, 31"},
+    {0x02c5c533, "div     a0, a1, a2"},
+    {0x30529073, "csrrw   zero, mtvec, t0"},
+    {0x0ff0000f, "fence   iorw, iorw"},
+    {0x00008067, "jalr    zero, 0(ra)"},
+    {0x30200073, "mret"},
+    {0x02345a93, ".word   0x2345a93"},          // srli with a shift of 35: rv64 only
+};
+
+static void check_disasm(void) {
+    char text[RV_DISASM_SIZE], error[128];
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(known_words) / sizeof(known_words[0]); i++) {
+        rv_disasm(known_words[i].insn, RV_RAM_BASE, text);
+        if (strcmp(text, known_words[i].text) != 0) {
+            printf("   0x%08x: \"%s\", expected \"%s\"\n", known_words[i].insn, text,
+                   known_words[i].text);
+            ok = 0;
+        }
+    }
+    report("disassembler: known words", ok);
+
+    ok = 1;
+    size_t named = 0;
+    for (int i = 0; i < 200000 && ok; i++) {
+        uint32_t insn = (uint32_t)next_random(), pc = RV_RAM_BASE + 4 * (uint32_t)i, back;
+        // mostly real opcodes, so most words decode to something
+        static const uint8_t opcodes[] = {0x03, 0x0F, 0x13, 0x17, 0x23, 0x33,
+                                          0x37, 0x63, 0x67, 0x6F, 0x73};
+        insn = (insn & ~0x7Fu) | opcodes[next_random() % sizeof(opcodes)];
+        rv_disasm(insn, pc, text);
+        if (strncmp(text, ".word", 5) == 0)
+            continue;
+        named++;
+        if (!rv_assemble(text, pc, &back, error, sizeof(error)) || back != insn) {
+            printf("   0x%08x: \"%s\" assembles to 0x%08x (%s)\n", insn, text, back, error);
+            ok = 0;
+        }
+    }
+    ok &= named > 100000;
+    report("disassembler: random words assemble back to themselves", ok);
+
+    uint32_t insn;
+    ok = !rv_assemble("addi a0, a0, 2048", RV_RAM_BASE, &insn, error, sizeof(error)) &&
+         !rv_assemble("beq a0, a1, 0x80001000", RV_RAM_BASE, &insn, error, sizeof(error)) &&
+         !rv_assemble("lw a0, 4(x32)", RV_RAM_BASE, &insn, error, sizeof(error)) &&
+         rv_assemble("sw x5, -4(x2)", RV_RAM_BASE, &insn, error, sizeof(error)) &&
+         insn == 0xfe512e23;
+    report("assembler: range checks and x0-x31 names", ok);
+}
+
+// The loops of the code loaded at RV_RAM_BASE, n words of it
+static size_t find_loops(const rv_cpu *cpu, size_t n, rv_loop **loops) {
+    rv_image image = {RV_RAM_BASE, NULL, 0, {{RV_RAM_BASE, (uint32_t)n * 4, RV_SEGMENT_EXECUTE}},
+                      1};
+    rv_cost_model model = RV_COST_MODEL_DEFAULT;
+    size_t count = 0;
+    char error[128];
+    if (!rv_find_loops(cpu, &image, &model, loops, &count, error, sizeof(error)))
+        printf("   %s\n", error);
+    return count;
+}
+
+// Whether loop costs what the extra iterations cost the simulator between
+// two runs, a and b, and the estimate has a single way round
+static int costs_as_run(const rv_loop *loop, const rv_cpu *a, const rv_cpu *b,
+                        uint64_t iterations) {
+    return loop->longest.cycles == loop->shortest.cycles &&
+           (b->instret - a->instret) == iterations * loop->longest.instructions &&
+           (b->cycles - a->cycles) == iterations * loop->longest.cycles;
+}
+
+static void check_loop_costs(void) {
+    uint32_t code[32];
+    label labels[4];
+    rv_cpu runs[2];
+    rv_loop *loops = NULL;
+    size_t n = 0, count;
+    for (int r = 0; r < 2; r++) {
+        n = build_add_two(code, 5 + (uint32_t)r, labels);
+        start_cpu(&runs[r], 4096);
+        rv_cpu_write(&runs[r], RV_RAM_BASE, code, n * 4);
+        rv_run(&runs[r], 1000, 0);
+    }
+    count = find_loops(&runs[0], n, &loops);
+    int ok = count == 1 && loops[0].header == labels[1].address && loops[0].depth == 1 &&
+             loops[0].longest.cycles == 5 && costs_as_run(&loops[0], &runs[0], &runs[1], 1);
+    rv_loops_free(loops, count);
+    rv_cpu_free(&runs[0]);
+    rv_cpu_free(&runs[1]);
+    report("loop costs: m.s, 3 instructions and 5 cycles an iteration", ok);
+
+    run_version(ORIGINAL, 3, &runs[0]);
+    run_version(ORIGINAL, 4, &runs[1]);
+    n = build_array_ops(code, 3, labels);
+    count = find_loops(&runs[0], n, &loops);
+    ok = count == 1 && loops[0].header == labels[1].address && loops[0].longest.cycles == 11 &&
+         loops[0].longest.mix[RV_CLASS_LOAD] == 1 && loops[0].longest.load_use_stalls == 1 &&
+         costs_as_run(&loops[0], &runs[0], &runs[1], 1);
+    rv_loops_free(loops, count);
+    rv_cpu_free(&runs[0]);
+    rv_cpu_free(&runs[1]);
+    report("loop costs: array_ops.s, 8 instructions and 11 cycles an element", ok);
+
+    // by_four runs once more for 8 elements than for 4, the tail loop once
+    // more for 7 than for 6
+    rv_cpu tails[2];
+    run_version(UNROLLED, 4, &runs[0]);
+    run_version(UNROLLED, 8, &runs[1]);
+    run_version(UNROLLED, 6, &tails[0]);
+    run_version(UNROLLED, 7, &tails[1]);
+    n = build_array_unrolled(code, 4, labels);
+    count = find_loops(&runs[0], n, &loops);
+    ok = count == 2 && loops[0].header == labels[1].address &&
+         costs_as_run(&loops[0], &runs[0], &runs[1], 1) && loops[0].longest.cycles == 16 &&
+         costs_as_run(&loops[1], &tails[0], &tails[1], 1) && loops[1].longest.cycles == 8;
+    rv_loops_free(loops, count);
+    for (int r = 0; r < 2; r++) {
+        rv_cpu_free(&runs[r]);
+        rv_cpu_free(&tails[r]);
+    }
+    report("loop costs: unrolled, 16 cycles per 4 elements and 8 per leftover one", ok);
+}
+
+// Disassembly of a megabyte-sized image, operands and fields, as rvdis lists it
+static void bench_disasm(void) {
+    uint32_t *words = malloc(DISASM_WORDS * sizeof(uint32_t));
+    if (words == NULL)
+        return;
+    uint32_t code[32];
+    label labels[4];
+    size_t n = build_array_ops(code, 3, labels);
+    for (uint32_t i = 0; i < DISASM_WORDS; i++)
+        words[i] = code[i % n];
+    char text[RV_DISASM_SIZE], fields[RV_FIELDS_SIZE];
+    size_t characters = 0;
+    double t0 = now_s();
+    for (uint32_t i = 0; i < DISASM_WORDS; i++) {
+        characters += rv_disasm(words[i], RV_RAM_BASE + 4 * i, text);
+        characters += rv_disasm_fields(words[i], fields);
+    }
+    double seconds = now_s() - t0;
+    char line[160];
+    snprintf(line, sizeof(line), "%-40s %11u words        %8.1f ms %7.1f MB/s", "disassembly",
+             DISASM_WORDS, seconds * 1e3, 4.0 * DISASM_WORDS / seconds / 1e6);
+    report(line, characters > 40u * DISASM_WORDS);
+    free(words);
+}
+
+static double bench_program(const char *what, const char *path, uint32_t ram, enum engine which,
+                            uint64_t want_instret) {
+    rv_cpu cpu;
+    rv_image image;
+    engine = which;
+    int loaded = load(&cpu, &image, path, ram);
+    engine = DECODE;
+    if (!loaded) {
+        report(what, 0);
+        return 0;
+    }
+    if (which == PROFILED && !rv_cpu_enable_profile(&cpu)) {
+        printf("   out of memory for the profile\n");
+        exit(1);
+    }
+    double start = now_s();
+    rv_run(&cpu, UINT64_MAX, 0);
+    double elapsed = now_s() - start;
+    double mips = cpu.instret / elapsed / 1e6;
+    char line[160];
+    snprintf(line, sizeof(line), "%-40s %11llu instructions %8.1f ms %7.1f MIPS  CPI %.2f", what,
+             (unsigned long long)cpu.instret, elapsed * 1e3, mips,
+             (double)cpu.cycles / cpu.instret);
+    report(line, cpu.instret == want_instret);
+    rv_image_free(&image);
+    rv_cpu_free(&cpu);
+    return mips;
+}
+
+int main(void) {
+    const char *add_path = "/tmp/rvsim_add_two.elf", *array_path = "/tmp/rvsim_array_ops.elf";
+    rv_cpu probe;
+    if (rv_cpu_init(&probe, RV_RAM_BASE, 4096) && !rv_cpu_enable_dbt(&probe, DBT_THRESHOLD)) {
+        printf("(no x86-64 translation on this host: skipping it)\n");
+        last_engine = BLOCKS;
+    }
+    rv_cpu_free(&probe);
+    for (engine = DECODE; engine <= last_engine; engine++) {
+        printf("=== correctness, %s ===\n", engine_names[engine]);
+        check_alu();
+        check_memory_and_control();
+        check_programs(add_path, array_path);
+        check_devices();
+        check_timer();
+        check_vector_ops();
+        check_array_versions();
+    }
+    engine = DECODE;
+    printf("\n=== block cache and translation versus decoding every fetch ===\n");
+    check_engines_agree();
+    check_self_modifying();
+
+    printf("\n=== disassembler and static loop costs ===\n");
+    check_disasm();
+    check_loop_costs();
+
+    printf("\n=== the toolchain-built programs ===\n");
+    check_built_programs();
+
+    printf("\n=== rvprof on recorded profile.s reports ===\n");
+    check_rvprof(array_path);
+
+    printf("\n=== array_ops per element (VLEN 128) ===\n");
+    printf("   %9s %-12s %8s %8s\n", "elements", "version", "instr", "cycles");
+    print_per_element(3);
+    print_per_element(1000);
+    print_per_element(100000);
+
+    printf("\n=== speed ===\n");
+    uint32_t code[32];
+    label labels[4];
+    size_t n = build_add_two(code, BENCH_ADD_LOOPS, labels);
+    if (!write_elf(add_path, code, (uint32_t)n * 4, labels, 2)) {
+        printf("cannot write %s\n", add_path);
+        return 1;
+    }
+    n = build_array_ops(code, BENCH_ARRAY_WORDS, labels);
+    uint32_t *image = calloc(n + BENCH_ARRAY_WORDS, 4);
+    if (image == NULL) {
+        printf("out of memory\n");
+        return 1;
+    }
+    memcpy(image, code, n * 4);
+    int written = write_elf(array_path, image, (uint32_t)(n + BENCH_ARRAY_WORDS) * 4, labels, 4);
+    free(image);
+    if (!written) {
+        printf("cannot write %s\n", array_path);
+        return 1;
+    }
+    uint64_t add_instret = 3 + 3ull * BENCH_ADD_LOOPS;
+    uint64_t array_instret = 5 + 8ull * BENCH_ARRAY_WORDS + 1;
+    double decode = bench_program("_add_two_five_times", add_path, 4096, DECODE, add_instret);
+    bench_program("_add_two_five_times, profiled", add_path, 4096, PROFILED, add_instret);
+    double blocks =
+        bench_program("_add_two_five_times, block cache", add_path, 4096, BLOCKS, add_instret);
+    printf("   block cache speedup: %.1fx\n", blocks / decode);
+    if (last_engine == DBT) {
+        double dbt = bench_program("_add_two_five_times, x86-64", add_path, 4096, DBT, add_instret);
+        printf("   translation speedup: %.1fx (%.1fx over the block cache)\n", dbt / decode,
+               dbt / blocks);
+    }
+    decode = bench_program("array_ops loop", array_path, BENCH_RAM, DECODE, array_instret);
+    bench_program("array_ops loop, profiled", array_path, BENCH_RAM, PROFILED, array_instret);
+    blocks = bench_program("array_ops loop, block cache", array_path, BENCH_RAM, BLOCKS,
+                           array_instret);
+    printf("   block cache speedup: %.1fx\n", blocks / decode);
+    if (last_engine == DBT) {
+        double dbt = bench_program("array_ops loop, x86-64", array_path, BENCH_RAM, DBT,
+                                   array_instret);
+        printf("   translation speedup: %.1fx (%.1fx over the block cache)\n", dbt / decode,
+               dbt / blocks);
+    }
+    bench_disasm();
+    printf("\n(%s and %s are left for ./rvsim.exe)\n", add_path, array_path);
+    return failures != 0;
+}
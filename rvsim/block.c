@@ -0,0 +1,641 @@
+/*
+ * block.c - Pre-decoded basic blocks, run with direct-threaded dispatch
+ * (see block.h)
+ *
+ * Cycles, instret and the load/store/branch counters are added a whole
+ * block at a time when it ends. Each block stores its static share: one
+ * cycle per instruction plus the load-use stalls inside the block. The
+ * dynamic parts are added as they happen: the stall on the block's first
+ * instruction (it depends on how the previous block ended) and the
+ * taken-branch penalty. When a run stops partway through a block (a
+ * fault, or a store into code), the instructions before that point are
+ * counted one by one instead.
+ *
+ * A block is only entered when it can run to its end: when fewer
+ * instructions are left than it holds, or stop_pc lies inside it, the
+ * run steps one instruction at a time through rv_run_decode. A block that
+ * ends with its successor already linked and passing those checks jumps
+ * straight to that block's first micro-op. An addi just before a block's
+ * branch is dispatched together with it.
+ *
+ * The guest registers live in a local array with a 33rd slot. Micro-ops
+ * that write x0 write that slot instead, so x0 reads as zero without a
+ * check.
+ *
+ * With translation on, a block that has been entered cache->threshold
+ * times is compiled (dbt.h) and entered natively from then on. Translated
+ * code hands back here at a jalr, at an exit not chained yet, when the
+ * limit is near, or on a fault or code write.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "dbt.h"
+#include "rv32.h"
+
+#define BLOCK_HASH 16384            // direct-mapped pc -> block table
+#define CACHE_BLOCKS 16384
+#define CACHE_UOPS (CACHE_BLOCKS * 8)
+
+struct rv_blocks {
+    block *table[BLOCK_HASH];
+    block blocks[CACHE_BLOCKS];
+    uop uops[CACHE_UOPS];
+    size_t block_count, uop_count;
+    uint64_t *code;             // a bit per RAM word that some block was decoded from
+    uint32_t code_lo, code_hi;  // words [code_lo, code_hi) may have bits set
+    rv_timing timing;           // what the block cycles were worked out with
+    uint64_t generation;        // bumped by every flush
+    struct rv_dbt *dbt;         // when translation to x86-64 is on
+    unsigned threshold;         // entries before a block is translated
+    rv_blocks_stats stats;
+};
+
+int rv_cpu_enable_blocks(rv_cpu *cpu) {
+    if (cpu->blocks != NULL)
+        return 1;
+    struct rv_blocks *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL)
+        return 0;
+    size_t words = cpu->ram_size / 4;
+    cache->code = calloc((words + 63) / 64, sizeof(uint64_t));
+    if (cache->code == NULL) {
+        free(cache);
+        return 0;
+    }
+    cache->timing = cpu->timing;
+    cpu->blocks = cache;
+    return 1;
+}
+
+int rv_cpu_enable_dbt(rv_cpu *cpu, unsigned threshold) {
+    if (!rv_cpu_enable_blocks(cpu))
+        return 0;
+    struct rv_blocks *cache = cpu->blocks;
+    if (cache->dbt == NULL)
+        cache->dbt = dbt_create();
+    cache->threshold = threshold ? threshold : 1;
+    return cache->dbt != NULL;
+}
+
+void rv_blocks_free(struct rv_blocks *blocks) {
+    if (blocks == NULL)
+        return;
+    dbt_free(blocks->dbt);
+    free(blocks->code);
+    free(blocks);
+}
+
+rv_blocks_stats rv_blocks_get_stats(const struct rv_blocks *blocks) {
+    return blocks->stats;
+}
+
+static void flush(struct rv_blocks *cache) {
+    memset(cache->table, 0, sizeof(cache->table));
+    cache->block_count = cache->uop_count = 0;
+    if (cache->code_hi > cache->code_lo) {
+        size_t first = cache->code_lo / 64, last = (cache->code_hi - 1) / 64;
+        memset(cache->code + first, 0, (last - first + 1) * sizeof(uint64_t));
+    }
+    cache->code_lo = cache->code_hi = 0;
+    if (cache->dbt != NULL)
+        dbt_flush(cache->dbt);
+    cache->generation++;
+    cache->stats.flushes++;
+}
+
+static inline int is_code(const struct rv_blocks *cache, uint32_t word) {
+    return cache->code[word / 64] >> (word % 64) & 1;
+}
+
+// A store of width 1, 2 or 4 at RAM offset at; 1 if it hit decoded code
+static inline int store_hits_code(const struct rv_blocks *cache, uint32_t at, uint32_t width) {
+    uint32_t first = at / 4, last = (at + width - 1) / 4;
+    if (last < cache->code_lo || first >= cache->code_hi)
+        return 0;
+    return is_code(cache, first) || is_code(cache, last);
+}
+
+void rv_blocks_stored(struct rv_blocks *blocks, uint32_t offset, size_t size) {
+    uint32_t first = offset / 4, last = (uint32_t)((offset + size - 1) / 4);
+    if (last < blocks->code_lo || first >= blocks->code_hi)
+        return;
+    for (uint32_t word = first; word <= last; word++) {
+        if (is_code(blocks, word)) {
+            flush(blocks);
+            return;
+        }
+    }
+}
+
+static inline uint32_t load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint16_t load16(const uint8_t *p) {
+    uint16_t v;
+    memcpy(&v, p, 2);
+    return v;
+}
+
+static inline uint32_t dest(uint32_t insn) {
+    return rv_rd(insn) ? rv_rd(insn) : X_SINK;
+}
+
+// One instruction at pc as a micro-op; 0 if it cannot go in a block
+static int decode(uint32_t insn, uint32_t pc, uop *u) {
+    static const uint8_t imm_kinds[8] = {UOP_ADDI, UOP_SLLI, UOP_SLTI, UOP_SLTIU,
+                                         UOP_XORI, UOP_SRLI, UOP_ORI,  UOP_ANDI};
+    static const uint8_t reg_kinds[8] = {UOP_ADD, UOP_SLL, UOP_SLT, UOP_SLTU,
+                                         UOP_XOR, UOP_SRL, UOP_OR,  UOP_AND};
+    static const uint8_t branch_kinds[8] = {UOP_BEQ, UOP_BNE, UOP_COUNT, UOP_COUNT,
+                                            UOP_BLT, UOP_BGE, UOP_BLTU,  UOP_BGEU};
+    static const uint8_t load_kinds[8] = {UOP_LB,  UOP_LH,  UOP_LW,    UOP_COUNT,
+                                          UOP_LBU, UOP_LHU, UOP_COUNT, UOP_COUNT};
+    uint32_t f3 = rv_funct3(insn), f7 = rv_funct7(insn);
+    *u = (uop){NULL, 0, UOP_COUNT, (uint8_t)dest(insn), (uint8_t)rv_rs1(insn),
+               (uint8_t)rv_rs2(insn), 0};
+    switch (rv_opcode(insn)) {
+    case RV_OP_LUI:
+        u->kind = UOP_LI;
+        u->imm = rv_imm_u(insn);
+        break;
+    case RV_OP_AUIPC:
+        u->kind = UOP_LI;
+        u->imm = (int32_t)(pc + (uint32_t)rv_imm_u(insn));
+        break;
+    case RV_OP_IMM:
+        u->kind = imm_kinds[f3];
+        u->imm = rv_imm_i(insn);
+        if (f3 == 1 || f3 == 5) {
+            u->imm = (int32_t)rv_rs2(insn);
+            if (f3 == 5 && f7 == 0x20)
+                u->kind = UOP_SRAI;
+            else if (f7 != 0)
+                return 0;
+        }
+        break;
+    case RV_OP_REG:
+        if (f7 == 0)
+            u->kind = reg_kinds[f3];
+        else if (f7 == 0x20 && f3 == 0)
+            u->kind = UOP_SUB;
+        else if (f7 == 0x20 && f3 == 5)
+            u->kind = UOP_SRA;
+        else
+            return 0;
+        break;
+    case RV_OP_LOAD:
+        u->kind = load_kinds[f3];
+        u->imm = rv_imm_i(insn);
+        break;
+    case RV_OP_STORE:
+        u->kind = f3 <= 2 ? UOP_SB + f3 : UOP_COUNT;
+        u->imm = rv_imm_s(insn);
+        break;
+    case RV_OP_BRANCH:
+        u->kind = branch_kinds[f3];
+        u->imm = (int32_t)(pc + (uint32_t)rv_imm_b(insn));
+        break;
+    case RV_OP_JAL:
+        if (insn == RV_INSN_J_SELF)
+            return 0;           // the idle-loop stop is rv_run_decode's
+        u->kind = UOP_JAL;
+        u->imm = (int32_t)(pc + (uint32_t)rv_imm_j(insn));
+        break;
+    case RV_OP_JALR:
+        if (f3 == 0)
+            u->kind = UOP_JALR;
+        u->imm = rv_imm_i(insn);
+        break;
+    case RV_OP_MISC_MEM:
+        u->kind = UOP_NOP;
+        break;
+    default:
+        return 0;
+    }
+    return u->kind != UOP_COUNT;
+}
+
+// Decode the block at pc into the cache; NULL if its first instruction
+// cannot go in a block. Kept out of line, away from the dispatch loop's
+// registers.
+__attribute__((noinline, cold)) static block *translate(struct rv_blocks *cache, const rv_cpu *cpu, uint32_t pc,
+                        const void *const *handlers, const void *const *fused) {
+    uint32_t at = pc - cpu->ram_base;
+    if ((pc & 3) || at > cpu->ram_size - 4)
+        return NULL;
+    if (cache->block_count == CACHE_BLOCKS || CACHE_UOPS - cache->uop_count < BLOCK_MAX_UOPS + 1)
+        flush(cache);
+    block *b = &cache->blocks[cache->block_count];
+    uop *uops = &cache->uops[cache->uop_count];
+    memset(b, 0, sizeof(*b));
+    uint32_t n = 0, pending = 0, stalls = 0;
+    int terminated = 0;
+    while (n < BLOCK_MAX_UOPS && at <= cpu->ram_size - 4) {
+        uint32_t insn = load32(cpu->ram + at);
+        uop *u = &uops[n];
+        if (!decode(insn, pc + 4 * n, u))
+            break;
+        uint32_t sources = rv_sources(insn) & ~1u;
+        if (n == 0)
+            b->first_sources = sources;
+        u->stall = (sources & pending) != 0;
+        stalls += u->stall;
+        pending = u->kind >= UOP_LB && u->kind <= UOP_LHU && rv_rd(insn) ? 1u << rv_rd(insn) : 0;
+        b->loads += u->kind >= UOP_LB && u->kind <= UOP_LHU;
+        b->stores += u->kind >= UOP_SB && u->kind <= UOP_SW;
+        b->branches += u->kind >= UOP_BEQ && u->kind <= UOP_BGEU;
+        n++;
+        at += 4;
+        if (u->kind >= UOP_BEQ) {
+            terminated = 1;
+            break;
+        }
+    }
+    if (n == 0)
+        return NULL;
+    if (!terminated)
+        uops[n] = (uop){NULL, 0, UOP_END, X_SINK, 0, 0, 0};
+    for (uint32_t i = 0; i < n + !terminated; i++)
+        uops[i].handler = handlers[uops[i].kind];
+    // An addi right before the closing branch (a loop counter step, most
+    // often) runs with it: one dispatch for the pair
+    if (n >= 2 && uops[n - 2].kind == UOP_ADDI && uops[n - 1].kind >= UOP_BEQ &&
+        uops[n - 1].kind <= UOP_BGEU)
+        uops[n - 2].handler = fused[uops[n - 1].kind - UOP_BEQ];
+
+    b->pc = pc;
+    b->end = pc + 4 * n;
+    b->count = n;
+    b->cycles = n + stalls * cache->timing.load_use;
+    b->pending_out = terminated ? 0 : pending;
+    b->uops = uops;
+    cache->block_count++;
+    cache->uop_count += n + !terminated;
+    cache->table[(pc / 4) % BLOCK_HASH] = b;
+    cache->stats.translations++;
+
+    uint32_t first = (pc - cpu->ram_base) / 4;
+    for (uint32_t word = first; word < first + n; word++)
+        cache->code[word / 64] |= 1ull << (word % 64);
+    if (cache->code_hi == cache->code_lo) {
+        cache->code_lo = first;
+        cache->code_hi = first + n;
+    } else {
+        cache->code_lo = first < cache->code_lo ? first : cache->code_lo;
+        cache->code_hi = first + n > cache->code_hi ? first + n : cache->code_hi;
+    }
+    return b;
+}
+
+// Cycles of, and loads and stores in, the first done instructions of b,
+// for a run that leaves it early. The stall on entering b is not in them.
+__attribute__((noinline, cold)) static uint64_t partial(const block *b, uint32_t done, uint64_t load_use,
+                        uint64_t *loads, uint64_t *stores) {
+    uint64_t cycles = 0;
+    for (uint32_t i = 0; i < done; i++) {
+        uint8_t kind = b->uops[i].kind;
+        cycles += 1 + b->uops[i].stall * load_use;
+        *loads += kind >= UOP_LB && kind <= UOP_LHU;
+        *stores += kind >= UOP_SB && kind <= UOP_SW;
+    }
+    return cycles;
+}
+
+enum rv_stop rv_run_blocks(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc) {
+    static const void *const handlers[UOP_COUNT] = {
+        [UOP_LI] = &&op_li, [UOP_ADDI] = &&op_addi, [UOP_SLTI] = &&op_slti,
+        [UOP_SLTIU] = &&op_sltiu, [UOP_XORI] = &&op_xori, [UOP_ORI] = &&op_ori,
+        [UOP_ANDI] = &&op_andi, [UOP_SLLI] = &&op_slli, [UOP_SRLI] = &&op_srli,
+        [UOP_SRAI] = &&op_srai, [UOP_ADD] = &&op_add, [UOP_SUB] = &&op_sub,
+        [UOP_SLL] = &&op_sll, [UOP_SLT] = &&op_slt, [UOP_SLTU] = &&op_sltu,
+        [UOP_XOR] = &&op_xor, [UOP_SRL] = &&op_srl, [UOP_SRA] = &&op_sra,
+        [UOP_OR] = &&op_or, [UOP_AND] = &&op_and, [UOP_LB] = &&op_lb, [UOP_LH] = &&op_lh,
+        [UOP_LW] = &&op_lw, [UOP_LBU] = &&op_lbu, [UOP_LHU] = &&op_lhu, [UOP_SB] = &&op_sb,
+        [UOP_SH] = &&op_sh, [UOP_SW] = &&op_sw, [UOP_NOP] = &&op_nop, [UOP_BEQ] = &&op_beq,
+        [UOP_BNE] = &&op_bne, [UOP_BLT] = &&op_blt, [UOP_BGE] = &&op_bge,
+        [UOP_BLTU] = &&op_bltu, [UOP_BGEU] = &&op_bgeu, [UOP_JAL] = &&op_jal,
+        [UOP_JALR] = &&op_jalr, [UOP_END] = &&op_end,
+    };
+    // addi and then the branch, by branch kind
+    static const void *const fused[UOP_BGEU - UOP_BEQ + 1] = {
+        &&op_addi_beq, &&op_addi_bne, &&op_addi_blt, &&op_addi_bge, &&op_addi_bltu, &&op_addi_bgeu,
+    };
+    struct rv_blocks *cache = cpu->blocks;
+    if (cache->timing.load_use != cpu->timing.load_use ||
+        cache->timing.taken_branch != cpu->timing.taken_branch) {
+        flush(cache);
+        cache->timing = cpu->timing;
+    }
+    struct rv_dbt *dbt = stop_pc == 0 ? cache->dbt : NULL;
+    uint8_t *ram = cpu->ram;
+    const uint32_t base = cpu->ram_base, size = cpu->ram_size;
+    const uint64_t load_use = cpu->timing.load_use, taken_penalty = cpu->timing.taken_branch;
+    dbt_context context;        // its registers are the block engine's too
+    uint32_t *const r = context.x;
+    memcpy(r, cpu->x, sizeof(cpu->x));
+    r[X_SINK] = 0;
+    uint32_t pc = cpu->pc;
+    uint64_t instret = cpu->instret, cycles = cpu->cycles;
+    uint64_t loads = cpu->loads, stores = cpu->stores;
+    uint64_t branches = cpu->branches, taken_branches = cpu->taken_branches;
+    const uint64_t limit = instret + max_instructions;
+    uint32_t pending = cpu->pending_load ? 1u << cpu->pending_load : 0;
+    block **slot = NULL;        // where the block just run keeps the next one
+    void *jump = NULL;          // the translated exit that led here, to chain
+    uint64_t jump_generation = 0;
+    enum rv_stop stop;
+
+#define NEXT() goto *(++u)->handler
+#define SYNC_OUT()                                                                      \
+    do {                                                                                \
+        memcpy(cpu->x, r, sizeof(cpu->x));                                              \
+        cpu->pc = pc;                                                                   \
+        cpu->instret = instret;                                                         \
+        cpu->cycles = cycles;                                                           \
+        cpu->loads = loads;                                                             \
+        cpu->stores = stores;                                                           \
+        cpu->branches = branches;                                                       \
+        cpu->taken_branches = taken_branches;                                           \
+        cpu->pending_load = pending ? (uint32_t)__builtin_ctz(pending) : 0;             \
+    } while (0)
+
+    for (;;) {
+        if (instret == limit) {
+            stop = RV_STOP_LIMIT;
+            break;
+        }
+        if (pc == stop_pc) {
+            stop = RV_STOP_PC;
+            break;
+        }
+        block *cur = slot != NULL ? *slot : NULL;
+        if (cur == NULL || cur->pc != pc) {
+            cur = cache->table[(pc / 4) % BLOCK_HASH];
+            if (cur == NULL || cur->pc != pc) {
+                uint64_t generation = cache->generation;
+                cur = translate(cache, cpu, pc, handlers, fused);
+                if (cache->generation != generation)
+                    slot = NULL;
+            }
+            if (slot != NULL)
+                *slot = cur;
+        }
+        if (cur == NULL || cur->count > limit - instret || stop_pc - pc < 4 * cur->count) {
+            // One instruction the slow way. It may also flush the cache.
+            SYNC_OUT();
+            stop = rv_run_decode(cpu, 1, stop_pc);
+            memcpy(r, cpu->x, sizeof(cpu->x));
+            pc = cpu->pc;
+            instret = cpu->instret;
+            cycles = cpu->cycles;
+            loads = cpu->loads;
+            stores = cpu->stores;
+            branches = cpu->branches;
+            taken_branches = cpu->taken_branches;
+            pending = cpu->pending_load ? 1u << cpu->pending_load : 0;
+            slot = NULL;
+            jump = NULL;
+            if (stop != RV_STOP_LIMIT)
+                return stop;
+            continue;
+        }
+
+        uint64_t entry_stall = (cur->first_sources & pending) ? load_use : 0;
+        uint32_t address, at, taken;
+        const uop *u = cur->uops;
+        if (dbt != NULL) {
+            if (cur->native == NULL && ++cur->runs >= cache->threshold) {
+                cur->native = dbt_compile(dbt, cur, cpu);
+                if (cur->native == NULL) {
+                    flush(cache);   // out of code space: start over
+                    slot = NULL;
+                    continue;
+                }
+                cache->stats.compiled++;
+            }
+            if (jump != NULL && cur->native != NULL && jump_generation == cache->generation) {
+                dbt_chain(jump, cur->native);
+                cache->stats.chained++;
+            }
+            jump = NULL;
+            if (cur->native != NULL)
+                goto native;
+        }
+        cycles += entry_stall;
+        goto *u->handler;
+
+#define ALU_IMM(name, expr)                                                             \
+    op_##name : {                                                                       \
+        uint32_t a = r[u->rs1], imm = (uint32_t)u->imm;                                 \
+        r[u->rd] = (expr);                                                              \
+        NEXT();                                                                         \
+    }
+#define ALU_REG(name, expr)                                                             \
+    op_##name : {                                                                       \
+        uint32_t a = r[u->rs1], b = r[u->rs2];                                          \
+        r[u->rd] = (expr);                                                              \
+        NEXT();                                                                         \
+    }
+#define LOAD(name, width, expr)                                                         \
+    op_##name : address = r[u->rs1] + (uint32_t)u->imm;                                 \
+    at = address - base;                                                                \
+    if (at > size - (width))                                                            \
+        goto load_fault;                                                                \
+    r[u->rd] = (expr);                                                                  \
+    NEXT();
+#define STORE(name, width)                                                              \
+    op_##name : address = r[u->rs1] + (uint32_t)u->imm;                                 \
+    at = address - base;                                                                \
+    if (at > size - (width))                                                            \
+        goto store_fault;                                                               \
+    memcpy(ram + at, &r[u->rs2], (width));                                              \
+    if (store_hits_code(cache, at, (width)))                                            \
+        goto code_modified;                                                             \
+    NEXT();
+#define BRANCH(name, condition)                                                         \
+    op_##name : {                                                                       \
+        uint32_t a = r[u->rs1], b = r[u->rs2];                                          \
+        taken = (condition);                                                            \
+        goto branch;                                                                    \
+    }
+#define ADDI_BRANCH(name, condition)                                                    \
+    op_addi_##name : {                                                                  \
+        r[u->rd] = r[u->rs1] + (uint32_t)u->imm;                                        \
+        u++;                                                                            \
+        uint32_t a = r[u->rs1], b = r[u->rs2];                                          \
+        taken = (condition);                                                            \
+        goto branch;                                                                    \
+    }
+
+    op_li:
+        r[u->rd] = (uint32_t)u->imm;
+        NEXT();
+        ALU_IMM(addi, a + imm)
+        ALU_IMM(slti, (int32_t)a < (int32_t)imm)
+        ALU_IMM(sltiu, a < imm)
+        ALU_IMM(xori, a ^ imm)
+        ALU_IMM(ori, a | imm)
+        ALU_IMM(andi, a & imm)
+        ALU_IMM(slli, a << imm)
+        ALU_IMM(srli, a >> imm)
+        ALU_IMM(srai, (uint32_t)((int32_t)a >> imm))
+        ALU_REG(add, a + b)
+        ALU_REG(sub, a - b)
+        ALU_REG(sll, a << (b & 31))
+        ALU_REG(slt, (int32_t)a < (int32_t)b)
+        ALU_REG(sltu, a < b)
+        ALU_REG(xor, a ^ b)
+        ALU_REG(srl, a >> (b & 31))
+        ALU_REG(sra, (uint32_t)((int32_t)a >> (b & 31)))
+        ALU_REG(or, a | b)
+        ALU_REG(and, a & b)
+        LOAD(lb, 1, (uint32_t)(int32_t)(int8_t)ram[at])
+        LOAD(lh, 2, (uint32_t)(int32_t)(int16_t)load16(ram + at))
+        LOAD(lw, 4, load32(ram + at))
+        LOAD(lbu, 1, ram[at])
+        LOAD(lhu, 2, load16(ram + at))
+        STORE(sb, 1)
+        STORE(sh, 2)
+        STORE(sw, 4)
+    op_nop:
+        NEXT();
+        BRANCH(beq, a == b)
+        BRANCH(bne, a != b)
+        BRANCH(blt, (int32_t)a < (int32_t)b)
+        BRANCH(bge, (int32_t)a >= (int32_t)b)
+        BRANCH(bltu, a < b)
+        BRANCH(bgeu, a >= b)
+        ADDI_BRANCH(beq, a == b)
+        ADDI_BRANCH(bne, a != b)
+        ADDI_BRANCH(blt, (int32_t)a < (int32_t)b)
+        ADDI_BRANCH(bge, (int32_t)a >= (int32_t)b)
+        ADDI_BRANCH(bltu, a < b)
+        ADDI_BRANCH(bgeu, a >= b)
+
+    branch:
+        branches++;
+        if (taken) {
+            pc = (uint32_t)u->imm;
+            cycles += taken_penalty;
+            taken_branches++;
+            slot = &cur->next[1];
+        } else {
+            pc = cur->end;
+            slot = &cur->next[0];
+        }
+        goto retire;
+    op_jal:
+        r[u->rd] = cur->end;
+        pc = (uint32_t)u->imm;
+        cycles += taken_penalty;
+        slot = &cur->next[1];
+        goto retire;
+    op_jalr:
+        pc = (r[u->rs1] + (uint32_t)u->imm) & ~1u;
+        r[u->rd] = cur->end;
+        cycles += taken_penalty;
+        slot = &cur->next[2];
+        goto retire;
+    op_end:
+        pc = cur->end;
+        slot = &cur->next[0];
+    retire:
+        instret += cur->count;
+        cycles += cur->cycles;
+        loads += cur->loads;
+        stores += cur->stores;
+        pending = cur->pending_out;
+        // Straight into the next block when the top of the loop would only
+        // find it through slot and enter it
+        if (dbt == NULL && *slot != NULL && (*slot)->pc == pc &&
+            (*slot)->count <= limit - instret && stop_pc - pc >= 4 * (*slot)->count) {
+            cur = *slot;
+            entry_stall = (cur->first_sources & pending) ? load_use : 0;
+            cycles += entry_stall;
+            u = cur->uops;
+            goto *u->handler;
+        }
+        continue;
+
+    load_fault:
+        stop = RV_STOP_LOAD_FAULT;
+        goto fault;
+    store_fault:
+        stop = RV_STOP_STORE_FAULT;
+    fault:
+        // u, the faulting instruction, does not count, nor does the stall
+        // on entering the block if u is its first
+        cpu->fault_address = address;
+        if (u == cur->uops)
+            cycles -= entry_stall;
+        cycles += partial(cur, (uint32_t)(u - cur->uops), load_use, &loads, &stores);
+        instret += (uint32_t)(u - cur->uops);
+        pc = cur->pc + 4 * (uint32_t)(u - cur->uops);
+        pending = 0;
+        break;
+    code_modified:
+        // u, the store, does count; go on after it with a fresh cache
+        cycles += partial(cur, (uint32_t)(u - cur->uops) + 1, load_use, &loads, &stores);
+        instret += (uint32_t)(u - cur->uops) + 1;
+        pc = cur->pc + 4 * ((uint32_t)(u - cur->uops) + 1);
+        pending = 0;
+        slot = NULL;
+        flush(cache);
+        continue;
+
+    native:
+        context.pc = pc;
+        context.pending = pending;
+        context.ram = ram;
+        context.code = cache->code;
+        context.budget = limit - instret;
+        context.cycles = cycles;
+        context.loads = loads;
+        context.stores = stores;
+        context.branches = branches;
+        context.taken_branches = taken_branches;
+        enum dbt_exit exit = dbt_run(dbt, &context, cur->native);
+        instret = limit - context.budget;
+        cycles = context.cycles;
+        loads = context.loads;
+        stores = context.stores;
+        branches = context.branches;
+        taken_branches = context.taken_branches;
+        pending = context.pending;
+        pc = context.pc;
+        slot = NULL;
+        if (exit == DBT_EXIT_NEXT) {
+            jump = context.jump;
+            jump_generation = cache->generation;
+            continue;
+        }
+        // Finish the block it stopped in as the micro-ops would have
+        cur = (block *)context.block;
+        u = &cur->uops[context.index];
+        address = context.fault_address;
+        entry_stall = (cur->first_sources & pending) ? load_use : 0;
+        cycles += entry_stall;
+        if (exit == DBT_EXIT_LOAD_FAULT)
+            goto load_fault;
+        if (exit == DBT_EXIT_STORE_FAULT)
+            goto store_fault;
+        goto code_modified;
+    }
+    SYNC_OUT();
+    return stop;
+
+#undef NEXT
+#undef SYNC_OUT
+#undef ALU_IMM
+#undef ALU_REG
+#undef LOAD
+#undef STORE
+#undef BRANCH
+#undef ADDI_BRANCH
+}
@@ -0,0 +1,85 @@
+/*
+ * block.h - Pre-decoded basic block cache for the rv32i simulator
+ *
+ * Each basic block is decoded once, the first time the pc reaches it,
+ * into an array of micro-ops. Every micro-op holds the address of the
+ * code that runs it (direct-threaded dispatch), with its registers and
+ * immediate already extracted. Blocks end at a branch or jump, before
+ * anything the block engine does not run itself (ecall/ebreak, CSR reads,
+ * illegal words, `j .`), or after BLOCK_MAX_UOPS instructions. Those
+ * single instructions go through rv_run_decode.
+ *
+ * Blocks remember their successors, so a loop goes from block to block
+ * without a table lookup.
+ *
+ * A store into a word that some block was decoded from (self-modifying
+ * code, or rv_cpu_write over the program) drops the whole cache. If the
+ * store was inside the running block, the run goes on at the instruction
+ * after the store.
+ *
+ * With rv_cpu_enable_dbt, blocks that keep running are also compiled to
+ * x86-64 (dbt.h) from the same micro-ops; the types below are shared with
+ * that.
+ */
+
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+#define BLOCK_MAX_UOPS 64
+#define X_SINK 32                   // where writes to x0 go
+
+enum uop_kind {
+    UOP_LI, UOP_ADDI, UOP_SLTI, UOP_SLTIU, UOP_XORI, UOP_ORI, UOP_ANDI,
+    UOP_SLLI, UOP_SRLI, UOP_SRAI,
+    UOP_ADD, UOP_SUB, UOP_SLL, UOP_SLT, UOP_SLTU, UOP_XOR, UOP_SRL, UOP_SRA, UOP_OR, UOP_AND,
+    UOP_LB, UOP_LH, UOP_LW, UOP_LBU, UOP_LHU,
+    UOP_SB, UOP_SH, UOP_SW,
+    UOP_NOP,
+    // these end a block
+    UOP_BEQ, UOP_BNE, UOP_BLT, UOP_BGE, UOP_BLTU, UOP_BGEU,
+    UOP_JAL, UOP_JALR,
+    UOP_END,                    // no instruction: the block was cut short
+    UOP_COUNT
+};
+
+typedef struct {
+    const void *handler;
+    int32_t imm;                // immediate, shift amount, or branch/jal target
+    uint8_t kind, rd, rs1, rs2; // rd is X_SINK for x0
+    uint8_t stall;              // reads the register the load before it wrote
+} uop;
+
+typedef struct block {
+    uint32_t pc, end;           // guest code [pc, end)
+    uint32_t count;             // instructions
+    uint32_t cycles;            // count + stalls inside the block
+    uint32_t loads, stores, branches;
+    uint32_t first_sources;     // registers the first instruction reads
+    uint32_t pending_out;       // 1 << rd if the last instruction is a load
+    uint32_t runs;              // times entered, counted while native is NULL
+    struct block *next[3];      // successors: fall-through, taken, last jalr target
+    const void *native;         // its x86-64 code, once compiled
+    uop *uops;
+} block;
+
+enum rv_stop rv_run_blocks(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc);
+
+// RAM bytes [offset, offset + size) were written
+void rv_blocks_stored(struct rv_blocks *blocks, uint32_t offset, size_t size);
+void rv_blocks_free(struct rv_blocks *blocks);
+
+typedef struct {
+    uint64_t translations;      // blocks decoded
+    uint64_t flushes;           // whole-cache drops: code was written, or the cache filled up
+    uint64_t compiled;          // blocks translated to x86-64
+    uint64_t chained;           // exits from x86-64 code linked straight to the next block
+} rv_blocks_stats;
+
+rv_blocks_stats rv_blocks_get_stats(const struct rv_blocks *blocks);
+
+#endif
@@ -0,0 +1,616 @@
+/*
+ * cfg.c - Control-flow graph, loops and their static cost (see cfg.h)
+ *
+ * 1. Recursive traversal from the entry point marks the words that are
+ *    code and where blocks start (branch and jump targets, the word after
+ *    a branch, labels). Data next to the code is never reached, so it is
+ *    never decoded as instructions.
+ * 2. Blocks run from a start to the next control transfer or start.
+ *    Their edges stay inside one function: a call's edge goes to the
+ *    instruction after it, and the callee is a root of its own.
+ * 3. A depth-first walk from the roots marks the back edges (to a block
+ *    still on the walk's stack) and gives a reverse postorder, which
+ *    orders every block after the ones that lead to it once the back
+ *    edges are left out.
+ * 4. Each header's loop is itself and every block that reaches one of
+ *    its back edges without passing through it. The most and fewest
+ *    cycles from the header to a back edge come from one pass over the
+ *    body in reverse postorder.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "disasm.h"
+#include "rv32.h"
+
+const char *const rv_class_names[RV_CLASS_COUNT] = {
+    "alu", "mul", "div", "load", "store", "branch", "jump", "system", "vector", "other",
+};
+
+#define INSN_MRET 0x30200073u
+
+#define WORD_REACHED 1
+#define WORD_LEADER 2
+
+typedef struct {
+    uint32_t start, end;        // [start, end)
+    int succ[2];                // -1 for none
+    int back[2];                // whether that edge closes a loop
+    int call;                   // the block a jal at the end calls, or -1
+    int *preds;
+    size_t pred_count;
+    size_t rpo;                 // reverse postorder position; SIZE_MAX if never reached
+} block;
+
+typedef struct {
+    const rv_cpu *cpu;
+    const rv_image *image;
+    const rv_cost_model *model;
+    uint32_t low, high;         // the code's address range
+    uint8_t *words;             // WORD_* per word in [low, high)
+    block *blocks;
+    size_t block_count;
+} graph;
+
+static int fail(char *error, size_t error_size, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+    return 0;
+}
+
+enum rv_class rv_classify(uint32_t insn) {
+    uint32_t opcode = rv_opcode(insn);
+    if (opcode == RV_OP_LOAD_FP || opcode == RV_OP_STORE_FP || opcode == RV_OP_V)
+        return RV_CLASS_VECTOR;
+    if (!rv_decodes(insn))
+        return RV_CLASS_OTHER;
+    switch (opcode) {
+    case RV_OP_LOAD: return RV_CLASS_LOAD;
+    case RV_OP_STORE: return RV_CLASS_STORE;
+    case RV_OP_BRANCH: return RV_CLASS_BRANCH;
+    case RV_OP_JAL:
+    case RV_OP_JALR: return RV_CLASS_JUMP;
+    case RV_OP_SYSTEM:
+    case RV_OP_MISC_MEM: return RV_CLASS_SYSTEM;
+    case RV_OP_REG:
+        if (rv_funct7(insn) == 1)
+            return rv_funct3(insn) < 4 ? RV_CLASS_MUL : RV_CLASS_DIV;
+        return RV_CLASS_ALU;
+    default: return RV_CLASS_ALU;
+    }
+}
+
+static uint32_t fetch(const graph *g, uint32_t address) {
+    uint32_t insn = 0;
+    rv_cpu_read(g->cpu, address, &insn, 4);
+    return insn;
+}
+
+static int in_code(const graph *g, uint32_t address) {
+    if (address < g->low || address >= g->high || (address & 3))
+        return 0;
+    for (size_t s = 0; s < g->image->segment_count; s++) {
+        const rv_segment *segment = &g->image->segments[s];
+        if ((segment->flags & RV_SEGMENT_EXECUTE) && address - segment->address < segment->size)
+            return 1;
+    }
+    return 0;
+}
+
+// Where control can go after insn at pc, inside the function: up to two
+// addresses, the fall-through first. *call gets the callee of a jal, or
+// of the auipc/jalr pair a call to a far label (or an unrelaxed one)
+// assembles to; prev is the instruction before insn.
+static int successors(uint32_t insn, uint32_t prev, uint32_t pc, uint32_t *next,
+                      uint32_t *call) {
+    enum rv_class class = rv_classify(insn);
+    *call = 0;
+    if (class == RV_CLASS_OTHER || insn == RV_INSN_J_SELF || insn == RV_INSN_ECALL ||
+        insn == RV_INSN_EBREAK || insn == INSN_MRET)
+        return 0;
+    if (class == RV_CLASS_BRANCH) {
+        next[0] = pc + 4;
+        next[1] = pc + (uint32_t)rv_imm_b(insn);
+        return next[1] == next[0] ? 1 : 2;
+    }
+    if (rv_opcode(insn) == RV_OP_JAL) {
+        if (rv_rd(insn) == 0) {
+            next[0] = pc + (uint32_t)rv_imm_j(insn);
+            return 1;
+        }
+        *call = pc + (uint32_t)rv_imm_j(insn);
+        next[0] = pc + 4;
+        return 1;
+    }
+    if (rv_opcode(insn) == RV_OP_JALR) {
+        uint32_t target = 0;
+        if (rv_opcode(prev) == RV_OP_AUIPC && rv_rd(prev) != 0 && rv_rd(prev) == rv_rs1(insn))
+            target = (pc - 4 + (uint32_t)rv_imm_u(prev) + (uint32_t)rv_imm_i(insn)) & ~1u;
+        if (rv_rd(insn) == 0) {
+            // a tail call goes on there; a return or an indirect jump
+            // goes nowhere we can follow
+            next[0] = target;
+            return target != 0;
+        }
+        // a call comes back
+        *call = target;
+        next[0] = pc + 4;
+        return 1;
+    }
+    next[0] = pc + 4;
+    return 1;
+}
+
+static int ends_block(uint32_t insn) {
+    enum rv_class class = rv_classify(insn);
+    return class == RV_CLASS_BRANCH || class == RV_CLASS_JUMP || class == RV_CLASS_OTHER ||
+           insn == RV_INSN_ECALL || insn == RV_INSN_EBREAK || insn == INSN_MRET;
+}
+
+static size_t word_index(const graph *g, uint32_t address) { return (address - g->low) / 4; }
+
+// Step 1: mark the code reachable from the entry and the block starts
+static int trace(graph *g) {
+    size_t capacity = 1024, count = 0;
+    uint32_t *work = malloc(capacity * sizeof(uint32_t));
+    if (work == NULL)
+        return 0;
+    work[count++] = g->image->entry;
+    while (count > 0) {
+        uint32_t pc = work[--count];
+        if (!in_code(g, pc))
+            continue;
+        g->words[word_index(g, pc)] |= WORD_LEADER;
+        for (; in_code(g, pc) && !(g->words[word_index(g, pc)] & WORD_REACHED); pc += 4) {
+            g->words[word_index(g, pc)] |= WORD_REACHED;
+            uint32_t insn = fetch(g, pc), next[2], call;
+            if (!ends_block(insn))
+                continue;
+            int n = successors(insn, fetch(g, pc - 4), pc, next, &call);
+            if (count + 3 > capacity) {
+                uint32_t *bigger = realloc(work, 2 * capacity * sizeof(uint32_t));
+                if (bigger == NULL) {
+                    free(work);
+                    return 0;
+                }
+                work = bigger;
+                capacity *= 2;
+            }
+            for (int i = 0; i < n; i++)
+                work[count++] = next[i];
+            if (call != 0)
+                work[count++] = call;
+            break;
+        }
+        // Running into code traced before means reaching the start of
+        // that trace, which is already a leader
+    }
+    free(work);
+    for (size_t i = 0; i < g->image->symbol_count; i++) {
+        uint32_t address = g->image->symbols[i].address;
+        if (in_code(g, address))
+            g->words[word_index(g, address)] |= WORD_LEADER;
+    }
+    return 1;
+}
+
+static int block_at(const graph *g, uint32_t address) {
+    size_t lo = 0, hi = g->block_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (g->blocks[mid].start == address)
+            return (int)mid;
+        if (g->blocks[mid].start < address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return -1;
+}
+
+// Step 2: the blocks, their edges and their predecessors
+static int split(graph *g) {
+    size_t words = word_index(g, g->high), capacity = 256;
+    g->blocks = malloc(capacity * sizeof(block));
+    if (g->blocks == NULL)
+        return 0;
+    for (size_t i = 0; i < words;) {
+        if (!(g->words[i] & WORD_REACHED)) {
+            i++;
+            continue;
+        }
+        if (g->block_count == capacity) {
+            block *bigger = realloc(g->blocks, 2 * capacity * sizeof(block));
+            if (bigger == NULL)
+                return 0;
+            g->blocks = bigger;
+            capacity *= 2;
+        }
+        block *b = &g->blocks[g->block_count++];
+        memset(b, 0, sizeof(*b));
+        b->start = g->low + 4 * (uint32_t)i;
+        do
+            i++;
+        while (i < words && (g->words[i] & WORD_REACHED) && !(g->words[i] & WORD_LEADER) &&
+               !ends_block(fetch(g, g->low + 4 * (uint32_t)i - 4)));
+        b->end = g->low + 4 * (uint32_t)i;
+        b->rpo = SIZE_MAX;
+    }
+
+    size_t *pred_counts = calloc(g->block_count + 1, sizeof(size_t));
+    if (pred_counts == NULL)
+        return 0;
+    for (size_t i = 0; i < g->block_count; i++) {
+        block *b = &g->blocks[i];
+        uint32_t last = b->end - 4, insn = fetch(g, last), next[2], call;
+        int n = ends_block(insn) ? successors(insn, fetch(g, last - 4), last, next, &call) : 1;
+        if (!ends_block(insn)) {
+            next[0] = b->end;
+            call = 0;
+        }
+        b->succ[0] = b->succ[1] = b->call = -1;
+        for (int k = 0; k < n; k++) {
+            b->succ[k] = block_at(g, next[k]);
+            if (b->succ[k] >= 0)
+                pred_counts[b->succ[k]]++;
+        }
+        if (call != 0)
+            b->call = block_at(g, call);
+    }
+    for (size_t i = 0; i < g->block_count; i++) {
+        g->blocks[i].preds = malloc((pred_counts[i] ? pred_counts[i] : 1) * sizeof(int));
+        if (g->blocks[i].preds == NULL) {
+            free(pred_counts);
+            return 0;
+        }
+    }
+    free(pred_counts);
+    for (size_t i = 0; i < g->block_count; i++)
+        for (int k = 0; k < 2; k++)
+            if (g->blocks[i].succ[k] >= 0) {
+                block *s = &g->blocks[g->blocks[i].succ[k]];
+                s->preds[s->pred_count++] = (int)i;
+            }
+    return 1;
+}
+
+// Step 3: back edges and reverse postorder, from the entry and then
+// from every callee
+static int walk(graph *g) {
+    size_t n = g->block_count, done = 0;
+    int *stack = malloc((n + 1) * sizeof(int)), *next_edge = calloc(n + 1, sizeof(int));
+    uint8_t *state = calloc(n + 1, 1);     // 0 unseen, 1 on the stack, 2 finished
+    if (stack == NULL || next_edge == NULL || state == NULL) {
+        free(stack);
+        free(next_edge);
+        free(state);
+        return 0;
+    }
+    for (size_t r = 0; r <= n; r++) {
+        int root = r == 0 ? block_at(g, g->image->entry) : g->blocks[r - 1].call;
+        if (root < 0 || state[root] != 0)
+            continue;
+        size_t depth = 0;
+        stack[depth++] = root;
+        state[root] = 1;
+        while (depth > 0) {
+            int b = stack[depth - 1];
+            if (next_edge[b] == 2) {
+                state[b] = 2;
+                g->blocks[b].rpo = n - 1 - done++;  // postorder, counted from the back
+                depth--;
+                continue;
+            }
+            int k = next_edge[b]++, s = g->blocks[b].succ[k];
+            if (s < 0)
+                continue;
+            if (state[s] == 1)
+                g->blocks[b].back[k] = 1;
+            else if (state[s] == 0) {
+                state[s] = 1;
+                stack[depth++] = s;
+            }
+        }
+    }
+    free(stack);
+    free(next_edge);
+    free(state);
+    return 1;
+}
+
+// The cycles and counts for running block b, the instruction before it
+// having been prev (0 for none), added to path
+static void run_block(const graph *g, const block *b, uint32_t prev, rv_path *path) {
+    const rv_cost_model *m = g->model;
+    uint32_t pending = rv_opcode(prev) == RV_OP_LOAD ? rv_rd(prev) : 0;
+    for (uint32_t pc = b->start; pc < b->end; pc += 4) {
+        uint32_t insn = fetch(g, pc);
+        enum rv_class class = rv_classify(insn);
+        path->instructions++;
+        path->cycles++;
+        path->mix[class]++;
+        if (pending != 0 && (rv_sources(insn) >> pending & 1)) {
+            path->cycles += m->timing.load_use;
+            path->load_use_stalls++;
+        }
+        pending = rv_opcode(insn) == RV_OP_LOAD ? rv_rd(insn) : 0;
+        if (class == RV_CLASS_MUL)
+            path->cycles += m->mul;
+        else if (class == RV_CLASS_DIV)
+            path->cycles += m->div;
+        if (class == RV_CLASS_JUMP && rv_rd(insn) != 0)
+            path->calls++;
+    }
+}
+
+// Taken-branch cycles for going from block a to block b
+static int taken(const graph *g, const block *a, const block *b) {
+    uint32_t insn = fetch(g, a->end - 4);
+    enum rv_class class = rv_classify(insn);
+    if (class == RV_CLASS_JUMP)
+        return 1;
+    return class == RV_CLASS_BRANCH && b->start != a->end;
+}
+
+static uint64_t edge_cycles(const graph *g, const block *a, const block *b) {
+    rv_path step = {0};
+    run_block(g, b, fetch(g, a->end - 4), &step);
+    return step.cycles + (taken(g, a, b) ? g->model->timing.taken_branch : 0);
+}
+
+static const graph *sorting;    // for by_rpo, which qsort gives no context
+
+static int by_rpo(const void *a, const void *b) {
+    size_t x = sorting->blocks[*(const int *)a].rpo, y = sorting->blocks[*(const int *)b].rpo;
+    return x < y ? -1 : x > y;
+}
+
+// Fill in path from the blocks its walk went through, latch last
+static int make_path(const graph *g, const int *order, size_t count, rv_path *path) {
+    memset(path, 0, sizeof(*path));
+    path->blocks = malloc(count * sizeof(rv_span));
+    if (path->blocks == NULL)
+        return 0;
+    path->block_count = count;
+    const block *latch = &g->blocks[order[count - 1]];
+    uint32_t prev = fetch(g, latch->end - 4);   // round the back edge
+    for (size_t i = 0; i < count; i++) {
+        const block *b = &g->blocks[order[i]];
+        const block *next = &g->blocks[order[(i + 1) % count]];
+        path->blocks[i] = (rv_span){b->start, b->end};
+        run_block(g, b, prev, path);
+        if (taken(g, b, next)) {
+            path->taken++;
+            path->cycles += g->model->timing.taken_branch;
+        }
+        prev = fetch(g, b->end - 4);
+    }
+    return 1;
+}
+
+typedef struct {
+    uint64_t cycles;
+    int from;                   // the block before on this way round, -1 at the header
+} reach;
+
+// The blocks from the header to latch, following from
+static size_t trace_back(const reach *r, int latch, int *order, size_t limit) {
+    size_t count = 0;
+    for (int b = latch; b >= 0 && count < limit; b = r[b].from)
+        order[count++] = b;
+    for (size_t i = 0; i < count / 2; i++) {
+        int t = order[i];
+        order[i] = order[count - 1 - i];
+        order[count - 1 - i] = t;
+    }
+    return count;
+}
+
+// Step 4 for the loop at header h: body holds its blocks
+static int cost_loop(const graph *g, int h, const int *body, size_t body_count,
+                     const int *member, int id, rv_loop *loop) {
+    size_t n = g->block_count;
+    reach *longest = malloc(n * sizeof(reach)), *shortest = malloc(n * sizeof(reach));
+    int *order = malloc(body_count * sizeof(int));
+    if (longest == NULL || shortest == NULL || order == NULL) {
+        free(longest);
+        free(shortest);
+        free(order);
+        return 0;
+    }
+    for (size_t i = 0; i < body_count; i++) {
+        longest[body[i]] = (reach){0, -2};          // -2: not reached this way
+        shortest[body[i]] = (reach){UINT64_MAX, -2};
+    }
+    rv_path first = {0};
+    run_block(g, &g->blocks[h], 0, &first);
+    longest[h] = (reach){first.cycles, -1};
+    shortest[h] = (reach){first.cycles, -1};
+
+    int best_long = -1, best_short = -1;
+    uint64_t long_total = 0, short_total = UINT64_MAX;
+    for (size_t i = 0; i < body_count; i++) {        // body is in reverse postorder
+        int a = body[i];
+        if (longest[a].from == -2)
+            continue;
+        const block *ba = &g->blocks[a];
+        for (int k = 0; k < 2; k++) {
+            int s = ba->succ[k];
+            if (s < 0 || member[s] != id)
+                continue;
+            uint64_t step = edge_cycles(g, ba, &g->blocks[s]);
+            if (s == h && ba->back[k]) {
+                // round to the next iteration: charge the header's first
+                // instruction for following this latch, not nothing
+                uint64_t total_long = longest[a].cycles + step - first.cycles;
+                uint64_t total_short = shortest[a].cycles + step - first.cycles;
+                if (best_long < 0 || total_long > long_total) {
+                    best_long = a;
+                    long_total = total_long;
+                }
+                if (best_short < 0 || total_short < short_total) {
+                    best_short = a;
+                    short_total = total_short;
+                }
+                continue;
+            }
+            if (ba->back[k])
+                continue;       // an inner loop's back edge: one pass through it
+            if (longest[s].from == -2 || longest[a].cycles + step > longest[s].cycles)
+                longest[s] = (reach){longest[a].cycles + step, a};
+            if (shortest[s].from == -2 || shortest[a].cycles + step < shortest[s].cycles)
+                shortest[s] = (reach){shortest[a].cycles + step, a};
+        }
+    }
+    int ok = best_long >= 0;
+    if (ok) {
+        loop->latch = g->blocks[best_long].end - 4;
+        size_t count = trace_back(longest, best_long, order, body_count);
+        ok = make_path(g, order, count, &loop->longest);
+        count = trace_back(shortest, best_short, order, body_count);
+        ok = ok && make_path(g, order, count, &loop->shortest);
+    }
+    free(longest);
+    free(shortest);
+    free(order);
+    return ok;
+}
+
+// The loops of g, in header order
+static int find_loops(graph *g, rv_loop **loops, size_t *count) {
+    size_t n = g->block_count, capacity = 16;
+    int *member = malloc((n + 1) * sizeof(int)), *body = malloc((n + 1) * sizeof(int));
+    int *work = malloc((n + 1) * sizeof(int));
+    int **bodies = malloc(capacity * sizeof(int *));
+    size_t *body_counts = malloc(capacity * sizeof(size_t));
+    *loops = malloc(capacity * sizeof(rv_loop));
+    int ok = member && body && work && bodies && body_counts && *loops;
+    for (size_t i = 0; ok && i < n; i++)
+        member[i] = -1;
+    for (size_t h = 0; ok && h < n; h++) {
+        // the back edges into h, and everything that reaches them
+        size_t body_count = 0, pending = 0;
+        int id = (int)*count;
+        for (size_t p = 0; p < g->blocks[h].pred_count; p++) {
+            int t = g->blocks[h].preds[p];
+            const block *bt = &g->blocks[t];
+            if ((bt->succ[0] == (int)h && bt->back[0]) || (bt->succ[1] == (int)h && bt->back[1]))
+                work[pending++] = t;
+        }
+        if (pending == 0)
+            continue;
+        member[h] = id;
+        body[body_count++] = (int)h;
+        while (pending > 0) {
+            int b = work[--pending];
+            if (member[b] == id)
+                continue;
+            member[b] = id;
+            body[body_count++] = b;
+            for (size_t p = 0; p < g->blocks[b].pred_count; p++) {
+                int pred = g->blocks[b].preds[p];
+                if (member[pred] != id && g->blocks[pred].rpo != SIZE_MAX)
+                    work[pending++] = pred;
+            }
+        }
+        sorting = g;
+        qsort(body, body_count, sizeof(int), by_rpo);
+
+        if (*count == capacity) {
+            capacity *= 2;
+            rv_loop *more = realloc(*loops, capacity * sizeof(rv_loop));
+            int **more_bodies = realloc(bodies, capacity * sizeof(int *));
+            size_t *more_counts = realloc(body_counts, capacity * sizeof(size_t));
+            if (more)
+                *loops = more;
+            if (more_bodies)
+                bodies = more_bodies;
+            if (more_counts)
+                body_counts = more_counts;
+            if (!more || !more_bodies || !more_counts) {
+                ok = 0;
+                break;
+            }
+        }
+        rv_loop *loop = &(*loops)[*count];
+        memset(loop, 0, sizeof(*loop));
+        loop->header = g->blocks[h].start;
+        loop->body_blocks = body_count;
+        for (size_t i = 0; i < body_count; i++)
+            loop->body_instructions += (g->blocks[body[i]].end - g->blocks[body[i]].start) / 4;
+        bodies[*count] = malloc(body_count * sizeof(int));
+        if (bodies[*count] == NULL) {
+            ok = 0;
+            break;
+        }
+        memcpy(bodies[*count], body, body_count * sizeof(int));
+        body_counts[*count] = body_count;
+        (*count)++;
+        ok = cost_loop(g, (int)h, body, body_count, member, id, loop);
+    }
+
+    // A loop is as deep as the number of loops whose bodies hold its header
+    for (size_t i = 0; ok && i < *count; i++) {
+        (*loops)[i].depth = 1;
+        for (size_t j = 0; j < *count; j++) {
+            if (i == j)
+                continue;
+            for (size_t k = 0; k < body_counts[j]; k++)
+                if (g->blocks[bodies[j][k]].start == (*loops)[i].header) {
+                    (*loops)[i].depth++;
+                    break;
+                }
+        }
+    }
+    for (size_t i = 0; bodies && i < *count; i++)
+        free(bodies[i]);
+    free(bodies);
+    free(body_counts);
+    free(member);
+    free(body);
+    free(work);
+    return ok;
+}
+
+int rv_find_loops(const rv_cpu *cpu, const rv_image *image, const rv_cost_model *model,
+                  rv_loop **loops, size_t *count, char *error, size_t error_size) {
+    graph g = {cpu, image, model, UINT32_MAX, 0, NULL, NULL, 0};
+    *loops = NULL;
+    *count = 0;
+    for (size_t s = 0; s < image->segment_count; s++) {
+        const rv_segment *segment = &image->segments[s];
+        if (!(segment->flags & RV_SEGMENT_EXECUTE) || segment->size < 4)
+            continue;
+        if (segment->address < g.low)
+            g.low = segment->address & ~3u;
+        if (segment->address + segment->size > g.high)
+            g.high = (segment->address + segment->size) & ~3u;
+    }
+    if (g.low >= g.high)
+        return fail(error, error_size, "no executable segment");
+    if (!in_code(&g, image->entry))
+        return fail(error, error_size, "the entry point 0x%08x is not in the code", image->entry);
+    g.words = calloc(word_index(&g, g.high) + 1, 1);
+    int ok = g.words != NULL && trace(&g) && split(&g) && walk(&g) && find_loops(&g, loops, count);
+    for (size_t i = 0; g.blocks && i < g.block_count; i++)
+        free(g.blocks[i].preds);
+    free(g.blocks);
+    free(g.words);
+    if (!ok)
+        return fail(error, error_size, "out of memory");
+    return 1;
+}
+
+void rv_loops_free(rv_loop *loops, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(loops[i].longest.blocks);
+        free(loops[i].shortest.blocks);
+    }
+    free(loops);
+}
@@ -0,0 +1,91 @@
+/*
+ * cfg.h - Loops and their cost per iteration, without running anything
+ *
+ * rv_find_loops follows the code of a loaded ELF from its entry point
+ * into basic blocks, finds the loops (a branch or jump back to a block
+ * that leads to it: loop:/j loop, bnez s3, _add_two_five_times, and the
+ * loops nested in them) and walks each one's iteration from its header
+ * back round to it. The cycles are sim.h's in-order model applied to
+ * that walk, with its rv_timing penalties:
+ *
+ *  - one cycle per instruction, plus mul or div extra for M instructions
+ *  - load_use when an instruction reads the register the load before it
+ *    wrote, including round the back edge into the next iteration
+ *  - taken_branch for every branch that goes to its target and every
+ *    jump, call and return
+ *
+ * so for straight-line loop bodies it comes to what rvsim counts per
+ * iteration. A loop with branches inside has several ways round; the
+ * most and the fewest cycles are both reported. Calls are charged for
+ * the jump only (the callee's own loops are listed separately), an inner
+ * loop is charged for one pass through its body, and vector instructions
+ * cost a cycle each, whatever vl.
+ */
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elf32.h"
+#include "sim.h"
+
+typedef struct {
+    rv_timing timing;
+    unsigned mul;               // extra cycles for mul, mulh, mulhsu, mulhu
+    unsigned div;               // and for div, divu, rem, remu
+} rv_cost_model;
+
+#define RV_COST_MODEL_DEFAULT {RV_TIMING_DEFAULT, 2, 32}
+
+enum rv_class {
+    RV_CLASS_ALU,               // OP, OP-IMM, lui, auipc
+    RV_CLASS_MUL,
+    RV_CLASS_DIV,
+    RV_CLASS_LOAD,
+    RV_CLASS_STORE,
+    RV_CLASS_BRANCH,
+    RV_CLASS_JUMP,              // jal, jalr
+    RV_CLASS_SYSTEM,            // CSRs, fence, ecall, ...
+    RV_CLASS_VECTOR,
+    RV_CLASS_OTHER,             // anything that does not decode
+    RV_CLASS_COUNT,
+};
+
+extern const char *const rv_class_names[RV_CLASS_COUNT];
+
+typedef struct {
+    uint32_t start, end;        // [start, end)
+} rv_span;
+
+// One way round a loop, from its header back to it
+typedef struct {
+    uint64_t instructions, cycles;
+    unsigned mix[RV_CLASS_COUNT];
+    unsigned load_use_stalls;   // instructions that waited for a load
+    unsigned taken;             // branches taken and jumps
+    unsigned calls;             // jal/jalr with a link register: callee not counted
+    rv_span *blocks;            // the basic blocks it goes through, in order
+    size_t block_count;
+} rv_path;
+
+typedef struct {
+    uint32_t header;            // the first instruction of every iteration
+    uint32_t latch;             // the branch or jump back to it, on the longest way round
+    unsigned depth;             // 1 for an outermost loop
+    size_t body_blocks;
+    uint64_t body_instructions; // in all of the body, every way round
+    rv_path longest, shortest;  // by cycles
+} rv_loop;
+
+// The loops in the code cpu holds, reachable from image->entry, ordered
+// by header address. 0 on failure, with a message in error; free the
+// loops with rv_loops_free either way.
+int rv_find_loops(const rv_cpu *cpu, const rv_image *image, const rv_cost_model *model,
+                  rv_loop **loops, size_t *count, char *error, size_t error_size);
+void rv_loops_free(rv_loop *loops, size_t count);
+
+enum rv_class rv_classify(uint32_t insn);
+
+#endif
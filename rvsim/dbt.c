@@ -0,0 +1,616 @@
+/*
+ * dbt.c - rv32i blocks to x86-64 (see dbt.h)
+ *
+ * Translated code runs with fixed host registers: rbx points at the
+ * dbt_context (so guest register n is at [rbx + 4n]), r12 at guest RAM,
+ * r13 at the decoded-code bitmap, r14 holds the instructions left and
+ * r15 the cycle count. Up to seven guest registers per block live in
+ * rsi, rdi, rbp and r8-r11; rax, rcx and rdx are scratch. dbt_run enters
+ * through a small trampoline at the start of the code buffer that saves
+ * the C callee-saved registers and loads the fixed ones, and every exit
+ * jumps back to its second half.
+ *
+ * Every instruction is emitted the simple way: operands into eax/edx (a
+ * register move when the guest register is cached), one x86 operation,
+ * the result back out. Loads and stores check the address against the
+ * RAM size with one compare; stores then test the decoded-code bitmap.
+ * The rare paths (faults, code writes, exits not yet chained) are stubs
+ * after the block's main line.
+ *
+ * A block's counters are added at its end, like the block engine's. On a
+ * fault or code write the context still holds the entry state, so the
+ * engine can count the instructions before it itself.
+ */
+
+#include <string.h>
+
+#include "dbt.h"
+
+#if defined(__x86_64__)
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#define DBT_CODE_SIZE (8u << 20)
+#define DBT_BLOCK_ROOM (32u << 10)  // more than any one block's code
+
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+#define CTX RBX
+#define RAM R12
+#define CODE R13
+#define BUDGET R14
+#define CYCLES R15
+
+static const int cache_regs[] = {RSI, RDI, R8, R9, R10, R11, RBP};
+#define CACHE_REGS (int)(sizeof(cache_regs) / sizeof(cache_regs[0]))
+
+// ModRM /digit of the 0x81 (imm32) and 0xC1/0xD3 (shift) groups
+enum { ALU_ADD = 0, ALU_OR = 1, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7 };
+enum { SHIFT_SHL = 4, SHIFT_SHR = 5, SHIFT_SAR = 7 };
+enum { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_A = 0x7, CC_L = 0xC, CC_GE = 0xD };
+
+#define CONTEXT(field) (int32_t)offsetof(dbt_context, field)
+
+struct rv_dbt {
+    uint8_t *code;
+    size_t used;                // bytes of code, the trampoline included
+    size_t trampoline;          // its size
+    const uint8_t *leave;       // where exits jump to, with eax = enum dbt_exit
+};
+
+typedef struct {
+    uint8_t *p, *end;
+} emitter;
+
+static void byte(emitter *e, uint32_t v) {
+    if (e->p < e->end)
+        *e->p++ = (uint8_t)v;
+}
+
+static void word32(emitter *e, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        byte(e, v >> 8 * i);
+}
+
+static void word64(emitter *e, uint64_t v) {
+    word32(e, (uint32_t)v);
+    word32(e, (uint32_t)(v >> 32));
+}
+
+static void rex(emitter *e, int w, int reg, int index, int base) {
+    uint32_t v = 0x40 | w << 3 | (reg >> 3) << 2 | (index >> 3) << 1 | base >> 3;
+    if (v != 0x40)
+        byte(e, v);
+}
+
+static void opcode(emitter *e, uint32_t op) {
+    if (op > 0xFF)
+        byte(e, op >> 8);
+    byte(e, op);
+}
+
+// op reg, rm (registers)
+static void op_reg(emitter *e, int w, uint32_t op, int reg, int rm) {
+    rex(e, w, reg, 0, rm);
+    opcode(e, op);
+    byte(e, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+// op reg, [base + disp]
+static void op_mem(emitter *e, int w, uint32_t op, int reg, int base, int32_t disp) {
+    rex(e, w, reg, 0, base);
+    opcode(e, op);
+    int mod = disp == 0 && (base & 7) != RBP ? 0 : disp >= -128 && disp <= 127 ? 1 : 2;
+    byte(e, (uint32_t)mod << 6 | (reg & 7) << 3 | (base & 7));
+    if ((base & 7) == RSP)
+        byte(e, 0x24);
+    if (mod == 1)
+        byte(e, (uint32_t)disp);
+    else if (mod == 2)
+        word32(e, (uint32_t)disp);
+}
+
+// op reg, [base + index], base not rbp/r13
+static void op_index(emitter *e, int w, uint32_t op, int reg, int base, int index) {
+    rex(e, w, reg, index, base);
+    opcode(e, op);
+    byte(e, 0x04 | (reg & 7) << 3);
+    byte(e, (index & 7) << 3 | (base & 7));
+}
+
+static void alu_imm(emitter *e, int w, int digit, int rm, uint32_t imm) {
+    op_reg(e, w, 0x81, digit, rm);
+    word32(e, imm);
+}
+
+static void alu_imm_mem(emitter *e, int w, int digit, int base, int32_t disp, uint32_t imm) {
+    op_mem(e, w, 0x81, digit, base, disp);
+    word32(e, imm);
+}
+
+static void mov_imm(emitter *e, int reg, uint32_t imm) {
+    rex(e, 0, 0, 0, reg);
+    byte(e, 0xB8 + (reg & 7));
+    word32(e, imm);
+}
+
+static void mov_imm64(emitter *e, int reg, uint64_t imm) {
+    rex(e, 1, 0, 0, reg);
+    byte(e, 0xB8 + (reg & 7));
+    word64(e, imm);
+}
+
+static void store_imm(emitter *e, int w, int32_t disp, uint32_t imm) {
+    op_mem(e, w, 0xC7, 0, CTX, disp);
+    word32(e, imm);
+}
+
+// A rel32 jump (cc < 0) or jcc; returns its offset field
+static uint8_t *jump(emitter *e, int cc) {
+    if (cc < 0) {
+        byte(e, 0xE9);
+    } else {
+        byte(e, 0x0F);
+        byte(e, 0x80 + (uint32_t)cc);
+    }
+    uint8_t *field = e->p;
+    word32(e, 0);
+    return field;
+}
+
+static void set_target(uint8_t *field, const uint8_t *target) {
+    int32_t rel = (int32_t)(target - (field + 4));
+    memcpy(field, &rel, 4);
+}
+
+// --- guest registers --------------------------------------------------
+
+typedef struct {
+    int8_t host[33];            // host register holding guest register n, or -1
+    uint32_t written;           // cached guest registers the block writes
+} allocation;
+
+static void reads(uint32_t *uses, const uop *u, int rs1, int rs2) {
+    if (rs1)
+        uses[u->rs1]++;
+    if (rs2)
+        uses[u->rs2]++;
+}
+
+// Cache the guest registers used at least twice, most used first
+static void allocate(const block *b, allocation *a) {
+    uint32_t uses[33] = {0};
+    for (uint32_t i = 0; i < b->count; i++) {
+        const uop *u = &b->uops[i];
+        uint8_t k = u->kind;
+        if (k == UOP_LI || k == UOP_JAL)
+            uses[u->rd]++;
+        else if (k <= UOP_SRAI || (k >= UOP_LB && k <= UOP_LHU) || k == UOP_JALR)
+            reads(uses, u, 1, 0), uses[u->rd]++;
+        else if (k <= UOP_AND)
+            reads(uses, u, 1, 1), uses[u->rd]++;
+        else if (k != UOP_NOP)
+            reads(uses, u, 1, 1);       // stores and branches
+    }
+    uses[0] = uses[X_SINK] = 0;
+    memset(a->host, -1, sizeof(a->host));
+    a->written = 0;
+    for (int n = 0; n < CACHE_REGS; n++) {
+        int best = 0;
+        for (int g = 1; g < 32; g++)
+            best = uses[g] > uses[best] ? g : best;
+        if (uses[best] < 2)
+            break;
+        a->host[best] = (int8_t)cache_regs[n];
+        uses[best] = 0;
+    }
+    for (uint32_t i = 0; i < b->count; i++) {
+        const uop *u = &b->uops[i];
+        int writes = u->kind <= UOP_LHU || u->kind == UOP_JAL || u->kind == UOP_JALR;
+        if (writes && u->rd != X_SINK && a->host[u->rd] >= 0)
+            a->written |= 1u << u->rd;
+    }
+}
+
+// reg = guest register g
+static void get(emitter *e, const allocation *a, int reg, int g) {
+    if (g == 0)
+        mov_imm(e, reg, 0);     // not xor: that would clobber the flags
+    else if (a->host[g] >= 0)
+        op_reg(e, 0, 0x8B, reg, a->host[g]);
+    else
+        op_mem(e, 0, 0x8B, reg, CTX, 4 * g);
+}
+
+// guest register g = reg
+static void put(emitter *e, const allocation *a, int g, int reg) {
+    if (g == X_SINK)
+        return;
+    if (a->host[g] >= 0)
+        op_reg(e, 0, 0x8B, a->host[g], reg);
+    else
+        op_mem(e, 0, 0x89, reg, CTX, 4 * g);
+}
+
+static void put_imm(emitter *e, const allocation *a, int g, uint32_t imm) {
+    if (g == X_SINK)
+        return;
+    if (a->host[g] >= 0)
+        mov_imm(e, a->host[g], imm);
+    else
+        store_imm(e, 0, 4 * g, imm);
+}
+
+static void load_cached(emitter *e, const allocation *a) {
+    for (int g = 1; g < 32; g++) {
+        if (a->host[g] >= 0)
+            op_mem(e, 0, 0x8B, a->host[g], CTX, 4 * g);
+    }
+}
+
+static void write_back(emitter *e, const allocation *a) {
+    for (int g = 1; g < 32; g++) {
+        if (a->written >> g & 1)
+            op_mem(e, 0, 0x89, a->host[g], CTX, 4 * g);
+    }
+}
+
+// --- blocks -----------------------------------------------------------
+
+enum stub_kind { STUB_BUDGET, STUB_LOAD_FAULT, STUB_STORE_FAULT, STUB_CODE, STUB_EXIT };
+
+typedef struct {
+    uint8_t *field;             // the jump to the stub
+    uint8_t kind;
+    uint32_t value;             // instruction index, or the exit's guest pc
+} stub;
+
+#define MAX_STUBS (3 * BLOCK_MAX_UOPS + 4)
+
+typedef struct {
+    emitter e;
+    allocation a;
+    const rv_cpu *cpu;
+    stub stubs[MAX_STUBS];
+    int stub_count;
+} compiler;
+
+static void to_stub(compiler *c, int cc, enum stub_kind kind, uint32_t value) {
+    stub *s = &c->stubs[c->stub_count++];
+    s->field = jump(&c->e, cc);
+    s->kind = (uint8_t)kind;
+    s->value = value;
+}
+
+// eax = guest address rs1 + imm as a RAM offset, leaving for a fault stub
+// when [offset, offset + width) is outside RAM
+static void address(compiler *c, const uop *u, uint32_t width, enum stub_kind fault,
+                    uint32_t index) {
+    get(&c->e, &c->a, RAX, u->rs1);
+    uint32_t offset = (uint32_t)u->imm - c->cpu->ram_base;
+    if (offset != 0)
+        alu_imm(&c->e, 0, ALU_ADD, RAX, offset);
+    alu_imm(&c->e, 0, ALU_CMP, RAX, c->cpu->ram_size - width);
+    to_stub(c, CC_A, fault, index);
+}
+
+// Leave for the code-write stub if the byte at RAM offset eax + add is in
+// a decoded word
+static void check_code(compiler *c, uint32_t add, uint32_t index) {
+    if (add == 0)
+        op_reg(&c->e, 0, 0x8B, RDX, RAX);
+    else
+        op_mem(&c->e, 0, 0x8D, RDX, RAX, (int32_t)add);     // lea
+    op_reg(&c->e, 0, 0xC1, SHIFT_SHR, RDX);
+    byte(&c->e, 2);
+    op_mem(&c->e, 1, 0x0FA3, RDX, CODE, 0);                 // bt [r13], rdx
+    to_stub(c, CC_B, STUB_CODE, index);
+}
+
+static void setcc(emitter *e, int cc) {
+    op_reg(e, 0, 0x0F90 + (uint32_t)cc, 0, RAX);            // setcc al
+    op_reg(e, 0, 0x0FB6, RAX, RAX);                         // movzx eax, al
+}
+
+static void body(compiler *c, const uop *u, uint32_t index) {
+    static const uint8_t alu_digits[] = {
+        [UOP_ADDI] = ALU_ADD, [UOP_XORI] = ALU_XOR, [UOP_ORI] = ALU_OR, [UOP_ANDI] = ALU_AND,
+        [UOP_SLLI] = SHIFT_SHL, [UOP_SRLI] = SHIFT_SHR, [UOP_SRAI] = SHIFT_SAR,
+        [UOP_SLL] = SHIFT_SHL, [UOP_SRL] = SHIFT_SHR, [UOP_SRA] = SHIFT_SAR,
+    };
+    static const uint16_t reg_opcodes[] = {
+        [UOP_ADD] = 0x03, [UOP_SUB] = 0x2B, [UOP_XOR] = 0x33, [UOP_OR] = 0x0B,
+        [UOP_AND] = 0x23, [UOP_SLT] = 0x3B, [UOP_SLTU] = 0x3B,
+    };
+    static const uint16_t load_opcodes[] = {
+        [UOP_LB] = 0x0FBE, [UOP_LH] = 0x0FBF, [UOP_LW] = 0x8B, [UOP_LBU] = 0x0FB6,
+        [UOP_LHU] = 0x0FB7,
+    };
+    static const uint8_t widths[] = {
+        [UOP_LB] = 1, [UOP_LH] = 2, [UOP_LW] = 4, [UOP_LBU] = 1, [UOP_LHU] = 2,
+        [UOP_SB] = 1, [UOP_SH] = 2, [UOP_SW] = 4,
+    };
+    emitter *e = &c->e;
+    const allocation *a = &c->a;
+    uint8_t k = u->kind;
+    uint32_t imm = (uint32_t)u->imm;
+    // Nothing to do for results that go to x0, except a load's fault check
+    if (u->rd == X_SINK && k <= UOP_AND)
+        return;
+    switch (k) {
+    case UOP_LI:
+        put_imm(e, a, u->rd, imm);
+        return;
+    case UOP_ADDI: case UOP_XORI: case UOP_ORI: case UOP_ANDI:
+        get(e, a, RAX, u->rs1);
+        if (imm != 0 || k == UOP_ANDI)
+            alu_imm(e, 0, alu_digits[k], RAX, imm);
+        break;
+    case UOP_SLTI: case UOP_SLTIU:
+        get(e, a, RAX, u->rs1);
+        alu_imm(e, 0, ALU_CMP, RAX, imm);
+        setcc(e, k == UOP_SLTI ? CC_L : CC_B);
+        break;
+    case UOP_SLLI: case UOP_SRLI: case UOP_SRAI:
+        get(e, a, RAX, u->rs1);
+        if (imm != 0) {
+            op_reg(e, 0, 0xC1, alu_digits[k], RAX);
+            byte(e, imm);
+        }
+        break;
+    case UOP_SLL: case UOP_SRL: case UOP_SRA:
+        get(e, a, RAX, u->rs1);
+        get(e, a, RCX, u->rs2);
+        op_reg(e, 0, 0xD3, alu_digits[k], RAX);             // x86 masks the count to 5 bits too
+        break;
+    case UOP_ADD: case UOP_SUB: case UOP_XOR: case UOP_OR: case UOP_AND:
+    case UOP_SLT: case UOP_SLTU:
+        get(e, a, RAX, u->rs1);
+        get(e, a, RDX, u->rs2);
+        op_reg(e, 0, reg_opcodes[k], RAX, RDX);
+        if (k == UOP_SLT || k == UOP_SLTU)
+            setcc(e, k == UOP_SLT ? CC_L : CC_B);
+        break;
+    case UOP_LB: case UOP_LH: case UOP_LW: case UOP_LBU: case UOP_LHU:
+        address(c, u, widths[k], STUB_LOAD_FAULT, index);
+        if (u->rd == X_SINK)
+            return;
+        op_index(e, 0, load_opcodes[k], RAX, RAM, RAX);
+        break;
+    case UOP_SB: case UOP_SH: case UOP_SW:
+        address(c, u, widths[k], STUB_STORE_FAULT, index);
+        get(e, a, RCX, u->rs2);
+        if (k == UOP_SH)
+            byte(e, 0x66);
+        op_index(e, 0, k == UOP_SB ? 0x88 : 0x89, RCX, RAM, RAX);
+        check_code(c, 0, index);
+        if (widths[k] > 1)
+            check_code(c, widths[k] - 1u, index);
+        return;
+    default:                    // UOP_NOP
+        return;
+    }
+    put(e, a, u->rd, RAX);
+}
+
+// Add the block's counters and cycles, as at the block engine's retire
+static void retire(compiler *c, const block *b) {
+    emitter *e = &c->e;
+    if (b->loads)
+        alu_imm_mem(e, 1, ALU_ADD, CTX, CONTEXT(loads), b->loads);
+    if (b->stores)
+        alu_imm_mem(e, 1, ALU_ADD, CTX, CONTEXT(stores), b->stores);
+    if (b->branches)
+        alu_imm_mem(e, 1, ALU_ADD, CTX, CONTEXT(branches), b->branches);
+    alu_imm(e, 1, ALU_SUB, BUDGET, b->count);
+    alu_imm(e, 1, ALU_ADD, CYCLES, b->cycles);
+    uint32_t load_use = c->cpu->timing.load_use;
+    if (b->first_sources && load_use) {
+        op_mem(e, 0, 0xF7, 0, CTX, CONTEXT(pending));       // test
+        word32(e, b->first_sources);
+        byte(e, 0x74);                                      // jz over the add
+        byte(e, 7);
+        alu_imm(e, 1, ALU_ADD, CYCLES, load_use);
+    }
+    store_imm(e, 0, CONTEXT(pending), b->pending_out);
+    write_back(e, &c->a);
+}
+
+static void taken(compiler *c) {
+    if (c->cpu->timing.taken_branch)
+        alu_imm(&c->e, 1, ALU_ADD, CYCLES, c->cpu->timing.taken_branch);
+}
+
+static void leave(emitter *e, const struct rv_dbt *dbt, enum dbt_exit exit) {
+    mov_imm(e, RAX, exit);
+    set_target(jump(e, -1), dbt->leave);
+}
+
+static void stubs(compiler *c, const struct rv_dbt *dbt, const block *b) {
+    emitter *e = &c->e;
+    for (int i = 0; i < c->stub_count; i++) {
+        stub *s = &c->stubs[i];
+        set_target(s->field, e->p);
+        switch (s->kind) {
+        case STUB_BUDGET:
+            store_imm(e, 0, CONTEXT(pc), b->pc);
+            store_imm(e, 1, CONTEXT(jump), 0);
+            leave(e, dbt, DBT_EXIT_NEXT);
+            break;
+        case STUB_EXIT:
+            // Not chained yet: tell the engine which jump this was
+            mov_imm64(e, RCX, (uint64_t)(uintptr_t)s->field);
+            op_mem(e, 1, 0x89, RCX, CTX, CONTEXT(jump));
+            store_imm(e, 0, CONTEXT(pc), s->value);
+            leave(e, dbt, DBT_EXIT_NEXT);
+            break;
+        default:
+            if (s->kind != STUB_CODE) {
+                alu_imm(e, 0, ALU_ADD, RAX, c->cpu->ram_base);
+                op_mem(e, 0, 0x89, RAX, CTX, CONTEXT(fault_address));
+            }
+            store_imm(e, 0, CONTEXT(index), s->value);
+            write_back(e, &c->a);
+            mov_imm64(e, RCX, (uint64_t)(uintptr_t)b);
+            op_mem(e, 1, 0x89, RCX, CTX, CONTEXT(block));
+            leave(e, dbt, s->kind == STUB_LOAD_FAULT    ? DBT_EXIT_LOAD_FAULT
+                          : s->kind == STUB_STORE_FAULT ? DBT_EXIT_STORE_FAULT
+                                                        : DBT_EXIT_CODE_MODIFIED);
+        }
+    }
+}
+
+const void *dbt_compile(struct rv_dbt *dbt, const block *b, const rv_cpu *cpu) {
+    static const uint8_t conditions[] = {
+        [UOP_BEQ] = CC_E, [UOP_BNE] = CC_NE, [UOP_BLT] = CC_L,
+        [UOP_BGE] = CC_GE, [UOP_BLTU] = CC_B, [UOP_BGEU] = CC_AE,
+    };
+    if (DBT_CODE_SIZE - dbt->used < DBT_BLOCK_ROOM)
+        return NULL;
+    compiler c;
+    c.e = (emitter){dbt->code + dbt->used, dbt->code + dbt->used + DBT_BLOCK_ROOM};
+    c.cpu = cpu;
+    c.stub_count = 0;
+    allocate(b, &c.a);
+    emitter *e = &c.e;
+    uint8_t *start = e->p;
+
+    alu_imm(e, 1, ALU_CMP, BUDGET, b->count);
+    to_stub(&c, CC_B, STUB_BUDGET, 0);
+    load_cached(e, &c.a);
+    for (uint32_t i = 0; i < b->count; i++) {
+        if (b->uops[i].kind < UOP_BEQ)
+            body(&c, &b->uops[i], i);
+    }
+
+    const uop *u = &b->uops[b->count - 1];
+    switch (u->kind >= UOP_BEQ ? u->kind : UOP_END) {
+    case UOP_JAL:
+        put_imm(e, &c.a, u->rd, b->end);
+        retire(&c, b);
+        taken(&c);
+        to_stub(&c, -1, STUB_EXIT, (uint32_t)u->imm);
+        break;
+    case UOP_JALR:
+        get(e, &c.a, RAX, u->rs1);
+        alu_imm(e, 0, ALU_ADD, RAX, (uint32_t)u->imm);
+        alu_imm(e, 0, ALU_AND, RAX, ~1u);
+        op_mem(e, 0, 0x89, RAX, CTX, CONTEXT(pc));
+        put_imm(e, &c.a, u->rd, b->end);
+        retire(&c, b);
+        taken(&c);
+        store_imm(e, 1, CONTEXT(jump), 0);
+        leave(e, dbt, DBT_EXIT_NEXT);
+        break;
+    case UOP_END:
+        retire(&c, b);
+        to_stub(&c, -1, STUB_EXIT, b->end);
+        break;
+    default: {
+        retire(&c, b);
+        get(e, &c.a, RAX, u->rs1);
+        get(e, &c.a, RDX, u->rs2);
+        op_reg(e, 0, 0x3B, RAX, RDX);                       // cmp eax, edx
+        uint8_t *to_taken = jump(e, conditions[u->kind]);
+        to_stub(&c, -1, STUB_EXIT, b->end);
+        set_target(to_taken, e->p);
+        taken(&c);
+        alu_imm_mem(e, 1, ALU_ADD, CTX, CONTEXT(taken_branches), 1);
+        to_stub(&c, -1, STUB_EXIT, (uint32_t)u->imm);
+    }
+    }
+    stubs(&c, dbt, b);
+    if (e->p == e->end)
+        abort();                // DBT_BLOCK_ROOM is too small
+    dbt->used += (size_t)(e->p - start);
+    dbt->used = (dbt->used + 15) & ~(size_t)15;
+    return start;
+}
+
+void dbt_chain(void *jump, const void *native) {
+    set_target(jump, native);
+}
+
+// --- entry and exit ---------------------------------------------------
+
+typedef enum dbt_exit (*trampoline)(dbt_context *context, const void *native);
+
+static void emit_trampoline(struct rv_dbt *dbt) {
+    emitter e = {dbt->code, dbt->code + DBT_CODE_SIZE};
+    static const int saved[] = {RBX, RBP, R12, R13, R14, R15};
+    for (int i = 0; i < 6; i++) {
+        rex(&e, 0, 0, 0, saved[i]);
+        byte(&e, 0x50 + (saved[i] & 7));                    // push
+    }
+    alu_imm(&e, 1, ALU_SUB, RSP, 8);                        // keep rsp 16-byte aligned
+    op_reg(&e, 1, 0x8B, CTX, RDI);
+    op_mem(&e, 1, 0x8B, RAM, CTX, CONTEXT(ram));
+    op_mem(&e, 1, 0x8B, CODE, CTX, CONTEXT(code));
+    op_mem(&e, 1, 0x8B, BUDGET, CTX, CONTEXT(budget));
+    op_mem(&e, 1, 0x8B, CYCLES, CTX, CONTEXT(cycles));
+    op_reg(&e, 0, 0xFF, 4, RSI);                            // jmp rsi
+
+    dbt->leave = e.p;
+    op_mem(&e, 1, 0x89, BUDGET, CTX, CONTEXT(budget));
+    op_mem(&e, 1, 0x89, CYCLES, CTX, CONTEXT(cycles));
+    alu_imm(&e, 1, ALU_ADD, RSP, 8);
+    for (int i = 5; i >= 0; i--) {
+        rex(&e, 0, 0, 0, saved[i]);
+        byte(&e, 0x58 + (saved[i] & 7));                    // pop
+    }
+    byte(&e, 0xC3);
+    dbt->trampoline = (size_t)(e.p - dbt->code + 15) & ~(size_t)15;
+    dbt->used = dbt->trampoline;
+}
+
+struct rv_dbt *dbt_create(void) {
+    struct rv_dbt *dbt = calloc(1, sizeof(*dbt));
+    if (dbt == NULL)
+        return NULL;
+    void *code = mmap(NULL, DBT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        free(dbt);
+        return NULL;
+    }
+    dbt->code = code;
+    emit_trampoline(dbt);
+    return dbt;
+}
+
+void dbt_free(struct rv_dbt *dbt) {
+    if (dbt == NULL)
+        return;
+    munmap(dbt->code, DBT_CODE_SIZE);
+    free(dbt);
+}
+
+void dbt_flush(struct rv_dbt *dbt) {
+    dbt->used = dbt->trampoline;
+}
+
+enum dbt_exit dbt_run(struct rv_dbt *dbt, dbt_context *context, const void *native) {
+    trampoline enter = (trampoline)(void *)dbt->code;
+    return enter(context, native);
+}
+
+#else
+
+struct rv_dbt *dbt_create(void) { return NULL; }
+void dbt_free(struct rv_dbt *dbt) { (void)dbt; }
+void dbt_flush(struct rv_dbt *dbt) { (void)dbt; }
+
+const void *dbt_compile(struct rv_dbt *dbt, const block *b, const rv_cpu *cpu) {
+    (void)dbt, (void)b, (void)cpu;
+    return NULL;
+}
+
+enum dbt_exit dbt_run(struct rv_dbt *dbt, dbt_context *context, const void *native) {
+    (void)dbt, (void)context, (void)native;
+    return DBT_EXIT_NEXT;
+}
+
+void dbt_chain(void *jump, const void *native) { (void)jump, (void)native; }
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * dbt.h - Dynamic binary translation of hot rv32i blocks to x86-64
+ *
+ * The block cache (block.h) counts how often each block is entered. With
+ * rv_cpu_enable_dbt, a block entered threshold times is compiled from its
+ * micro-ops into x86-64 code, and from then on runs natively:
+ *
+ *  - The guest registers a block uses most are held in host registers
+ *    for the whole block: loaded on entry, written back on every exit.
+ *  - The exits to the fall-through and branch/jal targets start out
+ *    returning to the block engine, which patches them into direct jumps
+ *    once the target is compiled too. A hot loop then runs entirely in
+ *    translated code. jalr always goes back through the engine.
+ *  - Each block adds its counters and cycles as the block engine would,
+ *    and first checks that enough of the instruction limit is left to
+ *    run it; if not, it hands back to the engine, which single-steps.
+ *  - A fault, or a store into decoded code, leaves with the block and the
+ *    instruction it happened at, and the engine finishes it the way it
+ *    does its own.
+ *
+ * Runs with a stop_pc stay in the block engine. Anything that flushes the
+ * block cache also drops all translated code.
+ *
+ * Only x86-64 hosts translate; elsewhere dbt_create returns NULL.
+ */
+
+#ifndef DBT_H
+#define DBT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "block.h"
+
+enum dbt_exit {
+    DBT_EXIT_NEXT,              // go on at pc; jump, if set, can be chained to it
+    DBT_EXIT_LOAD_FAULT,        // at block->uops[index], fault_address
+    DBT_EXIT_STORE_FAULT,
+    DBT_EXIT_CODE_MODIFIED,     // the store at block->uops[index] hit decoded code
+};
+
+// What translated code runs on. The guest registers come first, in the
+// block engine's layout.
+typedef struct {
+    uint32_t x[33];
+    uint32_t pc;
+    uint32_t pending;           // mask of the register a load just wrote
+    uint32_t fault_address;
+    uint32_t index;
+    uint8_t *ram;
+    const uint64_t *code;       // the block cache's bit per decoded RAM word
+    uint64_t budget;            // instructions left before the limit
+    uint64_t cycles, loads, stores, branches, taken_branches;
+    void *jump;                 // the exit taken, for dbt_chain
+    const block *block;
+} dbt_context;
+
+struct rv_dbt;
+
+// NULL if the host cannot run translated code
+struct rv_dbt *dbt_create(void);
+void dbt_free(struct rv_dbt *dbt);
+// Drop all translated code
+void dbt_flush(struct rv_dbt *dbt);
+
+// b's x86-64 code, for cpu's RAM and timing; NULL when the code buffer
+// is full (flush and retry)
+const void *dbt_compile(struct rv_dbt *dbt, const block *b, const rv_cpu *cpu);
+enum dbt_exit dbt_run(struct rv_dbt *dbt, dbt_context *context, const void *native);
+// Point the exit jump straight at native
+void dbt_chain(void *jump, const void *native);
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * devices.c - sifive_test, UART0, the CLINT timer and a quiet PLIC for
+ * rvsim (see devices.h)
+ *
+ * Every engine stops a load or store that misses RAM before it happens,
+ * with the pc on it and nothing retired. That makes the device layer a
+ * loop around rv_run: decode the one instruction, do it against the
+ * device, retire it (one cycle, like any load or store) and run on.
+ * Illegal instructions stop the same way, which is where mret and the
+ * illegal-instruction trap come in. The timer needs no help from the
+ * engines: each rv_run is cut off at the instruction where mtime reaches
+ * mtimecmp.
+ */
+
+#include "devices.h"
+#include "rv32.h"
+
+#define TEST_SIZE 0x1000u
+#define TEST_PASS 0x5555u
+#define TEST_FAIL 0x3333u
+#define TEST_RESET 0x7777u
+
+#define UART_SIZE 0x100u
+#define UART_THR 0
+#define UART_IIR 2
+#define UART_LCR 3
+#define UART_LSR 5
+#define LCR_DLAB 0x80
+#define IIR_NONE 0x01               // no interrupt pending
+#define LSR_IDLE 0x60               // THR and transmitter empty
+
+#define CLINT_BASE 0x02000000u
+#define CLINT_SIZE 0x10000u
+#define CLINT_MTIMECMP 0x02004000u  // hart 0's
+#define CLINT_MTIME 0x0200BFF8u
+#define PLIC_BASE 0x0C000000u
+#define PLIC_SIZE 0x4000000u
+#define INSTRUCTIONS_PER_TICK 100   // QEMU's 10 MHz mtime at -icount shift=0
+
+#define MSTATUS_MIE 0x8u
+#define MSTATUS_MPIE 0x80u
+#define MIE_MTIE 0x80u
+#define CAUSE_ILLEGAL 2u
+#define CAUSE_TIMER 0x80000007u
+
+void rv_devices_init(rv_devices *devices, FILE *uart) {
+    devices->uart = uart;
+    devices->exit_status = 0;
+    devices->uart_bytes = 0;
+    devices->uart_last = 0;
+    devices->uart_lcr = 0;
+    devices->mtimecmp = UINT64_MAX;
+    devices->interrupts = 0;
+}
+
+static int inside(uint32_t address, uint32_t base, uint32_t size) {
+    return address - base < size;
+}
+
+// 1 if address is a device; value is what a 4-byte load there reads,
+// shifted so the addressed byte is the low one
+static int device_read(const rv_cpu *cpu, rv_devices *devices, uint32_t address,
+                       uint32_t *value) {
+    *value = 0;
+    if (inside(address, RV_UART_BASE, UART_SIZE)) {
+        uint32_t reg = address - RV_UART_BASE;
+        if (reg == UART_LSR)
+            *value = LSR_IDLE;
+        else if (reg == UART_IIR)
+            *value = IIR_NONE;
+        else if (reg == UART_LCR)
+            *value = devices->uart_lcr;
+        return 1;
+    }
+    if (inside(address, CLINT_MTIME, 8)) {
+        uint64_t mtime = cpu->instret / INSTRUCTIONS_PER_TICK;
+        *value = (uint32_t)(mtime >> 8 * (address - CLINT_MTIME));
+        return 1;
+    }
+    if (inside(address, CLINT_MTIMECMP, 8)) {
+        *value = (uint32_t)(devices->mtimecmp >> 8 * (address - CLINT_MTIMECMP));
+        return 1;
+    }
+    return inside(address, RV_TEST_BASE, TEST_SIZE) || inside(address, CLINT_BASE, CLINT_SIZE) ||
+           inside(address, PLIC_BASE, PLIC_SIZE);
+}
+
+// 1 if address is a device; sets *exited for a sifive_test pass or fail
+static int device_write(rv_devices *devices, uint32_t address, uint32_t value, unsigned bytes,
+                        int *exited) {
+    if (inside(address, RV_TEST_BASE, TEST_SIZE)) {
+        if (address == RV_TEST_BASE && bytes == 4) {
+            if ((value & 0xFFFF) == TEST_FAIL) {
+                devices->exit_status = value >> 16;
+                *exited = 1;
+            } else if ((value & 0xFFFF) == TEST_PASS || (value & 0xFFFF) == TEST_RESET) {
+                devices->exit_status = 0;
+                *exited = 1;
+            }
+        }
+        return 1;
+    }
+    if (inside(address, RV_UART_BASE, UART_SIZE)) {
+        uint32_t reg = address - RV_UART_BASE;
+        if (reg == UART_LCR) {
+            devices->uart_lcr = (uint8_t)value;
+        } else if (reg == UART_THR && !(devices->uart_lcr & LCR_DLAB)) {
+            devices->uart_bytes++;
+            devices->uart_last = (uint8_t)value;
+            if (devices->uart != NULL)
+                fputc((int)(value & 0xFF), devices->uart);
+        }
+        return 1;
+    }
+    for (unsigned i = 0; i < bytes; i++) {
+        uint32_t byte = address + i - CLINT_MTIMECMP;
+        if (byte < 8) {
+            devices->mtimecmp &= ~(0xFFull << 8 * byte);
+            devices->mtimecmp |= (uint64_t)(value >> 8 * i & 0xFF) << 8 * byte;
+        }
+    }
+    return inside(address, CLINT_BASE, CLINT_SIZE) || inside(address, PLIC_BASE, PLIC_SIZE);
+}
+
+// The instret at which mtime reaches mtimecmp; UINT64_MAX for never
+static uint64_t timer_due(const rv_devices *devices) {
+    if (devices->mtimecmp > UINT64_MAX / INSTRUCTIONS_PER_TICK)
+        return UINT64_MAX;
+    return devices->mtimecmp * INSTRUCTIONS_PER_TICK;
+}
+
+static int timer_enabled(const rv_cpu *cpu) {
+    return (cpu->mstatus & MSTATUS_MIE) && (cpu->mie & MIE_MTIE);
+}
+
+// Go to mtvec with the pc as mepc. The jump costs what a taken one does;
+// nothing retires.
+static void take_trap(rv_cpu *cpu, uint32_t cause) {
+    cpu->mepc = cpu->pc;
+    cpu->mcause = cause;
+    cpu->mstatus &= ~MSTATUS_MPIE;
+    if (cpu->mstatus & MSTATUS_MIE)
+        cpu->mstatus |= MSTATUS_MPIE;
+    cpu->mstatus &= ~MSTATUS_MIE;
+    cpu->pc = cpu->mtvec & ~3u;
+    cpu->pending_load = 0;
+    cpu->cycles += cpu->timing.taken_branch;
+}
+
+// mret: back to mepc with MIE as it was, retired like a jump
+static void trap_return(rv_cpu *cpu) {
+    cpu->mstatus &= ~MSTATUS_MIE;
+    if (cpu->mstatus & MSTATUS_MPIE)
+        cpu->mstatus |= MSTATUS_MIE;
+    cpu->mstatus |= MSTATUS_MPIE;
+    cpu->pc = cpu->mepc;
+    cpu->pending_load = 0;
+    cpu->instret++;
+    cpu->cycles += 1 + cpu->timing.taken_branch;
+}
+
+enum rv_stop rv_run_devices(rv_cpu *cpu, rv_devices *devices, uint64_t max_instructions,
+                            uint32_t stop_pc) {
+    const uint64_t limit = cpu->instret + max_instructions;
+    for (;;) {
+        // Run up to the timer interrupt, or a tick at a time while it is
+        // pending but masked, to see it unmasked
+        uint64_t run = limit - cpu->instret, due = timer_due(devices);
+        if (cpu->instret >= due) {
+            if (timer_enabled(cpu)) {
+                take_trap(cpu, CAUSE_TIMER);
+                devices->interrupts++;
+                continue;
+            }
+            if (run > INSTRUCTIONS_PER_TICK)
+                run = INSTRUCTIONS_PER_TICK;
+        } else if (due - cpu->instret < run) {
+            run = due - cpu->instret;
+        }
+        enum rv_stop stop = rv_run(cpu, run, stop_pc);
+        if (stop == RV_STOP_LIMIT && cpu->instret != limit)
+            continue;
+        uint32_t insn;
+        if (stop == RV_STOP_IDLE_LOOP && timer_enabled(cpu) && due != UINT64_MAX) {
+            // `j .` until the interrupt: each time round is one
+            // instruction and a taken jump
+            uint64_t spins = (due < limit ? due : limit) - cpu->instret;
+            cpu->instret += spins;
+            cpu->cycles += spins * (1 + cpu->timing.taken_branch);
+            cpu->pending_load = 0;
+            if (cpu->instret == limit)
+                return RV_STOP_LIMIT;
+            continue;
+        }
+        if (stop == RV_STOP_ILLEGAL && rv_cpu_read(cpu, cpu->pc, &insn, 4)) {
+            if (insn == RV_INSN_MRET) {
+                trap_return(cpu);
+            } else if (cpu->mtvec != 0) {
+                take_trap(cpu, CAUSE_ILLEGAL);
+            } else {
+                return stop;
+            }
+            if (cpu->instret == limit)
+                return RV_STOP_LIMIT;
+            continue;
+        }
+        if (stop != RV_STOP_LOAD_FAULT && stop != RV_STOP_STORE_FAULT)
+            return stop;
+        if (!rv_cpu_read(cpu, cpu->pc, &insn, 4))
+            return stop;
+        uint32_t f3 = rv_funct3(insn), rd = rv_rd(insn), base = cpu->x[rv_rs1(insn)];
+        int exited = 0;
+        if (rv_opcode(insn) == RV_OP_LOAD) {
+            uint32_t value, address = base + (uint32_t)rv_imm_i(insn);
+            if (!device_read(cpu, devices, address, &value))
+                return stop;
+            switch (f3) {
+            case 0: value = (uint32_t)(int32_t)(int8_t)value; break;
+            case 1: value = (uint32_t)(int32_t)(int16_t)value; break;
+            case 4: value &= 0xFF; break;
+            case 5: value &= 0xFFFF; break;
+            default: break;
+            }
+            if (rd != 0)
+                cpu->x[rd] = value;
+            cpu->pending_load = rd;
+            cpu->loads++;
+        } else if (rv_opcode(insn) == RV_OP_STORE) {
+            uint32_t address = base + (uint32_t)rv_imm_s(insn);
+            if (!device_write(devices, address, cpu->x[rv_rs2(insn)], 1u << f3, &exited))
+                return stop;
+            cpu->pending_load = 0;
+            cpu->stores++;
+        } else {
+            return stop;        // a vector access: no device takes those
+        }
+        cpu->pc += 4;
+        cpu->instret++;
+        cpu->cycles++;
+        if (exited)
+            return RV_STOP_EXIT;
+        if (cpu->instret == limit)
+            return RV_STOP_LIMIT;
+    }
+}
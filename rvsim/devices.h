@@ -0,0 +1,68 @@
+/*
+ * devices.h - The virt board devices a headless run needs
+ *
+ * rv_run stops at any load or store outside RAM. rv_run_devices runs the
+ * ones that reach a device itself and carries on, so programs written for
+ * QEMU's virt board run unchanged:
+ *
+ *  - sifive_test (0x100000): 0x5555 is a pass, (code << 16) | 0x3333 a
+ *    failure with that code, as rvlib's _exit writes them. Either ends the
+ *    run with RV_STOP_EXIT and the status QEMU would exit with.
+ *  - UART0, an NS16550 (0x10000000): bytes written to THR go to the
+ *    output file; LSR always says the transmitter is empty, so polling
+ *    loops never wait. Nothing is ever received.
+ *  - the CLINT: mtime counts one tick per 100 instructions like QEMU's
+ *    with -icount shift=0, so delay loops end, and hart 0's mtimecmp
+ *    raises the machine timer interrupt (below). The rest of it, and the
+ *    PLIC, ignore writes and read 0, so start-up code that sets them up
+ *    gets through.
+ *
+ * Traps go to mtvec (direct mode only) the way the hardware takes them:
+ * mepc and mcause set, mstatus.MIE saved in MPIE and cleared, and mret
+ * undoes it. Two kinds are taken, the ones rvlib's trap handlers and
+ * profile.s need:
+ *
+ *  - the timer interrupt (mcause 0x80000007), once mtime reaches
+ *    mtimecmp with mie.MTIE and mstatus.MIE set. It lands between two
+ *    instructions, exactly where the count says; if it was pending while
+ *    masked, within a tick of being unmasked. A `j .` with the timer on
+ *    waits for it instead of stopping the run.
+ *  - an illegal instruction (mcause 2), once mtvec is set. Before that
+ *    the run stops with RV_STOP_ILLEGAL as always.
+ *
+ * mip still reads 0. Everything else (ecall, ebreak, faults no device
+ * takes) stops the run as before.
+ *
+ * The device accesses and traps are the slow path (the engine stops and
+ * restarts around each one), which costs nothing for code that stays in
+ * RAM.
+ */
+
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim.h"
+
+#define RV_TEST_BASE 0x100000u
+#define RV_UART_BASE 0x10000000u
+
+typedef struct {
+    FILE *uart;                 // where UART0's output goes; NULL drops it
+    uint32_t exit_status;       // after RV_STOP_EXIT: 0 for a pass, else the code
+    uint64_t uart_bytes;        // written to THR so far
+    uint8_t uart_last;          // the last of them
+    uint8_t uart_lcr;           // LCR, for telling THR from the divisor latch
+    uint64_t mtimecmp;          // hart 0's; all ones (never) until written
+    uint64_t interrupts;        // timer interrupts taken so far
+} rv_devices;
+
+void rv_devices_init(rv_devices *devices, FILE *uart);
+
+// rv_run, with device accesses handled as above; stop_pc 0 means none
+enum rv_stop rv_run_devices(rv_cpu *cpu, rv_devices *devices, uint64_t max_instructions,
+                            uint32_t stop_pc);
+
+#endif
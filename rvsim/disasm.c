@@ -0,0 +1,643 @@
+/*
+ * disasm.c - rv32im disassembler and one-line assembler (see disasm.h)
+ *
+ * Each instruction is a mask and match over the whole word, the way the
+ * ISA manual's tables read, plus the format that says where its operands
+ * are. Decoding is the first entry whose masked bits match; assembling
+ * looks the mnemonic up in the same table and puts the operands back
+ * with rv32.h's encoders. The text is built by hand rather than with
+ * snprintf: that is most of the time for a large image.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "disasm.h"
+#include "rv32.h"
+
+#define MNEMONIC_WIDTH 8        // operands start in this column, as objdump lays them out
+
+enum format {
+    F_R,        // rd, rs1, rs2
+    F_I,        // rd, rs1, imm
+    F_SHIFT,    // rd, rs1, shamt
+    F_LOAD,     // rd, imm(rs1)
+    F_JALR,     // rd, imm(rs1)
+    F_S,        // rs2, imm(rs1)
+    F_B,        // rs1, rs2, target
+    F_U,        // rd, imm >> 12
+    F_J,        // rd, target
+    F_CSR,      // rd, csr, rs1
+    F_CSRI,     // rd, csr, uimm
+    F_FENCE,    // pred, succ
+    F_NONE,
+};
+
+typedef struct {
+    const char *name;
+    uint32_t mask, match;
+    enum format format;
+} op;
+
+#define ENC(opcode, funct3, funct7) ((uint32_t)(funct7) << 25 | (funct3) << 12 | (opcode))
+#define M_OPCODE 0x0000007Fu
+#define M_FUNCT3 0x0000707Fu
+#define M_FUNCT7 0xFE00707Fu
+#define M_WORD 0xFFFFFFFFu
+
+static const op ops[] = {
+    {"ecall", M_WORD, RV_INSN_ECALL, F_NONE},
+    {"ebreak", M_WORD, RV_INSN_EBREAK, F_NONE},
+    {"mret", M_WORD, 0x30200073u, F_NONE},
+    {"wfi", M_WORD, 0x10500073u, F_NONE},
+    {"fence.i", M_WORD, 0x0000100Fu, F_NONE},
+    {"fence", 0xF00FFFFFu, RV_OP_MISC_MEM, F_FENCE},
+
+    {"lui", M_OPCODE, RV_OP_LUI, F_U},
+    {"auipc", M_OPCODE, RV_OP_AUIPC, F_U},
+    {"jal", M_OPCODE, RV_OP_JAL, F_J},
+    {"jalr", M_FUNCT3, ENC(RV_OP_JALR, 0, 0), F_JALR},
+
+    {"beq", M_FUNCT3, ENC(RV_OP_BRANCH, 0, 0), F_B},
+    {"bne", M_FUNCT3, ENC(RV_OP_BRANCH, 1, 0), F_B},
+    {"blt", M_FUNCT3, ENC(RV_OP_BRANCH, 4, 0), F_B},
+    {"bge", M_FUNCT3, ENC(RV_OP_BRANCH, 5, 0), F_B},
+    {"bltu", M_FUNCT3, ENC(RV_OP_BRANCH, 6, 0), F_B},
+    {"bgeu", M_FUNCT3, ENC(RV_OP_BRANCH, 7, 0), F_B},
+
+    {"lb", M_FUNCT3, ENC(RV_OP_LOAD, 0, 0), F_LOAD},
+    {"lh", M_FUNCT3, ENC(RV_OP_LOAD, 1, 0), F_LOAD},
+    {"lw", M_FUNCT3, ENC(RV_OP_LOAD, 2, 0), F_LOAD},
+    {"lbu", M_FUNCT3, ENC(RV_OP_LOAD, 4, 0), F_LOAD},
+    {"lhu", M_FUNCT3, ENC(RV_OP_LOAD, 5, 0), F_LOAD},
+    {"sb", M_FUNCT3, ENC(RV_OP_STORE, 0, 0), F_S},
+    {"sh", M_FUNCT3, ENC(RV_OP_STORE, 1, 0), F_S},
+    {"sw", M_FUNCT3, ENC(RV_OP_STORE, 2, 0), F_S},
+
+    {"addi", M_FUNCT3, ENC(RV_OP_IMM, 0, 0), F_I},
+    {"slti", M_FUNCT3, ENC(RV_OP_IMM, 2, 0), F_I},
+    {"sltiu", M_FUNCT3, ENC(RV_OP_IMM, 3, 0), F_I},
+    {"xori", M_FUNCT3, ENC(RV_OP_IMM, 4, 0), F_I},
+    {"ori", M_FUNCT3, ENC(RV_OP_IMM, 6, 0), F_I},
+    {"andi", M_FUNCT3, ENC(RV_OP_IMM, 7, 0), F_I},
+    {"slli", M_FUNCT7, ENC(RV_OP_IMM, 1, 0x00), F_SHIFT},
+    {"srli", M_FUNCT7, ENC(RV_OP_IMM, 5, 0x00), F_SHIFT},
+    {"srai", M_FUNCT7, ENC(RV_OP_IMM, 5, 0x20), F_SHIFT},
+
+    {"add", M_FUNCT7, ENC(RV_OP_REG, 0, 0x00), F_R},
+    {"sub", M_FUNCT7, ENC(RV_OP_REG, 0, 0x20), F_R},
+    {"sll", M_FUNCT7, ENC(RV_OP_REG, 1, 0x00), F_R},
+    {"slt", M_FUNCT7, ENC(RV_OP_REG, 2, 0x00), F_R},
+    {"sltu", M_FUNCT7, ENC(RV_OP_REG, 3, 0x00), F_R},
+    {"xor", M_FUNCT7, ENC(RV_OP_REG, 4, 0x00), F_R},
+    {"srl", M_FUNCT7, ENC(RV_OP_REG, 5, 0x00), F_R},
+    {"sra", M_FUNCT7, ENC(RV_OP_REG, 5, 0x20), F_R},
+    {"or", M_FUNCT7, ENC(RV_OP_REG, 6, 0x00), F_R},
+    {"and", M_FUNCT7, ENC(RV_OP_REG, 7, 0x00), F_R},
+    {"mul", M_FUNCT7, ENC(RV_OP_REG, 0, 0x01), F_R},
+    {"mulh", M_FUNCT7, ENC(RV_OP_REG, 1, 0x01), F_R},
+    {"mulhsu", M_FUNCT7, ENC(RV_OP_REG, 2, 0x01), F_R},
+    {"mulhu", M_FUNCT7, ENC(RV_OP_REG, 3, 0x01), F_R},
+    {"div", M_FUNCT7, ENC(RV_OP_REG, 4, 0x01), F_R},
+    {"divu", M_FUNCT7, ENC(RV_OP_REG, 5, 0x01), F_R},
+    {"rem", M_FUNCT7, ENC(RV_OP_REG, 6, 0x01), F_R},
+    {"remu", M_FUNCT7, ENC(RV_OP_REG, 7, 0x01), F_R},
+
+    {"csrrw", M_FUNCT3, ENC(RV_OP_SYSTEM, 1, 0), F_CSR},
+    {"csrrs", M_FUNCT3, ENC(RV_OP_SYSTEM, 2, 0), F_CSR},
+    {"csrrc", M_FUNCT3, ENC(RV_OP_SYSTEM, 3, 0), F_CSR},
+    {"csrrwi", M_FUNCT3, ENC(RV_OP_SYSTEM, 5, 0), F_CSRI},
+    {"csrrsi", M_FUNCT3, ENC(RV_OP_SYSTEM, 6, 0), F_CSRI},
+    {"csrrci", M_FUNCT3, ENC(RV_OP_SYSTEM, 7, 0), F_CSRI},
+};
+
+#define OP_COUNT (sizeof ops / sizeof ops[0])
+
+static const char *const register_names[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0", "s1", "a0",
+    "a1",   "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5",
+    "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+static const struct {
+    const char *name;
+    uint32_t number;
+} csr_names[] = {
+    {"mstatus", 0x300},  {"misa", 0x301},     {"mie", 0x304},     {"mtvec", 0x305},
+    {"mscratch", 0x340}, {"mepc", 0x341},     {"mcause", 0x342},  {"mtval", 0x343},
+    {"mip", 0x344},      {"mcycle", 0xB00},   {"minstret", 0xB02}, {"cycle", 0xC00},
+    {"time", 0xC01},     {"instret", 0xC02},  {"vl", 0xC20},      {"vtype", 0xC21},
+    {"vlenb", 0xC22},    {"cycleh", 0xC80},   {"timeh", 0xC81},   {"instreth", 0xC82},
+    {"mhartid", 0xF14},
+};
+
+#define CSR_NAME_COUNT (sizeof csr_names / sizeof csr_names[0])
+
+static const op *find_op(uint32_t insn) {
+    for (size_t i = 0; i < OP_COUNT; i++)
+        if ((insn & ops[i].mask) == ops[i].match)
+            return &ops[i];
+    return NULL;
+}
+
+// The text builders: each appends at *p and moves it on
+
+static void put(char **p, const char *s) {
+    while (*s)
+        *(*p)++ = *s++;
+}
+
+static void put_unsigned(char **p, uint32_t value) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n)
+        *(*p)++ = digits[--n];
+}
+
+static void put_signed(char **p, int32_t value) {
+    if (value < 0) {
+        *(*p)++ = '-';
+        put_unsigned(p, 0u - (uint32_t)value);
+    } else {
+        put_unsigned(p, (uint32_t)value);
+    }
+}
+
+static void put_hex(char **p, uint32_t value) {
+    static const char hex[] = "0123456789abcdef";
+    int shift = 28;
+    while (shift > 0 && (value >> shift) == 0)
+        shift -= 4;
+    put(p, "0x");
+    for (; shift >= 0; shift -= 4)
+        *(*p)++ = hex[(value >> shift) & 0xF];
+}
+
+static void put_register(char **p, uint32_t reg) { put(p, register_names[reg & 31]); }
+
+// A register and the ", " before the next operand
+static void put_register_comma(char **p, uint32_t reg) {
+    put_register(p, reg);
+    put(p, ", ");
+}
+
+static void put_csr(char **p, uint32_t number) {
+    for (size_t i = 0; i < CSR_NAME_COUNT; i++) {
+        if (csr_names[i].number == number) {
+            put(p, csr_names[i].name);
+            return;
+        }
+    }
+    put_hex(p, number);
+}
+
+static void put_fence_set(char **p, uint32_t set) {
+    if (set == 0) {
+        put(p, "0");
+        return;
+    }
+    const char *letters = "iorw";
+    for (int bit = 3; bit >= 0; bit--)
+        if (set & 1u << bit)
+            *(*p)++ = letters[3 - bit];
+}
+
+static void put_memory(char **p, int32_t imm, uint32_t base) {
+    put_signed(p, imm);
+    put(p, "(");
+    put_register(p, base);
+    put(p, ")");
+}
+
+int rv_decodes(uint32_t insn) { return find_op(insn) != NULL; }
+
+int rv_branch_target(uint32_t insn, uint32_t pc, uint32_t *target) {
+    if (rv_opcode(insn) == RV_OP_BRANCH && find_op(insn) != NULL) {
+        *target = pc + (uint32_t)rv_imm_b(insn);
+        return 1;
+    }
+    if (rv_opcode(insn) == RV_OP_JAL) {
+        *target = pc + (uint32_t)rv_imm_j(insn);
+        return 1;
+    }
+    return 0;
+}
+
+size_t rv_disasm(uint32_t insn, uint32_t pc, char *out) {
+    char *p = out;
+    const op *o = find_op(insn);
+    if (o == NULL) {
+        put(&p, ".word");
+        while (p - out < MNEMONIC_WIDTH)
+            *p++ = ' ';
+        put_hex(&p, insn);
+        *p = '\0';
+        return (size_t)(p - out);
+    }
+    put(&p, o->name);
+    if (o->format != F_NONE)
+        do
+            *p++ = ' ';
+        while (p - out < MNEMONIC_WIDTH);
+    uint32_t rd = rv_rd(insn), rs1 = rv_rs1(insn), rs2 = rv_rs2(insn);
+    switch (o->format) {
+    case F_R:
+        put_register_comma(&p, rd);
+        put_register_comma(&p, rs1);
+        put_register(&p, rs2);
+        break;
+    case F_I:
+        put_register_comma(&p, rd);
+        put_register_comma(&p, rs1);
+        put_signed(&p, rv_imm_i(insn));
+        break;
+    case F_SHIFT:
+        put_register_comma(&p, rd);
+        put_register_comma(&p, rs1);
+        put_unsigned(&p, rs2);
+        break;
+    case F_LOAD:
+    case F_JALR:
+        put_register_comma(&p, rd);
+        put_memory(&p, rv_imm_i(insn), rs1);
+        break;
+    case F_S:
+        put_register_comma(&p, rs2);
+        put_memory(&p, rv_imm_s(insn), rs1);
+        break;
+    case F_B:
+        put_register_comma(&p, rs1);
+        put_register_comma(&p, rs2);
+        put_hex(&p, pc + (uint32_t)rv_imm_b(insn));
+        break;
+    case F_U:
+        put_register_comma(&p, rd);
+        put_hex(&p, insn >> 12);
+        break;
+    case F_J:
+        put_register_comma(&p, rd);
+        put_hex(&p, pc + (uint32_t)rv_imm_j(insn));
+        break;
+    case F_CSR:
+    case F_CSRI:
+        put_register_comma(&p, rd);
+        put_csr(&p, insn >> 20);
+        put(&p, ", ");
+        if (o->format == F_CSR)
+            put_register(&p, rs1);
+        else
+            put_unsigned(&p, rs1);
+        break;
+    case F_FENCE:
+        put_fence_set(&p, insn >> 24 & 0xF);
+        put(&p, ", ");
+        put_fence_set(&p, insn >> 20 & 0xF);
+        break;
+    case F_NONE:
+        break;
+    }
+    *p = '\0';
+    return (size_t)(p - out);
+}
+
+// " name=value"
+static void put_field(char **p, const char *name, uint32_t value) {
+    put(p, " ");
+    put(p, name);
+    put(p, "=");
+    put_unsigned(p, value);
+}
+
+static void put_opcode(char **p, uint32_t insn) {
+    put(p, " op=");
+    put_hex(p, rv_opcode(insn));
+}
+
+size_t rv_disasm_fields(uint32_t insn, char *out) {
+    char *p = out;
+    const op *o = find_op(insn);
+    if (o == NULL) {
+        put(&p, "?");
+        put_opcode(&p, insn);
+        *p = '\0';
+        return (size_t)(p - out);
+    }
+    enum format format = o->format;
+    switch (format) {
+    case F_R:
+        put(&p, "R  f7=");
+        put_hex(&p, rv_funct7(insn));
+        put_field(&p, "rs2", rv_rs2(insn));
+        break;
+    case F_S:
+    case F_B:
+        put(&p, format == F_S ? "S  imm=" : "B  imm=");
+        put_signed(&p, format == F_S ? rv_imm_s(insn) : rv_imm_b(insn));
+        put_field(&p, "rs2", rv_rs2(insn));
+        break;
+    case F_U:
+    case F_J:
+        put(&p, format == F_U ? "U  imm=" : "J  imm=");
+        if (format == F_U)
+            put_hex(&p, insn >> 12);
+        else
+            put_signed(&p, rv_imm_j(insn));
+        put_field(&p, "rd", rv_rd(insn));
+        put_opcode(&p, insn);
+        *p = '\0';
+        return (size_t)(p - out);
+    case F_SHIFT:
+        put(&p, "I  f7=");
+        put_hex(&p, rv_funct7(insn));
+        put_field(&p, "shamt", rv_rs2(insn));
+        break;
+    case F_CSR:
+    case F_CSRI:
+        put(&p, "I  csr=");
+        put_hex(&p, insn >> 20);
+        break;
+    default:
+        put(&p, "I  imm=");
+        put_signed(&p, rv_imm_i(insn));
+        break;
+    }
+    put_field(&p, "rs1", rv_rs1(insn));
+    put_field(&p, "f3", rv_funct3(insn));
+    if (format != F_S && format != F_B)
+        put_field(&p, "rd", rv_rd(insn));
+    put_opcode(&p, insn);
+    *p = '\0';
+    return (size_t)(p - out);
+}
+
+// The assembler: a cursor over the text and somewhere to say what went
+// wrong
+
+typedef struct {
+    const char *s;
+    char *error;
+    size_t error_size;
+} parser;
+
+static int fail(parser *ps, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(ps->error, ps->error_size, format, args);
+    va_end(args);
+    return 0;
+}
+
+static void skip_spaces(parser *ps) {
+    while (*ps->s == ' ' || *ps->s == '\t')
+        ps->s++;
+}
+
+static int is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '.' || c == '_';
+}
+
+// The next name or number, at most size - 1 characters of it
+static size_t word(parser *ps, char *out, size_t size) {
+    skip_spaces(ps);
+    size_t n = 0;
+    while (is_word_char(ps->s[n]) && n + 1 < size) {
+        out[n] = ps->s[n];
+        n++;
+    }
+    out[n] = '\0';
+    ps->s += n;
+    return n;
+}
+
+static int expect(parser *ps, char c) {
+    skip_spaces(ps);
+    if (*ps->s != c)
+        return fail(ps, "expected '%c' at \"%s\"", c, ps->s);
+    ps->s++;
+    return 1;
+}
+
+static int parse_register(parser *ps, uint32_t *reg) {
+    char name[8];
+    word(ps, name, sizeof name);
+    for (uint32_t r = 0; r < 32; r++) {
+        if (strcmp(name, register_names[r]) == 0) {
+            *reg = r;
+            return 1;
+        }
+    }
+    if (strcmp(name, "fp") == 0) {
+        *reg = 8;
+        return 1;
+    }
+    // x0 to x31, with no leading zeros
+    int digits = (int)strspn(name + 1, "0123456789");
+    if (name[0] == 'x' && digits > 0 && name[1 + digits] == '\0' && digits <= 2 &&
+        !(digits == 2 && name[1] == '0')) {
+        uint32_t r = (uint32_t)(name[1] - '0');
+        if (digits == 2)
+            r = r * 10 + (uint32_t)(name[2] - '0');
+        if (r < 32) {
+            *reg = r;
+            return 1;
+        }
+    }
+    return fail(ps, "expected a register, not \"%s\"", name);
+}
+
+// Decimal or 0x hex, with an optional minus; anything from -2^31 to
+// 2^32 - 1, as the bits it stands for
+static int parse_number(parser *ps, int64_t *value) {
+    skip_spaces(ps);
+    int negative = *ps->s == '-';
+    if (negative)
+        ps->s++;
+    int base = 10;
+    if (ps->s[0] == '0' && (ps->s[1] == 'x' || ps->s[1] == 'X')) {
+        base = 16;
+        ps->s += 2;
+    }
+    int64_t v = 0;
+    int digits = 0;
+    for (;; ps->s++, digits++) {
+        char c = *ps->s;
+        int d = c >= '0' && c <= '9'   ? c - '0'
+                : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                       : 99;
+        if (d >= base)
+            break;
+        v = v * base + d;
+        if (v > 0xFFFFFFFFll)
+            return fail(ps, "number out of range");
+    }
+    if (digits == 0)
+        return fail(ps, "expected a number at \"%s\"", ps->s);
+    *value = negative ? -v : v;
+    if (*value < -0x80000000ll)
+        return fail(ps, "number out of range");
+    return 1;
+}
+
+static int parse_range(parser *ps, int64_t low, int64_t high, int32_t *value) {
+    int64_t v;
+    if (!parse_number(ps, &v))
+        return 0;
+    if (v < low || v > high)
+        return fail(ps, "%lld is out of range (%lld to %lld)", (long long)v, (long long)low,
+                    (long long)high);
+    *value = (int32_t)v;
+    return 1;
+}
+
+// imm(reg), or just (reg) for an offset of 0
+static int parse_memory(parser *ps, int32_t *imm, uint32_t *base) {
+    skip_spaces(ps);
+    *imm = 0;
+    if (*ps->s != '(' && !parse_range(ps, -2048, 2047, imm))
+        return 0;
+    return expect(ps, '(') && parse_register(ps, base) && expect(ps, ')');
+}
+
+// An absolute address, as the offset from pc: even and within reach
+static int parse_target(parser *ps, uint32_t pc, int32_t reach, int32_t *offset) {
+    int64_t target;
+    if (!parse_number(ps, &target))
+        return 0;
+    int32_t delta = (int32_t)((uint32_t)target - pc);
+    if (delta & 1)
+        return fail(ps, "target 0x%x is not 2-byte aligned", (uint32_t)target);
+    if (delta < -reach || delta >= reach)
+        return fail(ps, "target 0x%x is out of reach from 0x%x", (uint32_t)target, pc);
+    *offset = delta;
+    return 1;
+}
+
+static int parse_csr(parser *ps, uint32_t *number) {
+    skip_spaces(ps);
+    if (*ps->s >= '0' && *ps->s <= '9') {
+        int32_t v = 0;
+        if (!parse_range(ps, 0, 0xFFF, &v))
+            return 0;
+        *number = (uint32_t)v;
+        return 1;
+    }
+    char name[16];
+    word(ps, name, sizeof name);
+    for (size_t i = 0; i < CSR_NAME_COUNT; i++) {
+        if (strcmp(name, csr_names[i].name) == 0) {
+            *number = csr_names[i].number;
+            return 1;
+        }
+    }
+    return fail(ps, "unknown CSR \"%s\"", name);
+}
+
+static int parse_fence_set(parser *ps, uint32_t *set) {
+    char letters[8];
+    word(ps, letters, sizeof letters);
+    *set = 0;
+    if (strcmp(letters, "0") == 0)
+        return 1;
+    for (const char *c = letters; *c; c++) {
+        const char *at = strchr("iorw", *c);
+        if (at == NULL)
+            return fail(ps, "bad fence set \"%s\"", letters);
+        *set |= 8u >> (at - "iorw");
+    }
+    if (*set == 0)
+        return fail(ps, "expected a fence set (iorw)");
+    return 1;
+}
+
+static int comma(parser *ps) { return expect(ps, ','); }
+
+int rv_assemble(const char *text, uint32_t pc, uint32_t *insn, char *error, size_t error_size) {
+    parser ps = {text, error, error_size};
+    char name[16];
+    word(&ps, name, sizeof name);
+    const op *o = NULL;
+    for (size_t i = 0; i < OP_COUNT && o == NULL; i++)
+        if (strcmp(name, ops[i].name) == 0)
+            o = &ops[i];
+    if (o == NULL)
+        return fail(&ps, "unknown instruction \"%s\"", name);
+
+    uint32_t opcode = rv_opcode(o->match), f3 = rv_funct3(o->match), f7 = rv_funct7(o->match);
+    uint32_t rd = 0, rs1 = 0, rs2 = 0, csr = 0;
+    int32_t imm = 0;
+    int ok = 1;
+    switch (o->format) {
+    case F_R:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_register(&ps, &rs1) && comma(&ps) &&
+             parse_register(&ps, &rs2);
+        *insn = rv_encode_r(opcode, f3, f7, rd, rs1, rs2);
+        break;
+    case F_I:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_register(&ps, &rs1) && comma(&ps) &&
+             parse_range(&ps, -2048, 2047, &imm);
+        *insn = rv_encode_i(opcode, f3, rd, rs1, imm);
+        break;
+    case F_SHIFT:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_register(&ps, &rs1) && comma(&ps) &&
+             parse_range(&ps, 0, 31, &imm);
+        *insn = rv_encode_r(opcode, f3, f7, rd, rs1, (uint32_t)imm);
+        break;
+    case F_LOAD:
+    case F_JALR:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_memory(&ps, &imm, &rs1);
+        *insn = rv_encode_i(opcode, f3, rd, rs1, imm);
+        break;
+    case F_S:
+        ok = parse_register(&ps, &rs2) && comma(&ps) && parse_memory(&ps, &imm, &rs1);
+        *insn = rv_encode_s(opcode, f3, rs1, rs2, imm);
+        break;
+    case F_B:
+        ok = parse_register(&ps, &rs1) && comma(&ps) && parse_register(&ps, &rs2) &&
+             comma(&ps) && parse_target(&ps, pc, 1 << 12, &imm);
+        *insn = rv_encode_b(opcode, f3, rs1, rs2, imm);
+        break;
+    case F_U:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_range(&ps, 0, 0xFFFFF, &imm);
+        *insn = rv_encode_u(opcode, rd, (int32_t)((uint32_t)imm << 12));
+        break;
+    case F_J:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_target(&ps, pc, 1 << 20, &imm);
+        *insn = rv_encode_j(opcode, rd, imm);
+        break;
+    case F_CSR:
+    case F_CSRI:
+        ok = parse_register(&ps, &rd) && comma(&ps) && parse_csr(&ps, &csr) && comma(&ps);
+        if (ok && o->format == F_CSR)
+            ok = parse_register(&ps, &rs1);
+        else if (ok && parse_range(&ps, 0, 31, &imm))
+            rs1 = (uint32_t)imm;
+        else
+            ok = 0;
+        *insn = rv_encode_i(opcode, f3, rd, rs1, (int32_t)csr);
+        break;
+    case F_FENCE: {
+        uint32_t pred = 0xF, succ = 0xF;
+        skip_spaces(&ps);
+        if (*ps.s != '\0' && *ps.s != '#')
+            ok = parse_fence_set(&ps, &pred) && comma(&ps) && parse_fence_set(&ps, &succ);
+        *insn = pred << 24 | succ << 20 | o->match;
+        break;
+    }
+    case F_NONE:
+        *insn = o->match;
+        break;
+    }
+    if (!ok)
+        return 0;
+    skip_spaces(&ps);
+    if (*ps.s != '\0' && *ps.s != '#' && *ps.s != '\n')
+        return fail(&ps, "unexpected \"%s\" after the operands", ps.s);
+    return 1;
+}
@@ -0,0 +1,48 @@
+/*
+ * disasm.h - rv32im disassembler and one-line assembler
+ *
+ * One table of instructions, used both ways, so what rv_disasm prints
+ * rv_assemble reads back to the same word:
+ *
+ *   addi    a0, zero, 10
+ *   lw      t1, 8(sp)
+ *   beq     a1, a2, 0x80000020      (branch and jal targets as addresses)
+ *   lui     t0, 0x10000
+ *   csrrw   zero, mtvec, t0
+ *
+ * Covered: rv32i, M, Zicsr, fence/fence.i and mret/wfi. Instructions are
+ * printed in their base form (addi, not li or mv) with ABI register
+ * names; rv_assemble also takes x0-x31. Anything else, including the
+ * vector instructions vector.h runs, comes out as .word.
+ *
+ * Both write into the caller's buffer and never allocate, so a
+ * multi-megabyte image is listed in well under a second (rvdis.c).
+ */
+
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RV_DISASM_SIZE 64       // enough for any rv_disasm text
+#define RV_FIELDS_SIZE 80       // and any rv_disasm_fields text
+
+// The instruction at pc as text in out; returns the length. Branches and
+// jal show their target address.
+size_t rv_disasm(uint32_t insn, uint32_t pc, char *out);
+// The encoding's format and fields, most significant first, e.g.
+// "I  imm=10 rs1=0 f3=0 rd=10 op=0x13"; returns the length
+size_t rv_disasm_fields(uint32_t insn, char *out);
+// 1 if insn is one of the instructions above, 0 if rv_disasm would
+// print it as .word
+int rv_decodes(uint32_t insn);
+// Where a branch or jal at pc goes; 0 for anything else (jalr's target
+// is in a register)
+int rv_branch_target(uint32_t insn, uint32_t pc, uint32_t *target);
+
+// One instruction in rv_disasm's syntax, at pc. 0 on failure, with a
+// message in error.
+int rv_assemble(const char *text, uint32_t pc, uint32_t *insn, char *error, size_t error_size);
+
+#endif
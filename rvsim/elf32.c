@@ -0,0 +1,214 @@
+/*
+ * elf32.c - ELF32 loader (see elf32.h)
+ *
+ * The whole file is read into memory and every offset is checked against
+ * its size before use, so a truncated or corrupt file fails with a
+ * message rather than reading past the buffer.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf32.h"
+
+#define EM_RISCV 243
+#define PT_LOAD 1
+#define SHT_SYMTAB 2
+#define STT_NOTYPE 0
+#define STT_OBJECT 1
+#define STT_FUNC 2
+
+static void fail(char *error, size_t error_size, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+}
+
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Whether [offset, offset + length) lies inside a file of size bytes
+static int inside(size_t size, uint32_t offset, uint32_t length) {
+    return offset <= size && length <= size - offset;
+}
+
+static int by_address(const void *a, const void *b) {
+    const rv_symbol *x = a, *y = b;
+    if (x->address != y->address)
+        return x->address < y->address ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+// Labels from .symtab. Assembler-local names ($x mapping symbols, .L
+// labels) and section/file symbols are left out.
+static int load_symbols(const uint8_t *file, size_t size, rv_image *image) {
+    uint32_t shoff = get32(file + 32);
+    uint16_t shentsize = get16(file + 46), shnum = get16(file + 48);
+    if (shoff == 0 || shnum == 0)
+        return 1;               // stripped: no labels, but still runnable
+    if (shentsize < 40 || !inside(size, shoff, (uint32_t)shentsize * shnum))
+        return 0;
+    for (uint16_t s = 0; s < shnum; s++) {
+        const uint8_t *sh = file + shoff + (size_t)s * shentsize;
+        if (get32(sh + 4) != SHT_SYMTAB)
+            continue;
+        uint32_t offset = get32(sh + 16), length = get32(sh + 20), link = get32(sh + 24);
+        if (link >= shnum || !inside(size, offset, length))
+            return 0;
+        const uint8_t *strtab_header = file + shoff + (size_t)link * shentsize;
+        uint32_t strtab = get32(strtab_header + 16), strtab_size = get32(strtab_header + 20);
+        if (!inside(size, strtab, strtab_size))
+            return 0;
+        size_t count = length / 16;
+        image->symbols = calloc(count ? count : 1, sizeof(rv_symbol));
+        if (image->symbols == NULL)
+            return 0;
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t *sym = file + offset + i * 16;
+            uint32_t name = get32(sym);
+            unsigned type = sym[12] & 0xF;
+            uint16_t section = get16(sym + 14);
+            if (section == 0 || section >= 0xFF00 || name >= strtab_size)
+                continue;
+            if (type != STT_NOTYPE && type != STT_OBJECT && type != STT_FUNC)
+                continue;
+            const char *text = (const char *)file + strtab + name;
+            size_t text_length = strnlen(text, strtab_size - name);
+            if (text_length == 0 || text_length == strtab_size - name)
+                continue;       // empty or not NUL-terminated
+            if (text[0] == '$' || strncmp(text, ".L", 2) == 0)
+                continue;
+            char *copy = malloc(text_length + 1);
+            if (copy == NULL)
+                return 0;
+            memcpy(copy, text, text_length + 1);
+            image->symbols[image->symbol_count].name = copy;
+            image->symbols[image->symbol_count].address = get32(sym + 4);
+            image->symbols[image->symbol_count].size = get32(sym + 8);
+            image->symbol_count++;
+        }
+        qsort(image->symbols, image->symbol_count, sizeof(rv_symbol), by_address);
+        return 1;
+    }
+    return 1;
+}
+
+static int load_image(rv_cpu *cpu, const uint8_t *file, size_t size, rv_image *image,
+                      char *error, size_t error_size) {
+    if (size < 52 || memcmp(file, "\177ELF", 4) != 0) {
+        fail(error, error_size, "not an ELF file");
+        return 0;
+    }
+    if (file[4] != 1 || file[5] != 1 || get16(file + 18) != EM_RISCV) {
+        fail(error, error_size, "not a 32-bit little-endian RISC-V ELF");
+        return 0;
+    }
+    uint32_t phoff = get32(file + 28);
+    uint16_t phentsize = get16(file + 42), phnum = get16(file + 44);
+    if (phnum == 0 || phentsize < 32 || !inside(size, phoff, (uint32_t)phentsize * phnum)) {
+        fail(error, error_size, "bad program header table");
+        return 0;
+    }
+    for (uint16_t p = 0; p < phnum; p++) {
+        const uint8_t *ph = file + phoff + (size_t)p * phentsize;
+        if (get32(ph) != PT_LOAD)
+            continue;
+        uint32_t offset = get32(ph + 4), paddr = get32(ph + 12);
+        uint32_t filesz = get32(ph + 16), memsz = get32(ph + 20);
+        if (!inside(size, offset, filesz) || filesz > memsz) {
+            fail(error, error_size, "segment %u runs past the end of the file", p);
+            return 0;
+        }
+        // RAM starts zeroed, so the .bss tail (memsz - filesz) needs no work,
+        // but it must still fit
+        if (!rv_cpu_write(cpu, paddr, file + offset, filesz) || memsz > cpu->ram_size ||
+            paddr - cpu->ram_base > cpu->ram_size - memsz) {
+            fail(error, error_size, "segment %u (0x%08x, %u bytes) is outside RAM", p, paddr,
+                 memsz);
+            return 0;
+        }
+        if (image->segment_count == RV_MAX_SEGMENTS) {
+            fail(error, error_size, "more than %d loadable segments", RV_MAX_SEGMENTS);
+            return 0;
+        }
+        image->segments[image->segment_count++] = (rv_segment){paddr, filesz, get32(ph + 24)};
+    }
+    image->entry = get32(file + 24);
+    if (!load_symbols(file, size, image)) {
+        fail(error, error_size, "bad or unreadable symbol table");
+        return 0;
+    }
+    cpu->pc = image->entry;
+    return 1;
+}
+
+int rv_load_elf(rv_cpu *cpu, const char *path, rv_image *image, char *error, size_t error_size) {
+    memset(image, 0, sizeof(*image));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fail(error, error_size, "cannot open %s", path);
+        return 0;
+    }
+    uint8_t *file = NULL;
+    size_t size = 0, capacity = 0, n;
+    do {
+        if (size == capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            uint8_t *bigger = realloc(file, capacity);
+            if (bigger == NULL) {
+                free(file);
+                fclose(f);
+                fail(error, error_size, "out of memory");
+                return 0;
+            }
+            file = bigger;
+        }
+        n = fread(file + size, 1, capacity - size, f);
+        size += n;
+    } while (n > 0);
+    int ok = !ferror(f);
+    fclose(f);
+    if (!ok)
+        fail(error, error_size, "cannot read %s", path);
+    else
+        ok = load_image(cpu, file, size, image, error, error_size);
+    free(file);
+    if (!ok)
+        rv_image_free(image);
+    return ok;
+}
+
+void rv_image_free(rv_image *image) {
+    for (size_t i = 0; i < image->symbol_count; i++)
+        free(image->symbols[i].name);
+    free(image->symbols);
+    memset(image, 0, sizeof(*image));
+}
+
+const rv_symbol *rv_symbol_at(const rv_image *image, uint32_t address) {
+    size_t lo = 0, hi = image->symbol_count;
+    while (lo < hi) {           // first symbol above address
+        size_t mid = lo + (hi - lo) / 2;
+        if (image->symbols[mid].address <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo == 0 ? NULL : &image->symbols[lo - 1];
+}
+
+int rv_symbol_find(const rv_image *image, const char *name, uint32_t *address) {
+    for (size_t i = 0; i < image->symbol_count; i++) {
+        if (strcmp(image->symbols[i].name, name) == 0) {
+            *address = image->symbols[i].address;
+            return 1;
+        }
+    }
+    return 0;
+}
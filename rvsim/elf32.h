@@ -0,0 +1,50 @@
+/*
+ * elf32.h - Load a 32-bit RISC-V ELF into the simulator
+ *
+ * Only what rvsim needs: the PT_LOAD segments go into RAM, the entry
+ * point becomes the pc, and the symbol table is kept so addresses can be
+ * turned back into labels (_start, loop, _add_two_five_times, ...).
+ */
+
+#ifndef ELF32_H
+#define ELF32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+typedef struct {
+    char *name;
+    uint32_t address;
+    uint32_t size;              // from .size; 0 for most assembly labels
+} rv_symbol;
+
+#define RV_MAX_SEGMENTS 16
+#define RV_SEGMENT_EXECUTE 1    // p_flags' PF_X
+
+typedef struct {
+    uint32_t address;
+    uint32_t size;              // the bytes from the file; the rest is zeroed
+    uint32_t flags;
+} rv_segment;
+
+typedef struct {
+    uint32_t entry;
+    rv_symbol *symbols;         // sorted by address
+    size_t symbol_count;
+    rv_segment segments[RV_MAX_SEGMENTS];       // the PT_LOAD ones, in file order
+    size_t segment_count;
+} rv_image;
+
+// Load path into cpu's RAM and point cpu->pc at the entry. 0 on failure,
+// with a message in error.
+int rv_load_elf(rv_cpu *cpu, const char *path, rv_image *image, char *error, size_t error_size);
+void rv_image_free(rv_image *image);
+
+// The label at or before address, NULL if there is none
+const rv_symbol *rv_symbol_at(const rv_image *image, uint32_t address);
+// 0 if there is no such label
+int rv_symbol_find(const rv_image *image, const char *name, uint32_t *address);
+
+#endif
@@ -0,0 +1,393 @@
+/*
+ * main.c - rvsim: run rv32i ELFs and report what they did
+ *
+ *   rvsim [--max N] [--stop LABEL] [--ram MIB] [--profile] [--regs] [--decode]
+ *         [--dbt] [--threshold N] [--vlen BITS] [--elements N] [--quiet]
+ *         [--dump WHAT]... prog.elf...
+ *
+ * --max      stop after N instructions (default 1e9)
+ * --stop     stop when the pc reaches LABEL, e.g. done
+ * --ram      RAM size at 0x80000000 in MiB (default 16)
+ * --profile  instructions and cycles per label, hottest first (this
+ *            decodes every fetch)
+ * --regs     dump the registers at the end
+ * --decode   decode every fetch instead of using the block cache
+ * --dbt      also compile hot blocks to x86-64 (not with --stop)
+ * --threshold  block entries before --dbt compiles one (default 16)
+ * --vlen     vector register width, 32 to 1024 bits (default 128)
+ * --elements also print instructions and cycles per element, for a
+ *            program that processes N of them
+ * --quiet    one PASS/FAIL line per program instead of the counters
+ * --dump     memory at the end, as words: LABEL (its .size, or up to the
+ *            next label), LABEL:BYTES or ADDRESS:BYTES, e.g. my_array:12
+ *
+ * The program runs until one of sim.h's stop conditions, with the virt
+ * board's sifive_test, UART0 and CLINT timer in place (devices.h): what it
+ * prints goes to stdout, the timer interrupt goes to mtvec and writing to
+ * sifive_test ends it, as under QEMU. Falling off the end of m.s without
+ * --stop done is the "illegal instruction" stop at the first zero word.
+ *
+ * This is the headless way to run the sandbox's programs: no QEMU to
+ * start, no gdb to attach, and each run takes milliseconds. Several ELFs
+ * run one after the other in the same process.
+ *
+ * Exit status: with one program, the code it gave sifive_test if it did
+ * (0 for a pass; the low 8 bits of any other code, or 1 if those are 0,
+ * so a failure never exits 0), otherwise 0 if it stopped the way a
+ * finished program does (--stop's label, `j .`, ecall, ebreak, or running
+ * off the end of its code onto a zero word past everything loaded) and 1
+ * if it hit the instruction limit, any other illegal instruction or a bad
+ * access, never ran, or ended somewhere other than --stop's label. With
+ * several, 1 if any of them failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "devices.h"
+#include "elf32.h"
+#include "sim.h"
+
+#define MAX_DUMPS 16
+#define DUMP_GUESS_LIMIT 256        // bytes, for a label without .size
+
+static const char *const abi_names[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0", "s1", "a0",
+    "a1",   "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5",
+    "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rvsim [--max N] [--stop LABEL] [--ram MIB] [--profile] [--regs] "
+                    "[--decode] [--dbt] [--threshold N] [--vlen BITS] [--elements N] "
+                    "[--quiet] [--dump WHAT]... prog.elf...\n");
+}
+
+typedef struct {
+    const char *name;
+    uint64_t instret, cycles;
+} label_total;
+
+static int by_cycles(const void *a, const void *b) {
+    const label_total *x = a, *y = b;
+    if (x->cycles != y->cycles)
+        return x->cycles > y->cycles ? -1 : 1;
+    return 0;
+}
+
+// One row per label that ran; instructions before the first label go
+// under "?"
+static void print_profile(const rv_cpu *cpu, const rv_image *image) {
+    size_t rows = image->symbol_count + 1;
+    label_total *totals = calloc(rows, sizeof(label_total));
+    if (totals == NULL) {
+        fprintf(stderr, "rvsim: out of memory for the profile\n");
+        return;
+    }
+    for (size_t i = 0; i < image->symbol_count; i++)
+        totals[i].name = image->symbols[i].name;
+    totals[image->symbol_count].name = "?";
+    for (uint32_t word = 0; word < cpu->ram_size / 4; word++) {
+        if (cpu->profile_instret[word] == 0)
+            continue;
+        const rv_symbol *symbol = rv_symbol_at(image, cpu->ram_base + word * 4);
+        size_t row = symbol ? (size_t)(symbol - image->symbols) : image->symbol_count;
+        totals[row].instret += cpu->profile_instret[word];
+        totals[row].cycles += cpu->profile_cycles[word];
+    }
+    qsort(totals, rows, sizeof(label_total), by_cycles);
+    printf("\n%-24s %14s %14s %7s %6s\n", "label", "instructions", "cycles", "cycles%", "CPI");
+    for (size_t i = 0; i < rows && totals[i].instret > 0; i++) {
+        printf("%-24s %14llu %14llu %6.2f%% %6.2f\n", totals[i].name,
+               (unsigned long long)totals[i].instret, (unsigned long long)totals[i].cycles,
+               100.0 * totals[i].cycles / (cpu->cycles ? cpu->cycles : 1),
+               (double)totals[i].cycles / totals[i].instret);
+    }
+    free(totals);
+}
+
+// --dump's argument: a label, or an address when it starts with a digit
+typedef struct {
+    const char *label;
+    uint32_t address, bytes;        // bytes 0: work it out from the label
+} dump_request;
+
+typedef struct {
+    uint64_t max, elements;
+    const char *stop_label;
+    unsigned ram_mib, threshold, vlen;
+    int profile, regs, decode, dbt, quiet;
+    dump_request dumps[MAX_DUMPS];
+    size_t dump_count;
+} options;
+
+static int parse_dump(const char *arg, dump_request *dump) {
+    char *end;
+    const char *colon = strchr(arg, ':');
+    dump->label = NULL;
+    dump->address = 0;
+    dump->bytes = 0;
+    if (colon != NULL) {
+        dump->bytes = (uint32_t)strtoul(colon + 1, &end, 0);
+        if (*end != '\0' || dump->bytes == 0)
+            return 0;
+    }
+    if (arg[0] >= '0' && arg[0] <= '9') {
+        dump->address = (uint32_t)strtoul(arg, &end, 0);
+        return end == (colon ? colon : arg + strlen(arg)) && colon != NULL;
+    }
+    if (colon == arg)
+        return 0;
+    dump->label = arg;              // parse_dump's caller keeps arg alive
+    return 1;
+}
+
+// One dump, or 0 with a message if its label or range is not there
+static int print_dump(const rv_cpu *cpu, const rv_image *image, const dump_request *dump) {
+    uint32_t address = dump->address, bytes = dump->bytes;
+    char name[64];
+    if (dump->label != NULL) {
+        size_t length = strcspn(dump->label, ":");
+        snprintf(name, sizeof(name), "%.*s", (int)length, dump->label);
+        if (!rv_symbol_find(image, name, &address)) {
+            fprintf(stderr, "rvsim: --dump: no label %s\n", name);
+            return 0;
+        }
+        for (size_t i = 0; bytes == 0 && i < image->symbol_count; i++) {
+            const rv_symbol *symbol = &image->symbols[i];
+            if (symbol->address == address && symbol->size != 0)
+                bytes = symbol->size;
+            else if (symbol->address > address)
+                bytes = symbol->address - address;
+        }
+        if (bytes == 0 || bytes > DUMP_GUESS_LIMIT)
+            bytes = bytes == 0 ? 64 : DUMP_GUESS_LIMIT;
+    } else {
+        snprintf(name, sizeof(name), "0x%08x", address);
+    }
+    uint8_t *memory = malloc(bytes);
+    if (memory == NULL || !rv_cpu_read(cpu, address, memory, bytes)) {
+        fprintf(stderr, "rvsim: --dump: %s (%u bytes) is not all in RAM\n", name, bytes);
+        free(memory);
+        return 0;
+    }
+    printf("%s (0x%08x, %u bytes):", name, address, bytes);
+    for (uint32_t i = 0; i < bytes; i += 4) {
+        if (i % 32 == 0)
+            printf("\n  0x%08x ", address + i);
+        if (bytes - i >= 4) {
+            uint32_t word;
+            memcpy(&word, memory + i, 4);
+            printf(" %08x", word);
+        } else {
+            printf(" ");
+            for (uint32_t j = bytes - 1; j >= i && j < bytes; j--)
+                printf("%02x", memory[j]);
+        }
+    }
+    printf("\n");
+    free(memory);
+    return 1;
+}
+
+// 1 if the pc is on a zero word past the end of everything loaded: the
+// program ran off the end of its code, as m.s does without --stop
+static int ran_off_end(const rv_cpu *cpu, const rv_image *image) {
+    uint32_t word;
+    if (!rv_cpu_read(cpu, cpu->pc, &word, 4) || word != 0)
+        return 0;
+    for (size_t i = 0; i < image->segment_count; i++) {
+        const rv_segment *segment = &image->segments[i];
+        if (cpu->pc < (uint64_t)segment->address + segment->size)
+            return 0;
+    }
+    return 1;
+}
+
+// 0 for a program that finished, otherwise what the process should exit
+// with (see the top of the file)
+static int run_status(enum rv_stop stop, const rv_cpu *cpu, const rv_image *image,
+                      const rv_devices *devices, int wants_stop) {
+    switch (stop) {
+    case RV_STOP_EXIT:
+        // a process only passes on 8 bits: keep 0x100 and the like failures
+        if (devices->exit_status & 0xFF)
+            return (int)(devices->exit_status & 0xFF);
+        return devices->exit_status != 0;
+    case RV_STOP_PC:
+        return 0;
+    case RV_STOP_IDLE_LOOP:
+    case RV_STOP_ECALL:
+    case RV_STOP_EBREAK:
+        return wants_stop;
+    case RV_STOP_ILLEGAL:
+        return wants_stop || cpu->instret == 0 || !ran_off_end(cpu, image);
+    default:
+        return 1;
+    }
+}
+
+static void print_stop(enum rv_stop stop, const rv_cpu *cpu, const rv_image *image,
+                       const rv_devices *devices) {
+    const rv_symbol *where = rv_symbol_at(image, cpu->pc);
+    printf("%s", rv_stop_name(stop));
+    if (stop == RV_STOP_EXIT)
+        printf(" (status %u)", devices->exit_status);
+    printf(" at 0x%08x", cpu->pc);
+    if (where != NULL)
+        printf(" (%s+0x%x)", where->name, cpu->pc - where->address);
+    if (stop >= RV_STOP_FETCH_FAULT)
+        printf(", address 0x%08x", cpu->fault_address);
+}
+
+// Load, run and report one program; returns its run_status, or 1 if it
+// could not run at all
+static int run_program(const char *path, const options *o) {
+    rv_cpu cpu;
+    rv_image image;
+    rv_devices devices;
+    char error[256];
+    if (!rv_cpu_init(&cpu, RV_RAM_BASE, o->ram_mib << 20) ||
+        (o->profile && !rv_cpu_enable_profile(&cpu)) ||
+        (!o->decode && !rv_cpu_enable_blocks(&cpu))) {
+        fprintf(stderr, "rvsim: out of memory for %u MiB of RAM\n", o->ram_mib);
+        rv_cpu_free(&cpu);
+        return 1;
+    }
+    cpu.vlen = o->vlen;
+    if (o->dbt && !o->decode && !rv_cpu_enable_dbt(&cpu, o->threshold))
+        fprintf(stderr, "rvsim: no x86-64 translation on this host, interpreting\n");
+    if (!rv_load_elf(&cpu, path, &image, error, sizeof(error))) {
+        fprintf(stderr, "rvsim: %s: %s\n", path, error);
+        rv_cpu_free(&cpu);
+        return 1;
+    }
+    uint32_t stop_pc = 0;
+    if (o->stop_label != NULL && !rv_symbol_find(&image, o->stop_label, &stop_pc)) {
+        fprintf(stderr, "rvsim: %s: no label %s\n", path, o->stop_label);
+        rv_image_free(&image);
+        rv_cpu_free(&cpu);
+        return 1;
+    }
+
+    rv_devices_init(&devices, stdout);
+    double start = now_s();
+    enum rv_stop stop = rv_run_devices(&cpu, &devices, o->max, stop_pc);
+    double elapsed = now_s() - start;
+    int status = run_status(stop, &cpu, &image, &devices, o->stop_label != NULL);
+    if (devices.uart_bytes > 0 && devices.uart_last != '\n')
+        printf("\n");
+
+    if (o->quiet) {
+        printf("%s %s: ", status ? "FAIL" : "PASS", path);
+        print_stop(stop, &cpu, &image, &devices);
+        printf(", %llu instructions\n", (unsigned long long)cpu.instret);
+    } else {
+        printf("stopped:      ");
+        print_stop(stop, &cpu, &image, &devices);
+        printf("\ninstructions: %llu\n", (unsigned long long)cpu.instret);
+        printf("cycles:       %llu (CPI %.2f)\n", (unsigned long long)cpu.cycles,
+               cpu.instret ? (double)cpu.cycles / cpu.instret : 0.0);
+        printf("loads:        %llu\nstores:       %llu\n", (unsigned long long)cpu.loads,
+               (unsigned long long)cpu.stores);
+        printf("branches:     %llu (%llu taken)\n", (unsigned long long)cpu.branches,
+               (unsigned long long)cpu.taken_branches);
+        if (o->elements > 0)
+            printf("per element:  %.2f instructions, %.2f cycles (%llu elements)\n",
+                   (double)cpu.instret / o->elements, (double)cpu.cycles / o->elements,
+                   (unsigned long long)o->elements);
+        printf("speed:        %.1f MIPS\n", elapsed > 0 ? cpu.instret / elapsed / 1e6 : 0.0);
+    }
+    if (o->regs) {
+        for (int r = 0; r < 32; r++)
+            printf("x%-2d %-4s 0x%08x%s", r, abi_names[r], cpu.x[r], r % 4 == 3 ? "\n" : "   ");
+    }
+    for (size_t i = 0; i < o->dump_count; i++) {
+        if (!print_dump(&cpu, &image, &o->dumps[i]) && status == 0)
+            status = 1;
+    }
+    if (o->profile)
+        print_profile(&cpu, &image);
+
+    rv_image_free(&image);
+    rv_cpu_free(&cpu);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    options o = {.max = 1000000000, .ram_mib = 16, .threshold = RV_DBT_THRESHOLD,
+                 .vlen = RV_VLEN_DEFAULT};
+    const char **paths = calloc((size_t)argc, sizeof(char *));
+    size_t path_count = 0;
+    if (paths == NULL) {
+        fprintf(stderr, "rvsim: out of memory\n");
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            o.max = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--stop") == 0 && i + 1 < argc) {
+            o.stop_label = argv[++i];
+        } else if (strcmp(argv[i], "--ram") == 0 && i + 1 < argc) {
+            o.ram_mib = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            o.profile = 1;
+        } else if (strcmp(argv[i], "--regs") == 0) {
+            o.regs = 1;
+        } else if (strcmp(argv[i], "--decode") == 0) {
+            o.decode = 1;
+        } else if (strcmp(argv[i], "--dbt") == 0) {
+            o.dbt = 1;
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            o.threshold = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--vlen") == 0 && i + 1 < argc) {
+            o.vlen = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--elements") == 0 && i + 1 < argc) {
+            o.elements = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            o.quiet = 1;
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc && o.dump_count < MAX_DUMPS &&
+                   parse_dump(argv[i + 1], &o.dumps[o.dump_count])) {
+            o.dump_count++;
+            i++;
+        } else if (argv[i][0] != '-') {
+            paths[path_count++] = argv[i];
+        } else {
+            usage();
+            free(paths);
+            return 2;
+        }
+    }
+    if (path_count == 0 || o.ram_mib == 0 || o.ram_mib > 2048 || o.vlen < 32 ||
+        o.vlen > RV_VLEN_MAX || (o.vlen & (o.vlen - 1)) != 0) {
+        usage();
+        free(paths);
+        return 2;
+    }
+
+    int status = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < path_count; i++) {
+        if (path_count > 1 && !o.quiet)
+            printf("%s== %s ==\n", i > 0 ? "\n" : "", paths[i]);
+        fflush(stdout);
+        status = run_program(paths[i], &o);
+        failed += status != 0;
+        fflush(stdout);
+    }
+    if (path_count > 1) {
+        printf("%s%zu programs, %zu passed, %zu failed\n", o.quiet ? "" : "\n", path_count,
+               path_count - failed, failed);
+        status = failed > 0;
+    }
+    free(paths);
+    return status;
+}
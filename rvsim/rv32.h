@@ -0,0 +1,128 @@
+/*
+ * rv32.h - rv32i instruction fields and opcodes (plus the vector ones
+ * vector.h uses)
+ *
+ * Field extraction for the six base formats (R, I, S, B, U, J). The
+ * immediates come out sign-extended, already scaled the way the ISA
+ * manual defines them (B and J in bytes, U shifted into the top 20 bits).
+ * The rv_encode_* functions put the same fields back together, taking
+ * the immediates in the same form.
+ */
+
+#ifndef RV32_H
+#define RV32_H
+
+#include <stdint.h>
+
+enum rv_opcode {
+    RV_OP_LOAD = 0x03,
+    RV_OP_LOAD_FP = 0x07,       // vector loads here (no F/D)
+    RV_OP_MISC_MEM = 0x0F,      // fence
+    RV_OP_IMM = 0x13,
+    RV_OP_AUIPC = 0x17,
+    RV_OP_STORE = 0x23,
+    RV_OP_STORE_FP = 0x27,      // vector stores
+    RV_OP_REG = 0x33,
+    RV_OP_V = 0x57,             // vector arithmetic and vsetvl*
+    RV_OP_LUI = 0x37,
+    RV_OP_BRANCH = 0x63,
+    RV_OP_JALR = 0x67,
+    RV_OP_JAL = 0x6F,
+    RV_OP_SYSTEM = 0x73,
+};
+
+#define RV_INSN_ECALL 0x00000073u
+#define RV_INSN_EBREAK 0x00100073u
+#define RV_INSN_J_SELF 0x0000006Fu  // jal x0, 0: the "done: j done" idle loop
+#define RV_INSN_MRET 0x30200073u
+
+static inline uint32_t rv_opcode(uint32_t insn) { return insn & 0x7F; }
+static inline uint32_t rv_rd(uint32_t insn) { return (insn >> 7) & 0x1F; }
+static inline uint32_t rv_funct3(uint32_t insn) { return (insn >> 12) & 0x7; }
+static inline uint32_t rv_rs1(uint32_t insn) { return (insn >> 15) & 0x1F; }
+static inline uint32_t rv_rs2(uint32_t insn) { return (insn >> 20) & 0x1F; }
+static inline uint32_t rv_funct7(uint32_t insn) { return insn >> 25; }
+
+static inline int32_t rv_imm_i(uint32_t insn) { return (int32_t)insn >> 20; }
+
+// Gather the immediate bits unsigned, then sign-extend from the top one
+static inline int32_t rv_imm_s(uint32_t insn) {
+    uint32_t imm = (insn >> 25) << 5 | ((insn >> 7) & 0x1F);
+    return (int32_t)(imm << 20) >> 20;
+}
+
+static inline int32_t rv_imm_b(uint32_t insn) {
+    uint32_t imm = (insn >> 31) << 12 | ((insn << 4) & 0x800) | ((insn >> 20) & 0x7E0) |
+                   ((insn >> 7) & 0x1E);
+    return (int32_t)(imm << 19) >> 19;
+}
+
+static inline int32_t rv_imm_u(uint32_t insn) { return (int32_t)(insn & 0xFFFFF000u); }
+
+static inline int32_t rv_imm_j(uint32_t insn) {
+    uint32_t imm = (insn >> 31) << 20 | (insn & 0xFF000) | ((insn >> 9) & 0x800) |
+                   ((insn >> 20) & 0x7FE);
+    return (int32_t)(imm << 11) >> 11;
+}
+
+static inline uint32_t rv_encode_r(uint32_t opcode, uint32_t funct3, uint32_t funct7,
+                                   uint32_t rd, uint32_t rs1, uint32_t rs2) {
+    return funct7 << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+
+static inline uint32_t rv_encode_i(uint32_t opcode, uint32_t funct3, uint32_t rd, uint32_t rs1,
+                                   int32_t imm) {
+    return (uint32_t)imm << 20 | rs1 << 15 | funct3 << 12 | rd << 7 | opcode;
+}
+
+static inline uint32_t rv_encode_s(uint32_t opcode, uint32_t funct3, uint32_t rs1, uint32_t rs2,
+                                   int32_t imm) {
+    uint32_t u = (uint32_t)imm;
+    return (u >> 5 & 0x7F) << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 | (u & 0x1F) << 7 |
+           opcode;
+}
+
+static inline uint32_t rv_encode_b(uint32_t opcode, uint32_t funct3, uint32_t rs1, uint32_t rs2,
+                                   int32_t imm) {
+    uint32_t u = (uint32_t)imm;
+    return (u >> 12 & 1) << 31 | (u >> 5 & 0x3F) << 25 | rs2 << 20 | rs1 << 15 | funct3 << 12 |
+           (u >> 1 & 0xF) << 8 | (u >> 11 & 1) << 7 | opcode;
+}
+
+static inline uint32_t rv_encode_u(uint32_t opcode, uint32_t rd, int32_t imm) {
+    return ((uint32_t)imm & 0xFFFFF000u) | rd << 7 | opcode;
+}
+
+static inline uint32_t rv_encode_j(uint32_t opcode, uint32_t rd, int32_t imm) {
+    uint32_t u = (uint32_t)imm;
+    return (u >> 20 & 1) << 31 | (u >> 1 & 0x3FF) << 21 | (u >> 11 & 1) << 20 |
+           (u & 0xFF000) | rd << 7 | opcode;
+}
+
+// The registers an instruction reads, as a mask with bit n for xn
+static inline uint32_t rv_sources(uint32_t insn) {
+    switch (rv_opcode(insn)) {
+    case RV_OP_REG:
+    case RV_OP_STORE:
+    case RV_OP_BRANCH:
+        return 1u << rv_rs1(insn) | 1u << rv_rs2(insn);
+    case RV_OP_LOAD:
+    case RV_OP_IMM:
+    case RV_OP_JALR:
+    case RV_OP_LOAD_FP:
+    case RV_OP_STORE_FP:
+        return 1u << rv_rs1(insn);
+    case RV_OP_V:
+        // .vx forms and vsetvli read rs1; vsetivli's is an immediate,
+        // vsetvl also reads rs2
+        if (rv_funct3(insn) == 4)
+            return 1u << rv_rs1(insn);
+        if (rv_funct3(insn) != 7 || (insn >> 30) == 3)
+            return 0;
+        return 1u << rv_rs1(insn) | (insn >> 31 ? 1u << rv_rs2(insn) : 0);
+    default:
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * rvcost.c - Instructions and cycles per loop iteration, before running
+ *
+ *   rvcost [--load-use N] [--taken-branch N] [--mul N] [--div N] [--list] prog.elf
+ *
+ * Finds the loops in prog.elf's code (cfg.h) and prints, for each, what
+ * one iteration costs under the in-order model: the instruction mix, the
+ * load-use stalls and taken branches, and the cycles. For array_ops.s:
+ *
+ *   loop loop (0x80000014), 8 instructions, back from 0x80000030
+ *     per iteration: 8 instructions, 11 cycles, CPI 1.38
+ *     mix:           4 alu, 1 load, 1 store, 1 branch, 1 jump
+ *     penalties:     1 load-use stall, 1 taken branch or jump
+ *
+ * which is what `make simulate` measures per element. Loops inside loops
+ * are indented under them. A loop with more than one way round gives the
+ * longest and the shortest.
+ *
+ * --load-use, --taken-branch  the penalties in cycles (default 1 and 2,
+ *                             rvsim's)
+ * --mul, --div                extra cycles for M instructions (default 2
+ *                             and 32)
+ * --list                      the instructions of the longest way round
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "disasm.h"
+#include "elf32.h"
+#include "sim.h"
+
+static void usage(void) {
+    fprintf(stderr, "usage: rvcost [--load-use N] [--taken-branch N] [--mul N] [--div N] "
+                    "[--list] prog.elf\n");
+}
+
+static void print_where(const rv_image *image, uint32_t address) {
+    const rv_symbol *symbol = rv_symbol_at(image, address);
+    if (symbol == NULL)
+        printf("0x%08x", address);
+    else if (symbol->address == address)
+        printf("%s (0x%08x)", symbol->name, address);
+    else
+        printf("%s+0x%x (0x%08x)", symbol->name, address - symbol->address, address);
+}
+
+static const char *plural(unsigned long long n, const char *one, const char *many) {
+    return n == 1 ? one : many;
+}
+
+static void print_path(const rv_path *path, const char *indent, const char *what) {
+    printf("%s  %-15s%llu instructions, %llu cycles, CPI %.2f\n", indent, what,
+           (unsigned long long)path->instructions, (unsigned long long)path->cycles,
+           path->instructions ? (double)path->cycles / path->instructions : 0.0);
+    printf("%s  %-15s", indent, "mix:");
+    const char *separator = "";
+    for (int c = 0; c < RV_CLASS_COUNT; c++) {
+        if (path->mix[c] == 0)
+            continue;
+        printf("%s%u %s", separator, path->mix[c], rv_class_names[c]);
+        separator = ", ";
+    }
+    printf("\n%s  %-15s%u load-use %s, %u taken %s", indent, "penalties:",
+           path->load_use_stalls, plural(path->load_use_stalls, "stall", "stalls"), path->taken,
+           plural(path->taken, "branch or jump", "branches and jumps"));
+    if (path->calls)
+        printf(", %u %s (not counted inside)", path->calls, plural(path->calls, "call", "calls"));
+    printf("\n");
+}
+
+static void list_path(const rv_cpu *cpu, const rv_image *image, const rv_path *path,
+                      const char *indent) {
+    for (size_t i = 0; i < path->block_count; i++) {
+        const rv_span *span = &path->blocks[i];
+        const rv_symbol *symbol = rv_symbol_at(image, span->start);
+        if (symbol != NULL && symbol->address == span->start)
+            printf("%s    %s:\n", indent, symbol->name);
+        for (uint32_t pc = span->start; pc < span->end; pc += 4) {
+            uint32_t insn = 0;
+            char text[RV_DISASM_SIZE];
+            rv_cpu_read(cpu, pc, &insn, 4);
+            rv_disasm(insn, pc, text);
+            printf("%s      %08x:  %s\n", indent, pc, text);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    rv_cost_model model = RV_COST_MODEL_DEFAULT;
+    const char *path = NULL;
+    int list = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--load-use") == 0 && i + 1 < argc) {
+            model.timing.load_use = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--taken-branch") == 0 && i + 1 < argc) {
+            model.timing.taken_branch = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--mul") == 0 && i + 1 < argc) {
+            model.mul = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--div") == 0 && i + 1 < argc) {
+            model.div = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = 1;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (path == NULL) {
+        usage();
+        return 2;
+    }
+
+    rv_cpu cpu;
+    rv_image image;
+    char error[256];
+    if (!rv_cpu_init(&cpu, RV_RAM_BASE, 64u << 20)) {
+        fprintf(stderr, "rvcost: out of memory\n");
+        return 1;
+    }
+    if (!rv_load_elf(&cpu, path, &image, error, sizeof(error))) {
+        fprintf(stderr, "rvcost: %s: %s\n", path, error);
+        rv_cpu_free(&cpu);
+        return 1;
+    }
+    rv_loop *loops;
+    size_t count;
+    int ok = rv_find_loops(&cpu, &image, &model, &loops, &count, error, sizeof(error));
+    if (!ok) {
+        fprintf(stderr, "rvcost: %s: %s\n", path, error);
+    } else {
+        printf("%s: load-use +%u, taken branch +%u, mul +%u, div +%u cycles\n", path,
+               model.timing.load_use, model.timing.taken_branch, model.mul, model.div);
+        if (count == 0)
+            printf("\nno loops\n");
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        const rv_loop *loop = &loops[i];
+        char indent[32] = "";
+        for (unsigned d = 1; d < loop->depth && d < 8; d++)
+            strcat(indent, "    ");
+        printf("\n%sloop ", indent);
+        print_where(&image, loop->header);
+        printf(", %llu instructions, back from 0x%08x\n",
+               (unsigned long long)loop->body_instructions, loop->latch);
+        int same = loop->longest.cycles == loop->shortest.cycles &&
+                   loop->longest.instructions == loop->shortest.instructions;
+        print_path(&loop->longest, indent, same ? "per iteration:" : "longest:");
+        if (!same)
+            print_path(&loop->shortest, indent, "shortest:");
+        if (list)
+            list_path(&cpu, &image, &loop->longest, indent);
+    }
+    rv_loops_free(loops, count);
+    rv_image_free(&image);
+    rv_cpu_free(&cpu);
+    return !ok;
+}
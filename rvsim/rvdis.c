@@ -0,0 +1,261 @@
+/*
+ * rvdis.c - Annotated listing of rv32im machine code (disasm.h)
+ *
+ *   rvdis [--base ADDR] [--labels prog.elf] [--no-fields] prog.elf|image.bin
+ *   rvdis --encode [--base ADDR] 'addi a0, a0, 1'...
+ *
+ * One line per word: its address, the word, the instruction and its
+ * encoding fields, with the labels above the words they name and
+ * branch and jal targets named too:
+ *
+ *   _add_two_five_times:
+ *   8000000c:  01248933  add     s2, s1, s2                      R  f7=0x0 rs2=18 rs1=9 f3=0 rd=18 op=0x33
+ *   80000010:  fff98993  addi    s3, s3, -1                      I  imm=-1 rs1=19 f3=0 rd=19 op=0x13
+ *   80000014:  fe099ce3  bne     s3, zero, 0x8000000c <_add_two_five_times> B  imm=-8 ...
+ *
+ * An ELF's executable segments are listed with its own labels. A raw
+ * image (objcopy -O binary) starts at --base, 0x80000000 by default, and
+ * takes its labels from --labels if given. The listing depends on
+ * nothing but the bytes and the labels, so two images can be diffed
+ * with it; a few megabytes take well under a second.
+ *
+ * --no-fields  leave out the encoding fields
+ * --encode     assemble the arguments instead, one instruction each at
+ *              consecutive addresses from --base, and list the result
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "disasm.h"
+#include "elf32.h"
+#include "sim.h"
+
+#define TEXT_WIDTH 40           // the fields start in this column
+#define OUTPUT_BUFFER (1u << 20)
+
+typedef struct {
+    uint32_t base;
+    const char *labels_path;
+    int fields;
+    int encode;
+} options;
+
+static void usage(void) {
+    fprintf(stderr, "usage: rvdis [--base ADDR] [--labels prog.elf] [--no-fields] "
+                    "prog.elf|image.bin\n"
+                    "       rvdis --encode [--base ADDR] 'INSTRUCTION'...\n");
+}
+
+static char *put_hex8(char *p, uint32_t value) {
+    static const char hex[] = "0123456789abcdef";
+    for (int shift = 28; shift >= 0; shift -= 4)
+        *p++ = hex[(value >> shift) & 0xF];
+    return p;
+}
+
+static char *put_string(char *p, const char *s) {
+    size_t n = strlen(s);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+// " <label>" or " <label+0x10>" for a branch or jal target
+static char *put_target(char *p, const rv_image *image, uint32_t insn, uint32_t pc) {
+    uint32_t target;
+    if (image == NULL || !rv_branch_target(insn, pc, &target))
+        return p;
+    const rv_symbol *symbol = rv_symbol_at(image, target);
+    if (symbol == NULL)
+        return p;
+    p = put_string(p, " <");
+    p = put_string(p, symbol->name);
+    if (symbol->address != target) {
+        char offset[16];
+        snprintf(offset, sizeof offset, "+0x%x", target - symbol->address);
+        p = put_string(p, offset);
+    }
+    return put_string(p, ">");
+}
+
+// The listing of count words at address; labels from image, which may be
+// NULL. The line is built in place and written in one go.
+static void list_words(const uint8_t *bytes, size_t count, uint32_t address,
+                       const rv_image *image, int fields) {
+    size_t next = 0;            // the first label not yet printed
+    char line[TEXT_WIDTH + RV_DISASM_SIZE + RV_FIELDS_SIZE + 512];
+    for (size_t i = 0; i < count; i++, address += 4) {
+        const uint8_t *b = bytes + 4 * i;
+        uint32_t insn = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 |
+                        (uint32_t)b[3] << 24;
+        for (; image && next < image->symbol_count; next++) {
+            const rv_symbol *symbol = &image->symbols[next];
+            if (symbol->address > address)
+                break;
+            if (symbol->address == address)
+                printf("%s:\n", symbol->name);
+        }
+        char *p = put_hex8(line, address);
+        p = put_string(p, ":  ");
+        p = put_hex8(p, insn);
+        p = put_string(p, "  ");
+        char *text = p;
+        p += rv_disasm(insn, address, p);
+        p = put_target(p, image, insn, address);
+        if (fields) {
+            do
+                *p++ = ' ';
+            while (p - text < TEXT_WIDTH);
+            p += rv_disasm_fields(insn, p);
+        }
+        *p++ = '\n';
+        fwrite(line, 1, (size_t)(p - line), stdout);
+    }
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return NULL;
+    uint8_t *data = NULL;
+    size_t capacity = 0, n;
+    *size = 0;
+    do {
+        if (*size == capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            uint8_t *bigger = realloc(data, capacity);
+            if (bigger == NULL) {
+                free(data);
+                fclose(f);
+                return NULL;
+            }
+            data = bigger;
+        }
+        n = fread(data + *size, 1, capacity - *size, f);
+        *size += n;
+    } while (n > 0);
+    int ok = !ferror(f);
+    fclose(f);
+    if (!ok) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+// Load path's segments into cpu, with RAM at 0x80000000 at least as big
+// as the file
+static int load_elf(const char *path, rv_cpu *cpu, rv_image *image) {
+    char error[256];
+    uint32_t ram = 16u << 20;
+    FILE *f = fopen(path, "rb");
+    if (f != NULL && fseek(f, 0, SEEK_END) == 0) {
+        long size = ftell(f);
+        while (ram < (unsigned long)size && ram < (1u << 30))
+            ram *= 2;
+    }
+    if (f != NULL)
+        fclose(f);
+    if (!rv_cpu_init(cpu, RV_RAM_BASE, ram)) {
+        fprintf(stderr, "rvdis: out of memory\n");
+        return 0;
+    }
+    if (!rv_load_elf(cpu, path, image, error, sizeof(error))) {
+        fprintf(stderr, "rvdis: %s: %s\n", path, error);
+        rv_cpu_free(cpu);
+        return 0;
+    }
+    return 1;
+}
+
+static int encode(const options *o, char **lines, int count) {
+    uint32_t address = o->base;
+    for (int i = 0; i < count; i++, address += 4) {
+        uint32_t insn;
+        char error[128];
+        if (!rv_assemble(lines[i], address, &insn, error, sizeof(error))) {
+            fprintf(stderr, "rvdis: %s: %s\n", lines[i], error);
+            return 1;
+        }
+        uint8_t bytes[4] = {(uint8_t)insn, (uint8_t)(insn >> 8), (uint8_t)(insn >> 16),
+                            (uint8_t)(insn >> 24)};
+        list_words(bytes, 1, address, NULL, o->fields);
+    }
+    return 0;
+}
+
+static int disassemble(const options *o, const char *path) {
+    size_t size;
+    uint8_t *file = read_file(path, &size);
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+    int elf = size >= 4 && memcmp(file, "\177ELF", 4) == 0;
+    const char *labels_path = elf ? path : o->labels_path;
+    rv_cpu cpu;
+    rv_image image;
+    if (labels_path != NULL && !load_elf(labels_path, &cpu, &image)) {
+        free(file);
+        return 1;
+    }
+
+    if (elf) {
+        for (size_t s = 0; s < image.segment_count; s++) {
+            const rv_segment *segment = &image.segments[s];
+            if (segment->flags & RV_SEGMENT_EXECUTE)
+                list_words(cpu.ram + (segment->address - cpu.ram_base), segment->size / 4,
+                           segment->address, &image, o->fields);
+        }
+    } else {
+        list_words(file, size / 4, o->base, labels_path ? &image : NULL, o->fields);
+        if (size % 4)
+            fprintf(stderr, "rvdis: %s: %zu bytes left over at the end\n", path, size % 4);
+    }
+
+    if (labels_path != NULL) {
+        rv_image_free(&image);
+        rv_cpu_free(&cpu);
+    }
+    free(file);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    options o = {RV_RAM_BASE, NULL, 1, 0};
+    char **arguments = malloc((size_t)argc * sizeof(char *));
+    int count = 0;
+    if (arguments == NULL) {
+        fprintf(stderr, "rvdis: out of memory\n");
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--base") == 0 && i + 1 < argc) {
+            o.base = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--labels") == 0 && i + 1 < argc) {
+            o.labels_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-fields") == 0) {
+            o.fields = 0;
+        } else if (strcmp(argv[i], "--encode") == 0) {
+            o.encode = 1;
+        } else if (argv[i][0] != '-' || o.encode) {
+            arguments[count++] = argv[i];
+        } else {
+            usage();
+            free(arguments);
+            return 2;
+        }
+    }
+    if (count == 0 || (!o.encode && count != 1)) {
+        usage();
+        free(arguments);
+        return 2;
+    }
+
+    static char output[OUTPUT_BUFFER];
+    setvbuf(stdout, output, _IOFBF, sizeof output);
+    int status = o.encode ? encode(&o, arguments, count) : disassemble(&o, arguments[0]);
+    free(arguments);
+    return status;
+}
@@ -0,0 +1,261 @@
+/*
+ * rvprof.c - Flat profile from ../rvlib/profile.s's samples
+ *
+ *   rvprof [--pc] prog.elf [qemu-output]
+ *
+ * Reads what the program printed under QEMU or rvsim (a file, or stdin),
+ * passes its own output through and picks out the "rvprof" report: one
+ * mepc per timer interrupt. Each sample is charged to the label at or before it in
+ * prog.elf, and the labels are listed with the most samples first, so a
+ * loop that runs for billions of instructions shows up as the share of
+ * time it took without stepping through any of it.
+ *
+ * --pc  also list every sampled address, hottest first
+ *
+ * A sample is where the interrupt landed, so it says which instruction
+ * was about to run; with a period of N ticks each one stands for about
+ * N * 100 instructions under -icount shift=0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf32.h"
+#include "sim.h"
+
+#define REPORT_RUNNING 0xFFFFFFFFu      // profile_report called by the program
+#define REPORT_IDLE 0x80000007u         // the timer found the program at `j .`
+#define REPORT_FULL 0xFFFFFFFEu         // no room for another sample
+
+typedef struct {
+    uint32_t period, samples, room, mcause, mepc;
+    uint32_t *pcs;
+    size_t count, capacity;
+} report;
+
+typedef struct {
+    const char *name;
+    uint32_t address;           // of the label, or of the pc for --pc
+    uint64_t samples;
+} row;
+
+static void usage(void) { fprintf(stderr, "usage: rvprof [--pc] prog.elf [qemu-output]\n"); }
+
+static int by_value(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int by_samples(const void *a, const void *b) {
+    const row *x = a, *y = b;
+    if (x->samples != y->samples)
+        return x->samples > y->samples ? -1 : 1;
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static int add_sample(report *r, uint32_t pc) {
+    if (r->count == r->capacity) {
+        size_t capacity = r->capacity ? r->capacity * 2 : 4096;
+        uint32_t *pcs = realloc(r->pcs, capacity * sizeof(uint32_t));
+        if (pcs == NULL)
+            return 0;
+        r->pcs = pcs;
+        r->capacity = capacity;
+    }
+    r->pcs[r->count++] = pc;
+    return 1;
+}
+
+// Everything that is not the report goes to stdout. 1 if a report was
+// found, 0 if not, -1 if out of memory.
+static int read_report(FILE *in, report *r) {
+    char line[4096];
+    int found = 0, inside = 0;
+    while (fgets(line, sizeof line, in) != NULL) {
+        if (!inside) {
+            report header;
+            if (sscanf(line, "rvprof %x %x %x %x %x", &header.period, &header.samples,
+                       &header.room, &header.mcause, &header.mepc) == 5) {
+                r->period = header.period;
+                r->samples = header.samples;
+                r->room = header.room;
+                r->mcause = header.mcause;
+                r->mepc = header.mepc;
+                found = inside = 1;
+            } else {
+                fputs(line, stdout);
+            }
+            continue;
+        }
+        if (strncmp(line, "rvprof end", 10) == 0) {
+            inside = 0;
+            continue;
+        }
+        char *p = line, *end;
+        for (;;) {
+            unsigned long pc = strtoul(p, &end, 16);
+            if (end == p)
+                break;
+            if (!add_sample(r, (uint32_t)pc))
+                return -1;
+            p = end;
+        }
+    }
+    return found;
+}
+
+static const char *cause_name(uint32_t mcause) {
+    static const char *const exceptions[] = {
+        "misaligned fetch", "fetch fault", "illegal instruction", "ebreak",
+        "misaligned load", "load fault", "misaligned store", "store fault",
+        "ecall from U-mode", "ecall from S-mode", "exception 10", "ecall",
+    };
+    if (mcause == REPORT_RUNNING)
+        return "profile_report";
+    if (mcause == REPORT_IDLE)
+        return "idle loop";
+    if (mcause == REPORT_FULL)
+        return "sample buffer full";
+    if (mcause < sizeof exceptions / sizeof exceptions[0])
+        return exceptions[mcause];
+    return "unexpected trap";
+}
+
+static void print_where(const rv_image *image, uint32_t address) {
+    const rv_symbol *symbol = rv_symbol_at(image, address);
+    if (symbol == NULL)
+        return;
+    if (symbol->address == address)
+        printf(" (%s)", symbol->name);
+    else
+        printf(" (%s+0x%x)", symbol->name, address - symbol->address);
+}
+
+// Samples per label, or per pc with by_pc; pcs sorted. The rows go in
+// rows, which has room for count + 1 of them; returns how many.
+static size_t tally(const rv_image *image, const uint32_t *pcs, size_t count, int by_pc,
+                    row *rows) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const rv_symbol *symbol = rv_symbol_at(image, pcs[i]);
+        uint32_t key = by_pc ? pcs[i] : symbol ? symbol->address : 0;
+        const char *name = symbol ? symbol->name : "?";
+        if (n > 0 && rows[n - 1].address == key && rows[n - 1].name == name) {
+            rows[n - 1].samples++;
+            continue;
+        }
+        rows[n++] = (row){name, key, 1};
+    }
+    qsort(rows, n, sizeof(row), by_samples);
+    return n;
+}
+
+int main(int argc, char **argv) {
+    const char *elf_path = NULL, *output_path = NULL;
+    int by_pc = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pc") == 0) {
+            by_pc = 1;
+        } else if (argv[i][0] != '-' && elf_path == NULL) {
+            elf_path = argv[i];
+        } else if (argv[i][0] != '-' && output_path == NULL) {
+            output_path = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (elf_path == NULL) {
+        usage();
+        return 2;
+    }
+
+    // Only the labels are wanted; the RAM is just somewhere to load into
+    rv_cpu cpu;
+    rv_image image;
+    char error[256];
+    if (!rv_cpu_init(&cpu, RV_RAM_BASE, 16u << 20)) {
+        fprintf(stderr, "rvprof: out of memory\n");
+        return 1;
+    }
+    if (!rv_load_elf(&cpu, elf_path, &image, error, sizeof(error))) {
+        fprintf(stderr, "rvprof: %s: %s\n", elf_path, error);
+        rv_cpu_free(&cpu);
+        return 1;
+    }
+    rv_cpu_free(&cpu);
+
+    FILE *in = output_path ? fopen(output_path, "r") : stdin;
+    if (in == NULL) {
+        perror(output_path);
+        rv_image_free(&image);
+        return 1;
+    }
+    report r = {0};
+    int found = read_report(in, &r);
+    if (in != stdin)
+        fclose(in);
+    if (found <= 0) {
+        if (found < 0)
+            fprintf(stderr, "rvprof: out of memory for the samples\n");
+        else
+            fprintf(stderr, "rvprof: no rvprof report in %s\n",
+                    output_path ? output_path : "the input");
+        free(r.pcs);
+        rv_image_free(&image);
+        return 1;
+    }
+
+    printf("\nsamples:      %zu, one every %u timer ticks (%u instructions with -icount shift=0)\n",
+           r.count, r.period, r.period * 100);
+    if (r.count < r.samples)
+        printf("              (%u were taken; the report is cut short)\n", r.samples);
+    printf("stopped:      %s", cause_name(r.mcause));
+    if (r.mcause != REPORT_RUNNING) {
+        printf(" at 0x%08x", r.mepc);
+        print_where(&image, r.mepc);
+    }
+    printf("\n");
+
+    row *rows = malloc((r.count + 1) * sizeof(row));
+    if (rows == NULL) {
+        fprintf(stderr, "rvprof: out of memory\n");
+        free(r.pcs);
+        rv_image_free(&image);
+        return 1;
+    }
+    qsort(r.pcs, r.count, sizeof(uint32_t), by_value);
+    double total = r.count ? (double)r.count : 1.0;
+
+    size_t n = tally(&image, r.pcs, r.count, 0, rows);
+    printf("\n%-24s %10s %8s %8s\n", "label", "samples", "self%", "cumul%");
+    uint64_t running = 0;
+    for (size_t i = 0; i < n; i++) {
+        running += rows[i].samples;
+        printf("%-24s %10llu %7.2f%% %7.2f%%\n", rows[i].name,
+               (unsigned long long)rows[i].samples, 100.0 * rows[i].samples / total,
+               100.0 * running / total);
+    }
+
+    if (by_pc) {
+        n = tally(&image, r.pcs, r.count, 1, rows);
+        printf("\n%-10s %-28s %10s %8s\n", "pc", "where", "samples", "self%");
+        for (size_t i = 0; i < n; i++) {
+            const rv_symbol *symbol = rv_symbol_at(&image, rows[i].address);
+            char where[64];
+            if (symbol == NULL)
+                snprintf(where, sizeof where, "?");
+            else
+                snprintf(where, sizeof where, "%s+0x%x", symbol->name,
+                         rows[i].address - symbol->address);
+            printf("0x%08x %-28s %10llu %7.2f%%\n", rows[i].address, where,
+                   (unsigned long long)rows[i].samples, 100.0 * rows[i].samples / total);
+        }
+    }
+
+    free(rows);
+    free(r.pcs);
+    rv_image_free(&image);
+    return 0;
+}
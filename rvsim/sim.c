@@ -0,0 +1,387 @@
+/*
+ * sim.c - rv32i interpreter (see sim.h)
+ *
+ * The loop keeps pc, instret and cycles in locals and writes them back when
+ * it stops. It is written once as an always_inline function and
+ * instantiated with profiling on and off, so the plain run does not pay
+ * for the per-pc counters.
+ *
+ * Besides rv32i, the read-only counter CSRs (cycle, time, instret and
+ * their high halves, via csrrs/csrrc with rs1 = x0, i.e. rdcycle and
+ * friends) are supported so programs can time themselves. mstatus can be
+ * read and written, so a program can turn the vector unit on, and vector
+ * instructions go to vector.c. So can the trap CSRs start-up code writes
+ * (mtvec, mie, mscratch, mepc, mcause), but traps and mret are left to
+ * rv_run_devices (devices.h): here mret is an illegal-instruction stop.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "rv32.h"
+#include "sim.h"
+#include "vector.h"
+
+#define CSR_CYCLE 0xC00
+#define CSR_TIME 0xC01
+#define CSR_INSTRET 0xC02
+#define CSR_CYCLEH 0xC80
+#define CSR_TIMEH 0xC81
+#define CSR_INSTRETH 0xC82
+#define CSR_MIE 0x304
+#define CSR_MTVEC 0x305
+#define CSR_MSCRATCH 0x340
+#define CSR_MEPC 0x341
+#define CSR_MCAUSE 0x342
+#define CSR_MIP 0x344
+#define CSR_MHARTID 0xF14
+
+int rv_cpu_init(rv_cpu *cpu, uint32_t ram_base, uint32_t ram_size) {
+    memset(cpu, 0, sizeof(*cpu));
+    if (ram_size < 4)
+        return 0;
+    cpu->ram = calloc(ram_size, 1);
+    if (cpu->ram == NULL)
+        return 0;
+    cpu->ram_base = ram_base;
+    cpu->ram_size = ram_size;
+    cpu->pc = ram_base;
+    cpu->timing = (rv_timing)RV_TIMING_DEFAULT;
+    cpu->vlen = RV_VLEN_DEFAULT;
+    cpu->vtype = RV_VTYPE_VILL;
+    return 1;
+}
+
+void rv_cpu_free(rv_cpu *cpu) {
+    rv_blocks_free(cpu->blocks);
+    free(cpu->ram);
+    free(cpu->profile_cycles);
+    free(cpu->profile_instret);
+    memset(cpu, 0, sizeof(*cpu));
+}
+
+int rv_cpu_enable_profile(rv_cpu *cpu) {
+    size_t words = cpu->ram_size / 4;
+    if (cpu->profile_cycles == NULL)
+        cpu->profile_cycles = calloc(words, sizeof(uint64_t));
+    if (cpu->profile_instret == NULL)
+        cpu->profile_instret = calloc(words, sizeof(uint64_t));
+    return cpu->profile_cycles != NULL && cpu->profile_instret != NULL;
+}
+
+int rv_cpu_write(rv_cpu *cpu, uint32_t address, const void *bytes, size_t size) {
+    uint32_t offset = address - cpu->ram_base;
+    if (offset > cpu->ram_size || size > cpu->ram_size - offset)
+        return 0;
+    memcpy(cpu->ram + offset, bytes, size);
+    if (cpu->blocks != NULL && size > 0)
+        rv_blocks_stored(cpu->blocks, offset, size);
+    return 1;
+}
+
+int rv_cpu_read(const rv_cpu *cpu, uint32_t address, void *bytes, size_t size) {
+    uint32_t offset = address - cpu->ram_base;
+    if (offset > cpu->ram_size || size > cpu->ram_size - offset)
+        return 0;
+    memcpy(bytes, cpu->ram + offset, size);
+    return 1;
+}
+
+const char *rv_stop_name(enum rv_stop stop) {
+    static const char *const names[] = {
+        [RV_STOP_LIMIT] = "instruction limit",
+        [RV_STOP_PC] = "stop address",
+        [RV_STOP_IDLE_LOOP] = "idle loop (j .)",
+        [RV_STOP_ECALL] = "ecall",
+        [RV_STOP_EBREAK] = "ebreak",
+        [RV_STOP_EXIT] = "sifive_test exit",
+        [RV_STOP_ILLEGAL] = "illegal instruction",
+        [RV_STOP_FETCH_FAULT] = "fetch outside RAM",
+        [RV_STOP_LOAD_FAULT] = "load outside RAM",
+        [RV_STOP_STORE_FAULT] = "store outside RAM",
+    };
+    return (unsigned)stop < sizeof(names) / sizeof(names[0]) ? names[stop] : "unknown";
+}
+
+// Little-endian guest memory on a little-endian host; memcpy compiles to
+// a plain (unaligned) move
+static inline uint32_t load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint16_t load16(const uint8_t *p) {
+    uint16_t v;
+    memcpy(&v, p, 2);
+    return v;
+}
+
+__attribute__((always_inline)) static inline enum rv_stop
+run_loop(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc, const int profile) {
+    uint32_t *x = cpu->x;
+    uint8_t *ram = cpu->ram;
+    const uint32_t base = cpu->ram_base, size = cpu->ram_size;
+    const uint64_t load_use = cpu->timing.load_use, taken_penalty = cpu->timing.taken_branch;
+    uint32_t pc = cpu->pc;
+    uint64_t instret = cpu->instret, cycles = cpu->cycles;
+    const uint64_t limit = instret + max_instructions;
+    uint32_t pending_load = cpu->pending_load;
+    enum rv_stop stop;
+
+    for (;;) {
+        if (instret == limit) {
+            stop = RV_STOP_LIMIT;
+            break;
+        }
+        if (pc == stop_pc) {
+            stop = RV_STOP_PC;
+            break;
+        }
+        uint32_t offset = pc - base;
+        if (offset > size - 4 || (pc & 3)) {
+            cpu->fault_address = pc;
+            stop = RV_STOP_FETCH_FAULT;
+            break;
+        }
+        uint32_t insn = load32(ram + offset);
+        uint32_t opcode = rv_opcode(insn), rd = rv_rd(insn), f3 = rv_funct3(insn);
+        uint32_t rs1 = rv_rs1(insn), rs2 = rv_rs2(insn);
+        uint32_t a = x[rs1], b = x[rs2];
+        uint32_t next = pc + 4;
+        uint64_t cost = 1;
+        if (pending_load != 0 && (rv_sources(insn) >> pending_load & 1))
+            cost += load_use;
+        pending_load = 0;
+
+        // Every rv32i opcode ends in 0b11, so opcode >> 2 gives a dense switch
+        if ((insn & 3) != 3)
+            goto illegal;
+        switch (opcode >> 2) {
+        case RV_OP_LUI >> 2:
+            x[rd] = (uint32_t)rv_imm_u(insn);
+            break;
+        case RV_OP_AUIPC >> 2:
+            x[rd] = pc + (uint32_t)rv_imm_u(insn);
+            break;
+        case RV_OP_JAL >> 2:
+            if (insn == RV_INSN_J_SELF) {
+                stop = RV_STOP_IDLE_LOOP;
+                goto done;
+            }
+            x[rd] = next;
+            next = pc + (uint32_t)rv_imm_j(insn);
+            cost += taken_penalty;
+            break;
+        case RV_OP_JALR >> 2:
+            if (f3 != 0)
+                goto illegal;
+            next = (a + (uint32_t)rv_imm_i(insn)) & ~1u;
+            x[rd] = pc + 4;
+            cost += taken_penalty;
+            break;
+        case RV_OP_BRANCH >> 2: {
+            int take;
+            switch (f3) {
+            case 0: take = a == b; break;
+            case 1: take = a != b; break;
+            case 4: take = (int32_t)a < (int32_t)b; break;
+            case 5: take = (int32_t)a >= (int32_t)b; break;
+            case 6: take = a < b; break;
+            case 7: take = a >= b; break;
+            default: goto illegal;
+            }
+            cpu->branches++;
+            if (take) {
+                next = pc + (uint32_t)rv_imm_b(insn);
+                cost += taken_penalty;
+                cpu->taken_branches++;
+            }
+            break;
+        }
+        case RV_OP_LOAD >> 2: {
+            uint32_t address = a + (uint32_t)rv_imm_i(insn);
+            uint32_t at = address - base;
+            unsigned width = f3 & 3;        // 0 byte, 1 half, 2 word
+            if (width == 3 || f3 > 5)
+                goto illegal;
+            if (at > size - (1u << width)) {
+                cpu->fault_address = address;
+                stop = RV_STOP_LOAD_FAULT;
+                goto done;
+            }
+            uint32_t value;
+            switch (f3) {
+            case 0: value = (uint32_t)(int32_t)(int8_t)ram[at]; break;
+            case 1: value = (uint32_t)(int32_t)(int16_t)load16(ram + at); break;
+            case 2: value = load32(ram + at); break;
+            case 4: value = ram[at]; break;
+            default: value = load16(ram + at); break;
+            }
+            x[rd] = value;
+            pending_load = rd;
+            cpu->loads++;
+            break;
+        }
+        case RV_OP_STORE >> 2: {
+            uint32_t address = a + (uint32_t)rv_imm_s(insn);
+            uint32_t at = address - base;
+            if (f3 > 2)
+                goto illegal;
+            if (at > size - (1u << f3)) {
+                cpu->fault_address = address;
+                stop = RV_STOP_STORE_FAULT;
+                goto done;
+            }
+            memcpy(ram + at, &b, 1u << f3);
+            cpu->stores++;
+            if (cpu->blocks != NULL)
+                rv_blocks_stored(cpu->blocks, at, 1u << f3);
+            break;
+        }
+        case RV_OP_IMM >> 2: {
+            uint32_t imm = (uint32_t)rv_imm_i(insn), shamt = rs2;
+            switch (f3) {
+            case 0: x[rd] = a + imm; break;
+            case 2: x[rd] = (int32_t)a < (int32_t)imm; break;
+            case 3: x[rd] = a < imm; break;
+            case 4: x[rd] = a ^ imm; break;
+            case 6: x[rd] = a | imm; break;
+            case 7: x[rd] = a & imm; break;
+            case 1:
+                if (rv_funct7(insn) != 0)
+                    goto illegal;
+                x[rd] = a << shamt;
+                break;
+            default:
+                if (rv_funct7(insn) == 0)
+                    x[rd] = a >> shamt;
+                else if (rv_funct7(insn) == 0x20)
+                    x[rd] = (uint32_t)((int32_t)a >> shamt);
+                else
+                    goto illegal;
+                break;
+            }
+            break;
+        }
+        case RV_OP_REG >> 2:
+            if (rv_funct7(insn) == 0) {
+                switch (f3) {
+                case 0: x[rd] = a + b; break;
+                case 1: x[rd] = a << (b & 31); break;
+                case 2: x[rd] = (int32_t)a < (int32_t)b; break;
+                case 3: x[rd] = a < b; break;
+                case 4: x[rd] = a ^ b; break;
+                case 5: x[rd] = a >> (b & 31); break;
+                case 6: x[rd] = a | b; break;
+                default: x[rd] = a & b; break;
+                }
+            } else if (rv_funct7(insn) == 0x20 && f3 == 0) {
+                x[rd] = a - b;
+            } else if (rv_funct7(insn) == 0x20 && f3 == 5) {
+                x[rd] = (uint32_t)((int32_t)a >> (b & 31));
+            } else {
+                goto illegal;
+            }
+            break;
+        case RV_OP_MISC_MEM >> 2:
+            break;              // fence: nothing to order in a single hart
+        case RV_OP_SYSTEM >> 2:
+            if (insn == RV_INSN_ECALL) {
+                stop = RV_STOP_ECALL;
+                goto done;
+            }
+            if (insn == RV_INSN_EBREAK) {
+                stop = RV_STOP_EBREAK;
+                goto done;
+            }
+            if (f3 != 0 && f3 != 4) {
+                // csrrw/s/c and their immediate forms; csrrs/c with rs1 = 0
+                // only read, which is all the counters allow
+                int writes = (f3 & 3) == 1 || rs1 != 0;
+                uint32_t operand = f3 >= 5 ? rs1 : a;
+                uint64_t value = 0;
+                uint32_t *field = NULL;     // a CSR that reads back what was written
+                switch (insn >> 20) {
+                case CSR_CYCLE: case CSR_TIME: value = cycles; break;
+                case CSR_INSTRET: value = instret; break;
+                case CSR_CYCLEH: case CSR_TIMEH: value = cycles >> 32; break;
+                case CSR_INSTRETH: value = instret >> 32; break;
+                case RV_CSR_VL: value = cpu->vl; break;
+                case RV_CSR_VTYPE: value = cpu->vtype; break;
+                case RV_CSR_VLENB: value = cpu->vlen / 8; break;
+                case CSR_MIP: case CSR_MHARTID: break;     // nothing pending; hart 0
+                case RV_CSR_MSTATUS: field = &cpu->mstatus; break;
+                case CSR_MTVEC: field = &cpu->mtvec; break;
+                case CSR_MIE: field = &cpu->mie; break;
+                case CSR_MSCRATCH: field = &cpu->mscratch; break;
+                case CSR_MEPC: field = &cpu->mepc; break;
+                case CSR_MCAUSE: field = &cpu->mcause; break;
+                default: goto illegal;
+                }
+                if (field != NULL) {
+                    value = *field;
+                    if ((f3 & 3) == 1)
+                        *field = operand;
+                    else if ((f3 & 3) == 2)
+                        *field |= operand;
+                    else
+                        *field &= ~operand;
+                    writes = 0;
+                }
+                if (writes)
+                    goto illegal;
+                x[rd] = (uint32_t)value;
+                break;
+            }
+            goto illegal;
+        case RV_OP_LOAD_FP >> 2:
+        case RV_OP_STORE_FP >> 2:
+        case RV_OP_V >> 2: {
+            uint64_t vector_cost;
+            stop = rv_vector_step(cpu, insn, &vector_cost);
+            if (stop != RV_STOP_LIMIT)
+                goto done;
+            cost += vector_cost - 1;
+            break;
+        }
+        default:
+        illegal:
+            stop = RV_STOP_ILLEGAL;
+            goto done;
+        }
+
+        x[0] = 0;
+        if (profile) {
+            cpu->profile_cycles[offset / 4] += cost;
+            cpu->profile_instret[offset / 4]++;
+        }
+        cycles += cost;
+        instret++;
+        pc = next;
+    }
+done:
+    x[0] = 0;
+    cpu->pc = pc;
+    cpu->instret = instret;
+    cpu->cycles = cycles;
+    cpu->pending_load = pending_load;
+    return stop;
+}
+
+static enum rv_stop run_profiled(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc) {
+    return run_loop(cpu, max_instructions, stop_pc, 1);
+}
+
+enum rv_stop rv_run_decode(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc) {
+    if (cpu->profile_cycles != NULL && cpu->profile_instret != NULL)
+        return run_profiled(cpu, max_instructions, stop_pc);
+    return run_loop(cpu, max_instructions, stop_pc, 0);
+}
+
+enum rv_stop rv_run(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc) {
+    if (cpu->blocks != NULL && cpu->profile_cycles == NULL)
+        return rv_run_blocks(cpu, max_instructions, stop_pc);
+    return rv_run_decode(cpu, max_instructions, stop_pc);
+}
@@ -0,0 +1,109 @@
+/*
+ * sim.h - rv32i instruction-set simulator with an in-order cycle model
+ *
+ * Runs the ELF that `make machinecode` (or array_ops' `make compile`)
+ * builds, without QEMU or gdb: one flat RAM at the virt board's
+ * 0x80000000, 32 registers and a pc. Every instruction is decoded as it
+ * is fetched.
+ *
+ * Cycles come from a simple in-order pipeline model: one per instruction,
+ * plus rv_timing.load_use when an instruction reads the register the load
+ * just before it wrote, plus rv_timing.taken_branch for every taken
+ * branch and jump. It is meant to compare versions of the same code, not
+ * to match any particular core.
+ *
+ * A run stops at the instruction limit, at stop_pc, on ecall/ebreak, on
+ * an illegal instruction or bad memory access, or at `j .` (the "done:
+ * j done" these programs end with).
+ *
+ * Part of the vector extension is there too (vector.h), with VLEN of
+ * cpu->vlen bits: enough to compare a strip-mined RVV loop with scalar
+ * code. Vector instructions always go through the decode engine.
+ *
+ * With rv_cpu_enable_blocks, rv_run executes from a cache of pre-decoded
+ * basic blocks instead (block.h), and with rv_cpu_enable_dbt it compiles
+ * the hot ones to x86-64 (dbt.h). Results, counters and cycles are the
+ * same either way; rv_run_decode is the decode-every-fetch reference.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RV_RAM_BASE 0x80000000u
+
+typedef struct {
+    unsigned load_use;          // extra cycles for using a value loaded just before
+    unsigned taken_branch;      // extra cycles for a taken branch or a jump
+} rv_timing;
+
+#define RV_TIMING_DEFAULT {1, 2}
+#define RV_VLEN_DEFAULT 128      // QEMU's default for -cpu rv32,v=true
+#define RV_VLEN_MAX 1024
+#define RV_DBT_THRESHOLD 16     // block entries before translation, for rvsim --dbt
+
+enum rv_stop {
+    RV_STOP_LIMIT,              // ran max_instructions
+    RV_STOP_PC,                 // reached stop_pc
+    RV_STOP_IDLE_LOOP,          // jal x0, 0
+    RV_STOP_ECALL,
+    RV_STOP_EBREAK,
+    RV_STOP_EXIT,               // wrote to sifive_test (rv_run_devices, devices.h)
+    RV_STOP_ILLEGAL,
+    RV_STOP_FETCH_FAULT,        // pc outside RAM or misaligned
+    RV_STOP_LOAD_FAULT,
+    RV_STOP_STORE_FAULT,
+};
+
+struct rv_blocks;
+
+typedef struct {
+    uint32_t x[32];
+    uint32_t pc;
+    uint8_t *ram;
+    uint32_t ram_base, ram_size;
+    rv_timing timing;
+
+    uint64_t instret, cycles;
+    uint64_t loads, stores, branches, taken_branches;
+    uint32_t fault_address;     // for the fault stops
+    uint32_t pending_load;      // rd of the last instruction if it was a load, else 0
+
+    // When profile is set: cycles and instructions per 4-byte word of RAM,
+    // indexed by (pc - ram_base) / 4
+    uint64_t *profile_cycles, *profile_instret;
+
+    struct rv_blocks *blocks;   // when the block cache is on
+
+    uint32_t mstatus;           // VS (vector unit on/off), and MIE/MPIE for devices.h
+    // rv_run only reads and writes them, and stops at mret; rv_run_devices
+    // takes the traps and interrupts that use them (devices.h)
+    uint32_t mtvec, mscratch, mie, mepc, mcause;
+    uint32_t vlen;              // VLEN in bits: a power of two, 32..RV_VLEN_MAX
+    uint32_t vl, vtype;
+    uint8_t v[32][RV_VLEN_MAX / 8];
+} rv_cpu;
+
+// 0 if out of memory. RAM starts zeroed; timing is RV_TIMING_DEFAULT,
+// vlen RV_VLEN_DEFAULT.
+int rv_cpu_init(rv_cpu *cpu, uint32_t ram_base, uint32_t ram_size);
+void rv_cpu_free(rv_cpu *cpu);
+int rv_cpu_enable_profile(rv_cpu *cpu);
+// Profiled runs always decode every fetch; 0 if out of memory
+int rv_cpu_enable_blocks(rv_cpu *cpu);
+// Blocks also go to x86-64 code once entered threshold times (dbt.h);
+// 0 if out of memory or the host cannot run it
+int rv_cpu_enable_dbt(rv_cpu *cpu, unsigned threshold);
+
+// Copy bytes into RAM at a guest address; 0 if they do not fit
+int rv_cpu_write(rv_cpu *cpu, uint32_t address, const void *bytes, size_t size);
+int rv_cpu_read(const rv_cpu *cpu, uint32_t address, void *bytes, size_t size);
+
+// Run from cpu->pc; stop_pc 0 means none
+enum rv_stop rv_run(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc);
+enum rv_stop rv_run_decode(rv_cpu *cpu, uint64_t max_instructions, uint32_t stop_pc);
+const char *rv_stop_name(enum rv_stop stop);
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * vector.c - RVV 1.0 subset for the decode engine (see vector.h)
+ *
+ * The register file is cpu->v: 32 registers of cpu->vlen bits, each in a
+ * row of RV_VLEN_MAX bits. A register group of LMUL registers is walked
+ * element by element, so element i of the group at vd lives in register
+ * vd + i / (elements per register).
+ */
+
+#include <string.h>
+
+#include "block.h"
+#include "rv32.h"
+#include "vector.h"
+
+enum {
+    F6_VADD = 0x00, F6_VSUB = 0x02, F6_VRSUB = 0x03, F6_VAND = 0x09, F6_VOR = 0x0A,
+    F6_VXOR = 0x0B, F6_VMV = 0x17, F6_VSLL = 0x25, F6_VSRL = 0x28, F6_VSRA = 0x29,
+};
+enum { OPIVV = 0, OPIVI = 3, OPIVX = 4, OPCFG = 7 };
+
+static unsigned sew_bytes(uint32_t vtype) { return 1u << ((vtype >> 3) & 7); }
+static unsigned lmul(uint32_t vtype) { return 1u << (vtype & 7); }
+
+static uint32_t vlmax(const rv_cpu *cpu, uint32_t vtype) {
+    return cpu->vlen / 8 / sew_bytes(vtype) * lmul(vtype);
+}
+
+// SEW 8-32 with an integer LMUL, and no reserved bits
+static int supported(uint32_t vtype) {
+    return (vtype >> 8) == 0 && ((vtype >> 3) & 7) <= 2 && (vtype & 7) <= 3;
+}
+
+static uint8_t *element(rv_cpu *cpu, uint32_t reg, uint32_t i, unsigned bytes) {
+    uint32_t per_reg = cpu->vlen / 8 / bytes;
+    return cpu->v[reg + i / per_reg] + (i % per_reg) * bytes;
+}
+
+static uint32_t get(rv_cpu *cpu, uint32_t reg, uint32_t i, unsigned bytes) {
+    uint32_t value = 0;
+    memcpy(&value, element(cpu, reg, i, bytes), bytes);
+    return value;
+}
+
+static void set(rv_cpu *cpu, uint32_t reg, uint32_t i, unsigned bytes, uint32_t value) {
+    memcpy(element(cpu, reg, i, bytes), &value, bytes);
+}
+
+// Cycles for vl elements of the given width: one per VLEN bits, at least one
+static uint64_t cycles_for(const rv_cpu *cpu, uint32_t elements, unsigned bytes) {
+    uint32_t per_reg = cpu->vlen / 8 / bytes;
+    return elements > per_reg ? (elements + per_reg - 1) / per_reg : 1;
+}
+
+static enum rv_stop configure(rv_cpu *cpu, uint32_t insn) {
+    uint32_t rd = rv_rd(insn), rs1 = rv_rs1(insn), vtype, avl;
+    int keep_vl = 0;
+    if ((insn >> 31) == 0) {                        // vsetvli
+        vtype = (insn >> 20) & 0x7FF;
+        avl = cpu->x[rs1];
+        keep_vl = rs1 == 0 && rd == 0;
+        if (rs1 == 0 && rd != 0)
+            avl = UINT32_MAX;
+    } else if ((insn >> 30) == 3) {                 // vsetivli
+        vtype = (insn >> 20) & 0x3FF;
+        avl = rs1;
+    } else if ((insn >> 25) == 0x40) {              // vsetvl
+        vtype = cpu->x[rv_rs2(insn)];
+        avl = cpu->x[rs1];
+        keep_vl = rs1 == 0 && rd == 0;
+        if (rs1 == 0 && rd != 0)
+            avl = UINT32_MAX;
+    } else {
+        return RV_STOP_ILLEGAL;
+    }
+    if (!supported(vtype)) {
+        cpu->vtype = RV_VTYPE_VILL;
+        cpu->vl = 0;
+    } else {
+        uint32_t max = vlmax(cpu, vtype);
+        if (keep_vl)
+            avl = cpu->vl;
+        cpu->vtype = vtype;
+        cpu->vl = avl < max ? avl : max;
+    }
+    cpu->x[rd] = cpu->vl;
+    return RV_STOP_LIMIT;
+}
+
+static enum rv_stop load_store(rv_cpu *cpu, uint32_t insn, uint64_t *cost) {
+    static const unsigned widths[8] = {1, 0, 0, 0, 0, 2, 4, 0};   // width field -> EEW bytes
+    int store = rv_opcode(insn) == RV_OP_STORE_FP;
+    unsigned eew = widths[rv_funct3(insn)];
+    uint32_t vtype = cpu->vtype, vd = rv_rd(insn);
+    // unit stride (mop 0, lumop 0), unmasked, no segments, mew 0
+    if (eew == 0 || (vtype & RV_VTYPE_VILL) || (insn >> 25) != 1 || rv_rs2(insn) != 0)
+        return RV_STOP_ILLEGAL;
+    // The register group is EMUL = EEW / SEW * LMUL registers
+    unsigned emul_times_sew = eew * lmul(vtype);
+    if (emul_times_sew < sew_bytes(vtype) || emul_times_sew / sew_bytes(vtype) > 8)
+        return RV_STOP_ILLEGAL;
+    if (vd % (emul_times_sew / sew_bytes(vtype)) != 0)
+        return RV_STOP_ILLEGAL;
+
+    uint32_t address = cpu->x[rv_rs1(insn)], vl = cpu->vl;
+    uint32_t at = address - cpu->ram_base, bytes = vl * eew;
+    *cost = cycles_for(cpu, vl, eew);
+    if (vl > 0 && (at > cpu->ram_size || bytes > cpu->ram_size - at)) {
+        cpu->fault_address = address;
+        return store ? RV_STOP_STORE_FAULT : RV_STOP_LOAD_FAULT;
+    }
+    for (uint32_t i = 0; i < vl; i++) {
+        if (store)
+            memcpy(cpu->ram + at + i * eew, element(cpu, vd, i, eew), eew);
+        else
+            memcpy(element(cpu, vd, i, eew), cpu->ram + at + i * eew, eew);
+    }
+    if (store) {
+        cpu->stores++;
+        if (cpu->blocks != NULL && bytes > 0)
+            rv_blocks_stored(cpu->blocks, at, bytes);
+    } else {
+        cpu->loads++;
+    }
+    return RV_STOP_LIMIT;
+}
+
+static enum rv_stop arithmetic(rv_cpu *cpu, uint32_t insn, uint64_t *cost) {
+    uint32_t f6 = insn >> 26, f3 = rv_funct3(insn), vtype = cpu->vtype;
+    uint32_t vd = rv_rd(insn), vs1 = rv_rs1(insn), vs2 = rv_rs2(insn);
+    if ((vtype & RV_VTYPE_VILL) || ((insn >> 25) & 1) == 0)
+        return RV_STOP_ILLEGAL;
+    if (f3 != OPIVV && f3 != OPIVI && f3 != OPIVX)
+        return RV_STOP_ILLEGAL;
+    int ok;
+    switch (f6) {
+    case F6_VADD: case F6_VAND: case F6_VOR: case F6_VXOR:
+    case F6_VSLL: case F6_VSRL: case F6_VSRA:
+        ok = 1;
+        break;
+    case F6_VSUB: ok = f3 != OPIVI; break;
+    case F6_VRSUB: ok = f3 != OPIVV; break;
+    case F6_VMV: ok = vs2 == 0; break;
+    default: ok = 0; break;
+    }
+    unsigned bytes = sew_bytes(vtype), group = lmul(vtype);
+    if (!ok || vd % group || vs2 % group || (f3 == OPIVV && vs1 % group))
+        return RV_STOP_ILLEGAL;
+
+    uint32_t bits = 8 * bytes, mask = bits == 32 ? UINT32_MAX : (1u << bits) - 1;
+    uint32_t scalar = f3 == OPIVX ? cpu->x[vs1] : (uint32_t)((int32_t)(vs1 << 27) >> 27);
+    int shift = f6 == F6_VSLL || f6 == F6_VSRL || f6 == F6_VSRA;
+    if (f3 == OPIVI && shift)
+        scalar = vs1;           // shift immediates are unsigned
+    for (uint32_t i = 0; i < cpu->vl; i++) {
+        uint32_t a = get(cpu, vs2, i, bytes);
+        uint32_t b = (f3 == OPIVV ? get(cpu, vs1, i, bytes) : scalar) & mask;
+        int32_t signed_a = (int32_t)(a << (32 - bits)) >> (32 - bits);
+        uint32_t result;
+        switch (f6) {
+        case F6_VADD: result = a + b; break;
+        case F6_VSUB: result = a - b; break;
+        case F6_VRSUB: result = b - a; break;
+        case F6_VAND: result = a & b; break;
+        case F6_VOR: result = a | b; break;
+        case F6_VXOR: result = a ^ b; break;
+        case F6_VSLL: result = a << (b & (bits - 1)); break;
+        case F6_VSRL: result = a >> (b & (bits - 1)); break;
+        case F6_VSRA: result = (uint32_t)(signed_a >> (b & (bits - 1))); break;
+        default: result = b; break;                 // vmv.v
+        }
+        set(cpu, vd, i, bytes, result & mask);
+    }
+    *cost = cycles_for(cpu, cpu->vl, bytes);
+    return RV_STOP_LIMIT;
+}
+
+enum rv_stop rv_vector_step(rv_cpu *cpu, uint32_t insn, uint64_t *cost) {
+    if ((cpu->mstatus & RV_MSTATUS_VS) == 0)
+        return RV_STOP_ILLEGAL;
+    enum rv_stop stop;
+    *cost = 1;
+    if (rv_opcode(insn) != RV_OP_V)
+        stop = load_store(cpu, insn, cost);
+    else if (rv_funct3(insn) == OPCFG)
+        stop = configure(cpu, insn);
+    else
+        stop = arithmetic(cpu, insn, cost);
+    if (stop == RV_STOP_LIMIT)
+        cpu->mstatus |= RV_MSTATUS_VS;              // Dirty
+    return stop;
+}
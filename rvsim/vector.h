@@ -0,0 +1,43 @@
+/*
+ * vector.h - The subset of the RISC-V vector extension (RVV 1.0) that
+ * rvsim runs
+ *
+ * Enough for strip-mined integer loops like array_ops_rvv.s:
+ *
+ *  - vsetvli, vsetivli and vsetvl with SEW 8, 16 or 32 and LMUL 1, 2, 4
+ *    or 8 (anything else sets vill)
+ *  - unit-stride vle8/16/32.v and vse8/16/32.v
+ *  - vadd, vsub, vrsub, vand, vor, vxor, vsll, vsrl, vsra and vmv.v in
+ *    their .vv, .vx and .vi forms
+ *  - the vl, vtype and vlenb CSRs
+ *
+ * Masked (vm = 0), strided, indexed and segment forms are illegal
+ * instructions here, as is every vector instruction while mstatus.VS is
+ * Off, which is how QEMU and real harts start. Tails are left undisturbed.
+ * A load or store with any element outside RAM faults at its base
+ * address without touching anything.
+ *
+ * A vector instruction costs one cycle per VLEN bits it processes (so an
+ * LMUL=4 load of a full group costs 4), at least one. Loads and stores
+ * count once each in cpu->loads and cpu->stores.
+ */
+
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <stdint.h>
+
+#include "sim.h"
+
+#define RV_CSR_MSTATUS 0x300
+#define RV_CSR_VL 0xC20
+#define RV_CSR_VTYPE 0xC21
+#define RV_CSR_VLENB 0xC22
+#define RV_MSTATUS_VS (3u << 9)
+#define RV_VTYPE_VILL 0x80000000u
+
+// Run one LOAD-FP, STORE-FP or OP-V instruction: RV_STOP_LIMIT when it
+// ran, else the stop it causes. *cost gets its cycles.
+enum rv_stop rv_vector_step(rv_cpu *cpu, uint32_t insn, uint64_t *cost);
+
+#endif